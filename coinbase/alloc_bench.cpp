@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   alloc_bench.cpp
+ * Author: Chris Morrison
+ *
+ * Created on 19 October 2026, 19:55
+ */
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string>
+#include <boost/asio/io_context.hpp>
+#include <boost/thread/mutex.hpp>
+#include "async_exchange.hpp"
+#include "mock_context.hpp"
+#include "task.hpp"
+#include "trader.hpp"
+
+// ------------------------------------------------------------------------------------------------
+// Allocation check for the trading loop.
+//
+// Runs the work order coroutine against the mock exchange with global operator new replaced by a
+// counting version. A few warm-up cycles let every reused buffer (and the coroutine frame free lists)
+// reach its working size; after that the loop must not touch the heap at all, and the
+// program exits with status 1 if it does.
+// ------------------------------------------------------------------------------------------------
+
+static std::atomic<bool> counting(false);
+static std::atomic<unsigned long> allocations(0);
+static std::atomic<unsigned long> allocated_bytes(0);
+
+// The replacements are kept out of line: inlined into a caller, a delete would be seen as a bare free()
+// of memory that came from operator new.
+__attribute__((noinline)) void* operator new(std::size_t size)
+{
+    if (counting.load(std::memory_order_relaxed))
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    }
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) { return operator new(size); }
+__attribute__((noinline)) void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { operator delete(p); }
+void operator delete(void* p, std::size_t) noexcept { operator delete(p); }
+void operator delete[](void* p, std::size_t) noexcept { operator delete(p); }
+
+static const char* const prices[] = {
+    "8123.45", "8124.10", "8122.98", "8123.77", "8125.02", "8121.60", "8123.15", "8122.40"
+};
+
+///
+/// Steps the trader until the given number of orders have been posted (when steps is 0) or for the given
+/// number of steps, counting allocations for the latter.
+static mercury::task<void> drive(mercury::trader& robot, mercury::async_exchange& exchange,
+                                 mercury::mock_context& context, unsigned int posts, unsigned long steps,
+                                 unsigned long& done)
+{
+    done = 0;
+    counting = (steps != 0);
+    while (steps ? done < steps : context.posts() < posts)
+    {
+        bool running = co_await robot.step(exchange);
+        if (!running) break;
+        ++done;
+    }
+    counting = false;
+}
+
+int main(int argc, char** argv)
+{
+    const unsigned int warm_up_cycles = 8;
+    unsigned long steps = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 100000;
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "mercury-alloc-bench.txt";
+
+    {
+        std::ofstream file(path);
+        file << "BTC:BUY:EUR:8123.00:NONE" << std::endl;
+    }
+
+    boost::mutex mtx;
+    std::ostream quiet(nullptr);
+    boost::asio::io_context io;
+    mercury::trader_settings settings;
+    mercury::mock_context context(prices, sizeof(prices) / sizeof(prices[0]));
+    mercury::async_exchange exchange(context, io);
+    mercury::trader robot(settings, mtx, quiet);
+    unsigned long done = 0;
+
+    // Nothing really waits between steps, so every status check has to go to the exchange.
+    robot.skip_waits();
+    exchange.reconciler().set_max_age(std::chrono::seconds(0));
+    if (!robot.open(path.string()))
+    {
+        std::cerr << "Failed to open the work order file " << path << "." << std::endl;
+        return 1;
+    }
+
+    // Each cycle is BUY, WFB (resting), WFB (filled), SELL, WFS (resting), WFS (filled).
+    mercury::spawn(io, drive(robot, exchange, context, 2 * warm_up_cycles, 0, done));
+    io.run();
+    if (context.posts() < 2 * warm_up_cycles)
+    {
+        std::cerr << "The trading loop stopped during warm-up." << std::endl;
+        return 1;
+    }
+
+    unsigned int first_post = context.posts();
+    io.restart();
+    mercury::spawn(io, drive(robot, exchange, context, 0, steps, done));
+    io.run();
+    if (done < steps)
+    {
+        std::cerr << "The trading loop stopped after " << done << " steps." << std::endl;
+        return 1;
+    }
+
+    std::filesystem::remove(path);
+
+    std::cout << "steps: " << steps << std::endl;
+    std::cout << "orders: " << (context.posts() - first_post) << std::endl;
+    std::cout << "allocations: " << allocations << std::endl;
+    std::cout << "allocated_bytes: " << allocated_bytes << std::endl;
+
+    return (allocations == 0) ? 0 : 1;
+}
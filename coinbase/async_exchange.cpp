@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   async_exchange.cpp
+ * Author: Chris Morrison
+ *
+ * Created on 19 October 2026, 21:15
+ */
+#include "async_exchange.hpp"
+
+namespace mercury
+{
+
+using namespace cryptocoin::trading;
+
+async_exchange::async_exchange(exchange_context& context, boost::asio::io_context& io, boost::asio::thread_pool* pool)
+    : context_(context), io_(io)
+{
+    if (pool) strand_.emplace(pool->get_executor());
+}
+
+bool async_exchange::set_market_bus(const market_bus_reader* bus, const std::string& product, std::chrono::microseconds max_age)
+{
+    uint32_t index = 0;
+
+    if (bus && !bus->find(product, index)) return false;
+
+    bus_ = bus;
+    bus_index_ = index;
+    bus_max_age_ = max_age.count();
+
+    return true;
+}
+
+order_status async_exchange::post_limit_order(order_side side, const std::string& size, const std::string& price, std::string& out_uuid)
+{
+    order_status result = context_.post_order(side, limit, size, price, "", out_uuid);
+    if (result == in_progress) reconciler_.track(out_uuid);
+    return result;
+}
+
+order_status async_exchange::cancel(const std::string& uuid)
+{
+    order_status result = context_.cancel_order(uuid);
+    if (result != network_error) reconciler_.forget(uuid);
+    return result;
+}
+
+}
@@ -0,0 +1,356 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   async_exchange.hpp
+ * Author: Chris Morrison
+ *
+ * Created on 19 October 2026, 21:15
+ */
+#ifndef ASYNC_EXCHANGE_HPP
+#define ASYNC_EXCHANGE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/asio/thread_pool.hpp>
+#include "exchange_context.hpp"
+#include "market_bus.hpp"
+#include "order_reconciler.hpp"
+#include "product_info.hpp"
+#include "request_scheduler.hpp"
+
+namespace mercury
+{
+
+///
+/// Awaitable front end to an exchange_context, for work orders running as coroutines (see task.hpp).
+///
+/// The exchange calls themselves block, so they are run on a strand of a worker pool and the awaiting
+/// coroutine is resumed on the io_context once the answer is in. The strand means the context only
+/// ever sees one call at a time, however many work orders share it. Without a pool the calls are made
+/// in place and the coroutine never suspends, which suits contexts that never block, such as the mock
+/// used by the benchmarks.
+///
+/// Resting orders of every work order on the exchange are tracked by one order_reconciler, so their
+/// status checks are answered by a single bulk lookup. Prices can come from a market bus instead of
+/// the exchange (see market_bus.hpp), in which case a fresh price is read in place without a call.
+///
+/// With a request_scheduler set, every call first waits for the scheduler to let it through, so the
+/// exchanges of all markets together stay within the rate limit. Given the context's count of HTTP
+/// requests, a call that made more than one (a bulk status lookup over several pages, say) is charged
+/// for each of them once it returns.
+class async_exchange
+{
+public:
+    ///
+    /// Awaitable for one blocking call.
+    template <typename F>
+    class call : private scheduled_request
+    {
+    public:
+        typedef std::invoke_result_t<F&> result_type;
+
+        call(async_exchange& exchange, F function, request_priority priority)
+            : exchange_(exchange), function_(std::move(function)), priority_(priority)
+        {
+        }
+
+        bool await_ready()
+        {
+            if (exchange_.strand_ || exchange_.scheduler_) return false;
+            run();
+            return true;
+        }
+
+        void await_suspend(std::coroutine_handle<> awaiting)
+        {
+            awaiting_ = awaiting;
+            if (!exchange_.scheduler_)
+            {
+                dispatch();
+                return;
+            }
+            start = [](scheduled_request* request) { static_cast<call*>(request)->dispatch(); };
+            exchange_.scheduler_->submit(priority_, this);
+        }
+
+        result_type await_resume()
+        {
+            if constexpr (!std::is_void_v<result_type>) return std::move(result_);
+        }
+
+    private:
+        void run()
+        {
+            const std::atomic<uint64_t>* count = exchange_.request_count_;
+            uint64_t before = count ? count->load() : 0;
+
+            if constexpr (std::is_void_v<result_type>)
+                function_();
+            else
+                result_ = function_();
+
+            // The strand runs one call at a time, so every request counted in between was this call's.
+            if (count) requests_ = count->load() - before;
+        }
+
+        void finish()
+        {
+            if (exchange_.scheduler_ && exchange_.request_count_) exchange_.scheduler_->charge(requests_);
+            awaiting_.resume();
+        }
+
+        void dispatch()
+        {
+            if (!exchange_.strand_)
+            {
+                run();
+                boost::asio::post(exchange_.io_, [this]() { finish(); });
+                return;
+            }
+
+            // The guard keeps io_context::run() from returning while the call is out on the pool.
+            boost::asio::post(*exchange_.strand_, [this, work = boost::asio::make_work_guard(exchange_.io_)]()
+            {
+                run();
+                boost::asio::post(exchange_.io_, [this]() { finish(); });
+            });
+        }
+
+        async_exchange& exchange_;
+        F function_;
+        request_priority priority_;
+        std::coroutine_handle<> awaiting_;
+        uint64_t requests_ = 1;
+        std::conditional_t<std::is_void_v<result_type>, char, result_type> result_{};
+    };
+
+    ///
+    /// Awaitable for a price read: answered from the market bus when it has a fresh price, otherwise
+    /// by the call it wraps.
+    template <typename F>
+    class price_call
+    {
+    public:
+        price_call(async_exchange& exchange, std::string& out, F function)
+            : exchange_(exchange), out_(out), fallback_(exchange, std::move(function), request_priority::polling)
+        {
+        }
+
+        bool await_ready()
+        {
+            if (exchange_.bus_ && exchange_.bus_->read_price(exchange_.bus_index_, exchange_.bus_max_age_, out_)) return true;
+            return fallback_.await_ready();
+        }
+
+        void await_suspend(std::coroutine_handle<> awaiting) { fallback_.await_suspend(awaiting); }
+        void await_resume() {}
+
+    private:
+        async_exchange& exchange_;
+        std::string& out_;
+        call<F> fallback_;
+    };
+
+    ///
+    /// Awaitable for a timer.
+    class timer
+    {
+    public:
+        ///
+        /// \param io       The io_context to resume on.
+        /// \param duration How long to wait.
+        /// \param current  If given, points at the timer while the wait is in progress, so that the wait
+        ///                 can be cut short with cancel().
+        timer(boost::asio::io_context& io, std::chrono::steady_clock::duration duration, timer** current = nullptr)
+            : timer_(io, duration), current_(current)
+        {
+        }
+
+        bool await_ready() const noexcept { return false; }
+
+        void await_suspend(std::coroutine_handle<> awaiting)
+        {
+            if (current_) *current_ = this;
+            timer_.async_wait([this, awaiting](const boost::system::error_code&)
+            {
+                if (current_ && *current_ == this) *current_ = nullptr;
+                awaiting.resume();
+            });
+        }
+
+        void await_resume() const noexcept {}
+
+        /// Ends the wait now.
+        void cancel() { timer_.cancel(); }
+
+    private:
+        boost::asio::steady_timer timer_;
+        timer** current_;
+    };
+
+    ///
+    /// \param context The exchange to drive; it must outlive this object.
+    /// \param io      The io_context the work orders run on.
+    /// \param pool    Worker pool for the blocking calls, or nullptr to make them in place.
+    async_exchange(exchange_context& context, boost::asio::io_context& io, boost::asio::thread_pool* pool = nullptr);
+
+    exchange_context& context() { return context_; }
+    order_reconciler& reconciler() { return reconciler_; }
+
+    ///
+    /// Takes prices from a market bus while they are fresh, falling back to the exchange when they are
+    /// not (the feed handler has stopped, say).
+    ///
+    /// \param bus     The bus, which must outlive this object; nullptr to stop using one.
+    /// \param product The product whose prices to read, e.g. "BTC-EUR".
+    /// \param max_age The oldest price that is still good enough.
+    /// \return false if the bus does not carry the product.
+    bool set_market_bus(const market_bus_reader* bus, const std::string& product, std::chrono::microseconds max_age);
+
+    ///
+    /// Sends every call through a scheduler, which may be shared with the exchanges of other markets.
+    ///
+    /// \param scheduler The scheduler, which must outlive this object and run on the same io_context;
+    ///                  nullptr to make calls as soon as they are awaited.
+    void set_scheduler(request_scheduler* scheduler) { scheduler_ = scheduler; }
+
+    ///
+    /// Has the scheduler charge each call for the HTTP requests it made rather than one apiece.
+    ///
+    /// \param count The running count of requests made by the context at the bottom of the chain, which
+    ///              must outlive this object; nullptr to charge one per call.
+    void set_request_count(const std::atomic<uint64_t>* count) { request_count_ = count; }
+
+    /// Reads the current price into out, which is left empty on failure.
+    auto read_current_price(std::string& out)
+    {
+        return make_price_call([this, &out]() { context_.read_current_price(out); }, out);
+    }
+
+    /// Reads the fiat balance into out, which is left empty on failure.
+    auto read_fiat_balance(std::string& out)
+    {
+        return make_call([this, &out]() { context_.read_fiat_balance(out); }, request_priority::account);
+    }
+
+    /// Reads the coin balance into out, which is left empty on failure.
+    auto read_coin_balance(std::string& out)
+    {
+        return make_call([this, &out]() { context_.read_coin_balance(out); }, request_priority::account);
+    }
+
+    ///
+    /// Posts a limit order. Orders left resting on the book are tracked for get_order_status().
+    ///
+    /// \param side     Buy or sell.
+    /// \param size     Order size.
+    /// \param price    Limit price.
+    /// \param out_uuid Receives the order identifier.
+    auto post_order(cryptocoin::trading::order_side side, const std::string& size, const std::string& price, std::string& out_uuid)
+    {
+        return make_call([this, side, &size, &price, &out_uuid]() { return post_limit_order(side, size, price, out_uuid); },
+                         request_priority::trading);
+    }
+
+    /// Returns the status of an order through the shared reconciler.
+    auto get_order_status(const std::string& uuid)
+    {
+        return make_call([this, &uuid]() { return reconciler_.status(context_, uuid); }, request_priority::polling);
+    }
+
+    /// Cancels an order and stops tracking it unless the outcome is not yet known.
+    auto cancel_order(const std::string& uuid)
+    {
+        return make_call([this, &uuid]() { return cancel(uuid); }, request_priority::trading);
+    }
+
+    /// Fetches the product's trading rules, see exchange_context::get_product_info().
+    auto get_product_info(product_info& out)
+    {
+        return make_call([this, &out]() { return context_.get_product_info(out); }, request_priority::account);
+    }
+
+    /// Looks up what a completed order traded, see exchange_context::get_fill().
+    auto get_fill(const std::string& uuid, order_fill& out)
+    {
+        return make_call([this, &uuid, &out]() { return context_.get_fill(uuid, out); }, request_priority::account);
+    }
+
+    /// Reads the last price, best bid and ask and daily volume, see exchange_context::get_ticker().
+    auto get_ticker(ticker& out)
+    {
+        return make_call([this, &out]() { return context_.get_ticker(out); }, request_priority::polling);
+    }
+
+    ///
+    /// Reads the ticker from a context that the driven one passes its calls on to, on the same strand, so
+    /// that a health probe is neither checked nor recorded by the contexts above it.
+    ///
+    /// \param inner A context in the chain below the driven one.
+    /// \param out   Receives the ticker.
+    auto probe(exchange_context& inner, ticker& out)
+    {
+        return make_call([&inner, &out]() { return inner.get_ticker(out); }, request_priority::polling);
+    }
+
+    auto sell_price_adjustment()
+    {
+        return make_call([this]() { return context_.sell_price_adjustment(); }, request_priority::account);
+    }
+
+    auto buy_price_ajustment()
+    {
+        return make_call([this]() { return context_.buy_price_ajustment(); }, request_priority::account);
+    }
+
+    /// Suspends the awaiting coroutine for the given time without holding up its thread.
+    timer wait(std::chrono::steady_clock::duration duration, timer** current = nullptr) { return timer(io_, duration, current); }
+
+private:
+    template <typename F>
+    call<F> make_call(F function, request_priority priority) { return call<F>(*this, std::move(function), priority); }
+
+    template <typename F>
+    price_call<F> make_price_call(F function, std::string& out) { return price_call<F>(*this, out, std::move(function)); }
+
+    cryptocoin::trading::order_status post_limit_order(cryptocoin::trading::order_side side, const std::string& size,
+                                                       const std::string& price, std::string& out_uuid);
+    cryptocoin::trading::order_status cancel(const std::string& uuid);
+
+    exchange_context& context_;
+    boost::asio::io_context& io_;
+    order_reconciler reconciler_;
+    std::optional<boost::asio::strand<boost::asio::thread_pool::executor_type>> strand_;
+    request_scheduler* scheduler_ = nullptr;
+    const std::atomic<uint64_t>* request_count_ = nullptr;
+    const market_bus_reader* bus_ = nullptr;
+    uint32_t bus_index_ = 0;
+    int64_t bus_max_age_ = 0;
+};
+
+}
+
+#endif /* ASYNC_EXCHANGE_HPP */
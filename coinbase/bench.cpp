@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   bench.cpp
+ * Author: Chris Morrison
+ *
+ * Created on 19 October 2026, 20:40
+ */
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <boost/algorithm/string.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/thread/mutex.hpp>
+#include <benchmark/benchmark.h>
+#include <coinbase.hpp>
+#include "async_exchange.hpp"
+#include "fixed_point.hpp"
+#include "mock_context.hpp"
+#include "product_info.hpp"
+#include "task.hpp"
+#include "trader.hpp"
+#include "work_order.hpp"
+
+// ------------------------------------------------------------------------------------------------
+// Micro-benchmarks for the robot's hot paths.
+//
+// Where the loop has moved away from a library call, the old way is measured next to the new one so
+// the gap stays visible. For machine-readable results run with --benchmark_format=json, or with
+// --benchmark_out=<file> --benchmark_out_format=json to keep the console output as well.
+// ------------------------------------------------------------------------------------------------
+
+static const char work_order_line[] = "BTC:WFB:EUR:8123.45:c5ab5e4d-8d3b-4a6c-9f1e-6a0b1f2d3c4e";
+
+static const char* const prices[] = {
+    "8123.45", "8124.10", "8122.98", "8123.77", "8125.02", "8121.60", "8123.15", "8122.40"
+};
+
+// --------------------------------------------------------------------------------------------
+// Work order parse and serialize.
+// --------------------------------------------------------------------------------------------
+
+static void work_order_parse(benchmark::State& state)
+{
+    mercury::work_order order;
+
+    for (auto _ : state)
+    {
+        bool ok = order.parse(work_order_line, sizeof(work_order_line) - 1);
+        benchmark::DoNotOptimize(ok);
+    }
+}
+BENCHMARK(work_order_parse);
+
+static void work_order_parse_split(benchmark::State& state)
+{
+    std::string line(work_order_line);
+    std::vector<std::string> strs;
+
+    for (auto _ : state)
+    {
+        boost::split(strs, line, boost::is_any_of(":"));
+        benchmark::DoNotOptimize(strs.data());
+    }
+}
+BENCHMARK(work_order_parse_split);
+
+static void work_order_format(benchmark::State& state)
+{
+    mercury::work_order order;
+    char buf[256];
+
+    order.parse(work_order_line, sizeof(work_order_line) - 1);
+    for (auto _ : state)
+    {
+        std::size_t len = order.format(buf, sizeof(buf));
+        benchmark::DoNotOptimize(len);
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(work_order_format);
+
+static void work_order_format_stream(benchmark::State& state)
+{
+    std::string coin("BTC"), fiat("EUR"), price("8123.45"), uuid("c5ab5e4d-8d3b-4a6c-9f1e-6a0b1f2d3c4e");
+
+    for (auto _ : state)
+    {
+        std::ostringstream out;
+        out << coin << ":" << "WFB:" << fiat << ":" << price << ":" << uuid << std::endl;
+        benchmark::DoNotOptimize(out.str());
+    }
+}
+BENCHMARK(work_order_format_stream);
+
+// --------------------------------------------------------------------------------------------
+// Price parse and format.
+// --------------------------------------------------------------------------------------------
+
+static void price_parse_stold(benchmark::State& state)
+{
+    std::string price(prices[0]);
+
+    for (auto _ : state) benchmark::DoNotOptimize(std::stold(price));
+}
+BENCHMARK(price_parse_stold);
+
+static void price_parse_fixed(benchmark::State& state)
+{
+    std::string price(prices[0]);
+    int64_t value = 0;
+
+    for (auto _ : state)
+    {
+        mercury::parse_fixed(price, 8, value);
+        benchmark::DoNotOptimize(value);
+    }
+}
+BENCHMARK(price_parse_fixed);
+
+static void price_format_precision(benchmark::State& state)
+{
+    long double price = 8123.45;
+
+    for (auto _ : state) benchmark::DoNotOptimize(utilities::to_string_with_precision(price, 2));
+}
+BENCHMARK(price_format_precision);
+
+static void price_format_fixed(benchmark::State& state)
+{
+    char buf[48];
+
+    for (auto _ : state)
+    {
+        std::size_t len = mercury::format_fixed(812345, 2, buf, sizeof(buf));
+        benchmark::DoNotOptimize(len);
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(price_format_fixed);
+
+// --------------------------------------------------------------------------------------------
+// Order size computation.
+// --------------------------------------------------------------------------------------------
+
+static void order_size(benchmark::State& state)
+{
+    mercury::product_info product;
+    std::string price;
+    std::string size;
+
+    product.set("BTC-EUR", "0.01", "0.00000001", "0.001", "70");
+    for (auto _ : state)
+    {
+        product.quantise_price("8123.456", false, price);
+        bool ok = product.size_for_funds(987.65, std::strtold(price.c_str(), nullptr), size);
+        benchmark::DoNotOptimize(ok);
+        benchmark::DoNotOptimize(size.data());
+    }
+}
+BENCHMARK(order_size);
+
+// --------------------------------------------------------------------------------------------
+// Logging.
+// --------------------------------------------------------------------------------------------
+
+static void log_timestamp(benchmark::State& state)
+{
+    for (auto _ : state) benchmark::DoNotOptimize(utilities::timestamp());
+}
+BENCHMARK(log_timestamp);
+
+// --------------------------------------------------------------------------------------------
+// One full BUY -> WFB -> SELL -> WFS cycle against the mock exchange.
+// --------------------------------------------------------------------------------------------
+
+// With orders filling on the first check, a cycle is four steps.
+static mercury::task<void> trade_cycle_steps(mercury::trader& robot, mercury::async_exchange& exchange, bool& running)
+{
+    for (int i = 0; i < 4 && running; ++i)
+    {
+        bool stepped = co_await robot.step(exchange);
+        running = stepped;
+    }
+}
+
+static void trade_cycle(benchmark::State& state)
+{
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "mercury-bench.txt";
+    {
+        std::ofstream file(path);
+        file << "BTC:BUY:EUR:8123.00:NONE" << std::endl;
+    }
+
+    boost::mutex mtx;
+    std::ostream quiet(nullptr);
+    boost::asio::io_context io;
+    mercury::trader_settings settings;
+    mercury::mock_context context(prices, sizeof(prices) / sizeof(prices[0]), 0);
+    mercury::async_exchange exchange(context, io);
+    mercury::trader robot(settings, mtx, quiet);
+
+    robot.skip_waits();
+    exchange.reconciler().set_max_age(std::chrono::seconds(0));
+    if (!robot.open(path.string()))
+    {
+        state.SkipWithError("failed to open the work order file");
+        return;
+    }
+
+    bool running = true;
+    for (auto _ : state)
+    {
+        mercury::spawn(io, trade_cycle_steps(robot, exchange, running));
+        io.run();
+        io.restart();
+        if (!running)
+        {
+            state.SkipWithError("the trading loop stopped");
+            break;
+        }
+    }
+    state.counters["orders"] = benchmark::Counter(context.posts(), benchmark::Counter::kIsRate);
+
+    std::filesystem::remove(path);
+}
+BENCHMARK(trade_cycle);
+
+BENCHMARK_MAIN();
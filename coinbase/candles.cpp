@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   candles.cpp
+ * Author: Chris Morrison
+ *
+ * Created on 20 October 2026, 04:10
+ */
+#include <algorithm>
+#include "candles.hpp"
+
+namespace mercury
+{
+
+int64_t candle_length_us(candle_resolution resolution)
+{
+    switch (resolution)
+    {
+        case candle_resolution::second: return 1000000;
+        case candle_resolution::minute: return 60000000;
+        case candle_resolution::five_minutes: return 300000000;
+        case candle_resolution::hour: return 3600000000LL;
+        default: return 0;
+    }
+}
+
+candle_series::candle_series(int64_t length_us, std::size_t capacity)
+    : length_us_(length_us > 0 ? length_us : 1), bars_(capacity ? capacity : 1)
+{
+}
+
+void candle_series::open_bar(int64_t start_us, double price)
+{
+    head_ = (count_ == 0) ? 0 : (head_ + 1 == bars_.size() ? 0 : head_ + 1);
+    if (count_ < bars_.size()) ++count_;
+
+    candle& bar = bars_[head_];
+    bar.start_us = start_us;
+    bar.open = bar.high = bar.low = bar.close = price;
+    bar.volume = 0.0;
+    bar.ticks = 0;
+}
+
+void candle_series::update(int64_t time_us, double price, double volume)
+{
+    // Floor rather than truncate, so that times before the epoch still land in the right bar.
+    int64_t start = time_us - ((time_us % length_us_) + length_us_) % length_us_;
+
+    if (count_ == 0)
+    {
+        open_bar(start, price);
+    }
+    else if (start > bars_[head_].start_us)
+    {
+        // Fill any bars the market was quiet for, at most a ring's worth, then open the tick's own bar.
+        double last = bars_[head_].close;
+        int64_t missing = (start - bars_[head_].start_us) / length_us_ - 1;
+        int64_t fill = std::min<int64_t>(missing, int64_t(bars_.size()) - 1);
+        for (int64_t i = fill; i > 0; --i) open_bar(start - i * length_us_, last);
+        open_bar(start, price);
+    }
+
+    candle& bar = bars_[head_];
+    if (bar.ticks == 0) bar.open = price;
+    bar.high = std::max(bar.high, price);
+    bar.low = std::min(bar.low, price);
+    bar.close = price;
+    bar.volume += volume;
+    ++bar.ticks;
+}
+
+bool candle_series::range(std::size_t bars, double& low, double& high) const
+{
+    if (count_ == 0) return false;
+
+    std::size_t n = std::min(bars ? bars : 1, count_);
+    low = at(0).low;
+    high = at(0).high;
+    for (std::size_t age = 1; age < n; ++age)
+    {
+        low = std::min(low, at(age).low);
+        high = std::max(high, at(age).high);
+    }
+    return true;
+}
+
+void candle_series::save(snapshot_writer& out) const
+{
+    out.put(length_us_);
+    out.put(uint64_t(bars_.size()));
+    out.put(uint64_t(count_));
+
+    // Oldest first, so the ring can be loaded into any head position.
+    for (std::size_t age = count_; age-- > 0;)
+    {
+        const candle& bar = at(age);
+        out.put(bar.start_us);
+        out.put(bar.open);
+        out.put(bar.high);
+        out.put(bar.low);
+        out.put(bar.close);
+        out.put(bar.volume);
+        out.put(bar.ticks);
+    }
+}
+
+bool candle_series::load(snapshot_reader& in)
+{
+    int64_t length = 0;
+    uint64_t capacity = 0;
+    uint64_t count = 0;
+
+    if (!in.get(length) || !in.get(capacity) || !in.get(count)) return false;
+    if (length != length_us_ || capacity != bars_.size() || count > capacity) return false;
+
+    std::vector<candle> loaded(bars_.size());
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        candle& bar = loaded[i];
+        if (!in.get(bar.start_us) || !in.get(bar.open) || !in.get(bar.high) || !in.get(bar.low) || !in.get(bar.close) ||
+            !in.get(bar.volume) || !in.get(bar.ticks))
+        {
+            return false;
+        }
+    }
+
+    bars_.swap(loaded);
+    count_ = count;
+    head_ = count ? count - 1 : 0;
+    return true;
+}
+
+candle_aggregator::candle_aggregator(const candle_settings& settings)
+{
+    series_.reserve(std::size_t(candle_resolution::count));
+    series_.emplace_back(candle_length_us(candle_resolution::second), settings.seconds);
+    series_.emplace_back(candle_length_us(candle_resolution::minute), settings.minutes);
+    series_.emplace_back(candle_length_us(candle_resolution::five_minutes), settings.five_minutes);
+    series_.emplace_back(candle_length_us(candle_resolution::hour), settings.hours);
+}
+
+void candle_aggregator::warm_up(const int64_t* times, const double* prices, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i) update(times[i], prices[i]);
+}
+
+const candle* candle_aggregator::last_closed(candle_resolution resolution) const
+{
+    const candle_series& s = series(resolution);
+    return (s.size() < 2) ? nullptr : &s.at(1);
+}
+
+void candle_aggregator::save(snapshot_writer& out) const
+{
+    for (const candle_series& s : series_) s.save(out);
+}
+
+bool candle_aggregator::load(snapshot_reader& in)
+{
+    // Load into copies, so that a mismatch part way through leaves every series as it was.
+    std::vector<candle_series> loaded = series_;
+    for (candle_series& s : loaded)
+    {
+        if (!s.load(in)) return false;
+    }
+    series_.swap(loaded);
+    return true;
+}
+
+}
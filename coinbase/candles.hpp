@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   candles.hpp
+ * Author: Chris Morrison
+ *
+ * Created on 20 October 2026, 04:10
+ */
+#ifndef CANDLES_HPP
+#define CANDLES_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "snapshot.hpp"
+
+// ------------------------------------------------------------------------------------------------
+// Streaming OHLCV candles.
+//
+// One candle_aggregator builds bars at every resolution at once from the ticks a work order sees.
+// Each resolution keeps its most recent bars in a ring sized at construction, so a tick costs a few
+// comparisons per resolution and never allocates. A bar is aligned to a multiple of its resolution
+// since the epoch; a gap with no ticks is filled with flat bars at the last close, so bar n back is
+// always n resolutions ago. The bars can be saved to a snapshot, and rebuilt from a tick file.
+// ------------------------------------------------------------------------------------------------
+
+namespace mercury
+{
+
+/// The resolutions candles are kept at.
+enum class candle_resolution
+{
+    second,
+    minute,
+    five_minutes,
+    hour,
+    count
+};
+
+/// Length of a bar in microseconds.
+int64_t candle_length_us(candle_resolution resolution);
+
+///
+/// One bar.
+struct candle
+{
+    int64_t start_us = 0;   ///< Start of the bar, microseconds since the epoch.
+    double open = 0.0;
+    double high = 0.0;
+    double low = 0.0;
+    double close = 0.0;
+    double volume = 0.0;    ///< Total volume traded, or the number of ticks where sizes are unknown.
+    uint32_t ticks = 0;     ///< Ticks that went into the bar; 0 for a bar that only fills a gap.
+};
+
+///
+/// The most recent bars at one resolution.
+class candle_series
+{
+public:
+    ///
+    /// \param length_us Length of a bar in microseconds.
+    /// \param capacity  Number of bars kept, counting the one still forming.
+    candle_series(int64_t length_us, std::size_t capacity);
+
+    /// Adds a tick. A tick older than the forming bar is counted in the forming bar.
+    void update(int64_t time_us, double price, double volume);
+
+    int64_t length_us() const { return length_us_; }
+    std::size_t capacity() const { return bars_.size(); }
+
+    /// Bars held, counting the one still forming.
+    std::size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+
+    ///
+    /// Returns a bar by age: 0 is the bar still forming, 1 the last closed bar and so on.
+    ///
+    /// \param age Must be less than size().
+    const candle& at(std::size_t age) const
+    {
+        std::size_t n = bars_.size();
+        return bars_[(head_ + n - age) % n];
+    }
+
+    /// Highest high and lowest low over the newest bars, including the one forming; false if empty.
+    bool range(std::size_t bars, double& low, double& high) const;
+
+    void save(snapshot_writer& out) const;
+
+    /// Fails if the series was saved with a different length or capacity.
+    bool load(snapshot_reader& in);
+
+private:
+    void open_bar(int64_t start_us, double price);
+
+    int64_t length_us_;
+    std::vector<candle> bars_;
+    std::size_t head_ = 0;
+    std::size_t count_ = 0;
+};
+
+///
+/// How many bars to keep at each resolution.
+struct candle_settings
+{
+    std::size_t seconds = 120;          ///< Two minutes of 1s bars.
+    std::size_t minutes = 120;          ///< Two hours of 1m bars.
+    std::size_t five_minutes = 96;      ///< Eight hours of 5m bars.
+    std::size_t hours = 48;             ///< Two days of 1h bars.
+};
+
+///
+/// Candles at every resolution for one product.
+class candle_aggregator
+{
+public:
+    explicit candle_aggregator(const candle_settings& settings = candle_settings());
+
+    /// Feeds one tick to every resolution. Without trade sizes, pass a volume of 1.
+    void update(int64_t time_us, double price, double volume = 1.0)
+    {
+        for (candle_series& s : series_) s.update(time_us, price, volume);
+    }
+
+    /// Loads a block of history, oldest first.
+    void warm_up(const int64_t* times, const double* prices, std::size_t n);
+
+    const candle_series& series(candle_resolution resolution) const { return series_[std::size_t(resolution)]; }
+
+    /// The last closed bar at a resolution, or nullptr if no bar has closed yet.
+    const candle* last_closed(candle_resolution resolution) const;
+
+    void save(snapshot_writer& out) const;
+
+    /// Loads every resolution or, if the snapshot does not match the settings, none of them.
+    bool load(snapshot_reader& in);
+
+private:
+    std::vector<candle_series> series_;
+};
+
+}
+
+#endif /* CANDLES_HPP */
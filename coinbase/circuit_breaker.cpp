@@ -0,0 +1,218 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   circuit_breaker.cpp
+ * Author: Chris Morrison
+ *
+ * Created on 20 October 2026, 07:45
+ */
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include "circuit_breaker.hpp"
+
+namespace mercury
+{
+
+using cryptocoin::trading::order_status;
+
+// The fewest calls the breaker judges, and the run of good calls it takes to close again.
+static const unsigned int least_calls = 20;
+
+circuit_breaker::circuit_breaker(const breaker_settings& settings)
+    : settings_(settings), min_calls_(std::min(least_calls, settings.window ? settings.window : 1u)),
+      latencies_(settings.window ? settings.window : 1, 0), failures_(latencies_.size(), 0)
+{
+    sorted_.reserve(latencies_.size());
+}
+
+int64_t circuit_breaker::p99_locked() const
+{
+    // A partial sort of a copy: a window is about a hundred calls, each of which took milliseconds.
+    sorted_.assign(latencies_.begin(), latencies_.begin() + count_);
+    std::size_t rank = (count_ * 99 + 99) / 100 - 1;
+    std::nth_element(sorted_.begin(), sorted_.begin() + rank, sorted_.end());
+    return sorted_[rank];
+}
+
+void circuit_breaker::record(int64_t latency_us, bool failed)
+{
+    bool changed = false;
+    bool now_tripped = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++calls_;
+
+        // While tripped, only an unbroken run of good calls counts towards closing again.
+        if (tripped_ && (failed || (settings_.max_p99_ms > 0.0 && double(latency_us) > settings_.max_p99_ms * 1000.0)))
+        {
+            count_ = 0;
+            next_ = 0;
+            failed_ = 0;
+            return;
+        }
+
+        if (count_ == latencies_.size()) failed_ -= failures_[next_];
+        else ++count_;
+        latencies_[next_] = latency_us;
+        failures_[next_] = failed ? 1 : 0;
+        failed_ += failures_[next_];
+        next_ = (next_ + 1 == latencies_.size()) ? 0 : next_ + 1;
+
+        if (count_ < min_calls_) return;
+
+        bool slow = settings_.max_p99_ms > 0.0 && double(p99_locked()) > settings_.max_p99_ms * 1000.0;
+        bool failing = settings_.max_error_rate > 0.0 && double(failed_) > settings_.max_error_rate * double(count_);
+
+        if (!tripped_ && (slow || failing))
+        {
+            reason_ = slow ? "the exchange is answering too slowly" : "too many calls to the exchange are failing";
+            ++trips_;
+            tripped_ = true;
+            changed = true;
+            now_tripped = true;
+
+            // Recovery is judged only on calls made from now on.
+            count_ = 0;
+            next_ = 0;
+            failed_ = 0;
+        }
+        else if (tripped_ && !slow && !failing)
+        {
+            reason_ = "the exchange has recovered";
+            tripped_ = false;
+            changed = true;
+        }
+    }
+    if (changed && on_change_) on_change_(now_tripped, reason_.c_str());
+}
+
+void circuit_breaker::report(std::ostream& out) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    out << "Circuit breaker: " << (tripped_ ? "tripped, " + reason_ : std::string("closed")) << "; " << calls_ << " calls, "
+        << trips_ << " trips, " << held_back_ << " orders held back." << std::endl;
+    if (count_ == 0) return;
+
+    out << "  Last " << count_ << " calls: " << std::fixed << std::setprecision(1) << (double(p99_locked()) / 1000.0)
+        << " ms p99, " << (100.0 * double(failed_) / double(count_)) << "% failed." << std::endl;
+}
+
+// ------------------------------------------------------------------------------------------------
+// The timed context.
+// ------------------------------------------------------------------------------------------------
+
+template <typename F, typename P>
+auto breaker_context::timed(F call, P failed)
+{
+    auto start = std::chrono::steady_clock::now();
+    auto result = call();
+    auto took = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    breaker_.record(took.count(), failed(result));
+    return result;
+}
+
+static bool empty_text(const std::string& text) { return text.empty(); }
+static bool not_answered(order_status status) { return status == cryptocoin::trading::network_error; }
+static bool not_ok(bool ok) { return !ok; }
+static bool never(long double) { return false; }
+
+std::string breaker_context::fiat_balance()
+{
+    return timed([this]() { return inner_.fiat_balance(); }, empty_text);
+}
+
+std::string breaker_context::coin_balance()
+{
+    return timed([this]() { return inner_.coin_balance(); }, empty_text);
+}
+
+std::string breaker_context::current_price()
+{
+    return timed([this]() { return inner_.current_price(); }, empty_text);
+}
+
+void breaker_context::read_current_price(std::string& out)
+{
+    timed([this, &out]() { inner_.read_current_price(out); return !out.empty(); }, not_ok);
+}
+
+void breaker_context::read_fiat_balance(std::string& out)
+{
+    timed([this, &out]() { inner_.read_fiat_balance(out); return !out.empty(); }, not_ok);
+}
+
+void breaker_context::read_coin_balance(std::string& out)
+{
+    timed([this, &out]() { inner_.read_coin_balance(out); return !out.empty(); }, not_ok);
+}
+
+order_status breaker_context::post_order(cryptocoin::trading::order_side side, cryptocoin::trading::order_type type,
+                                         const std::string& size, const std::string& price, const std::string& funds,
+                                         std::string& out_uuid)
+{
+    if (breaker_.tripped())
+    {
+        breaker_.held_back();
+        out_uuid.clear();
+        return cryptocoin::trading::network_error;
+    }
+    return timed([&]() { return inner_.post_order(side, type, size, price, funds, out_uuid); }, not_answered);
+}
+
+order_status breaker_context::get_order_status(const std::string& uuid)
+{
+    return timed([this, &uuid]() { return inner_.get_order_status(uuid); }, not_answered);
+}
+
+long double breaker_context::sell_price_adjustment()
+{
+    return timed([this]() { return inner_.sell_price_adjustment(); }, never);
+}
+
+long double breaker_context::buy_price_ajustment()
+{
+    return timed([this]() { return inner_.buy_price_ajustment(); }, never);
+}
+
+order_status breaker_context::cancel_order(const std::string& uuid)
+{
+    return timed([this, &uuid]() { return inner_.cancel_order(uuid); }, not_answered);
+}
+
+bool breaker_context::get_order_statuses(const std::vector<std::string>& uuids, std::vector<order_status>& out)
+{
+    return timed([this, &uuids, &out]() { return inner_.get_order_statuses(uuids, out); }, not_ok);
+}
+
+bool breaker_context::get_product_info(product_info& out)
+{
+    return timed([this, &out]() { return inner_.get_product_info(out); }, not_ok);
+}
+
+bool breaker_context::get_fill(const std::string& uuid, order_fill& out)
+{
+    // An order that has not traded has no fill, so only the latency says anything about the exchange.
+    return timed([this, &uuid, &out]() { return inner_.get_fill(uuid, out); }, [](bool) { return false; });
+}
+
+bool breaker_context::get_ticker(ticker& out)
+{
+    return timed([this, &out]() { return inner_.get_ticker(out); }, not_ok);
+}
+
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   circuit_breaker.hpp
+ * Author: Chris Morrison
+ *
+ * Created on 20 October 2026, 07:45
+ */
+#ifndef CIRCUIT_BREAKER_HPP
+#define CIRCUIT_BREAKER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "exchange_context.hpp"
+
+// ------------------------------------------------------------------------------------------------
+// Circuit breaker for a degraded exchange.
+//
+// Every call made to the exchange is timed, and its outcome noted, over a window of the most recent
+// calls of every pair. When the 99th percentile of their latency or the share of them that failed
+// passes its limit, the breaker trips into safe mode: no order is posted, while cancels, status
+// checks and price reads carry on, so resting orders can still be managed but nothing new is priced
+// off data that may be stale. A posted order is answered with network_error, which the trader
+// already backs off from.
+//
+// While tripped, the owner probes the exchange every few seconds (see async_exchange::probe()) so
+// that there are fresh calls to judge it by. The window is emptied when the breaker trips and again
+// on every slow or failed call after that; the breaker closes once 20 calls in a row (or the whole
+// window, if smaller) have been within both limits.
+// ------------------------------------------------------------------------------------------------
+
+namespace mercury
+{
+
+///
+/// When the breaker trips. Each limit is off when zero.
+struct breaker_settings
+{
+    double max_p99_ms = 0.0;        ///< Slowest the 99th percentile of call latency may be, in milliseconds.
+    double max_error_rate = 0.0;    ///< Largest share of calls that may fail, as a fraction.
+    unsigned int window = 100;      ///< Number of recent calls judged.
+    unsigned int probe_seconds = 5; ///< Time between probes while tripped.
+
+    bool enabled() const { return max_p99_ms > 0.0 || max_error_rate > 0.0; }
+};
+
+/// Called with true and the reason when the breaker trips, and with false when it closes again.
+typedef void (*breaker_callback)(bool tripped, const char* why);
+
+///
+/// The latency and error measurements of every call to the exchange, and the state they put the
+/// breaker in. Shared by the breaker contexts of every pair; safe to use from any thread.
+class circuit_breaker
+{
+public:
+    explicit circuit_breaker(const breaker_settings& settings);
+
+    /// \param on_change Told whenever the breaker trips or closes; may be nullptr.
+    void set_alert(breaker_callback on_change) { on_change_ = on_change; }
+
+    const breaker_settings& settings() const { return settings_; }
+
+    /// True while in safe mode.
+    bool tripped() const { return tripped_; }
+
+    ///
+    /// Adds a call to the window and trips or closes the breaker as the window now calls for.
+    ///
+    /// \param latency_us How long the call took.
+    /// \param failed     Whether it failed to reach the exchange or get an answer.
+    void record(int64_t latency_us, bool failed);
+
+    /// Counts an order kept back while tripped.
+    void held_back() { ++held_back_; }
+
+    /// Prints the state, the window's latency and error rate and how often the breaker has tripped.
+    void report(std::ostream& out) const;
+
+private:
+    /// The 99th percentile latency of the calls in the window, in microseconds.
+    int64_t p99_locked() const;
+
+    breaker_settings settings_;
+    unsigned int min_calls_;
+    breaker_callback on_change_ = nullptr;
+
+    mutable std::mutex mutex_;
+    std::atomic<bool> tripped_{ false };
+    std::vector<int64_t> latencies_;
+    std::vector<uint8_t> failures_;
+    mutable std::vector<int64_t> sorted_;
+    std::size_t next_ = 0;
+    std::size_t count_ = 0;
+    unsigned int failed_ = 0;
+    std::string reason_;
+    uint64_t calls_ = 0;
+    uint64_t trips_ = 0;
+    std::atomic<uint64_t> held_back_{ 0 };
+};
+
+///
+/// Exchange context that times every call made through it for a circuit breaker, and holds back
+/// orders while the breaker is tripped. Like any context, it is called by one thread at a time.
+class breaker_context : public exchange_context
+{
+public:
+    ///
+    /// \param inner   The context that makes the calls; it must outlive this object.
+    /// \param breaker The breaker to feed; it must outlive this object.
+    breaker_context(exchange_context& inner, circuit_breaker& breaker) : inner_(inner), breaker_(breaker) {}
+
+    std::string fiat_balance() override;
+    std::string coin_balance() override;
+    std::string current_price() override;
+    void read_current_price(std::string& out) override;
+    void read_fiat_balance(std::string& out) override;
+    void read_coin_balance(std::string& out) override;
+
+    cryptocoin::trading::order_status post_order(cryptocoin::trading::order_side side, cryptocoin::trading::order_type type,
+                                                 const std::string& size, const std::string& price, const std::string& funds,
+                                                 std::string& out_uuid) override;
+    cryptocoin::trading::order_status get_order_status(const std::string& uuid) override;
+    long double sell_price_adjustment() override;
+    long double buy_price_ajustment() override;
+
+    cryptocoin::trading::order_status cancel_order(const std::string& uuid) override;
+    bool get_order_statuses(const std::vector<std::string>& uuids, std::vector<cryptocoin::trading::order_status>& out) override;
+    bool get_product_info(product_info& out) override;
+    bool get_fill(const std::string& uuid, order_fill& out) override;
+    bool get_ticker(ticker& out) override;
+
+private:
+    /// Makes a call, timing it, and feeds the breaker; failed says from its result whether it failed.
+    template <typename F, typename P>
+    auto timed(F call, P failed);
+
+    exchange_context& inner_;
+    circuit_breaker& breaker_;
+};
+
+}
+
+#endif /* CIRCUIT_BREAKER_HPP */
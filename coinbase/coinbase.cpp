@@ -24,33 +24,178 @@
 #include <string>
 #include <cstdlib>
 #include <ctime>
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <chrono>
 #include <filesystem>
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/signal_set.hpp>
+#include <boost/asio/thread_pool.hpp>
 #include <boost/thread/thread.hpp>
 #include <tclap/CmdLine.h>
 #include <pushbullet.hpp>
-#include <coinbase.hpp>
 #include <alsa/asoundlib.h>
 #include <sndfile.h>
+#include "async_exchange.hpp"
+#include "circuit_breaker.hpp"
+#include "coinbase_context.hpp"
+#include "execution.hpp"
+#include "exit_engine.hpp"
+#include "fixed_point.hpp"
+#include "ledger.hpp"
+#include "market_bus.hpp"
+#include "paper_context.hpp"
+#include "plugin_host.hpp"
+#include "portfolio.hpp"
+#include "profiler.hpp"
+#include "request_scheduler.hpp"
+#include "risk_engine.hpp"
+#include "session_recording.hpp"
+#include "state_snapshots.hpp"
+#include "strategy.hpp"
+#include "task.hpp"
+#include "tick_store.hpp"
+#include "trader.hpp"
+#include "worker_health.hpp"
 
 void play_sound(const std::string& sound_file);
 
 static boost::mutex mtx;
-static long double fiat_percent = 0;
-static std::string work_order_path;
-static std::fstream work_order_file;
-static std::string coin;
-static std::string fiat;
-static std::string action;
+static mercury::trader_settings settings;
+static std::vector<std::string> work_order_paths;
+static unsigned int pool_threads = 1;
+static double request_rate = 5.0;
+static double request_burst = 10.0;
+static std::string tick_path;
+static std::string bus_name;
+static std::string ledger_path;
+static std::string snapshot_path;
+static unsigned int snapshot_seconds = 60;
+static std::string profile_path;
+static std::string volume_profile_path;
+static std::string health_path;
+static bool paper = false;
+static double paper_fiat = 1000.0;
+static double paper_coin = 0.0;
+static std::string paper_replay_path;
+static mercury::paper_settings paper_settings;
+static mercury::paper_account paper_account;
+static std::string record_session_path;
+static std::string replay_session_path;
+static mercury::session_recorder session_recorder;
+static mercury::session_player session_player;
+static mercury::portfolio portfolio;
+static mercury::risk_limits risk_limits;
+static std::unique_ptr<mercury::risk_engine> risk;
+static std::atomic<bool> kill_cancel_due{ false };
+static mercury::breaker_settings breaker_settings;
+static std::unique_ptr<mercury::circuit_breaker> breaker;
 static communications::messaging::pushbullet message_dispatcher;
+static mercury::tick_store_writer tick_recorder;
+static mercury::market_bus_reader market_bus;
+static mercury::trade_ledger ledger;
+static mercury::state_profiler profiler;
+static mercury::plugin_host plugins;
+static mercury::volume_profile volume_profile;
+static std::unique_ptr<mercury::request_scheduler> scheduler;
+static mercury::health_reporter health;
+static mercury::async_exchange::timer* health_wait = nullptr;
+static mercury::async_exchange::timer* probe_wait = nullptr;
+static unsigned int robots_running = 0;
+
+// Prices on the market bus older than this are ignored in favour of asking the exchange.
+static const std::chrono::seconds bus_max_age(10);
+
+// How often new ticks on the market bus are read.
+static const std::chrono::milliseconds bus_check_interval(5);
+
+// How often a health report is sent to the supervisor.
+static const std::chrono::seconds health_interval(1);
 
 void print_change_update(long double up, long double down);
-bool execute_trade(cryptocoin::trading::trade_context& context);
+void announce_fill(cryptocoin::trading::order_side side);
+void warm_up_history(const std::string& tick_file, mercury::market_indicators& indicators, mercury::candle_aggregator& candles);
+void report_positions();
+void report_profile();
+void report_requests();
+void report_portfolio();
+void report_risk();
+void report_breaker();
+void alert_breaker(bool tripped, const char* why);
+void alert_rejected(const std::string& pair, const char* what);
+void alert_killed(const std::string& pair, const char* what);
+mercury::task<void> run_robot(mercury::trader& robot, mercury::async_exchange& exchange, boost::asio::signal_set& signals,
+                              mercury::state_snapshots* snapshots);
 
-int main(int argc, char** argv)
+///
+/// One trading pair: its exchange connection, the awaitable front end and the exits that every work
+/// order on the pair shares. When paper trading, the front end drives a fill simulator that only takes
+/// market data from the connection; when replaying a session, it is answered from the recording and the
+/// connection is never used. With a circuit breaker, every call that reaches the answering context is
+/// timed. When recording, every call made by the front end goes into the session file. With risk limits
+/// set, every order is checked before it goes any further.
+struct market
 {
-    std::vector<std::string> strs;
-    std::string next_op;
+    market(const std::string& credentials, const std::string& coin, const std::string& fiat,
+           boost::asio::io_context& io, boost::asio::thread_pool& pool)
+        : context(credentials, coin, fiat, print_change_update),
+          player(session_player.is_open() ? std::make_unique<mercury::replay_context>(session_player, coin + "-" + fiat) : nullptr),
+          simulator(paper ? std::make_unique<mercury::paper_context>(context, paper_account, coin, fiat, paper_settings) : nullptr),
+          breaker_checks(breaker ? std::make_unique<mercury::breaker_context>(source(), *breaker) : nullptr),
+          recorder(session_recorder.is_open()
+                       ? std::make_unique<mercury::recording_context>(measured(), session_recorder, coin + "-" + fiat) : nullptr),
+          risk_checks(risk ? std::make_unique<mercury::risk_context>(recorded(), *risk, coin + "-" + fiat) : nullptr),
+          exchange(front(), io, &pool)
+    {
+    }
+
+    /// The context that answers the calls: the exchange, the fill simulator or a recorded session.
+    mercury::exchange_context& source()
+    {
+        if (player) return *player;
+        if (simulator) return *simulator;
+        return context;
+    }
+
+    /// The context that answers the calls, timing them for the circuit breaker if there is one.
+    mercury::exchange_context& measured()
+    {
+        return breaker_checks ? static_cast<mercury::exchange_context&>(*breaker_checks) : source();
+    }
+
+    /// The context that answers the calls, recording them if asked to.
+    mercury::exchange_context& recorded() { return recorder ? static_cast<mercury::exchange_context&>(*recorder) : measured(); }
+
+    /// The context the calls are made on.
+    mercury::exchange_context& front() { return risk_checks ? static_cast<mercury::exchange_context&>(*risk_checks) : recorded(); }
+
+    mercury::coinbase_context context;
+    std::unique_ptr<mercury::replay_context> player;
+    std::unique_ptr<mercury::paper_context> simulator;
+    std::unique_ptr<mercury::breaker_context> breaker_checks;
+    std::unique_ptr<mercury::recording_context> recorder;
+    std::unique_ptr<mercury::risk_context> risk_checks;
+    mercury::async_exchange exchange;
+    mercury::exit_engine exits;
+    bool on_bus = false;
+    uint32_t bus_index = 0;
+};
+
+mercury::task<void> watch_bus(boost::asio::io_context& io, std::map<std::string, std::unique_ptr<market>>& markets);
+mercury::task<void> report_health(boost::asio::io_context& io);
+mercury::task<void> probe_exchange(boost::asio::io_context& io, std::map<std::string, std::unique_ptr<market>>& markets);
+bool open_paper_account(market& pair_market, const std::string& coin, const std::string& fiat);
+void watch_signals(boost::asio::signal_set& signals, boost::asio::io_context& io, std::map<std::string, std::unique_ptr<market>>& markets);
+mercury::task<void> cancel_resting_orders(std::map<std::string, std::unique_ptr<market>>& markets);
+void end_replay();
 
+int main(int argc, char** argv)
+{
     // --------------------------------------------------------------------------------------------
     // Get the command line arguments.
     // --------------------------------------------------------------------------------------------
@@ -68,27 +213,263 @@ int main(int argc, char** argv)
         // Define a value argument and add it to the command line.
         // A value arg defines a flag and a type of value that it expects,
         // such as "-n Bishop".
-        TCLAP::ValueArg<std::string> name_arg("f", "work-order-file", "Full path of the work order file.", true, "", "file path");
+        TCLAP::MultiArg<std::string> name_arg("f", "work-order-file", "Full path of a work order file; give it once for every work order to run.", true, "file path");
         cmd.add(name_arg);
-        TCLAP::ValueArg<unsigned int> percent_arg("p", "percent-of-balance", "The percentage of the fiat balance to use for trades (default: 100%)", false, 100, "number");
+        TCLAP::ValueArg<unsigned int> percent_arg("p", "percent-of-balance", "The percentage of the fiat balance (or with --weight, of the pair's share of it) to use for trades (default: 100%)", false, 100, "number");
         cmd.add(percent_arg);
+        TCLAP::ValueArg<std::string> record_arg("r", "record-ticks", "Record every price seen to the given compressed tick file.", false, "", "file path");
+        cmd.add(record_arg);
+        TCLAP::ValueArg<double> chase_arg("c", "chase-percent", "Cancel and re-price a resting order once the market is this many percent away from it (default: 0, never)", false, 0, "number");
+        cmd.add(chase_arg);
+        TCLAP::ValueArg<std::string> strategy_arg("", "strategy", "Strategy for work orders that do not name one: classic, patient, plain or a plugin's (default: classic)", false, mercury::default_strategy, "name");
+        cmd.add(strategy_arg);
+        TCLAP::MultiArg<std::string> plugin_arg("", "plugin", "Load a strategy plugin (shared library); SIGHUP reloads every plugin.", false, "file path");
+        cmd.add(plugin_arg);
+        TCLAP::ValueArg<double> stop_loss_arg("", "stop-loss", "Sell at the market once the price is this many percent below the buy (default: 0, never)", false, 0, "number");
+        cmd.add(stop_loss_arg);
+        TCLAP::ValueArg<double> trail_arg("", "trail", "Sell at the market once the price is this many percent below its high since trailing began (default: 0, never)", false, 0, "number");
+        cmd.add(trail_arg);
+        TCLAP::ValueArg<double> trail_from_arg("", "trail-from", "Start trailing once the price is this many percent above the buy (default: 0)", false, 0, "number");
+        cmd.add(trail_from_arg);
+        TCLAP::ValueArg<unsigned int> max_hold_arg("", "max-hold", "Sell at the market once coin has been held this many minutes (default: 0, no limit)", false, 0, "number");
+        cmd.add(max_hold_arg);
+        TCLAP::ValueArg<unsigned int> check_arg("i", "check-interval", "Minutes between checks on a resting order (default: 10)", false, 10, "number");
+        cmd.add(check_arg);
+        TCLAP::ValueArg<std::string> bus_arg("b", "market-bus", "Read prices from the market bus published by mercury-feed under this name.", false, "", "name");
+        cmd.add(bus_arg);
+        TCLAP::ValueArg<std::string> ledger_arg("l", "ledger", "Append every fill to this trade ledger and keep P&L from it.", false, "", "file path");
+        cmd.add(ledger_arg);
+        TCLAP::ValueArg<std::string> basis_arg("", "cost-basis", "How the ledger costs coin sold: fifo or average (default: fifo)", false, "fifo", "method");
+        cmd.add(basis_arg);
+        TCLAP::ValueArg<std::string> snapshot_arg("s", "snapshot", "Keep a snapshot of the runtime state in this file and resume from it on start-up.", false, "", "file path");
+        cmd.add(snapshot_arg);
+        TCLAP::ValueArg<unsigned int> snapshot_interval_arg("", "snapshot-interval", "Seconds between snapshots (default: 60)", false, 60, "number");
+        cmd.add(snapshot_interval_arg);
+        TCLAP::ValueArg<std::string> profile_arg("", "profile", "Trace the time spent in every state and wait to this file (Chrome trace format) and report it.", false, "", "file path");
+        cmd.add(profile_arg);
+        TCLAP::ValueArg<std::string> volume_profile_arg("", "volume-profile", "Weight VWAP slices by the 24 hourly volumes (UTC) in this file (default: flat).", false, "", "file path");
+        cmd.add(volume_profile_arg);
+        TCLAP::ValueArg<unsigned int> threads_arg("t", "exchange-threads", "Threads used to make calls to the exchange (default: 1)", false, 1, "number");
+        cmd.add(threads_arg);
+        TCLAP::ValueArg<double> rate_arg("", "request-rate", "Most requests per second sent to the exchange, over every work order; orders and cancels go first (default: 5, 0 for no limit)", false, 5, "number");
+        cmd.add(rate_arg);
+        TCLAP::ValueArg<double> burst_arg("", "request-burst", "Requests that may be sent at once after a quiet spell (default: 10)", false, 10, "number");
+        cmd.add(burst_arg);
+        TCLAP::ValueArg<std::string> health_arg("", "health-socket", "Send a health report every second to the supervisor listening on this socket.", false, "", "file path");
+        cmd.add(health_arg);
+        TCLAP::SwitchArg paper_arg("", "paper", "Paper trade: simulate the orders and the account against the live prices, risking nothing.");
+        cmd.add(paper_arg);
+        TCLAP::ValueArg<double> paper_fiat_arg("", "paper-fiat", "Fiat balance the simulated account starts with (default: 1000)", false, 1000, "number");
+        cmd.add(paper_fiat_arg);
+        TCLAP::ValueArg<double> paper_coin_arg("", "paper-coin", "Coin balance the simulated account starts with (default: 0)", false, 0, "number");
+        cmd.add(paper_coin_arg);
+        TCLAP::ValueArg<double> maker_fee_arg("", "paper-maker-fee", "Fee on simulated fills of resting orders, percent (default: 0.15)", false, 0.15, "number");
+        cmd.add(maker_fee_arg);
+        TCLAP::ValueArg<double> taker_fee_arg("", "paper-taker-fee", "Fee on simulated orders that cross the market, percent (default: 0.25)", false, 0.25, "number");
+        cmd.add(taker_fee_arg);
+        TCLAP::ValueArg<double> queue_arg("", "paper-queue", "Size resting ahead of a simulated order at its price, as a multiple of its size (default: 1)", false, 1, "number");
+        cmd.add(queue_arg);
+        TCLAP::ValueArg<std::string> replay_arg("", "paper-replay", "Paper trade against the prices in this tick file, played back in real time, instead of the live ones.", false, "", "file path");
+        cmd.add(replay_arg);
+        TCLAP::MultiArg<std::string> weight_arg("", "weight", "Run the pairs as a portfolio with this target weight for a pair, e.g. BTC-EUR=60; give it once for every pair traded.", false, "pair=weight");
+        cmd.add(weight_arg);
+        TCLAP::ValueArg<std::string> record_session_arg("", "record-session", "Record every call to the exchange, with its results and timing, to this session file.", false, "", "file path");
+        cmd.add(record_session_arg);
+        TCLAP::ValueArg<std::string> replay_session_arg("", "replay-session", "Answer every call to the exchange from this recorded session file, as fast as possible, instead of trading.", false, "", "file path");
+        cmd.add(replay_session_arg);
+        TCLAP::ValueArg<double> price_band_arg("", "max-price-deviation", "Reject orders priced further than this from the last price, percent (default: 0, no limit)", false, 0, "number");
+        cmd.add(price_band_arg);
+        TCLAP::ValueArg<double> notional_arg("", "max-notional", "Reject orders worth more than this, in fiat (default: 0, no limit)", false, 0, "number");
+        cmd.add(notional_arg);
+        TCLAP::ValueArg<unsigned int> open_orders_arg("", "max-open-orders", "Reject orders once this many are resting over every pair (default: 0, no limit)", false, 0, "number");
+        cmd.add(open_orders_arg);
+        TCLAP::ValueArg<unsigned int> order_rate_arg("", "max-orders-per-minute", "Reject orders once this many have been posted in the last minute over every pair (default: 0, no limit)", false, 0, "number");
+        cmd.add(order_rate_arg);
+        TCLAP::ValueArg<double> daily_loss_arg("", "max-daily-loss", "Stop posting and cancel every resting order once the loss since midnight (UTC) passes this, in fiat (default: 0, no limit)", false, 0, "number");
+        cmd.add(daily_loss_arg);
+        TCLAP::ValueArg<double> breaker_latency_arg("", "breaker-p99-ms", "Stop posting orders while the 99th percentile latency of recent calls to the exchange is over this, in milliseconds (default: 0, no limit)", false, 0, "number");
+        cmd.add(breaker_latency_arg);
+        TCLAP::ValueArg<double> breaker_errors_arg("", "breaker-error-rate", "Stop posting orders while more than this share of recent calls to the exchange fail, percent (default: 0, no limit)", false, 0, "number");
+        cmd.add(breaker_errors_arg);
+        TCLAP::ValueArg<unsigned int> breaker_window_arg("", "breaker-window", "Number of recent calls to the exchange the circuit breaker judges (default: 100)", false, 100, "number");
+        cmd.add(breaker_window_arg);
+        TCLAP::ValueArg<unsigned int> breaker_probe_arg("", "breaker-probe-seconds", "Time between probes of the exchange while the circuit breaker is tripped (default: 5)", false, 5, "seconds");
+        cmd.add(breaker_probe_arg);
 
         // Parse the argv array.
         cmd.parse(argc, argv);
 
         // Get the value parsed by each arg.
-        work_order_path = name_arg.getValue();
+        work_order_paths = name_arg.getValue();
         unsigned int pc = percent_arg.getValue();
         if (pc < 10)
         {
             std::cerr << "Invalid value for '--percent-of-balance,' at least 10% of your fiat balance must be used." << std::endl;
             return 1;
         }
-        fiat_percent = pc / 100.00;
+        settings.fiat_percent = pc / 100.00;
+
+        if (chase_arg.getValue() < 0 || chase_arg.getValue() >= 100)
+        {
+            std::cerr << "Invalid value for '--chase-percent,' the value must be between 0 and 100." << std::endl;
+            return 1;
+        }
+        settings.chase_fraction = chase_arg.getValue() / 100.00;
+
+        for (const std::string& path : plugin_arg.getValue())
+        {
+            std::string error;
+            if (!plugins.load(path, error))
+            {
+                std::cerr << "Invalid value for '--plugin,' " << error << "." << std::endl;
+                return 1;
+            }
+        }
+
+        settings.strategy_name = strategy_arg.getValue();
+        if (!mercury::find_strategy(settings.strategy_name.c_str()) && !plugins.has(settings.strategy_name.c_str()))
+        {
+            std::cerr << "Invalid value for '--strategy,' the strategies are:" << std::endl;
+            mercury::list_strategies(std::cerr);
+            return 1;
+        }
 
-        if (work_order_path.empty() || !std::filesystem::exists(work_order_path))
+        if (stop_loss_arg.getValue() < 0 || stop_loss_arg.getValue() >= 100)
         {
-            std::cerr << "Invalid value for '--work-order-file,' a valid path to an existing file must be given." << std::endl;
+            std::cerr << "Invalid value for '--stop-loss,' the value must be between 0 and 100." << std::endl;
+            return 1;
+        }
+        if (trail_arg.getValue() < 0 || trail_arg.getValue() >= 100)
+        {
+            std::cerr << "Invalid value for '--trail,' the value must be between 0 and 100." << std::endl;
+            return 1;
+        }
+        if (trail_from_arg.getValue() < 0)
+        {
+            std::cerr << "Invalid value for '--trail-from,' the value must not be negative." << std::endl;
+            return 1;
+        }
+        settings.exits.stop_loss = stop_loss_arg.getValue() / 100.00;
+        settings.exits.trail = trail_arg.getValue() / 100.00;
+        settings.exits.trail_from = trail_from_arg.getValue() / 100.00;
+        settings.exits.max_hold_us = int64_t(max_hold_arg.getValue()) * 60 * 1000000;
+
+        settings.check_minutes = check_arg.getValue();
+        if (settings.check_minutes < 1)
+        {
+            std::cerr << "Invalid value for '--check-interval,' the interval must be at least 1 minute." << std::endl;
+            return 1;
+        }
+
+        for (const std::string& path : work_order_paths)
+        {
+            if (path.empty() || !std::filesystem::exists(path))
+            {
+                std::cerr << "Invalid value for '--work-order-file,' a valid path to an existing file must be given." << std::endl;
+                return 1;
+            }
+        }
+
+        pool_threads = threads_arg.getValue();
+        if (pool_threads < 1)
+        {
+            std::cerr << "Invalid value for '--exchange-threads,' at least 1 thread must be used." << std::endl;
+            return 1;
+        }
+
+        request_rate = rate_arg.getValue();
+        request_burst = burst_arg.getValue();
+        if (request_rate < 0 || (request_rate > 0 && request_burst < 1))
+        {
+            std::cerr << "Invalid value for '--request-rate' or '--request-burst,' the rate must not be negative and the burst must be at least 1." << std::endl;
+            return 1;
+        }
+
+        tick_path = record_arg.getValue();
+        bus_name = bus_arg.getValue();
+        ledger_path = ledger_arg.getValue();
+        snapshot_path = snapshot_arg.getValue();
+        snapshot_seconds = snapshot_interval_arg.getValue();
+        profile_path = profile_arg.getValue();
+        volume_profile_path = volume_profile_arg.getValue();
+        health_path = health_arg.getValue();
+
+        paper = paper_arg.getValue();
+        paper_fiat = paper_fiat_arg.getValue();
+        paper_coin = paper_coin_arg.getValue();
+        paper_settings.maker_fee = maker_fee_arg.getValue() / 100.00;
+        paper_settings.taker_fee = taker_fee_arg.getValue() / 100.00;
+        paper_settings.queue_ahead = queue_arg.getValue();
+        paper_replay_path = replay_arg.getValue();
+        if (paper_fiat < 0 || paper_coin < 0 || paper_settings.maker_fee < 0 || paper_settings.taker_fee < 0 || paper_settings.queue_ahead < 0)
+        {
+            std::cerr << "Invalid value for a '--paper-' option, balances, fees and the queue must not be negative." << std::endl;
+            return 1;
+        }
+        if (!paper_replay_path.empty() && (!paper || work_order_paths.size() > 1))
+        {
+            std::cerr << "Invalid value for '--paper-replay,' a tick file can only be played back when paper trading a single work order." << std::endl;
+            return 1;
+        }
+        for (const std::string& weight : weight_arg.getValue())
+        {
+            if (!portfolio.add_pair(weight))
+            {
+                std::cerr << "Invalid value for '--weight,' " << weight << " is not a new pair and a positive weight, e.g. BTC-EUR=60." << std::endl;
+                return 1;
+            }
+        }
+
+        risk_limits.price_band = price_band_arg.getValue() / 100.00;
+        risk_limits.max_notional = notional_arg.getValue();
+        risk_limits.max_open_orders = open_orders_arg.getValue();
+        risk_limits.max_orders_per_minute = order_rate_arg.getValue();
+        risk_limits.max_daily_loss = daily_loss_arg.getValue();
+        if (risk_limits.price_band < 0 || risk_limits.max_notional < 0 || risk_limits.max_daily_loss < 0)
+        {
+            std::cerr << "Invalid value for a risk limit, '--max-price-deviation,' '--max-notional' and '--max-daily-loss' must not be negative." << std::endl;
+            return 1;
+        }
+
+        breaker_settings.max_p99_ms = breaker_latency_arg.getValue();
+        breaker_settings.max_error_rate = breaker_errors_arg.getValue() / 100.00;
+        breaker_settings.window = breaker_window_arg.getValue();
+        breaker_settings.probe_seconds = breaker_probe_arg.getValue();
+        if (breaker_settings.max_p99_ms < 0 || breaker_settings.max_error_rate < 0 || breaker_settings.max_error_rate >= 1 ||
+            breaker_settings.window == 0 || breaker_settings.probe_seconds == 0)
+        {
+            std::cerr << "Invalid value for a '--breaker-' option, the limits must not be negative, the error rate must be under 100% and the window and probe time must be at least 1." << std::endl;
+            return 1;
+        }
+
+        record_session_path = record_session_arg.getValue();
+        replay_session_path = replay_session_arg.getValue();
+        if (!replay_session_path.empty() && (paper || !record_session_path.empty()))
+        {
+            std::cerr << "Invalid value for '--replay-session,' a recorded session cannot be replayed while paper trading or recording." << std::endl;
+            return 1;
+        }
+        if ((!record_session_path.empty() || !replay_session_path.empty()) && !bus_name.empty())
+        {
+            std::cerr << "Invalid value for '--market-bus,' prices read from the bus do not go through the session file." << std::endl;
+            return 1;
+        }
+        if (snapshot_seconds < 1)
+        {
+            std::cerr << "Invalid value for '--snapshot-interval,' snapshots must be at least 1 second apart." << std::endl;
+            return 1;
+        }
+
+        mercury::cost_basis basis;
+        if (!mercury::parse_cost_basis(basis_arg.getValue(), basis))
+        {
+            std::cerr << "Invalid value for '--cost-basis,' the method must be fifo or average." << std::endl;
+            return 1;
+        }
+        ledger = mercury::trade_ledger(basis);
+        if (!tick_path.empty() && work_order_paths.size() > 1)
+        {
+            std::cerr << "Invalid value for '--record-ticks,' ticks can only be recorded when running a single work order." << std::endl;
             return 1;
         }
     }
@@ -134,75 +515,287 @@ int main(int argc, char** argv)
 
     std::cout << "DONE" << std::endl;
 
-    std::cout << utilities::timestamp() << " Opening work order file...       ";
+    // Create our trading contexts, one for each pair traded.
+    std::stringstream init_string;
+    init_string << "ee3f2635939845af5e1db506109aeeb6" << ":";
+    init_string << "v3ty5dro4zq" << ":";
+    init_string << "pSVf+fsikQrnc5UxlKxCQ15zBj68+UFoZE4v/9LFHiBiGsfLrDApu2YQyseAkl+IXhba/ihCmNrhqpM/Zdi3NQ==";
 
-    // Verify that the work order file exists and is accessible.
-    work_order_file.open(work_order_path, std::ios::in | std::ios::out);
-    if (!work_order_file)
+    if (!bus_name.empty())
     {
-        std::cout << "FAILED: " << strerror(errno) << std::endl;
-        mtx.lock();
-        std::cout << utilities::timestamp() << " Fatal error: failed to open the work order file: " << strerror(errno) << std::endl;
-        mtx.unlock();
+        std::cout << utilities::timestamp() << " Attaching to the market bus...   ";
+        if (!market_bus.open(bus_name))
+        {
+            std::cout << "FAILED" << std::endl;
+            std::cerr << "Invalid value for '--market-bus,' no market bus of that name is being published." << std::endl;
+            return 1;
+        }
+        std::cout << "DONE" << std::endl;
+    }
+
+    if (!ledger_path.empty())
+    {
+        std::cout << utilities::timestamp() << " Opening trade ledger...          ";
+        if (!ledger.open(ledger_path))
+        {
+            std::cout << "FAILED" << std::endl;
+            return 1;
+        }
+        std::cout << "DONE" << std::endl;
+    }
+
+    if (!volume_profile_path.empty())
+    {
+        std::cout << utilities::timestamp() << " Loading volume profile...        ";
+        if (!volume_profile.load(volume_profile_path))
+        {
+            std::cout << "FAILED" << std::endl;
+            return 1;
+        }
+        std::cout << "DONE" << std::endl;
+    }
+
+    if (!health_path.empty() && !health.open(health_path))
+    {
+        std::cerr << "Invalid value for '--health-socket,' the path is too long for a socket." << std::endl;
         return 1;
     }
-    else
+
+    if (!profile_path.empty())
     {
+        std::cout << utilities::timestamp() << " Opening profile trace...         ";
+        if (!profiler.open(profile_path))
+        {
+            std::cout << "FAILED" << std::endl;
+            return 1;
+        }
         std::cout << "DONE" << std::endl;
     }
 
-    // Read out the contents of the work order file.
-    work_order_file >> next_op;
-    work_order_file.clear(); // Make sure we are not EOF.
-    work_order_file.seekg(0, std::ios::beg);
+    if (!record_session_path.empty())
+    {
+        std::cout << utilities::timestamp() << " Opening session recording...     ";
+        if (!session_recorder.open(record_session_path))
+        {
+            std::cout << "FAILED" << std::endl;
+            return 1;
+        }
+        std::cout << "DONE" << std::endl;
+    }
 
-    if (next_op.empty())
+    if (!replay_session_path.empty())
     {
-        mtx.lock();
-        std::cout << utilities::timestamp() << " Fatal error: no instructions could be found in the work order file." << std::endl;
-        mtx.unlock();
+        std::cout << utilities::timestamp() << " Loading recorded session...      ";
+        if (!session_player.open(replay_session_path))
+        {
+            std::cout << "FAILED" << std::endl;
+            std::cerr << "Invalid value for '--replay-session,' the file could not be read or is not a session file." << std::endl;
+            return 1;
+        }
+        std::cout << "DONE" << std::endl;
+        if (session_player.work_orders() != work_order_paths.size())
+        {
+            std::cerr << "Invalid value for '--work-order-file,' the session was recorded with " << session_player.work_orders()
+                      << " work orders." << std::endl;
+            return 1;
+        }
+        session_player.set_end(end_replay);
+    }
 
-        return 1;
+    // Every work order runs as a coroutine on this one thread; only the blocking calls to the exchange
+    // are handed to the pool.
+    boost::asio::io_context io;
+    boost::asio::thread_pool pool(pool_threads);
+    std::map<std::string, std::unique_ptr<market>> markets;
+    std::vector<std::unique_ptr<mercury::trader>> robots;
+
+    // One scheduler for every market, since the exchange limits the requests made with the key as a whole.
+    // A replay is not throttled, since nothing is sent to the exchange.
+    if (request_rate > 0 && !session_player.is_open())
+        scheduler = std::make_unique<mercury::request_scheduler>(io, request_rate, request_burst);
+
+    // Nothing is sent to the exchange during a replay, so there is nothing for the circuit breaker to judge.
+    if (breaker_settings.enabled() && !session_player.is_open())
+    {
+        breaker = std::make_unique<mercury::circuit_breaker>(breaker_settings);
+        breaker->set_alert(alert_breaker);
     }
 
-    // Get the information from the instruction in the file.
+    if (risk_limits.enabled())
+    {
+        risk = std::make_unique<mercury::risk_engine>(risk_limits);
+        risk->set_alerts(alert_rejected, alert_killed);
+    }
+
+    // SIGUSR1 prints the positions, the profile, the request throttling, the portfolio, the risk checks and the circuit
+    // breaker, SIGHUP reloads the plugins, SIGUSR2 trips the kill switch; SIGINT and SIGTERM stop trading.
+    boost::asio::signal_set signals(io, SIGINT, SIGTERM, SIGUSR1);
+    signals.add(SIGHUP);
+    signals.add(SIGUSR2);
+    watch_signals(signals, io, markets);
 
-    boost::split(strs, next_op, boost::is_any_of(":"));
-    if (strs.size() != 5)
+    std::unique_ptr<mercury::state_snapshots> snapshots;
+    if (!snapshot_path.empty()) snapshots = std::make_unique<mercury::state_snapshots>(snapshot_path, io, pool, std::chrono::seconds(snapshot_seconds));
+
+    for (const std::string& path : work_order_paths)
     {
-        mtx.lock();
-        std::cout << utilities::timestamp() << " Fatal error: the work order file did not contain the expected information and may be corrupted or damaged." << std::endl;
-        mtx.unlock();
+        std::cout << utilities::timestamp() << " Opening work order file...       ";
 
-        return 1;
+        auto robot = std::make_unique<mercury::trader>(settings, mtx);
+        robot->set_plugins(&plugins);
+        if (!robot->open(path))
+        {
+            std::cout << "FAILED" << std::endl;
+            return 1;
+        }
+        std::cout << "DONE" << std::endl;
+
+        // A replay only follows the recording if every work order starts where it did.
+        char line[256];
+        robot->current().format(line, sizeof(line));
+        if (session_recorder.is_open()) session_recorder.add_work_order(line);
+        if (session_player.is_open())
+        {
+            const std::string& recorded = session_player.work_order(robots.size());
+            if (recorded != line)
+            {
+                std::cerr << "Invalid value for '--work-order-file,' " << path << " must hold " << recorded << " to replay the session." << std::endl;
+                return 1;
+            }
+            robot->skip_waits();
+        }
+
+        std::string coin(robot->current().coin);
+        std::string fiat(robot->current().fiat);
+        std::string pair = coin + "-" + fiat;
+
+        if (!tick_path.empty())
+        {
+            // Prices recorded by earlier runs give the market indicators and candles a head start.
+            warm_up_history(tick_path, robot->indicators(), robot->candles());
+            if (!tick_recorder.open(tick_path))
+            {
+                std::cerr << "Invalid value for '--record-ticks,' the file could not be opened or is not a tick file." << std::endl;
+                return 1;
+            }
+            robot->set_tick_recorder(&tick_recorder);
+        }
+        robot->set_fill(announce_fill);
+        if (ledger.is_open()) robot->set_ledger(&ledger);
+        if (!profile_path.empty()) robot->set_profiler(&profiler, profiler.add_track(path));
+        robot->set_volume_profile(&volume_profile);
+        if (!portfolio.empty())
+        {
+            std::size_t member = 0;
+            if (!portfolio.join(coin, fiat, member))
+            {
+                std::cerr << "Invalid value for '--weight,' every pair traded needs a weight and " << pair << " has none." << std::endl;
+                return 1;
+            }
+            robot->set_portfolio(&portfolio, member);
+        }
+
+        if (markets.find(pair) == markets.end())
+        {
+            if (session_player.is_open() && !session_player.has_channel(pair))
+            {
+                std::cerr << "Invalid value for '--replay-session,' the session has no calls for " << pair << "." << std::endl;
+                return 1;
+            }
+            auto pair_market = std::make_unique<market>(init_string.str(), coin, fiat, io, pool);
+            if (paper && !open_paper_account(*pair_market, coin, fiat)) return 1;
+
+            // Load the product's trading rules now, so that every order we post is sized and priced exactly.
+            mercury::product_info product;
+            std::cout << utilities::timestamp() << " Loading product information...   ";
+            if (!pair_market->front().get_product_info(product))
+            {
+                std::cout << "FAILED" << std::endl;
+                mtx.lock();
+                std::cout << utilities::timestamp() << " Fatal error: failed to load the trading rules for " << pair << "." << std::endl;
+                mtx.unlock();
+                return 1;
+            }
+            std::cout << "DONE" << std::endl;
+
+            mtx.lock();
+            std::cout << utilities::timestamp() << " Using " << std::fixed << std::setprecision(2) << (settings.fiat_percent * 100.00) << "% of the " << fiat << " fiat balance." << std::endl;
+            mtx.unlock();
+
+            if (market_bus.is_open() && !pair_market->exchange.set_market_bus(&market_bus, pair, bus_max_age))
+            {
+                mtx.lock();
+                std::cout << utilities::timestamp() << " Note: the market bus does not carry " << pair << ", its prices will come from the exchange." << std::endl;
+                mtx.unlock();
+            }
+            if (market_bus.is_open()) pair_market->on_bus = market_bus.find(pair, pair_market->bus_index);
+            pair_market->exchange.set_scheduler(scheduler.get());
+
+            // A replayed session never reaches the exchange, so there are no requests to count.
+            if (!session_player.is_open()) pair_market->exchange.set_request_count(&pair_market->context.requests());
+
+            markets.emplace(pair, std::move(pair_market));
+        }
+
+        if (settings.exits.enabled()) robot->set_exit_engine(&markets[pair]->exits);
+
+        ++robots_running;
+        if (snapshots) snapshots->add(path, *robot);
+        mercury::spawn(io, run_robot(*robot, markets[pair]->exchange, signals, snapshots.get()));
+        robots.push_back(std::move(robot));
     }
 
-    // The first parameter is the coin.
-    coin = strs[0];
+    if (snapshots)
+    {
+        std::cout << utilities::timestamp() << " Restoring the last snapshot...   ";
+        std::size_t restored = snapshots->restore();
+        std::cout << "DONE (" << restored << " of " << robots.size() << " work orders)" << std::endl;
+        snapshots->start();
+    }
 
-    // The second parameter is always the action we are required to take and will be on of the following
-    // BUY
-    // SELL
-    // WFB
-    // WFS
-    action = strs[1];
+    // Orders left resting by an earlier run count towards the risk limits, and the kill switch cancels them too.
+    if (risk)
+    {
+        for (const auto& robot : robots)
+        {
+            const mercury::work_order& order = robot->current();
+            bool buying = order.is("WFB");
+            std::string uuid(order.uuid);
+            if ((!buying && !order.is("WFS")) || uuid.empty() || uuid == "NONE") continue;
 
-    // The third parameter is the fiat currency to use.
-    fiat = strs[2];
+            market& pair_market = *markets[std::string(order.coin) + "-" + order.fiat];
+            pair_market.risk_checks->adopt(uuid, buying ? cryptocoin::trading::buy : cryptocoin::trading::sell, std::strtod(order.price, nullptr));
+        }
+    }
 
-    // Create our trading context.
-    std::stringstream init_string;
-    init_string << "ee3f2635939845af5e1db506109aeeb6" << ":";
-    init_string << "v3ty5dro4zq" << ":";
-    init_string << "pSVf+fsikQrnc5UxlKxCQ15zBj68+UFoZE4v/9LFHiBiGsfLrDApu2YQyseAkl+IXhba/ihCmNrhqpM/Zdi3NQ==";
+    // Without the market bus the exits and the risk checks only see the prices the work orders fetch.
+    if ((settings.exits.enabled() || risk) && market_bus.is_open()) mercury::spawn(io, watch_bus(io, markets));
+    if (health.is_open()) mercury::spawn(io, report_health(io));
+    if (breaker) mercury::spawn(io, probe_exchange(io, markets));
 
-    cryptocoin::trading::coinbase_trade_context coinbase(init_string.str(), coin, fiat, print_change_update);
+    // Returns once every work order has stopped, or on a signal to stop.
+    io.run();
+    pool.join();
 
-    mtx.lock();
-    std::cout << utilities::timestamp() << " Using " << std::fixed << std::setprecision(2) << (fiat_percent * 100.00) << "% of the " << fiat << " fiat balance." << std::endl;
-    mtx.unlock();
+    if (snapshots && !snapshots->save_now())
+    {
+        std::cerr << utilities::timestamp() << " Warning: failed to write the final snapshot to " << snapshot_path << "." << std::endl;
+    }
 
-    while (execute_trade(coinbase)) {}
+    if (ledger.is_open()) report_positions();
+    if (!profile_path.empty())
+    {
+        report_profile();
+        profiler.close();
+    }
+    if (session_player.is_open())
+    {
+        mtx.lock();
+        std::cout << utilities::timestamp() << " ";
+        session_player.report(std::cout);
+        mtx.unlock();
+    }
+    session_recorder.close();
 
     return 1;
 }
@@ -218,382 +811,338 @@ void print_change_update(long double up, long double down)
     mtx.unlock();
 }
 
-bool execute_trade(cryptocoin::trading::trade_context& context)
+///
+/// Rings the till when an order fills.
+///
+/// \param side The side of the order that filled.
+void announce_fill(cryptocoin::trading::order_side side)
 {
-    long double old_price = 0.0;
-    long double tenpc = 0.0;
-    uint64_t new_price = 0;
-    std::vector<std::string> strs;
-    std::string next_op;
+    if (side == cryptocoin::trading::buy)
+        play_sound("/usr/share/auto-trader-bots/chaching1.wav");
+    else
+        play_sound("/usr/share/auto-trader-bots/chaching2.wav");
+}
 
-    work_order_file >> next_op;
-    work_order_file.clear(); // Make sure we are not EOF.
-    work_order_file.seekg(0, std::ios::beg);
+///
+/// Runs one work order. Once the last work order has stopped, the signal wait and the snapshot timer
+/// are cancelled so that the io_context can run out of work.
+mercury::task<void> run_robot(mercury::trader& robot, mercury::async_exchange& exchange, boost::asio::signal_set& signals,
+                              mercury::state_snapshots* snapshots)
+{
+    co_await robot.run(exchange);
+    if (--robots_running > 0) co_return;
 
-    if (next_op.empty())
-    {
-        mtx.lock();
-        std::cout << utilities::timestamp() << " Fatal error: no instructions could be found in the work order file." << std::endl;
-        mtx.unlock();
+    signals.cancel();
+    if (snapshots) snapshots->stop();
+    if (health_wait) health_wait->cancel();
+    if (probe_wait) probe_wait->cancel();
+}
 
-        return false;
-    }
+///
+/// Checks the exits of every pair against each tick on the market bus, so that an exit fires within
+/// milliseconds of the price that crosses it, and gives the risk checks the same prices to check orders
+/// against. Stops once the last work order has.
+mercury::task<void> watch_bus(boost::asio::io_context& io, std::map<std::string, std::unique_ptr<market>>& markets)
+{
+    const double scale = double(mercury::power_of_ten(mercury::bus_decimals));
+    mercury::bus_tick tick;
+    uint64_t missed = 0;
 
-    // Get the information from the instruction in the file.
-    boost::split(strs, next_op, boost::is_any_of(":"));
-    if (strs.size() != 5)
+    while (robots_running > 0)
     {
-        mtx.lock();
-        std::cout << utilities::timestamp() << " Fatal error: the work order file did not contain the expected information and may be corrupted or damaged." << std::endl;
-        mtx.unlock();
+        co_await mercury::async_exchange::timer(io, bus_check_interval);
+
+        // Only the latest price matters, so ticks overwritten before they were read are no loss.
+        while (market_bus.next(tick, missed))
+        {
+            for (auto& [pair, m] : markets)
+            {
+                if (!m->on_bus || m->bus_index != tick.product || tick.price <= 0) continue;
+
+                double price = double(tick.price) / scale;
+                m->exits.update(price, tick.time_us);
+                if (m->risk_checks) m->risk_checks->observe(price, tick.time_us);
+            }
+        }
 
-        return false;
+        int64_t now = mercury::bus_now();
+        for (auto& [pair, m] : markets) m->exits.expire(now);
     }
+}
+
+///
+/// Tells the supervisor how this worker is doing, once a second until the last work order has stopped.
+/// How late the trading thread wakes up for each report shows how loaded it is.
+mercury::task<void> report_health(boost::asio::io_context& io)
+{
+    mercury::health_report report;
 
-    // Verify that the coin still matches.
-    if (strs[0] != coin)
+    while (robots_running > 0)
     {
-        std::cout << utilities::timestamp() << " Fatal error: unexpected information in the work order file." << std::endl;
-        return false;
+        auto due = std::chrono::steady_clock::now() + health_interval;
+        co_await mercury::async_exchange::timer(io, health_interval, &health_wait);
+        if (robots_running == 0) break;
+
+        auto late = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - due);
+        report.loop_lag_us = std::max<int64_t>(0, late.count());
+        report.work_orders = robots_running;
+        report.queued_requests = 0;
+        if (scheduler)
+        {
+            for (uint64_t queued : scheduler->stats().queued) report.queued_requests += uint32_t(queued);
+        }
+        health.send(report);
     }
+}
 
-    // The second parameter is always the action we are required to take and will be on of the following
-    // BUY
-    // SELL
-    // WFB
-    // WFS
-    action = strs[1];
+///
+/// While the circuit breaker is tripped, probes the exchange of every pair every few seconds, so that it
+/// has fresh calls to judge the exchange by and can close as soon as it recovers. The probes go straight
+/// to the timed context, past the risk checks and the session recording. Stops once the last work order has.
+mercury::task<void> probe_exchange(boost::asio::io_context& io, std::map<std::string, std::unique_ptr<market>>& markets)
+{
+    const std::chrono::seconds interval(breaker_settings.probe_seconds);
+    mercury::ticker ticker;
 
-    // Verify that the fiat still matches.
-    if (strs[2] != fiat)
+    while (robots_running > 0)
     {
-        std::cout << utilities::timestamp() << " Fatal error: unexpected information in the work order file." << std::endl;
-        return false;
+        co_await mercury::async_exchange::timer(io, interval, &probe_wait);
+        if (robots_running == 0) break;
+        if (!breaker->tripped()) continue;
+
+        for (auto& [pair, m] : markets) co_await m->exchange.probe(*m->breaker_checks, ticker);
     }
+}
 
-    // ============================================================================================
-    // We need to buy some coin at the price in the work order file.
-    // ============================================================================================
-    if (action == "BUY")
-    {
-        std::string buy_price(strs[3]);
-        std::string current_price = context.current_price();
+///
+/// Funds the simulated account for a newly opened pair, once for each currency, and starts the tick
+/// file playback if there is one.
+///
+/// \return false if the tick file cannot be played back.
+bool open_paper_account(market& pair_market, const std::string& coin, const std::string& fiat)
+{
+    static std::set<std::string> funded;
 
-        // Make sure the price is right.
-        long double bp = std::stold(buy_price);
-        long double cp = std::stold(current_price);
+    if (funded.insert(fiat).second) paper_account.deposit(fiat, paper_fiat);
+    if (funded.insert(coin).second) paper_account.deposit(coin, paper_coin);
 
-        // If the current price has dropped below our buy price then update our buy price.
-        if (cp < bp)
-        {
-            buy_price = current_price;
-            bp = cp;
-            mtx.lock();
-            std::cout << utilities::timestamp() << " Updated buy price to current, better price of " << current_price << " " << fiat << std::endl;
-            mtx.unlock();
-        }
+    mtx.lock();
+    std::cout << utilities::timestamp() << " Paper trading " << coin << "-" << fiat << ": orders are simulated, no funds are at risk." << std::endl;
+    mtx.unlock();
 
-        // Work out order size.
-        std::string sbal = context.fiat_balance();
-        if (sbal.empty())
-        {
-            mtx.lock();
-            std::cout << utilities::timestamp() << " Warning: failed to retrieve balance from server - retrying in 30 seconds." << std::endl;
-            mtx.unlock();
-            boost::this_thread::sleep(boost::posix_time::seconds(30));
-            return true;
-        }
-        long double bal = std::stold(sbal);
-        if (bal < 5.00)
-        {
-            mtx.lock();
-            std::cout << utilities::timestamp() << " Fiat fiat_balance is less than 5.00 " << fiat << " - trading impossible." << std::endl;
-            mtx.unlock();
-            return false;
-        }
-        // Get the percentage of the fiat fiat_balance that we are allowed to use/
-        bal *= fiat_percent;
-        long double to_buy = bal / bp;
-        std::string size = utilities::to_string_with_precision(to_buy, 2);
-        char c;
-        if ((c = size.back()) > '0')
-        {
-            size.pop_back();
-            size.push_back(c - 1);
-        }
+    if (paper_replay_path.empty() || pair_market.simulator->replay(paper_replay_path)) return true;
 
-        // Perform the trade.
-        mtx.lock();
-        std::cout << utilities::timestamp() << " Performing buy of " << size << " " << coin << " at " << buy_price << " " << fiat << " per coin with " << sbal << " " << fiat << "." << std::endl;
-        mtx.unlock();
-        std::string out_uuid;
-        std::string str_new_price;
-        cryptocoin::trading::order_status result = context.post_order(cryptocoin::trading::buy, cryptocoin::trading::limit, size, buy_price, "", out_uuid);
-        switch (result)
-        {
-            case cryptocoin::trading::in_progress:
-                work_order_file.seekp(0, std::ios::beg);
-                work_order_file << coin << ":" << "WFB:" << fiat << ":" << buy_price << ":" << out_uuid << std::endl;
-                work_order_file << std::string(40, ' ');
-                work_order_file.flush();
-                mtx.lock();
-                std::cout << utilities::timestamp() << " Buy order posted - checking outcome in 10 minutes." << std::endl;
-                mtx.unlock();
-                boost::this_thread::sleep(boost::posix_time::minutes(10));
-                return true;
-            case cryptocoin::trading::completed:
-                play_sound("/usr/share/auto-trader-bots/chaching1.wav");
-                old_price = std::stold(buy_price);
-                tenpc = old_price * context.sell_price_adjustment();
-                if (tenpc < 1.00) tenpc = 1.00;
-                new_price = old_price + tenpc;
-                str_new_price = utilities::to_string_with_precision(new_price, 2);
-                work_order_file.seekp(0, std::ios::beg);
-                work_order_file << coin << ":" << "SELL:" << fiat << ":" << std::to_string(new_price) << ":NONE" << std::endl;
-                work_order_file << std::string(40, ' ');
-                work_order_file.flush();
-                mtx.lock();
-                std::cout << utilities::timestamp() << " The current buy order has completed successfully." << std::endl;
-                mtx.unlock();
-                return true;
-            case cryptocoin::trading::network_error:
-                mtx.lock();
-                std::cout << utilities::timestamp() << " Warning: a temporary network error occurred - retrying in 1 minute." << std::endl;
-                mtx.unlock();
-                boost::this_thread::sleep(boost::posix_time::minutes(1));
-                return true;
-            case cryptocoin::trading::fatal_error:
-                mtx.lock();
-                std::cout << utilities::timestamp() << " A fatal error occurred - see the log file for details." << std::endl;
-                mtx.unlock();
-                return false;
-            case cryptocoin::trading::insufficient_funds:
-                mtx.lock();
-                std::cout << utilities::timestamp() << " Warning: failed to post buy order due to insufficient fiat fiat_balance - retrying in 30 minutes." << std::endl;
-                mtx.unlock();
-                boost::this_thread::sleep(boost::posix_time::minutes(30));
-                return true;
-            default:
-                mtx.lock();
-                std::cout << utilities::timestamp() << " Warning: failed to post buy order - retrying in 30 seconds." << std::endl;
-                mtx.unlock();
-                boost::this_thread::sleep(boost::posix_time::seconds(30));
-                return true;
-        }
-    }
+    std::cerr << "Invalid value for '--paper-replay,' the file could not be opened or is not a tick file." << std::endl;
+    return false;
+}
+
+///
+/// Stops the robot once every pair has run through its recorded session. Called on an exchange thread,
+/// so it stops the robot the way SIGTERM would, through the signal handler on the trading thread.
+void end_replay()
+{
+    std::raise(SIGTERM);
+}
 
-    // ============================================================================================
-    // A buy has been set up, we need to see if it has completed.
-    // ============================================================================================
-    if (action == "WFB")
+///
+/// Prints the position and P&L of every pair in the ledger.
+void report_positions()
+{
+    mtx.lock();
+    std::cout << utilities::timestamp() << " Positions:" << std::endl;
+    ledger.summarise(std::cout);
+    mtx.unlock();
+}
+
+///
+/// Prints the time each work order has spent in every state and wait.
+void report_profile()
+{
+    mtx.lock();
+    std::cout << utilities::timestamp() << " Time in state:" << std::endl;
+    profiler.report(std::cout);
+    mtx.unlock();
+}
+
+///
+/// Prints how far the request scheduler has had to hold back calls to the exchange.
+void report_requests()
+{
+    mtx.lock();
+    std::cout << utilities::timestamp() << " ";
+    scheduler->report(std::cout);
+    mtx.unlock();
+}
+
+///
+/// Prints every pair's share of the account and the funds its orders hold.
+void report_portfolio()
+{
+    mtx.lock();
+    std::cout << utilities::timestamp() << " ";
+    portfolio.report(std::cout);
+    mtx.unlock();
+}
+
+///
+/// Prints the orders checked and rejected by the risk limits and the day's profit or loss.
+void report_risk()
+{
+    mtx.lock();
+    std::cout << utilities::timestamp() << " ";
+    risk->report(std::cout);
+    mtx.unlock();
+}
+
+///
+/// Prints the state of the circuit breaker and the latency and error rate of recent calls to the exchange.
+void report_breaker()
+{
+    mtx.lock();
+    std::cout << utilities::timestamp() << " ";
+    breaker->report(std::cout);
+    mtx.unlock();
+}
+
+///
+/// Reports the circuit breaker tripping or closing. Called on the exchange thread that made the call.
+///
+/// \param tripped True if it has tripped, false if it has closed.
+/// \param why     What the calls to the exchange showed.
+void alert_breaker(bool tripped, const char* why)
+{
+    mtx.lock();
+    if (tripped)
+        std::cout << utilities::timestamp() << " Warning: circuit breaker tripped, " << why << "; no orders will be posted until it recovers."
+                  << std::endl;
+    else
+        std::cout << utilities::timestamp() << " Note: circuit breaker closed, " << why << "; orders will be posted again."
+                  << std::endl;
+    mtx.unlock();
+}
+
+///
+/// Reports an order the risk limits kept from being posted.
+///
+/// \param pair The pair the order was for.
+/// \param what Why it was rejected.
+void alert_rejected(const std::string& pair, const char* what)
+{
+    mtx.lock();
+    std::cout << utilities::timestamp() << " Warning: rejected an order for " << pair << ", " << what << "." << std::endl;
+    mtx.unlock();
+}
+
+///
+/// Reports the kill switch tripping and has the resting orders cancelled. Called once, on whichever
+/// thread tripped it, so the cancelling is left to the signal handler on the trading thread.
+///
+/// \param pair The pair that tripped it, or empty.
+/// \param what Why it tripped.
+void alert_killed(const std::string& pair, const char* what)
+{
+    mtx.lock();
+    std::cout << utilities::timestamp() << " Kill switch: " << what << (pair.empty() ? "" : " on ") << pair << "; no more orders will be posted."
+              << std::endl;
+    mtx.unlock();
+
+    kill_cancel_due = true;
+    std::raise(SIGUSR2);
+}
+
+///
+/// Cancels every order the risk checks know to be resting, on every pair.
+mercury::task<void> cancel_resting_orders(std::map<std::string, std::unique_ptr<market>>& markets)
+{
+    std::vector<std::string> uuids;
+
+    for (auto& [pair, m] : markets)
     {
-        std::string buy_price(strs[3]);
-        std::string uuid = strs[4];
-        std::string str_new_price;
+        if (!m->risk_checks) continue;
 
-        cryptocoin::trading::order_status result = context.get_order_status(uuid);
-        switch (result)
+        m->risk_checks->open_orders(uuids);
+        for (const std::string& uuid : uuids)
         {
-            case cryptocoin::trading::in_progress:
-                mtx.lock();
-                std::cout << utilities::timestamp() << " The current buy order has not yet completed - checking again in 10 minutes." << std::endl;
-                mtx.unlock();
-                boost::this_thread::sleep(boost::posix_time::minutes(10));
-                return true;
-            case cryptocoin::trading::completed:
-                play_sound("/usr/share/auto-trader-bots/chaching1.wav");
-                old_price = std::stold(buy_price);
-                tenpc = old_price * context.sell_price_adjustment();
-                if (tenpc < 1.00) tenpc = 1.00;
-                new_price = old_price + tenpc;
-                str_new_price = utilities::to_string_with_precision(new_price, 2);
-                work_order_file.seekp(0, std::ios::beg);
-                work_order_file << coin << ":" << "SELL:" << fiat << ":" << str_new_price << ":NONE" << std::endl;
-                work_order_file << std::string(40, ' ');
-                work_order_file.flush();
-                mtx.lock();
-                std::cout << utilities::timestamp() << " The current buy order has completed successfully." << std::endl;
-                mtx.unlock();
-                return true;
-            case cryptocoin::trading::network_error:
-                mtx.lock();
-                std::cout << utilities::timestamp() << " Warning: a temporary network error occurred - retrying in 1 minute." << std::endl;
-                mtx.unlock();
-                boost::this_thread::sleep(boost::posix_time::minutes(1));
-                return true;
-            case cryptocoin::trading::cancelled:
-                work_order_file.seekp(0, std::ios::beg);
-                work_order_file << coin << ":" << "BUY:" << fiat << ":" << buy_price << ":NONE" << std::endl;
-                work_order_file << std::string(40, ' ');
-                work_order_file.flush();
-                mtx.lock();
-                std::cout << utilities::timestamp() << " The current buy order appears to have been cancelled - setting up for repost in 1 minute." << std::endl;
-                mtx.unlock();
-                boost::this_thread::sleep(boost::posix_time::minutes(1));
-                return true;
-            case cryptocoin::trading::fatal_error:
-                mtx.lock();
-                std::cout << utilities::timestamp() << " A fatal error occurred - see the log file for details." << std::endl;
-                mtx.unlock();
-                return false;
+            cryptocoin::trading::order_status result = co_await m->exchange.cancel_order(uuid);
+
+            mtx.lock();
+            if (result == cryptocoin::trading::cancelled || result == cryptocoin::trading::completed)
+                std::cout << utilities::timestamp() << " Kill switch: order " << uuid << " on " << pair << " is no longer resting." << std::endl;
+            else
+                std::cout << utilities::timestamp() << " Warning: failed to cancel order " << uuid << " on " << pair << ", cancel it by hand." << std::endl;
+            mtx.unlock();
         }
     }
+}
 
-    // ============================================================================================
-    // We need to buy some coin at the price in the work order file.
-    // ============================================================================================
-    if (action == "SELL")
+///
+/// Handles the signals the robot is controlled with, re-arming itself after each one.
+///
+/// \param signals The signals to wait for.
+/// \param io      The io_context to stop when told to.
+/// \param markets Every pair traded, for the kill switch to cancel their orders.
+void watch_signals(boost::asio::signal_set& signals, boost::asio::io_context& io, std::map<std::string, std::unique_ptr<market>>& markets)
+{
+    signals.async_wait([&signals, &io, &markets](const boost::system::error_code& error, int number)
     {
-        std::string sell_price(strs[3]);
-        std::string current_price = context.current_price();
-
-        // Make sure the price is right.
-        long double bp = std::stold(sell_price);
-        long double cp = std::stold(current_price);
-
-        // If the current price has risen above our buy price then update our buy price.
-        if (cp > bp)
+        if (error) return;
+        if (number == SIGHUP)
         {
-            sell_price = current_price;
-            bp = cp;
-            std::cout << utilities::timestamp() << " Updated buy price to current, better price of " << current_price << " " << fiat << std::endl;
+            // Signals are handled on the trading thread, so no plugin is being called during the swap.
+            boost::lock_guard<boost::mutex> lock(mtx);
+            plugins.reload(std::cout);
+            watch_signals(signals, io, markets);
+            return;
         }
-
-        std::string sbal = context.coin_balance();
-        if (sbal.empty())
+        if (number == SIGUSR2)
         {
-            mtx.lock();
-            std::cout << utilities::timestamp() << " Warning: failed to retrieve fiat balance from server - retrying in 30 seconds." << std::endl;
-            mtx.unlock();
-            boost::this_thread::sleep(boost::posix_time::seconds(30));
-            return true;
+            // Tripping the switch by hand raises SIGUSR2 again through alert_killed(); only the first
+            // signal after a trip cancels the resting orders.
+            if (risk) risk->kill("", "tripped by hand");
+            if (kill_cancel_due.exchange(false)) mercury::spawn(io, cancel_resting_orders(markets));
+            watch_signals(signals, io, markets);
+            return;
         }
-
-        long double bal = std::stold(sbal);
-        if (bal == 0.00)
+        if (number != SIGUSR1)
         {
-
+            io.stop();
+            return;
         }
+        if (ledger.is_open()) report_positions();
+        if (!profile_path.empty()) report_profile();
+        if (scheduler) report_requests();
+        if (!portfolio.empty()) report_portfolio();
+        if (risk) report_risk();
+        if (breaker) report_breaker();
+        watch_signals(signals, io, markets);
+    });
+}
 
-        // Perform the trade.
-        mtx.lock();
-        std::cout << utilities::timestamp() << " Performing sell of " << sbal << " " << coin << " at " << sell_price << " " << fiat << " per coin ." << std::endl;
-        mtx.unlock();
-        std::string out_uuid;
-        std::string str_new_price;
-        cryptocoin::trading::order_status result = context.post_order(cryptocoin::trading::sell, cryptocoin::trading::limit, sbal, sell_price, "", out_uuid);
-        switch (result)
-        {
-            case cryptocoin::trading::in_progress:
-                work_order_file.seekp(0, std::ios::beg);
-                work_order_file << coin << ":" << "WFS:" << fiat << ":" << sell_price << ":" << out_uuid << std::endl;
-                work_order_file << std::string(40, ' ');
-                work_order_file.flush();
-                mtx.lock();
-                std::cout << utilities::timestamp() << " Sell order posted - checking outcome in 10 minutes." << std::endl;
-                mtx.unlock();
-                boost::this_thread::sleep(boost::posix_time::minutes(10));
-                return true;
-            case cryptocoin::trading::completed:
-                play_sound("/usr/share/auto-trader-bots/chaching2.wav");
-                old_price = std::stold(sell_price);
-                tenpc = old_price * context.buy_price_ajustment();
-                if (tenpc < 1.00) tenpc = 1.00;
-                new_price = old_price - tenpc;
-                str_new_price = utilities::to_string_with_precision(new_price, 2);
-                work_order_file.seekp(0, std::ios::beg);
-                work_order_file << coin << ":" << "BUY:" << fiat << ":" << std::to_string(new_price) << ":NONE" << std::endl;
-                work_order_file << std::string(40, ' ');
-                work_order_file.flush();
-                mtx.lock();
-                std::cout << utilities::timestamp() << " The current sell order has completed successfully." << std::endl;
-                mtx.unlock();
-                return true;
-            case cryptocoin::trading::network_error:
-                mtx.lock();
-                std::cout << utilities::timestamp() << " Warning: a temporary network error occurred - retrying in 1 minute." << std::endl;
-                mtx.unlock();
-                boost::this_thread::sleep(boost::posix_time::minutes(1));
-                return true;
-            case cryptocoin::trading::fatal_error:
-                mtx.lock();
-                std::cout << utilities::timestamp() << " A fatal error occurred - see the log file for details." << std::endl;
-                mtx.unlock();
-                return false;
-            case cryptocoin::trading::insufficient_funds:
-                mtx.lock();
-                std::cout << utilities::timestamp() << " Warning: failed to post sell order due to insufficient " << coin << " fiat_balance - retrying in 30 minutes." << std::endl;
-                mtx.unlock();
-                boost::this_thread::sleep(boost::posix_time::minutes(30));
-                return true;
-            default:
-                mtx.lock();
-                std::cout << utilities::timestamp() << " Warning: failed to post sell order - retrying in 30 seconds." << std::endl;
-                mtx.unlock();
-                boost::this_thread::sleep(boost::posix_time::seconds(30));
-                return true;
-        }
-    }
+///
+/// Loads the price history from a previously recorded tick file into the market indicators and rebuilds
+/// the candles from it.
+///
+/// \param tick_file  Path of the tick file; it is fine for it not to exist yet.
+/// \param indicators The indicators to warm up.
+/// \param candles    The candles to rebuild.
+void warm_up_history(const std::string& tick_file, mercury::market_indicators& indicators, mercury::candle_aggregator& candles)
+{
+    mercury::tick_store_reader reader;
+    std::vector<int64_t> times;
+    std::vector<int64_t> prices;
+    std::vector<int64_t> history_times;
+    std::vector<double> history;
 
-    // ============================================================================================
-    // A sell order has been set up, we need to see if it has completed.
-    // ============================================================================================
-    if (action == "WFS")
-    {
-        std::string sell_price(strs[3]);
-        std::string uuid = strs[4];
-        std::string str_new_price;
+    if (!std::filesystem::exists(tick_file) || !reader.open(tick_file)) return;
 
-        cryptocoin::trading::order_status result = context.get_order_status(uuid);
-        switch (result)
-        {
-            case cryptocoin::trading::in_progress:
-                mtx.lock();
-                std::cout << utilities::timestamp() << " The current sell order has not yet completed - checking again in 10 minutes." << std::endl;
-                mtx.unlock();
-                boost::this_thread::sleep(boost::posix_time::minutes(10));
-                return true;
-            case cryptocoin::trading::completed:
-                play_sound("/usr/share/auto-trader-bots/chaching2.wav");
-                old_price = std::stold(sell_price);
-                tenpc = old_price * context.buy_price_ajustment();
-                if (tenpc < 1.00) tenpc = 1.00;
-                new_price = old_price + tenpc;
-                str_new_price = utilities::to_string_with_precision(new_price, 2);
-                work_order_file.seekp(0, std::ios::beg);
-                work_order_file << coin << ":" << "BUY:" << fiat << ":" << str_new_price << ":NONE" << std::endl;
-                work_order_file << std::string(40, ' ');
-                work_order_file.flush();
-                mtx.lock();
-                std::cout << utilities::timestamp() << " The current sell order has completed successfully." << std::endl;
-                mtx.unlock();
-                return true;
-            case cryptocoin::trading::network_error:
-                mtx.lock();
-                std::cout << utilities::timestamp() << " Warning: a temporary network error occurred - retrying in 1 minute." << std::endl;
-                mtx.unlock();
-                boost::this_thread::sleep(boost::posix_time::minutes(1));
-                return true;
-            case cryptocoin::trading::cancelled:
-                work_order_file.seekp(0, std::ios::beg);
-                work_order_file << coin << ":" << "SELL:" << fiat << ":" << sell_price << ":NONE" << std::endl;
-                work_order_file << std::string(40, ' ');
-                work_order_file.flush();
-                mtx.lock();
-                std::cout << utilities::timestamp() << " The current sell order appears to have been cancelled - setting up for repost in 1 minute." << std::endl;
-                mtx.unlock();
-                boost::this_thread::sleep(boost::posix_time::minutes(1));
-                return true;
-            case cryptocoin::trading::fatal_error:
-                mtx.lock();
-                std::cout << utilities::timestamp() << " A fatal error occurred - see the log file for details." << std::endl;
-                mtx.unlock();
-                return false;
-        }
+    long double scale = mercury::power_of_ten(reader.price_decimals());
+    while (reader.next_block(times, prices))
+    {
+        for (int64_t p : prices) history.push_back(static_cast<double>(p / scale));
+        history_times.insert(history_times.end(), times.begin(), times.end());
     }
-
-    work_order_file.close();
-    return false;
+    indicators.warm_up(history.data(), history.size());
+    candles.warm_up(history_times.data(), history.data(), history.size());
 }
 
 void play_sound(const std::string& sound_file)
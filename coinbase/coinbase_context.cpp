@@ -0,0 +1,230 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   coinbase_context.cpp
+ * Author: Chris Morrison
+ *
+ * Created on 19 October 2026, 13:40
+ */
+#include <unordered_set>
+#include "coinbase_context.hpp"
+
+namespace mercury
+{
+
+using namespace cryptocoin::trading;
+
+// Upper bound on the pages of open orders fetched per lookup (100 orders per page).
+static const int max_open_order_pages = 20;
+
+// How long the product rules are trusted before they are fetched again.
+static const std::chrono::hours product_info_lifetime(1);
+
+static std::string field(const web::json::value& object, const char* name)
+{
+    if (!object.has_field(name) || !object.at(name).is_string()) return std::string();
+    return utility::conversions::to_utf8string(object.at(name).as_string());
+}
+
+coinbase_context::coinbase_context(const std::string& init_string, const std::string& coin, const std::string& fiat, adjustment_callback callback)
+    : context_(init_string, coin, fiat, callback), rest_(init_string), product_(coin + "-" + fiat)
+{
+}
+
+std::string coinbase_context::fiat_balance()
+{
+    ++requests_;
+    return context_.fiat_balance();
+}
+
+std::string coinbase_context::coin_balance()
+{
+    ++requests_;
+    return context_.coin_balance();
+}
+
+std::string coinbase_context::current_price()
+{
+    ++requests_;
+    return context_.current_price();
+}
+
+order_status coinbase_context::post_order(order_side side, order_type type, const std::string& size, const std::string& price,
+                                          const std::string& funds, std::string& out_uuid)
+{
+    product_info info;
+    std::string exact_size = size;
+    std::string exact_price = price;
+
+    // Snap the order onto the product's increments so the exchange has no reason to reject it. Buy
+    // prices round down and sell prices round up, so the rounding never works against us.
+    if (get_product_info(info))
+    {
+        if (!size.empty() && !info.quantise_size(size, exact_size)) return insufficient_funds;
+        if (!price.empty() && type == limit) exact_price = info.quantise_price(price, side == sell);
+    }
+
+    ++requests_;
+    order_status result = context_.post_order(side, type, exact_size, exact_price, funds, out_uuid);
+
+    // An outright rejection may mean the rules have changed under us; fetch them again next time.
+    if (result != in_progress && result != completed && result != network_error && result != insufficient_funds) info_stale_ = true;
+
+    return result;
+}
+
+order_status coinbase_context::get_order_status(const std::string& uuid)
+{
+    ++requests_;
+    return context_.get_order_status(uuid);
+}
+
+long double coinbase_context::sell_price_adjustment()
+{
+    ++requests_;
+    return context_.sell_price_adjustment();
+}
+
+long double coinbase_context::buy_price_ajustment()
+{
+    ++requests_;
+    return context_.buy_price_ajustment();
+}
+
+order_status coinbase_context::cancel_order(const std::string& uuid)
+{
+    web::json::value reply;
+    ++requests_;
+    int status = rest_.request(web::http::methods::DEL, "/orders/" + uuid, "", reply);
+
+    if (status == 200) return cancelled;
+    if (coinbase_rest::is_transient(status)) return network_error;
+
+    // "Order already done" (400) or not found (404): the order left the book before the cancel got
+    // there, so ask how it ended.
+    if (status == 400 || status == 404)
+    {
+        ++requests_;
+        order_status result = context_.get_order_status(uuid);
+        return (result == in_progress) ? network_error : result;
+    }
+
+    return fatal_error;
+}
+
+bool coinbase_context::get_order_statuses(const std::vector<std::string>& uuids, std::vector<order_status>& out)
+{
+    std::unordered_set<std::string> open;
+    std::string cursor;
+
+    // List everything that is still on the book, across all products.
+    for (int page = 0; page < max_open_order_pages; ++page)
+    {
+        web::json::value reply;
+        std::string path = "/orders?status=open&status=pending&status=active&limit=100";
+        if (!cursor.empty()) path += "&after=" + cursor;
+
+        ++requests_;
+        int status = rest_.request(web::http::methods::GET, path, "", reply, &cursor);
+        if (status != 200 || !reply.is_array()) return false;
+
+        for (auto& order : reply.as_array())
+        {
+            std::string id = field(order, "id");
+            if (!id.empty()) open.insert(id);
+        }
+        if (cursor.empty() || reply.as_array().size() < 100) break;
+    }
+
+    // Anything not on the book any more has either filled or been cancelled; only those need asking about.
+    std::vector<order_status> result;
+    result.reserve(uuids.size());
+    for (const std::string& uuid : uuids)
+    {
+        if (open.count(uuid))
+        {
+            result.push_back(in_progress);
+            continue;
+        }
+        ++requests_;
+        result.push_back(context_.get_order_status(uuid));
+    }
+    out.swap(result);
+
+    return true;
+}
+
+bool coinbase_context::get_product_info(product_info& out)
+{
+    if (info_valid_ && !info_stale_ && std::chrono::steady_clock::now() - info_loaded_ < product_info_lifetime)
+    {
+        out = info_;
+        return true;
+    }
+
+    web::json::value reply;
+    product_info fresh;
+    ++requests_;
+    int status = rest_.request(web::http::methods::GET, "/products/" + product_, "", reply);
+
+    if (status == 200 && reply.is_object() &&
+        fresh.set(product_, field(reply, "quote_increment"), field(reply, "base_increment"), field(reply, "base_min_size"), field(reply, "base_max_size")))
+    {
+        info_ = fresh;
+        info_valid_ = true;
+        info_stale_ = false;
+        info_loaded_ = std::chrono::steady_clock::now();
+    }
+
+    // If the refresh failed, the rules we already have are still far better than none.
+    if (!info_valid_) return false;
+
+    out = info_;
+    return true;
+}
+
+bool coinbase_context::get_fill(const std::string& uuid, order_fill& out)
+{
+    web::json::value reply;
+    ++requests_;
+    int status = rest_.request(web::http::methods::GET, "/orders/" + uuid, "", reply);
+
+    if (status != 200 || !reply.is_object()) return false;
+
+    out.size = field(reply, "filled_size");
+    out.value = field(reply, "executed_value");
+    out.fee = field(reply, "fill_fees");
+
+    return !out.size.empty() && !out.value.empty();
+}
+
+bool coinbase_context::get_ticker(ticker& out)
+{
+    web::json::value reply;
+    ++requests_;
+    int status = rest_.request(web::http::methods::GET, "/products/" + product_ + "/ticker", "", reply);
+
+    if (status != 200 || !reply.is_object()) return false;
+
+    out.price = field(reply, "price");
+    out.bid = field(reply, "bid");
+    out.ask = field(reply, "ask");
+    out.volume = field(reply, "volume");
+
+    return !out.price.empty();
+}
+
+}
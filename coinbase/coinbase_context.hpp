@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   coinbase_context.hpp
+ * Author: Chris Morrison
+ *
+ * Created on 19 October 2026, 13:40
+ */
+#ifndef COINBASE_CONTEXT_HPP
+#define COINBASE_CONTEXT_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <coinbase.hpp>
+#include "exchange_context.hpp"
+#include "coinbase_rest.hpp"
+
+namespace mercury
+{
+
+/// Signature of the callback that receives updated sell/buy adjustment rates.
+typedef void (*adjustment_callback)(long double up, long double down);
+
+///
+/// Exchange context for Coinbase Pro: the financial_services coinbase trade context for the basic
+/// calls, plus direct REST access for everything else.
+class coinbase_context : public exchange_context
+{
+public:
+    coinbase_context(const std::string& init_string, const std::string& coin, const std::string& fiat, adjustment_callback callback);
+
+    std::string fiat_balance() override;
+    std::string coin_balance() override;
+    std::string current_price() override;
+    cryptocoin::trading::order_status post_order(cryptocoin::trading::order_side side, cryptocoin::trading::order_type type,
+                                                 const std::string& size, const std::string& price, const std::string& funds,
+                                                 std::string& out_uuid) override;
+    cryptocoin::trading::order_status get_order_status(const std::string& uuid) override;
+    long double sell_price_adjustment() override;
+    long double buy_price_ajustment() override;
+
+    cryptocoin::trading::order_status cancel_order(const std::string& uuid) override;
+    bool get_order_statuses(const std::vector<std::string>& uuids, std::vector<cryptocoin::trading::order_status>& out) override;
+    bool get_product_info(product_info& out) override;
+    bool get_fill(const std::string& uuid, order_fill& out) override;
+    bool get_ticker(ticker& out) override;
+
+    /// Every HTTP request made so far, for the request scheduler to charge calls that make more than one.
+    const std::atomic<uint64_t>& requests() const { return requests_; }
+
+private:
+    cryptocoin::trading::coinbase_trade_context context_;
+    coinbase_rest rest_;
+    std::string product_;
+    product_info info_;
+    bool info_valid_ = false;
+    bool info_stale_ = true;
+    std::chrono::steady_clock::time_point info_loaded_;
+    std::atomic<uint64_t> requests_{ 0 };
+};
+
+}
+
+#endif /* COINBASE_CONTEXT_HPP */
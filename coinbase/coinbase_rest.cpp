@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   coinbase_rest.cpp
+ * Author: Chris Morrison
+ *
+ * Created on 19 October 2026, 13:25
+ */
+#include <ctime>
+#include <vector>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include "coinbase_rest.hpp"
+
+namespace mercury
+{
+
+static std::string base64_encode(const unsigned char* data, std::size_t len)
+{
+    std::string out(4 * ((len + 2) / 3), '\0');
+    int n = EVP_EncodeBlock(reinterpret_cast<unsigned char*>(&out[0]), data, static_cast<int>(len));
+    out.resize(n > 0 ? n : 0);
+    return out;
+}
+
+static std::string base64_decode(const std::string& text)
+{
+    std::string out(3 * ((text.size() + 3) / 4), '\0');
+    int n = EVP_DecodeBlock(reinterpret_cast<unsigned char*>(&out[0]), reinterpret_cast<const unsigned char*>(text.data()), static_cast<int>(text.size()));
+    if (n < 0) return std::string();
+
+    // EVP_DecodeBlock counts the padding characters as output bytes.
+    std::size_t pad = 0;
+    for (auto it = text.rbegin(); it != text.rend() && *it == '='; ++it) ++pad;
+    out.resize(static_cast<std::size_t>(n) - pad);
+    return out;
+}
+
+coinbase_rest::coinbase_rest(const std::string& init_string, const std::string& base_url) : client_(base_url)
+{
+    std::size_t first = init_string.find(':');
+    std::size_t second = (first == std::string::npos) ? std::string::npos : init_string.find(':', first + 1);
+
+    if (second == std::string::npos) return;
+
+    key_ = init_string.substr(0, first);
+    passphrase_ = init_string.substr(first + 1, second - first - 1);
+    secret_ = base64_decode(init_string.substr(second + 1));
+}
+
+std::string coinbase_rest::sign(const std::string& timestamp, const std::string& method, const std::string& path, const std::string& body) const
+{
+    std::string what = timestamp + method + path + body;
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int len = 0;
+
+    HMAC(EVP_sha256(), secret_.data(), static_cast<int>(secret_.size()), reinterpret_cast<const unsigned char*>(what.data()), what.size(), digest, &len);
+
+    return base64_encode(digest, len);
+}
+
+int coinbase_rest::request(const web::http::method& method, const std::string& path, const std::string& body, web::json::value& out,
+                           std::string* cursor)
+{
+    std::string timestamp = std::to_string(std::time(nullptr));
+    std::string verb = utility::conversions::to_utf8string(method);
+
+    web::http::http_request req(method);
+    req.set_request_uri(utility::conversions::to_string_t(path));
+    req.headers().add("CB-ACCESS-KEY", utility::conversions::to_string_t(key_));
+    req.headers().add("CB-ACCESS-SIGN", utility::conversions::to_string_t(sign(timestamp, verb, path, body)));
+    req.headers().add("CB-ACCESS-TIMESTAMP", utility::conversions::to_string_t(timestamp));
+    req.headers().add("CB-ACCESS-PASSPHRASE", utility::conversions::to_string_t(passphrase_));
+    if (!body.empty()) req.set_body(utility::conversions::to_string_t(body), "application/json");
+
+    try
+    {
+        web::http::http_response response = client_.request(req).get();
+        if (cursor)
+        {
+            bool more = response.headers().has("CB-AFTER");
+            *cursor = more ? utility::conversions::to_utf8string(response.headers()["CB-AFTER"]) : std::string();
+        }
+        try
+        {
+            out = response.extract_json(true).get();
+        }
+        catch (std::exception&)
+        {
+            out = web::json::value::null();
+        }
+        return response.status_code();
+    }
+    catch (std::exception&)
+    {
+        out = web::json::value::null();
+        return 0;
+    }
+}
+
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   coinbase_rest.hpp
+ * Author: Chris Morrison
+ *
+ * Created on 19 October 2026, 13:25
+ */
+#ifndef COINBASE_REST_HPP
+#define COINBASE_REST_HPP
+
+#include <string>
+#include <cpprest/http_client.h>
+#include <cpprest/json.h>
+
+namespace mercury
+{
+
+///
+/// Signed access to the Coinbase Pro REST API, for the endpoints that the financial_services trade
+/// context does not wrap.
+class coinbase_rest
+{
+public:
+    ///
+    /// \param init_string The "key:passphrase:secret" string the coinbase trade context is created with.
+    /// \param base_url    The API root.
+    explicit coinbase_rest(const std::string& init_string, const std::string& base_url = "https://api.pro.coinbase.com");
+
+    ///
+    /// Performs a signed request.
+    ///
+    /// \param method The HTTP method.
+    /// \param path   The request path including any query string, e.g. "/orders?status=open".
+    /// \param body   The request body, empty for none.
+    /// \param out    Receives the decoded JSON reply.
+    /// \param cursor If not null, receives the pagination cursor for the next page (empty on the last page).
+    /// \return the HTTP status code, or 0 if the request never reached the server.
+    int request(const web::http::method& method, const std::string& path, const std::string& body, web::json::value& out,
+                std::string* cursor = nullptr);
+
+    /// True for status codes that are worth retrying later (no connection, throttled, server trouble).
+    static bool is_transient(int status) { return status == 0 || status == 429 || status >= 500; }
+
+private:
+    std::string sign(const std::string& timestamp, const std::string& method, const std::string& path, const std::string& body) const;
+
+    std::string key_;
+    std::string passphrase_;
+    std::string secret_;
+    web::http::client::http_client client_;
+};
+
+}
+
+#endif /* COINBASE_REST_HPP */
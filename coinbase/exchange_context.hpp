@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   exchange_context.hpp
+ * Author: Chris Morrison
+ *
+ * Created on 19 October 2026, 13:20
+ */
+#ifndef EXCHANGE_CONTEXT_HPP
+#define EXCHANGE_CONTEXT_HPP
+
+#include <string>
+#include <vector>
+#include <trade_context.hpp>
+#include "product_info.hpp"
+
+namespace mercury
+{
+
+///
+/// The top of a product's book, as decimal text exactly as the exchange sent it. Fields the exchange
+/// did not give are left empty.
+struct ticker
+{
+    std::string price;
+    std::string bid;
+    std::string ask;
+    std::string volume;
+};
+
+///
+/// What a completed order actually traded, as decimal text exactly as the exchange sent it.
+struct order_fill
+{
+    std::string size;   ///< Coin bought or sold.
+    std::string value;  ///< Fiat paid or received, before fees.
+    std::string fee;    ///< Fiat paid in fees.
+};
+
+///
+/// The financial_services trade context, extended with the exchange calls that the robot needs but
+/// that the basic interface does not provide.
+class exchange_context : public cryptocoin::trading::trade_context
+{
+public:
+    ///
+    /// Versions of the basic queries that leave the answer in a string owned by the caller, reusing its
+    /// storage; a caller that keeps the string between calls then avoids a heap allocation per call.
+    /// The defaults just forward to the basic queries.
+    ///
+    /// \param out Receives the answer, empty on failure.
+    virtual void read_current_price(std::string& out) { out = current_price(); }
+    virtual void read_fiat_balance(std::string& out) { out = fiat_balance(); }
+    virtual void read_coin_balance(std::string& out) { out = coin_balance(); }
+
+    ///
+    /// Cancels a resting order. A fill can reach the exchange before the cancel does, so callers must
+    /// be prepared for the order to have completed instead.
+    ///
+    /// \param uuid The identifier returned by post_order().
+    /// \return cancelled if the order was taken off the book, completed if it filled first,
+    ///         network_error if the outcome is not known yet, or fatal_error.
+    virtual cryptocoin::trading::order_status cancel_order(const std::string& uuid) = 0;
+
+    ///
+    /// Looks up the status of many orders at once. Orders still on the book are found from a single
+    /// listing of the account's open orders; only orders that have left the book since the last look
+    /// cost a request of their own.
+    ///
+    /// \param uuids The orders to look up.
+    /// \param out   Receives the status of each order, in the same order as uuids.
+    /// \return false if the open orders could not be listed, in which case out is left unchanged.
+    virtual bool get_order_statuses(const std::vector<std::string>& uuids, std::vector<cryptocoin::trading::order_status>& out) = 0;
+
+    ///
+    /// Returns the trading rules (price and size increments, size limits) for the context's product.
+    /// Implementations are expected to cache these and only go back to the exchange when the copy they
+    /// hold is old or an order has been rejected.
+    ///
+    /// \param out Receives the rules.
+    /// \return false if the rules have never been loaded and cannot be loaded now.
+    virtual bool get_product_info(product_info& out) = 0;
+
+    ///
+    /// Looks up what an order filled at. The default knows nothing about fills.
+    ///
+    /// \param uuid The identifier returned by post_order().
+    /// \param out  Receives the fill; its strings are reused.
+    /// \return false if the details are not available.
+    virtual bool get_fill(const std::string& /* uuid */, order_fill& /* out */) { return false; }
+
+    ///
+    /// Reads the last trade price together with the best bid and ask. The default only knows the price.
+    ///
+    /// \param out Receives the ticker; its strings are reused.
+    /// \return false if not even the price could be read.
+    virtual bool get_ticker(ticker& out)
+    {
+        read_current_price(out.price);
+        out.bid.clear();
+        out.ask.clear();
+        out.volume.clear();
+        return !out.price.empty();
+    }
+};
+
+}
+
+#endif /* EXCHANGE_CONTEXT_HPP */
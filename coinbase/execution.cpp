@@ -0,0 +1,293 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   execution.cpp
+ * Author: Chris Morrison
+ *
+ * Created on 19 October 2026, 23:50
+ */
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <strings.h>
+#include "execution.hpp"
+
+namespace mercury
+{
+
+static const int64_t hour_us = int64_t(3600) * 1000000;
+
+// Reads an unsigned number that runs up to the next comma or the end of the text.
+static bool read_count(const char*& p, unsigned long& out)
+{
+    char* end = nullptr;
+
+    if (*p < '0' || *p > '9') return false;
+    out = std::strtoul(p, &end, 10);
+    if (*end != ',' && *end != '\0') return false;
+    p = (*end == ',') ? end + 1 : end;
+
+    return true;
+}
+
+bool execution_plan::parse(const char* text)
+{
+    execution_plan plan;
+
+    if (!text || !*text)
+    {
+        *this = plan;
+        return true;
+    }
+
+    if (strncasecmp(text, "twap,", 5) == 0)
+        plan.style = execution_style::twap;
+    else if (strncasecmp(text, "vwap,", 5) == 0)
+        plan.style = execution_style::vwap;
+    else
+        return false;
+
+    const char* p = text + 5;
+    unsigned long slices = 0;
+    unsigned long minutes = 0;
+    if (!read_count(p, slices) || !read_count(p, minutes)) return false;
+    if (slices < 1 || slices > max_execution_slices || minutes < 1 || minutes > 24 * 60) return false;
+    plan.slices = static_cast<unsigned int>(slices);
+    plan.interval_minutes = static_cast<unsigned int>(minutes);
+
+    if (*p)
+    {
+        char* end = nullptr;
+        double percent = std::strtod(p, &end);
+        if (*end != '\0' || !(percent > 0.0 && percent <= 100.0)) return false;
+        plan.participation = percent / 100.0;
+    }
+
+    *this = plan;
+    return true;
+}
+
+volume_profile::volume_profile()
+{
+    for (double& h : hours_) h = 1.0 / 24.0;
+}
+
+bool volume_profile::load(const std::string& path)
+{
+    std::ifstream file(path);
+    double hours[24];
+    double total = 0.0;
+
+    for (double& h : hours)
+    {
+        if (!(file >> h) || h < 0.0) return false;
+        total += h;
+    }
+    if (!(total > 0.0)) return false;
+
+    for (int i = 0; i < 24; ++i) hours_[i] = hours[i] / total;
+    return true;
+}
+
+double volume_profile::share(int64_t from_us, int64_t to_us) const
+{
+    double total = 0.0;
+
+    for (int64_t t = from_us; t < to_us;)
+    {
+        int64_t hour_end = (t / hour_us + 1) * hour_us;
+        int64_t end = (to_us < hour_end) ? to_us : hour_end;
+
+        total += hours_[(t / hour_us) % 24] * double(end - t) / double(hour_us);
+        t = end;
+    }
+
+    return total;
+}
+
+void parent_order::start(double total, int64_t start_us, const execution_plan& plan)
+{
+    clear();
+    plan_ = plan;
+    total_ = total;
+    start_us_ = start_us;
+}
+
+void parent_order::clear()
+{
+    total_ = 0.0;
+    start_us_ = 0;
+    count_ = 0;
+}
+
+double parent_order::filled() const
+{
+    double sum = 0.0;
+    for (std::size_t i = 0; i < count_; ++i) sum += children_[i].filled;
+    return sum;
+}
+
+double parent_order::value() const
+{
+    double sum = 0.0;
+    for (std::size_t i = 0; i < count_; ++i) sum += children_[i].value;
+    return sum;
+}
+
+double parent_order::remaining() const
+{
+    double left = total_ - filled();
+    return (left > 0.0) ? left : 0.0;
+}
+
+double parent_order::average_price() const
+{
+    double size = filled();
+    return (size > 0.0) ? value() / size : 0.0;
+}
+
+const child_order* parent_order::working() const
+{
+    return (count_ && !children_[count_ - 1].done) ? &children_[count_ - 1] : nullptr;
+}
+
+double parent_order::next_size(int64_t now_us, const volume_profile& profile, double daily_volume) const
+{
+    int64_t interval_us = int64_t(plan_.interval_minutes) * 60 * 1000000;
+    int64_t slice = (now_us > start_us_ && interval_us > 0) ? (now_us - start_us_) / interval_us : 0;
+
+    // The share of the parent that the schedule says should have traded by the end of this slice.
+    double due = 1.0;
+    if (slice + 1 < int64_t(plan_.slices))
+    {
+        due = double(slice + 1) / plan_.slices;
+        if (plan_.style == execution_style::vwap)
+        {
+            double whole = profile.share(start_us_, start_us_ + plan_.slices * interval_us);
+            if (whole > 0.0) due = profile.share(start_us_, start_us_ + (slice + 1) * interval_us) / whole;
+        }
+    }
+
+    const child_order* out = working();
+    double size = total_ * due - filled() - (out ? out->size : 0.0);
+
+    if (plan_.participation > 0.0 && daily_volume > 0.0)
+    {
+        double cap = plan_.participation * daily_volume * profile.share(now_us, now_us + interval_us);
+        if (size > cap) size = cap;
+    }
+
+    double left = remaining();
+    if (size > left) size = left;
+
+    return (size > 0.0) ? size : 0.0;
+}
+
+int64_t parent_order::next_slice_us(int64_t now_us) const
+{
+    int64_t interval_us = int64_t(plan_.interval_minutes) * 60 * 1000000;
+    int64_t slice = (now_us > start_us_ && interval_us > 0) ? (now_us - start_us_) / interval_us : 0;
+
+    return start_us_ + (slice + 1) * interval_us;
+}
+
+bool parent_order::last_slice(int64_t now_us) const
+{
+    return next_slice_us(now_us) >= start_us_ + int64_t(plan_.slices) * plan_.interval_minutes * 60 * 1000000;
+}
+
+bool parent_order::add_child(const char* uuid, double size, double price, int64_t until_us)
+{
+    if (full() || std::strlen(uuid) >= sizeof(children_[0].uuid)) return false;
+
+    child_order& c = children_[count_++];
+    c = child_order();
+    std::strcpy(c.uuid, uuid);
+    c.size = size;
+    c.price = price;
+    c.until_us = until_us;
+
+    return true;
+}
+
+void parent_order::finish_child(double filled, double value)
+{
+    if (!count_ || children_[count_ - 1].done) return;
+
+    child_order& c = children_[count_ - 1];
+    c.filled = filled;
+    c.value = value;
+    c.done = true;
+}
+
+void parent_order::save(snapshot_writer& out) const
+{
+    out.put(uint32_t(plan_.style));
+    out.put(uint32_t(plan_.slices));
+    out.put(uint32_t(plan_.interval_minutes));
+    out.put(plan_.participation);
+    out.put(total_);
+    out.put(start_us_);
+    out.put(uint64_t(count_));
+    for (std::size_t i = 0; i < count_; ++i)
+    {
+        const child_order& c = children_[i];
+        out.put(c.uuid);
+        out.put(c.size);
+        out.put(c.price);
+        out.put(c.filled);
+        out.put(c.value);
+        out.put(c.until_us);
+        out.put(uint32_t(c.done));
+    }
+}
+
+bool parent_order::load(snapshot_reader& in)
+{
+    parent_order saved;
+    uint32_t style = 0;
+    uint32_t slices = 0;
+    uint32_t minutes = 0;
+    uint64_t count = 0;
+
+    if (!in.get(style) || !in.get(slices) || !in.get(minutes) || !in.get(saved.plan_.participation) || !in.get(saved.total_) ||
+        !in.get(saved.start_us_) || !in.get(count))
+    {
+        return false;
+    }
+    if (style > uint32_t(execution_style::vwap) || count > max_child_orders) return false;
+    saved.plan_.style = execution_style(style);
+    saved.plan_.slices = slices;
+    saved.plan_.interval_minutes = minutes;
+
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        child_order& c = saved.children_[i];
+        uint32_t done = 0;
+        if (!in.get(c.uuid, sizeof(c.uuid)) || !in.get(c.size) || !in.get(c.price) || !in.get(c.filled) || !in.get(c.value) ||
+            !in.get(c.until_us) || !in.get(done))
+        {
+            return false;
+        }
+        c.done = (done != 0);
+    }
+    saved.count_ = count;
+
+    *this = saved;
+    return true;
+}
+
+}
@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   execution.hpp
+ * Author: Chris Morrison
+ *
+ * Created on 19 October 2026, 23:50
+ */
+#ifndef EXECUTION_HPP
+#define EXECUTION_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "snapshot.hpp"
+
+// ------------------------------------------------------------------------------------------------
+// Sliced execution.
+//
+// A work order can have its buys and sells worked as a parent order that is split into child limit
+// orders over time, rather than posted in one go. TWAP spreads the parent evenly over the schedule;
+// VWAP follows the market's usual volume through the day, so that more is traded in the busy hours.
+// Either can be capped to a share of the volume the market is expected to trade while a child is out.
+// The parent and the fills of its children are kept in a fixed table, so working a parent never
+// allocates and the whole thing goes into the warm-restart snapshot.
+// ------------------------------------------------------------------------------------------------
+
+namespace mercury
+{
+
+enum class execution_style
+{
+    single,     ///< One order for the lot.
+    twap,       ///< Equal slices at regular intervals.
+    vwap        ///< Slices sized to the volume profile.
+};
+
+///
+/// How a work order's buys and sells are executed, from the optional sixth field of the work order:
+/// empty for a single order, otherwise "twap,<slices>,<minutes>[,<percent>]" or
+/// "vwap,<slices>,<minutes>[,<percent>]", where the percentage caps each child's share of the
+/// expected volume.
+struct execution_plan
+{
+    execution_style style = execution_style::single;
+    unsigned int slices = 1;            ///< Children the parent is scheduled over.
+    unsigned int interval_minutes = 0;  ///< Minutes between children.
+    double participation = 0.0;         ///< Largest share of the expected market volume per child; 0 for no cap.
+
+    /// \return false, leaving the plan unchanged, if the text is not a valid plan.
+    bool parse(const char* text);
+
+    bool sliced() const { return style != execution_style::single; }
+};
+
+///
+/// The share of a day's volume that usually trades in each hour (UTC).
+class volume_profile
+{
+public:
+    /// A flat profile, under which VWAP slices the same as TWAP.
+    volume_profile();
+
+    ///
+    /// Reads 24 hourly volumes (any scale, whitespace separated), starting at midnight UTC.
+    ///
+    /// \return false if the file cannot be read or does not hold 24 non-negative numbers with a
+    ///         positive total, in which case the profile is left unchanged.
+    bool load(const std::string& path);
+
+    /// The share of a day's volume expected to trade between two times, microseconds since the epoch.
+    double share(int64_t from_us, int64_t to_us) const;
+
+private:
+    double hours_[24];
+};
+
+/// Most children a parent can have, counting those added to catch up with the schedule.
+constexpr std::size_t max_child_orders = 48;
+
+/// Most slices a plan can be scheduled over, leaving room in the table to catch up.
+constexpr unsigned int max_execution_slices = 32;
+
+///
+/// One child of a parent order.
+struct child_order
+{
+    char uuid[64] = {};
+    double size = 0.0;      ///< Coin ordered.
+    double price = 0.0;     ///< Limit price.
+    double filled = 0.0;    ///< Coin traded.
+    double value = 0.0;     ///< Fiat traded, before fees.
+    int64_t until_us = 0;   ///< When its slice ends; it is cancelled then if it is still working.
+    bool done = false;
+};
+
+///
+/// A parent order worked through child orders.
+class parent_order
+{
+public:
+    ///
+    /// Starts working a parent order.
+    ///
+    /// \param total    Coin to trade in all.
+    /// \param start_us When the schedule starts, microseconds since the epoch.
+    /// \param plan     The schedule; must be sliced.
+    void start(double total, int64_t start_us, const execution_plan& plan);
+
+    /// Forgets the parent and its children.
+    void clear();
+
+    bool active() const { return total_ > 0.0; }
+    double total() const { return total_; }
+    double filled() const;
+    double value() const;
+    double remaining() const;
+
+    /// The average price traded at so far, 0 if nothing has.
+    double average_price() const;
+
+    std::size_t children() const { return count_; }
+    const child_order& child(std::size_t index) const { return children_[index]; }
+
+    /// The last child, if it is still out.
+    const child_order* working() const;
+
+    /// True once no more children can be added.
+    bool full() const { return count_ == max_child_orders; }
+
+    ///
+    /// Works out the next child: what the schedule says should have traded by now less what has,
+    /// capped to the participation limit.
+    ///
+    /// \param now_us       The time.
+    /// \param profile      The volume profile the schedule follows (VWAP) and the cap is taken from.
+    /// \param daily_volume The market's volume over the last day, 0 if it is not known (no cap).
+    /// \return the size of the child, 0 if the schedule is up to date.
+    double next_size(int64_t now_us, const volume_profile& profile, double daily_volume) const;
+
+    /// When the slice after the one under way at now_us starts.
+    int64_t next_slice_us(int64_t now_us) const;
+
+    /// True once the schedule has reached its last slice.
+    bool last_slice(int64_t now_us) const;
+
+    /// Records a child that has been posted; fails if the table is full.
+    bool add_child(const char* uuid, double size, double price, int64_t until_us);
+
+    /// Records what the working child traded once it has filled or been cancelled.
+    void finish_child(double filled, double value);
+
+    void save(snapshot_writer& out) const;
+    bool load(snapshot_reader& in);
+
+private:
+    execution_plan plan_;
+    double total_ = 0.0;
+    int64_t start_us_ = 0;
+    child_order children_[max_child_orders];
+    std::size_t count_ = 0;
+};
+
+}
+
+#endif /* EXECUTION_HPP */
@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   exit_engine.cpp
+ * Author: Chris Morrison
+ *
+ * Created on 19 October 2026, 23:35
+ */
+#include <algorithm>
+#include "exit_engine.hpp"
+
+namespace mercury
+{
+
+const char* exit_reason_name(exit_reason reason)
+{
+    switch (reason)
+    {
+        case exit_reason::stop_loss:
+            return "stop-loss";
+        case exit_reason::trailing_stop:
+            return "trailing take-profit";
+        case exit_reason::time_limit:
+            return "time limit";
+    }
+    return "unknown";
+}
+
+// Removes the trigger belonging to a slot, keeping the rest in order.
+template <typename Trigger>
+static void remove_trigger(std::vector<Trigger>& triggers, uint32_t slot)
+{
+    auto found = std::find_if(triggers.begin(), triggers.end(), [slot](const Trigger& t) { return t.slot == slot; });
+    if (found != triggers.end()) triggers.erase(found);
+}
+
+exit_engine::exit_engine(std::size_t capacity)
+{
+    guards_.reserve(capacity);
+    free_.reserve(capacity);
+    stops_.reserve(capacity);
+    activations_.reserve(capacity);
+    deadlines_.reserve(capacity);
+}
+
+bool exit_engine::arm(exit_watcher& watcher, double entry, int64_t entry_us, const exit_rules& rules)
+{
+    disarm(watcher);
+    if (!rules.enabled() || entry <= 0.0) return false;
+
+    uint32_t slot;
+    if (free_.empty())
+    {
+        slot = static_cast<uint32_t>(guards_.size());
+        guards_.emplace_back();
+    }
+    else
+    {
+        slot = free_.back();
+        free_.pop_back();
+    }
+
+    guard& g = guards_[slot];
+    g = guard();
+    g.watcher = &watcher;
+    g.trail = rules.trail;
+    ++guarded_;
+
+    if (rules.stop_loss > 0.0) set_stop(slot, entry * (1.0 - rules.stop_loss), false);
+
+    if (rules.trail > 0.0)
+    {
+        price_trigger t = { entry * (1.0 + rules.trail_from), slot };
+        auto at = std::upper_bound(activations_.begin(), activations_.end(), t,
+                                   [](const price_trigger& a, const price_trigger& b) { return a.price > b.price; });
+        activations_.insert(at, t);
+    }
+
+    if (rules.max_hold_us > 0)
+    {
+        time_trigger t = { entry_us + rules.max_hold_us, slot };
+        auto at = std::upper_bound(deadlines_.begin(), deadlines_.end(), t,
+                                   [](const time_trigger& a, const time_trigger& b) { return a.time_us > b.time_us; });
+        deadlines_.insert(at, t);
+    }
+
+    return true;
+}
+
+void exit_engine::disarm(const exit_watcher& watcher)
+{
+    uint32_t slot = find(watcher);
+    if (slot != no_slot) release(slot);
+}
+
+bool exit_engine::armed(const exit_watcher& watcher) const
+{
+    return find(watcher) != no_slot;
+}
+
+void exit_engine::update(double price, int64_t now_us)
+{
+    expire(now_us);
+
+    // Positions that have risen far enough start trailing from here.
+    while (!activations_.empty() && price >= activations_.back().price)
+    {
+        uint32_t slot = activations_.back().slot;
+        guard& g = guards_[slot];
+
+        activations_.pop_back();
+        g.trailing = true;
+        g.peak = price;
+        if (price < lowest_peak_) lowest_peak_ = price;
+        set_stop(slot, price * (1.0 - g.trail), true);
+    }
+
+    if (price > lowest_peak_) raise_trailing_stops(price);
+
+    while (!stops_.empty() && price <= stops_.back().price)
+    {
+        uint32_t slot = stops_.back().slot;
+        fire(slot, guards_[slot].stop_is_trail ? exit_reason::trailing_stop : exit_reason::stop_loss, price);
+    }
+}
+
+void exit_engine::expire(int64_t now_us)
+{
+    while (!deadlines_.empty() && now_us >= deadlines_.back().time_us)
+    {
+        uint32_t slot = deadlines_.back().slot;
+        fire(slot, exit_reason::time_limit, 0.0);
+    }
+}
+
+uint32_t exit_engine::find(const exit_watcher& watcher) const
+{
+    for (std::size_t i = 0; i < guards_.size(); ++i)
+    {
+        if (guards_[i].watcher == &watcher) return static_cast<uint32_t>(i);
+    }
+    return no_slot;
+}
+
+void exit_engine::set_stop(uint32_t slot, double stop, bool from_trail)
+{
+    guard& g = guards_[slot];
+    if (stop <= g.stop) return;
+
+    remove_trigger(stops_, slot);
+    g.stop = stop;
+    g.stop_is_trail = from_trail;
+
+    price_trigger t = { stop, slot };
+    auto at = std::upper_bound(stops_.begin(), stops_.end(), t,
+                               [](const price_trigger& a, const price_trigger& b) { return a.price < b.price; });
+    stops_.insert(at, t);
+}
+
+void exit_engine::raise_trailing_stops(double price)
+{
+    bool moved = false;
+
+    lowest_peak_ = std::numeric_limits<double>::infinity();
+    for (price_trigger& t : stops_)
+    {
+        guard& g = guards_[t.slot];
+        if (!g.trailing) continue;
+
+        if (price > g.peak)
+        {
+            g.peak = price;
+            double stop = price * (1.0 - g.trail);
+            if (stop > g.stop)
+            {
+                g.stop = stop;
+                g.stop_is_trail = true;
+                t.price = stop;
+                moved = true;
+            }
+        }
+        if (g.peak < lowest_peak_) lowest_peak_ = g.peak;
+    }
+
+    // The stops were raised in place, so put them back in order; the array is already nearly sorted.
+    if (moved)
+    {
+        std::sort(stops_.begin(), stops_.end(), [](const price_trigger& a, const price_trigger& b) { return a.price < b.price; });
+    }
+}
+
+void exit_engine::fire(uint32_t slot, exit_reason reason, double price)
+{
+    exit_watcher* watcher = guards_[slot].watcher;
+
+    // Released first, so that the watcher is free to arm again from inside the call.
+    release(slot);
+    watcher->exit_triggered(reason, price);
+}
+
+void exit_engine::release(uint32_t slot)
+{
+    remove_trigger(stops_, slot);
+    remove_trigger(activations_, slot);
+    remove_trigger(deadlines_, slot);
+
+    guards_[slot] = guard();
+    free_.push_back(slot);
+    --guarded_;
+}
+
+}
@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   exit_engine.hpp
+ * Author: Chris Morrison
+ *
+ * Created on 19 October 2026, 23:35
+ */
+#ifndef EXIT_ENGINE_HPP
+#define EXIT_ENGINE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// ------------------------------------------------------------------------------------------------
+// Tick-driven exits.
+//
+// Once a buy fills, the position it opened can be guarded by a hard stop-loss, a trailing
+// take-profit and a time limit. The guards of every position on a product live in one exit_engine,
+// which is given every price seen for the product. Triggers are kept in flat arrays sorted so that
+// the one closest to firing is at the back: a tick that fires nothing costs three comparisons however
+// many positions are guarded. Only a new high for a trailing position costs more, as every trailing
+// stop below it is raised.
+// ------------------------------------------------------------------------------------------------
+
+namespace mercury
+{
+
+///
+/// The exits guarding a position, as fractions of the entry price. Each is off when zero.
+struct exit_rules
+{
+    double stop_loss = 0.0;     ///< Sell once the price falls this far below the entry.
+    double trail_from = 0.0;    ///< Start trailing once the price is this far above the entry.
+    double trail = 0.0;         ///< While trailing, sell once the price falls this far below its high.
+    int64_t max_hold_us = 0;    ///< Sell once the position has been held this many microseconds.
+
+    bool enabled() const { return stop_loss > 0.0 || trail > 0.0 || max_hold_us > 0; }
+};
+
+/// Why a position was closed.
+enum class exit_reason
+{
+    stop_loss,
+    trailing_stop,
+    time_limit
+};
+
+/// The name an exit reason is logged under.
+const char* exit_reason_name(exit_reason reason);
+
+///
+/// Something holding a guarded position.
+class exit_watcher
+{
+public:
+    virtual ~exit_watcher() = default;
+
+    ///
+    /// Called once when one of the position's exits fires; the position is no longer guarded.
+    ///
+    /// \param reason Which exit fired.
+    /// \param price  The price that fired it.
+    virtual void exit_triggered(exit_reason reason, double price) = 0;
+};
+
+///
+/// The exits guarding every position on one product.
+class exit_engine
+{
+public:
+    ///
+    /// \param capacity Number of positions to make room for up front; more can be added, at the cost
+    ///                 of an allocation when they are armed.
+    explicit exit_engine(std::size_t capacity = 16);
+
+    ///
+    /// Guards a position, replacing any guard the watcher already had.
+    ///
+    /// \param watcher  Told when an exit fires; it must stay alive while it is armed.
+    /// \param entry    The price the position was opened at.
+    /// \param entry_us When it was opened, microseconds since the epoch.
+    /// \param rules    The exits to guard it with.
+    /// \return false if the rules have no exit enabled, in which case the position is not guarded.
+    bool arm(exit_watcher& watcher, double entry, int64_t entry_us, const exit_rules& rules);
+
+    /// Stops guarding a watcher's position, if it has one.
+    void disarm(const exit_watcher& watcher);
+
+    bool armed(const exit_watcher& watcher) const;
+    std::size_t size() const { return guarded_; }
+
+    ///
+    /// Checks a new price, firing every exit it crosses and every time limit that has passed.
+    ///
+    /// \param price  The price.
+    /// \param now_us Microseconds since the epoch.
+    void update(double price, int64_t now_us);
+
+    /// Fires the time limits that have passed, for when there is no new price.
+    void expire(int64_t now_us);
+
+private:
+    struct guard
+    {
+        exit_watcher* watcher = nullptr;
+        double trail = 0.0;
+        double stop = 0.0;
+        double peak = 0.0;
+        bool trailing = false;
+        bool stop_is_trail = false;
+    };
+
+    struct price_trigger
+    {
+        double price;
+        uint32_t slot;
+    };
+
+    struct time_trigger
+    {
+        int64_t time_us;
+        uint32_t slot;
+    };
+
+    uint32_t find(const exit_watcher& watcher) const;
+    void set_stop(uint32_t slot, double stop, bool from_trail);
+    void raise_trailing_stops(double price);
+    void fire(uint32_t slot, exit_reason reason, double price);
+    void release(uint32_t slot);
+
+    static constexpr uint32_t no_slot = std::numeric_limits<uint32_t>::max();
+
+    std::vector<guard> guards_;
+    std::vector<uint32_t> free_;
+    std::size_t guarded_ = 0;
+
+    std::vector<price_trigger> stops_;          ///< Ascending: the highest stop is at the back.
+    std::vector<price_trigger> activations_;    ///< Descending: the lowest activation is at the back.
+    std::vector<time_trigger> deadlines_;       ///< Descending: the soonest deadline is at the back.
+
+    /// The lowest high of any trailing position; a price above it raises trailing stops.
+    double lowest_peak_ = std::numeric_limits<double>::infinity();
+};
+
+}
+
+#endif /* EXIT_ENGINE_HPP */
@@ -0,0 +1,213 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   feed.cpp
+ * Author: Chris Morrison
+ *
+ * Created on 19 October 2026, 20:40
+ */
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <tclap/CmdLine.h>
+#include "coinbase_context.hpp"
+#include "fixed_point.hpp"
+#include "market_bus.hpp"
+
+// ------------------------------------------------------------------------------------------------
+// mercury-feed: polls the exchange once for every product and publishes the answers on a market bus
+// in /dev/shm, so that any number of robots on the machine share one upstream connection. With
+// --watch it attaches to an existing bus as a reader instead and prints every tick it sees.
+// ------------------------------------------------------------------------------------------------
+
+static volatile std::sig_atomic_t stopping = 0;
+
+static void stop(int)
+{
+    stopping = 1;
+}
+
+// The feed handler does not trade, so it has no use for the adjustment rates.
+static void ignore_adjustments(long double, long double)
+{
+}
+
+static bool read_credentials(const std::string& path, std::string& out)
+{
+    std::ifstream file(path);
+
+    return file && std::getline(file, out) && !out.empty();
+}
+
+static bool to_fixed(const std::string& text, int64_t& out)
+{
+    out = 0;
+    return text.empty() || mercury::parse_fixed(text, mercury::bus_decimals, out);
+}
+
+static int watch(const std::string& name)
+{
+    mercury::market_bus_reader reader;
+    mercury::bus_tick tick;
+    uint64_t missed = 0;
+
+    if (!reader.open(name))
+    {
+        std::cerr << "Failed to attach to the market bus '" << name << "'." << std::endl;
+        return 1;
+    }
+
+    while (!stopping)
+    {
+        if (!reader.next(tick, missed))
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+        if (missed) std::cout << "... " << missed << " ticks missed" << std::endl;
+
+        std::cout << tick.time_us << ' ' << tick.product << ' ' << mercury::format_fixed(tick.price, mercury::bus_decimals) << ' '
+                  << mercury::format_fixed(tick.bid, mercury::bus_decimals) << ' '
+                  << mercury::format_fixed(tick.ask, mercury::bus_decimals) << std::endl;
+    }
+
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> products;
+    std::string name;
+    std::string credentials;
+    unsigned int interval_ms = 1000;
+    unsigned int ring_size = 4096;
+    bool watching = false;
+
+    try
+    {
+        TCLAP::CmdLine cmd("Market data feed handler for the cryptocoin trading robots", ' ', "0.1");
+
+        TCLAP::MultiArg<std::string> product_arg("p", "product", "A product to publish, e.g. BTC-EUR; give it once for every product.", false, "product");
+        cmd.add(product_arg);
+        TCLAP::ValueArg<std::string> name_arg("n", "bus-name", "Name of the market bus in /dev/shm (default: mercury-market)", false, "mercury-market", "name");
+        cmd.add(name_arg);
+        TCLAP::ValueArg<std::string> key_arg("k", "credentials-file", "File holding the API credentials as key:passphrase:secret.", false, "", "file path");
+        cmd.add(key_arg);
+        TCLAP::ValueArg<unsigned int> interval_arg("i", "interval", "Milliseconds between polls of each product (default: 1000)", false, 1000, "number");
+        cmd.add(interval_arg);
+        TCLAP::ValueArg<unsigned int> ring_arg("s", "ring-size", "Ticks kept on the bus for readers that fall behind (default: 4096)", false, 4096, "number");
+        cmd.add(ring_arg);
+        TCLAP::SwitchArg watch_arg("w", "watch", "Attach to the bus as a reader and print the ticks published on it.");
+        cmd.add(watch_arg);
+
+        cmd.parse(argc, argv);
+
+        products = product_arg.getValue();
+        name = name_arg.getValue();
+        interval_ms = interval_arg.getValue();
+        ring_size = ring_arg.getValue();
+        watching = watch_arg.getValue();
+
+        if (!watching && products.empty())
+        {
+            std::cerr << "Invalid value for '--product,' at least one product must be given." << std::endl;
+            return 1;
+        }
+        if (!watching && !read_credentials(key_arg.getValue(), credentials))
+        {
+            std::cerr << "Invalid value for '--credentials-file,' a readable file holding the API credentials must be given." << std::endl;
+            return 1;
+        }
+        if (interval_ms < 100)
+        {
+            std::cerr << "Invalid value for '--interval,' polls must be at least 100 milliseconds apart." << std::endl;
+            return 1;
+        }
+    }
+    catch (TCLAP::ArgException& e)
+    {
+        std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
+        return 1;
+    }
+
+    std::signal(SIGINT, stop);
+    std::signal(SIGTERM, stop);
+
+    if (watching) return watch(name);
+
+    std::vector<std::unique_ptr<mercury::coinbase_context>> contexts;
+    for (const std::string& product : products)
+    {
+        std::size_t dash = product.find('-');
+        if (dash == std::string::npos || dash == 0 || dash + 1 == product.size())
+        {
+            std::cerr << "Invalid value for '--product,' '" << product << "' is not of the form COIN-FIAT." << std::endl;
+            return 1;
+        }
+        contexts.push_back(std::make_unique<mercury::coinbase_context>(credentials, product.substr(0, dash), product.substr(dash + 1), ignore_adjustments));
+    }
+
+    mercury::market_bus_writer writer;
+    if (!writer.create(name, products, ring_size))
+    {
+        std::cerr << "Failed to create the market bus '" << name << "'." << std::endl;
+        return 1;
+    }
+
+    std::cout << "Publishing " << products.size() << " products on /dev/shm/" << name << std::endl;
+
+    mercury::ticker ticker;
+    std::vector<mercury::bus_tick> last(products.size());
+    auto next_poll = std::chrono::steady_clock::now();
+
+    while (!stopping)
+    {
+        for (uint32_t i = 0; i < contexts.size() && !stopping; ++i)
+        {
+            mercury::bus_tick tick;
+
+            tick.product = i;
+            if (!contexts[i]->get_ticker(ticker) || !to_fixed(ticker.price, tick.price) || !to_fixed(ticker.bid, tick.bid) ||
+                !to_fixed(ticker.ask, tick.ask) || !to_fixed(ticker.volume, tick.volume))
+            {
+                continue;
+            }
+            tick.time_us = mercury::bus_now();
+
+            // An unchanged market is not a tick, but it still tells the robots their price is current.
+            if (tick.price == last[i].price && tick.bid == last[i].bid && tick.ask == last[i].ask)
+            {
+                writer.refresh(tick);
+                continue;
+            }
+            writer.publish(tick);
+            last[i] = tick;
+        }
+
+        next_poll += std::chrono::milliseconds(interval_ms);
+        while (!stopping && std::chrono::steady_clock::now() < next_poll) std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        if (std::chrono::steady_clock::now() > next_poll) next_poll = std::chrono::steady_clock::now();
+    }
+
+    writer.close();
+    return 0;
+}
@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   fixed_point.hpp
+ * Author: Chris Morrison
+ *
+ * Created on 19 October 2026, 09:12
+ */
+#ifndef FIXED_POINT_HPP
+#define FIXED_POINT_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+#include <string>
+
+namespace mercury
+{
+
+/// Largest number of decimal places supported by the fixed-point helpers.
+constexpr int max_decimals = 18;
+
+/// Returns 10 raised to the given power (0 to max_decimals).
+inline int64_t power_of_ten(int exponent)
+{
+    static const int64_t table[max_decimals + 1] = {
+        1LL, 10LL, 100LL, 1000LL, 10000LL, 100000LL, 1000000LL, 10000000LL, 100000000LL,
+        1000000000LL, 10000000000LL, 100000000000LL, 1000000000000LL, 10000000000000LL,
+        100000000000000LL, 1000000000000000LL, 10000000000000000LL, 100000000000000000LL,
+        1000000000000000000LL
+    };
+
+    return table[exponent];
+}
+
+///
+/// Parses a decimal string such as "8123.45" into an integer scaled by 10^decimals. Digits beyond the
+/// requested precision are truncated, never rounded, so the result is never larger than the input.
+///
+/// \param first    Start of the text.
+/// \param last     One past the end of the text.
+/// \param decimals Number of decimal places to keep.
+/// \param out      Receives the scaled value.
+/// \return true on success, false if the text is not a plain decimal number or its scaled value does
+///         not fit in 64 bits.
+inline bool parse_fixed(const char* first, const char* last, int decimals, int64_t& out)
+{
+    const int64_t largest = std::numeric_limits<int64_t>::max();
+    bool negative = false;
+    bool seen_digit = false;
+    int64_t whole = 0;
+    int64_t fraction = 0;
+    int places = 0;
+
+    if (first != last && (*first == '-' || *first == '+'))
+    {
+        negative = (*first == '-');
+        ++first;
+    }
+
+    for (; first != last && *first != '.'; ++first)
+    {
+        if (*first < '0' || *first > '9') return false;
+        int digit = *first - '0';
+        if (whole > (largest - digit) / 10) return false;
+        whole = whole * 10 + digit;
+        seen_digit = true;
+    }
+
+    if (first != last)
+    {
+        for (++first; first != last; ++first)
+        {
+            if (*first < '0' || *first > '9') return false;
+            if (places < decimals)
+            {
+                fraction = fraction * 10 + (*first - '0');
+                ++places;
+            }
+            seen_digit = true;
+        }
+    }
+
+    if (!seen_digit) return false;
+
+    // The fraction is always under 10^decimals, so only the whole part can push the result out of range.
+    fraction *= power_of_ten(decimals - places);
+    if (whole > (largest - fraction) / power_of_ten(decimals)) return false;
+    out = whole * power_of_ten(decimals) + fraction;
+    if (negative) out = -out;
+
+    return true;
+}
+
+/// \overload
+inline bool parse_fixed(const std::string& text, int decimals, int64_t& out)
+{
+    return parse_fixed(text.data(), text.data() + text.size(), decimals, out);
+}
+
+///
+/// Formats a scaled integer back into decimal text without touching the heap.
+///
+/// \param value    The scaled value.
+/// \param decimals Number of decimal places the value is scaled by.
+/// \param buf      Output buffer; 24 + decimals characters is always enough.
+/// \param len      Size of the output buffer.
+/// \return the number of characters written (not counting the terminating null), or 0 if the buffer is too small.
+inline std::size_t format_fixed(int64_t value, int decimals, char* buf, std::size_t len)
+{
+    char tmp[48];
+    std::size_t n = 0;
+    uint64_t v = (value < 0) ? (0 - static_cast<uint64_t>(value)) : static_cast<uint64_t>(value);
+
+    for (int i = 0; i < decimals; ++i)
+    {
+        tmp[n++] = static_cast<char>('0' + (v % 10));
+        v /= 10;
+    }
+    if (decimals > 0) tmp[n++] = '.';
+    do
+    {
+        tmp[n++] = static_cast<char>('0' + (v % 10));
+        v /= 10;
+    } while (v != 0);
+    if (value < 0) tmp[n++] = '-';
+
+    if (n + 1 > len) return 0;
+    for (std::size_t i = 0; i < n; ++i) buf[i] = tmp[n - 1 - i];
+    buf[n] = '\0';
+
+    return n;
+}
+
+/// \overload
+inline std::string format_fixed(int64_t value, int decimals)
+{
+    char buf[48];
+    return std::string(buf, format_fixed(value, decimals, buf, sizeof(buf)));
+}
+
+}
+
+#endif /* FIXED_POINT_HPP */
@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   fixed_point_test.cpp
+ * Author: Chris Morrison
+ *
+ * Created on 20 October 2026, 18:20
+ */
+#include <cstdint>
+#include <limits>
+#include <string>
+#include "fixed_point.hpp"
+#include "unit_test.hpp"
+
+using namespace mercury;
+
+static const int64_t largest = std::numeric_limits<int64_t>::max();
+
+// Parses text, giving -1 for text that does not parse so that a check can compare in one go.
+static int64_t parsed(const char* text, int decimals)
+{
+    int64_t out = 0;
+    return parse_fixed(std::string(text), decimals, out) ? out : -1;
+}
+
+static void test_parse()
+{
+    CHECK(parsed("8123.45", 2) == 812345);
+    CHECK(parsed("8123.45", 8) == 812345000000LL);
+    CHECK(parsed("0.00000001", 8) == 1);
+    CHECK(parsed("+3", 2) == 300);
+    CHECK(parsed(".5", 2) == 50);
+    CHECK(parsed("5.", 2) == 500);
+    CHECK(parsed("007", 0) == 7);
+
+    int64_t out = 0;
+    CHECK(parse_fixed(std::string("-0.5"), 2, out) && out == -50);
+
+    // Extra digits are cut off, never rounded.
+    CHECK(parsed("1.239", 2) == 123);
+    CHECK(parsed("12.99", 0) == 12);
+    CHECK(parsed("0.123456789123456789123", 18) == 123456789123456789LL);
+}
+
+static void test_parse_rejects()
+{
+    const char* const bad[] = { "", "-", "+", ".", "-.", "1.2.3", "1e5", " 1", "1 ", "0x10", "12,5", "--1", "1-" };
+
+    for (const char* text : bad)
+    {
+        int64_t out = 42;
+        bool ok = parse_fixed(std::string(text), 2, out);
+        CHECK(!ok);
+        CHECK(out == 42);
+        if (ok) std::fprintf(stderr, "    accepted \"%s\"\n", text);
+    }
+}
+
+static void test_parse_range()
+{
+    CHECK(parsed("9223372036854775807", 0) == largest);
+    CHECK(parsed("9223372036854775808", 0) == -1);
+    CHECK(parsed("99999999999999999999", 0) == -1);
+
+    // The scaled value is what must fit, not just the digits.
+    CHECK(parsed("92233720368.54775807", 8) == largest);
+    CHECK(parsed("92233720368.54775808", 8) == -1);
+    CHECK(parsed("92233720369", 8) == -1);
+    CHECK(parsed("9.223372036854775807", 18) == largest);
+    CHECK(parsed("10", 18) == -1);
+}
+
+// Formats a value, giving an empty string if the buffer was too small.
+static std::string formatted(int64_t value, int decimals, std::size_t len = 48)
+{
+    char buf[48];
+    std::size_t n = format_fixed(value, decimals, buf, len);
+    return (n == 0) ? std::string() : std::string(buf, n);
+}
+
+static void test_format()
+{
+    CHECK(formatted(812345, 2) == "8123.45");
+    CHECK(formatted(-50, 2) == "-0.50");
+    CHECK(formatted(1, 8) == "0.00000001");
+    CHECK(formatted(0, 8) == "0.00000000");
+    CHECK(formatted(5, 0) == "5");
+    CHECK(formatted(0, 0) == "0");
+    CHECK(formatted(largest, 0) == "9223372036854775807");
+    CHECK(formatted(std::numeric_limits<int64_t>::min(), 0) == "-9223372036854775808");
+    CHECK(formatted(largest, 18) == "9.223372036854775807");
+    CHECK(format_fixed(812345, 2) == "8123.45");
+
+    // Seven characters and the terminating null.
+    CHECK(formatted(812345, 2, 8) == "8123.45");
+    CHECK(formatted(812345, 2, 7).empty());
+    CHECK(formatted(812345, 2, 0).empty());
+}
+
+static void test_round_trip()
+{
+    const int64_t values[] = { 0, 1, -1, 9, 10, 99, 100, 812345, -812345, 100000000, 123456789012345LL, largest, -largest };
+
+    for (int decimals : { 0, 2, 8, max_decimals })
+    {
+        for (int64_t value : values)
+        {
+            int64_t back = 0;
+            CHECK(parse_fixed(format_fixed(value, decimals), decimals, back));
+            CHECK(back == value);
+        }
+    }
+}
+
+int main()
+{
+    test_parse();
+    test_parse_rejects();
+    test_parse_range();
+    test_format();
+    test_round_trip();
+
+    return test_result("fixed_point");
+}
@@ -0,0 +1,233 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   indicators.cpp
+ * Author: Chris Morrison
+ *
+ * Created on 19 October 2026, 11:05
+ */
+#include <algorithm>
+#include "indicators.hpp"
+
+namespace mercury
+{
+
+// ------------------------------------------------------------------------------------------------
+// Batch kernels.
+//
+// The loops below keep four independent accumulators so that the compiler can map them straight
+// onto vector registers without needing to reassociate floating point additions.
+// ------------------------------------------------------------------------------------------------
+
+double ema_of(const double* x, std::size_t n, double alpha)
+{
+    // Expanded, the average after n values is
+    //     (1 - alpha)^(n - 1) * x[0] + sum(i = 1..n-1) alpha * (1 - alpha)^(n - 1 - i) * x[i]
+    // i.e. a dot product with geometrically decaying weights, walked backwards from the newest value.
+    // Weights below 1e-18 cannot affect a double, so very long histories are cut short.
+    const double decay = 1.0 - alpha;
+    const double decay4 = decay * decay * decay * decay;
+    std::size_t depth = n - 1;
+
+    if (decay > 0.0 && decay < 1.0)
+    {
+        double cutoff = std::log(1e-18) / std::log(decay);
+        if (cutoff < double(depth)) depth = static_cast<std::size_t>(cutoff);
+    }
+
+    double w[4] = { alpha, alpha * decay, alpha * decay * decay, alpha * decay * decay * decay };
+    double acc[4] = { 0.0, 0.0, 0.0, 0.0 };
+    const double* newest = x + n - 1;
+    std::size_t k = 0;
+
+    for (; k + 4 <= depth; k += 4)
+    {
+        for (int j = 0; j < 4; ++j)
+        {
+            acc[j] += w[j] * newest[-static_cast<std::ptrdiff_t>(k + j)];
+            w[j] *= decay4;
+        }
+    }
+    for (int j = 0; k < depth; ++k, ++j) acc[0] += w[j] * newest[-static_cast<std::ptrdiff_t>(k)];
+
+    double result = (acc[0] + acc[1]) + (acc[2] + acc[3]);
+
+    // Whatever weight has not been handed out stays on the oldest value used; when the history was not
+    // cut short this is exactly the (1 - alpha)^(n - 1) weight of the seed.
+    result += std::pow(decay, double(depth)) * x[n - 1 - depth];
+
+    return result;
+}
+
+void sum_and_squares(const double* x, std::size_t n, double& sum, double& squares)
+{
+    double s[4] = { 0.0, 0.0, 0.0, 0.0 };
+    double q[4] = { 0.0, 0.0, 0.0, 0.0 };
+    std::size_t i = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+        for (int j = 0; j < 4; ++j)
+        {
+            s[j] += x[i + j];
+            q[j] += x[i + j] * x[i + j];
+        }
+    }
+    for (; i < n; ++i)
+    {
+        s[0] += x[i];
+        q[0] += x[i] * x[i];
+    }
+
+    sum = (s[0] + s[1]) + (s[2] + s[3]);
+    squares = (q[0] + q[1]) + (q[2] + q[3]);
+}
+
+// ------------------------------------------------------------------------------------------------
+// Warm-up of the derived indicators.
+// ------------------------------------------------------------------------------------------------
+
+void rolling_volatility::warm_up(const double* prices, std::size_t n)
+{
+    std::vector<double> returns;
+    returns.reserve(n);
+
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        if (last_ > 0.0 && prices[i] > 0.0) returns.push_back(std::log(prices[i] / last_));
+        last_ = prices[i];
+    }
+    returns_.warm_up(returns.data(), returns.size());
+}
+
+void vwap::warm_up(const double* prices, const double* volumes, std::size_t n)
+{
+    std::vector<double> notional(n);
+
+    for (std::size_t i = 0; i < n; ++i) notional[i] = prices[i] * volumes[i];
+    notional_.warm_up(notional.data(), n);
+    volume_.warm_up(volumes, n);
+}
+
+void rsi::warm_up(const double* prices, std::size_t n)
+{
+    std::vector<double> gains;
+    std::vector<double> losses;
+    gains.reserve(n);
+    losses.reserve(n);
+
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        if (has_last_)
+        {
+            double change = prices[i] - last_;
+            gains.push_back(change > 0.0 ? change : 0.0);
+            losses.push_back(change < 0.0 ? -change : 0.0);
+        }
+        last_ = prices[i];
+        has_last_ = true;
+    }
+    gains_.warm_up(gains.data(), gains.size());
+    losses_.warm_up(losses.data(), losses.size());
+}
+
+// ------------------------------------------------------------------------------------------------
+// market_indicators
+// ------------------------------------------------------------------------------------------------
+
+market_indicators::market_indicators(const indicator_settings& settings)
+    : settings_(settings),
+      trend_(settings.trend_period),
+      volatility_(settings.volatility_window),
+      vwap_(settings.vwap_window),
+      bands_(settings.band_window, settings.band_width),
+      rsi_(settings.rsi_period)
+{
+}
+
+void market_indicators::update(double price, double volume)
+{
+    trend_.update(price);
+    volatility_.update(price);
+    vwap_.update(price, volume);
+    bands_.update(price);
+    rsi_.update(price);
+    last_ = price;
+}
+
+void market_indicators::warm_up(const double* prices, std::size_t n)
+{
+    if (n == 0) return;
+
+    std::vector<double> volumes(n, 1.0);
+
+    trend_.warm_up(prices, n);
+    volatility_.warm_up(prices, n);
+    vwap_.warm_up(prices, volumes.data(), n);
+    bands_.warm_up(prices, n);
+    rsi_.warm_up(prices, n);
+    last_ = prices[n - 1];
+}
+
+bool market_indicators::ready() const
+{
+    return trend_.ready() && volatility_.ready() && vwap_.ready() && bands_.ready() && rsi_.ready();
+}
+
+bool market_indicators::falling_sharply() const
+{
+    return ready() && last_ < bands_.lower() && rsi_.value() <= settings_.rsi_oversold;
+}
+
+bool market_indicators::rising_sharply() const
+{
+    return ready() && last_ > bands_.upper() && rsi_.value() >= settings_.rsi_overbought;
+}
+
+long double market_indicators::adjustment_rate(long double price, long double rate) const
+{
+    if (!ready() || price <= 0.0) return rate;
+
+    long double swing = (bands_.upper() - bands_.middle()) / price;
+
+    return std::max(rate, swing);
+}
+
+void market_indicators::save(snapshot_writer& out) const
+{
+    trend_.save(out);
+    volatility_.save(out);
+    vwap_.save(out);
+    bands_.save(out);
+    rsi_.save(out);
+    out.put(last_);
+}
+
+bool market_indicators::load(snapshot_reader& in)
+{
+    market_indicators loaded(settings_);
+
+    if (!loaded.trend_.load(in) || !loaded.volatility_.load(in) || !loaded.vwap_.load(in) || !loaded.bands_.load(in) ||
+        !loaded.rsi_.load(in) || !in.get(loaded.last_))
+    {
+        return false;
+    }
+
+    *this = loaded;
+    return true;
+}
+
+}
@@ -0,0 +1,420 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   indicators.hpp
+ * Author: Chris Morrison
+ *
+ * Created on 19 October 2026, 11:05
+ */
+#ifndef INDICATORS_HPP
+#define INDICATORS_HPP
+
+#include <cstddef>
+#include <cmath>
+#include <vector>
+#include "snapshot.hpp"
+
+// ------------------------------------------------------------------------------------------------
+// Streaming market indicators.
+//
+// Every indicator is updated in O(1) per tick and never allocates after construction. Each one also
+// has a warm_up() that loads a block of history in one go using vectorisable batch kernels; the
+// state after warm_up() is the same as after calling update() for every value in turn. Every one can
+// save its state to a snapshot and load it back, so price history survives a restart.
+// ------------------------------------------------------------------------------------------------
+
+namespace mercury
+{
+
+// ------------------------------------------------------------------------------------------------
+// Batch kernels used for warm-up.
+// ------------------------------------------------------------------------------------------------
+
+///
+/// Computes the value an exponential moving average seeded with x[0] has after consuming x[0..n).
+///
+/// \param x     The series.
+/// \param n     Number of values, must be at least 1.
+/// \param alpha Smoothing factor.
+double ema_of(const double* x, std::size_t n, double alpha);
+
+/// Sums x[0..n) and the squares of x[0..n).
+void sum_and_squares(const double* x, std::size_t n, double& sum, double& squares);
+
+// ------------------------------------------------------------------------------------------------
+// Building blocks.
+// ------------------------------------------------------------------------------------------------
+
+///
+/// Exponential moving average.
+class ema
+{
+public:
+    explicit ema(std::size_t period) : period_(period ? period : 1), alpha_(2.0 / (period_ + 1.0)) {}
+
+    void update(double x)
+    {
+        value_ = count_ ? value_ + alpha_ * (x - value_) : x;
+        ++count_;
+    }
+
+    void warm_up(const double* x, std::size_t n)
+    {
+        if (n == 0) return;
+
+        // Seeding with x[0] differs from carrying on from the current value only in the weight left on
+        // the seed, which decays as (1 - alpha)^n.
+        double fresh = ema_of(x, n, alpha_);
+        value_ = count_ ? fresh + (value_ - x[0]) * std::pow(1.0 - alpha_, double(n)) : fresh;
+        count_ += n;
+    }
+
+    /// Resets the average to use a different smoothing factor (Wilder's RSI uses 1 / period).
+    void set_alpha(double alpha) { alpha_ = alpha; }
+
+    double value() const { return value_; }
+    bool ready() const { return count_ >= period_; }
+    std::size_t count() const { return count_; }
+
+    void save(snapshot_writer& out) const
+    {
+        out.put(value_);
+        out.put(uint64_t(count_));
+    }
+
+    bool load(snapshot_reader& in)
+    {
+        uint64_t count = 0;
+        if (!in.get(value_) || !in.get(count)) return false;
+        count_ = count;
+        return true;
+    }
+
+private:
+    std::size_t period_;
+    double alpha_;
+    double value_ = 0.0;
+    std::size_t count_ = 0;
+};
+
+///
+/// Fixed-size window of the most recent values with running sum and sum of squares.
+class rolling_window
+{
+public:
+    explicit rolling_window(std::size_t size) : values_(size ? size : 1, 0.0) {}
+
+    void update(double x)
+    {
+        std::size_t size = values_.size();
+
+        if (count_ >= size)
+        {
+            double old = values_[head_];
+            sum_ -= old;
+            squares_ -= old * old;
+        }
+        values_[head_] = x;
+        sum_ += x;
+        squares_ += x * x;
+        head_ = (head_ + 1 == size) ? 0 : head_ + 1;
+        ++count_;
+
+        // Re-sum from scratch once per lap so rounding errors cannot accumulate.
+        if (head_ == 0) sum_and_squares(values_.data(), size, sum_, squares_);
+    }
+
+    void warm_up(const double* x, std::size_t n)
+    {
+        std::size_t size = values_.size();
+
+        if (n >= size)
+        {
+            for (std::size_t i = 0; i < size; ++i) values_[i] = x[n - size + i];
+            head_ = 0;
+            count_ += n;
+            sum_and_squares(values_.data(), size, sum_, squares_);
+            return;
+        }
+        for (std::size_t i = 0; i < n; ++i) update(x[i]);
+    }
+
+    bool full() const { return count_ >= values_.size(); }
+    std::size_t size() const { return (count_ < values_.size()) ? count_ : values_.size(); }
+    double sum() const { return sum_; }
+
+    double mean() const
+    {
+        std::size_t n = size();
+        return n ? sum_ / n : 0.0;
+    }
+
+    double variance() const
+    {
+        std::size_t n = size();
+        if (n < 2) return 0.0;
+        double m = sum_ / n;
+        double v = (squares_ - n * m * m) / (n - 1);
+        return (v > 0.0) ? v : 0.0;
+    }
+
+    double stddev() const { return std::sqrt(variance()); }
+
+    void save(snapshot_writer& out) const
+    {
+        out.put(values_.data(), values_.size());
+        out.put(uint64_t(head_));
+        out.put(uint64_t(count_));
+        out.put(sum_);
+        out.put(squares_);
+    }
+
+    /// Fails if the window was saved with a different size.
+    bool load(snapshot_reader& in)
+    {
+        uint64_t head = 0;
+        uint64_t count = 0;
+        if (!in.get(values_.data(), values_.size()) || !in.get(head) || !in.get(count) || !in.get(sum_) || !in.get(squares_)) return false;
+        if (head >= values_.size()) return false;
+        head_ = head;
+        count_ = count;
+        return true;
+    }
+
+private:
+    std::vector<double> values_;
+    std::size_t head_ = 0;
+    std::size_t count_ = 0;
+    double sum_ = 0.0;
+    double squares_ = 0.0;
+};
+
+// ------------------------------------------------------------------------------------------------
+// Indicators.
+// ------------------------------------------------------------------------------------------------
+
+///
+/// Standard deviation of log returns over a window of ticks.
+class rolling_volatility
+{
+public:
+    explicit rolling_volatility(std::size_t window) : returns_(window) {}
+
+    void update(double price)
+    {
+        if (last_ > 0.0 && price > 0.0) returns_.update(std::log(price / last_));
+        last_ = price;
+    }
+
+    void warm_up(const double* prices, std::size_t n);
+
+    double value() const { return returns_.stddev(); }
+    bool ready() const { return returns_.full(); }
+
+    void save(snapshot_writer& out) const
+    {
+        returns_.save(out);
+        out.put(last_);
+    }
+
+    bool load(snapshot_reader& in) { return returns_.load(in) && in.get(last_); }
+
+private:
+    rolling_window returns_;
+    double last_ = 0.0;
+};
+
+///
+/// Volume weighted average price over a window of ticks.
+class vwap
+{
+public:
+    explicit vwap(std::size_t window) : notional_(window), volume_(window) {}
+
+    void update(double price, double volume)
+    {
+        notional_.update(price * volume);
+        volume_.update(volume);
+    }
+
+    void warm_up(const double* prices, const double* volumes, std::size_t n);
+
+    double value() const { return (volume_.sum() > 0.0) ? notional_.sum() / volume_.sum() : 0.0; }
+    bool ready() const { return volume_.full(); }
+
+    void save(snapshot_writer& out) const
+    {
+        notional_.save(out);
+        volume_.save(out);
+    }
+
+    bool load(snapshot_reader& in) { return notional_.load(in) && volume_.load(in); }
+
+private:
+    rolling_window notional_;
+    rolling_window volume_;
+};
+
+///
+/// Bollinger bands: a simple moving average plus and minus a multiple of the standard deviation.
+class bollinger_bands
+{
+public:
+    bollinger_bands(std::size_t window, double width) : prices_(window), width_(width) {}
+
+    void update(double price) { prices_.update(price); }
+    void warm_up(const double* prices, std::size_t n) { prices_.warm_up(prices, n); }
+
+    double middle() const { return prices_.mean(); }
+    double upper() const { return prices_.mean() + width_ * prices_.stddev(); }
+    double lower() const { return prices_.mean() - width_ * prices_.stddev(); }
+    bool ready() const { return prices_.full(); }
+
+    void save(snapshot_writer& out) const { prices_.save(out); }
+    bool load(snapshot_reader& in) { return prices_.load(in); }
+
+private:
+    rolling_window prices_;
+    double width_;
+};
+
+///
+/// Relative strength index using Wilder's smoothing of gains and losses.
+class rsi
+{
+public:
+    explicit rsi(std::size_t period) : gains_(period), losses_(period)
+    {
+        gains_.set_alpha(1.0 / (period ? period : 1));
+        losses_.set_alpha(1.0 / (period ? period : 1));
+    }
+
+    void update(double price)
+    {
+        if (has_last_)
+        {
+            double change = price - last_;
+            gains_.update(change > 0.0 ? change : 0.0);
+            losses_.update(change < 0.0 ? -change : 0.0);
+        }
+        last_ = price;
+        has_last_ = true;
+    }
+
+    void warm_up(const double* prices, std::size_t n);
+
+    double value() const
+    {
+        double down = losses_.value();
+        if (down <= 0.0) return gains_.value() > 0.0 ? 100.0 : 50.0;
+        return 100.0 - 100.0 / (1.0 + gains_.value() / down);
+    }
+
+    bool ready() const { return gains_.ready(); }
+
+    void save(snapshot_writer& out) const
+    {
+        gains_.save(out);
+        losses_.save(out);
+        out.put(last_);
+        out.put(uint32_t(has_last_));
+    }
+
+    bool load(snapshot_reader& in)
+    {
+        uint32_t has_last = 0;
+        if (!gains_.load(in) || !losses_.load(in) || !in.get(last_) || !in.get(has_last)) return false;
+        has_last_ = (has_last != 0);
+        return true;
+    }
+
+private:
+    ema gains_;
+    ema losses_;
+    double last_ = 0.0;
+    bool has_last_ = false;
+};
+
+///
+/// Tuning for market_indicators, in ticks.
+struct indicator_settings
+{
+    std::size_t trend_period = 20;
+    std::size_t volatility_window = 20;
+    std::size_t vwap_window = 20;
+    std::size_t band_window = 20;
+    double band_width = 2.0;
+    std::size_t rsi_period = 14;
+    double rsi_overbought = 70.0;
+    double rsi_oversold = 30.0;
+};
+
+///
+/// The full set of indicators kept for one product.
+class market_indicators
+{
+public:
+    explicit market_indicators(const indicator_settings& settings = indicator_settings());
+
+    /// Feeds one tick to every indicator. Without trade sizes, pass a volume of 1.
+    void update(double price, double volume = 1.0);
+
+    /// Loads a block of historical prices (all with unit volume).
+    void warm_up(const double* prices, std::size_t n);
+
+    /// True once every indicator has seen enough ticks to be meaningful.
+    bool ready() const;
+
+    /// The market is stretched downwards: price below the lower band with an oversold RSI.
+    bool falling_sharply() const;
+
+    /// The market is stretched upwards: price above the upper band with an overbought RSI.
+    bool rising_sharply() const;
+
+    ///
+    /// Works out how far from a fill price the follow-up order should be placed, as a fraction of the
+    /// price. The exchange-provided rate is used as a floor and widened to the half-width of the
+    /// Bollinger bands when the market is swinging further than that.
+    ///
+    /// \param price The fill price.
+    /// \param rate  The adjustment rate reported by the trade context.
+    long double adjustment_rate(long double price, long double rate) const;
+
+    void save(snapshot_writer& out) const;
+
+    /// Loads every indicator or, if the snapshot does not match the settings, none of them.
+    bool load(snapshot_reader& in);
+
+    double last_price() const { return last_; }
+    const ema& trend() const { return trend_; }
+    const rolling_volatility& volatility() const { return volatility_; }
+    const vwap& volume_weighted() const { return vwap_; }
+    const bollinger_bands& bands() const { return bands_; }
+    const rsi& strength() const { return rsi_; }
+
+private:
+    indicator_settings settings_;
+    ema trend_;
+    rolling_volatility volatility_;
+    vwap vwap_;
+    bollinger_bands bands_;
+    rsi rsi_;
+    double last_ = 0.0;
+};
+
+}
+
+#endif /* INDICATORS_HPP */
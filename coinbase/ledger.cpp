@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   ledger.cpp
+ * Author: Chris Morrison
+ *
+ * Created on 19 October 2026, 21:15
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include "ledger.hpp"
+
+namespace mercury
+{
+
+using namespace cryptocoin::trading;
+
+// Sizes and amounts below this are rounding noise, not coin.
+static const long double dust = 1e-12L;
+
+void position::apply(const fill& f)
+{
+    if (f.size <= 0) return;
+
+    long double price = f.value / f.size;
+
+    fees_ += f.fee;
+    volume_ += f.value;
+
+    if (f.side == buy)
+    {
+        ++buys_;
+        quantity_ += f.size;
+        cost_ += f.value;
+        if (method_ == cost_basis::fifo) lots_.push_back({ f.size, price });
+        return;
+    }
+
+    ++sells_;
+
+    long double held = (f.size < quantity_) ? f.size : quantity_;
+    if (held > 0)
+    {
+        long double sold_cost = (method_ == cost_basis::fifo) ? take_fifo(held, price) : held * average_cost();
+
+        realised_ += held * price - sold_cost;
+        cost_ -= sold_cost;
+        quantity_ -= held;
+    }
+    if (f.size - held > dust) unmatched_ += f.size - held;
+
+    if (quantity_ < dust)
+    {
+        quantity_ = 0;
+        cost_ = 0;
+        lots_.clear();
+    }
+}
+
+long double position::take_fifo(long double size, long double price)
+{
+    long double sold_cost = 0;
+
+    while (size > dust && !lots_.empty())
+    {
+        lot& oldest = lots_.front();
+        long double take = (size < oldest.size) ? size : oldest.size;
+
+        sold_cost += take * oldest.unit_cost;
+        oldest.size -= take;
+        size -= take;
+        if (oldest.size <= dust) lots_.pop_front();
+    }
+
+    // Lots and quantity can only disagree by rounding; anything left is costed at the sale price.
+    return sold_cost + size * price;
+}
+
+bool parse_cost_basis(const std::string& name, cost_basis& out)
+{
+    if (name == "fifo")
+        out = cost_basis::fifo;
+    else if (name == "average")
+        out = cost_basis::average;
+    else
+        return false;
+
+    return true;
+}
+
+position& trade_ledger::book(const std::string& pair)
+{
+    return positions_.try_emplace(pair, method_).first->second;
+}
+
+// Splits a ledger line "time:pair:side:size:value:fee:uuid" in place.
+static bool parse_line(char* line, std::string& pair, fill& f)
+{
+    char* fields[7];
+    int count = 0;
+
+    for (char* p = line; count < 7; ++count)
+    {
+        fields[count] = p;
+        if (count == 6) break;
+        p = std::strchr(p, ':');
+        if (!p) return false;
+        *p++ = '\0';
+    }
+
+    f.time_us = std::strtoll(fields[0], nullptr, 10);
+    pair = fields[1];
+    if (std::strcmp(fields[2], "BUY") == 0)
+        f.side = buy;
+    else if (std::strcmp(fields[2], "SELL") == 0)
+        f.side = sell;
+    else
+        return false;
+    f.size = std::strtold(fields[3], nullptr);
+    f.value = std::strtold(fields[4], nullptr);
+    f.fee = std::strtold(fields[5], nullptr);
+
+    return !pair.empty() && f.size > 0;
+}
+
+bool trade_ledger::open(const std::string& path)
+{
+    std::ifstream existing(path);
+    std::string line;
+    std::string pair;
+    fill f;
+
+    while (std::getline(existing, line))
+    {
+        if (parse_line(line.data(), pair, f)) book(pair).apply(f);
+    }
+
+    file_.open(path, std::ios::out | std::ios::app);
+    return file_.is_open();
+}
+
+bool trade_ledger::record(const std::string& pair, const fill& f, const std::string& uuid)
+{
+    char line[256];
+
+    book(pair).apply(f);
+
+    int len = std::snprintf(line, sizeof(line), "%lld:%s:%s:%.8Lf:%.8Lf:%.8Lf:%s\n", static_cast<long long>(f.time_us),
+                            pair.c_str(), (f.side == buy) ? "BUY" : "SELL", f.size, f.value, f.fee, uuid.c_str());
+    if (len <= 0 || len >= static_cast<int>(sizeof(line)) || !file_.is_open()) return false;
+
+    file_.write(line, len);
+    file_.flush();
+
+    return static_cast<bool>(file_);
+}
+
+void trade_ledger::summarise(std::ostream& out) const
+{
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+
+    out << std::fixed;
+    for (const auto& [pair, p] : positions_)
+    {
+        out << pair << ": " << p.buys() << " buys, " << p.sells() << " sells, volume " << std::setprecision(2) << p.volume() << std::endl;
+        out << "    holding " << std::setprecision(8) << p.quantity() << " at an average cost of " << std::setprecision(2)
+            << p.average_cost() << ", marked at " << p.mark_price() << std::endl;
+        out << "    realised " << p.realised() << ", unrealised " << p.unrealised() << ", fees " << p.fees() << ", net "
+            << p.net() << std::endl;
+        if (p.unmatched() > 0)
+            out << "    " << std::setprecision(8) << p.unmatched() << " sold that was held before the ledger began" << std::endl;
+    }
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+}
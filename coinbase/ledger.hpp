@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   ledger.hpp
+ * Author: Chris Morrison
+ *
+ * Created on 19 October 2026, 21:15
+ */
+#ifndef LEDGER_HPP
+#define LEDGER_HPP
+
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <ostream>
+#include <string>
+#include <trade_context.hpp>
+
+// ------------------------------------------------------------------------------------------------
+// Trade ledger.
+//
+// Every fill is appended to a text file, one line per fill, and is never rewritten. Positions are
+// kept up to date as fills arrive rather than rebuilt from the file: a fill costs O(1) (amortised
+// for FIFO, where each lot is pushed and popped once), and on start-up the file is replayed once to
+// pick up where the last run left off.
+//
+// Realised P&L is before fees; fees are kept separately so that the net figure is realised plus
+// unrealised less fees.
+// ------------------------------------------------------------------------------------------------
+
+namespace mercury
+{
+
+/// How the cost of coin sold is worked out.
+enum class cost_basis
+{
+    fifo,       ///< The oldest coin bought is the first sold.
+    average     ///< Every coin held costs the running average.
+};
+
+///
+/// A fill, as the exchange reported it.
+struct fill
+{
+    int64_t time_us = 0;
+    cryptocoin::trading::order_side side = cryptocoin::trading::buy;
+    long double size = 0;   ///< Coin bought or sold.
+    long double value = 0;  ///< Fiat paid or received, before fees.
+    long double fee = 0;    ///< Fiat paid in fees.
+};
+
+///
+/// Running position and P&L for one pair.
+class position
+{
+public:
+    explicit position(cost_basis method = cost_basis::fifo) : method_(method) {}
+
+    /// Applies a fill.
+    void apply(const fill& f);
+
+    /// Sets the price unrealised P&L is measured against.
+    void mark(long double price) { mark_ = price; }
+
+    long double quantity() const { return quantity_; }
+    long double cost() const { return cost_; }
+    long double average_cost() const { return (quantity_ > 0) ? cost_ / quantity_ : 0; }
+    long double realised() const { return realised_; }
+    long double unrealised() const { return (mark_ > 0) ? quantity_ * mark_ - cost_ : 0; }
+    long double fees() const { return fees_; }
+    long double net() const { return realised_ + unrealised() - fees_; }
+    long double mark_price() const { return mark_; }
+    long double volume() const { return volume_; }
+    unsigned int buys() const { return buys_; }
+    unsigned int sells() const { return sells_; }
+
+    /// Coin sold that the ledger never saw bought (held before it was started); its cost is unknown
+    /// and it is taken to have sold at cost.
+    long double unmatched() const { return unmatched_; }
+
+private:
+    struct lot
+    {
+        long double size;
+        long double unit_cost;
+    };
+
+    long double take_fifo(long double size, long double price);
+
+    cost_basis method_;
+    std::deque<lot> lots_;
+    long double quantity_ = 0;
+    long double cost_ = 0;
+    long double realised_ = 0;
+    long double fees_ = 0;
+    long double mark_ = 0;
+    long double volume_ = 0;
+    long double unmatched_ = 0;
+    unsigned int buys_ = 0;
+    unsigned int sells_ = 0;
+};
+
+///
+/// The append-only fill log and the positions built from it.
+class trade_ledger
+{
+public:
+    explicit trade_ledger(cost_basis method = cost_basis::fifo) : method_(method) {}
+
+    ///
+    /// Opens (or creates) the ledger file and replays the fills already in it.
+    ///
+    /// \return false if the file cannot be opened for appending.
+    bool open(const std::string& path);
+
+    bool is_open() const { return file_.is_open(); }
+
+    ///
+    /// Returns the position for a pair, starting an empty one if there is none yet. The reference stays
+    /// valid for the life of the ledger.
+    position& book(const std::string& pair);
+
+    ///
+    /// Appends a fill to the file and applies it to the pair's position.
+    ///
+    /// \param pair The pair traded, e.g. "BTC-EUR".
+    /// \param f    The fill.
+    /// \param uuid The order that filled, kept in the file for cross-checking with the exchange.
+    /// \return false if the fill could not be written; the position is updated regardless.
+    bool record(const std::string& pair, const fill& f, const std::string& uuid);
+
+    /// Every position, by pair.
+    const std::map<std::string, position>& positions() const { return positions_; }
+
+    /// Writes a table of every position to out.
+    void summarise(std::ostream& out) const;
+
+private:
+    cost_basis method_;
+    std::ofstream file_;
+    std::map<std::string, position> positions_;
+};
+
+///
+/// Parses a cost basis name as given on the command line ("fifo" or "average").
+///
+/// \return false if the name is not recognised.
+bool parse_cost_basis(const std::string& name, cost_basis& out);
+
+}
+
+#endif /* LEDGER_HPP */
@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   ledger_test.cpp
+ * Author: Chris Morrison
+ *
+ * Created on 20 October 2026, 19:10
+ */
+#include <cmath>
+#include <filesystem>
+#include <string>
+#include "ledger.hpp"
+#include "unit_test.hpp"
+
+using namespace mercury;
+using namespace cryptocoin::trading;
+
+// Amounts go through long double arithmetic (and the ledger file keeps eight places), so they are
+// compared to a tolerance rather than exactly.
+static bool near(long double actual, long double expected)
+{
+    return std::fabs(actual - expected) < 1e-6L;
+}
+
+static fill make_fill(order_side side, long double size, long double value, long double fee = 0)
+{
+    fill f;
+    f.side = side;
+    f.size = size;
+    f.value = value;
+    f.fee = fee;
+    return f;
+}
+
+// Two buys at different prices, then a sale of one and a half coins: the two cost bases part ways.
+static void buy_twice_sell_some(position& p)
+{
+    p.apply(make_fill(buy, 1, 100, 1));
+    p.apply(make_fill(buy, 1, 200));
+    p.apply(make_fill(sell, 1.5L, 450, 2));
+}
+
+static void test_fifo()
+{
+    position p(cost_basis::fifo);
+
+    buy_twice_sell_some(p);
+
+    // The coin sold is the whole first lot at 100 and half the second at 200.
+    CHECK(near(p.realised(), 450 - (100 + 100)));
+    CHECK(near(p.quantity(), 0.5L));
+    CHECK(near(p.cost(), 100));
+    CHECK(near(p.average_cost(), 200));
+    CHECK(near(p.fees(), 3));
+    CHECK(near(p.volume(), 750));
+    CHECK(p.buys() == 2);
+    CHECK(p.sells() == 1);
+
+    CHECK(near(p.unrealised(), 0));
+    p.mark(250);
+    CHECK(near(p.unrealised(), 0.5L * 250 - 100));
+    CHECK(near(p.net(), 250 + 25 - 3));
+
+    // Selling more than is held sells the rest at cost and counts the excess as unmatched.
+    p.apply(make_fill(sell, 1, 300));
+    CHECK(near(p.realised(), 250 + (150 - 100)));
+    CHECK(near(p.unmatched(), 0.5L));
+    CHECK(near(p.quantity(), 0));
+    CHECK(near(p.cost(), 0));
+    CHECK(near(p.unrealised(), 0));
+
+    // With nothing held the lots start again from the next buy.
+    p.apply(make_fill(buy, 2, 500));
+    p.apply(make_fill(sell, 1, 300));
+    CHECK(near(p.realised(), 300 + (300 - 250)));
+    CHECK(near(p.average_cost(), 250));
+}
+
+static void test_fifo_across_lots()
+{
+    position p(cost_basis::fifo);
+
+    p.apply(make_fill(buy, 1, 10));
+    p.apply(make_fill(buy, 1, 20));
+    p.apply(make_fill(buy, 1, 30));
+
+    // Sales that split lots take the oldest first, whatever their size.
+    p.apply(make_fill(sell, 0.5L, 20));
+    CHECK(near(p.realised(), 20 - 5));
+    p.apply(make_fill(sell, 1, 40));
+    CHECK(near(p.realised(), 15 + (40 - (5 + 10))));
+    CHECK(near(p.cost(), 10 + 30));
+    p.apply(make_fill(sell, 1.5L, 60));
+    CHECK(near(p.realised(), 40 + (60 - (10 + 30))));
+    CHECK(near(p.quantity(), 0));
+    CHECK(near(p.unmatched(), 0));
+}
+
+static void test_average()
+{
+    position p(cost_basis::average);
+
+    buy_twice_sell_some(p);
+
+    // Every coin costs the average of 150.
+    CHECK(near(p.realised(), 450 - 225));
+    CHECK(near(p.quantity(), 0.5L));
+    CHECK(near(p.cost(), 75));
+    CHECK(near(p.average_cost(), 150));
+
+    // A buy at a new price moves the average; the coin already held keeps its share of the cost.
+    p.apply(make_fill(buy, 0.5L, 125));
+    CHECK(near(p.average_cost(), 200));
+    p.apply(make_fill(sell, 1, 100));
+    CHECK(near(p.realised(), 225 + (100 - 200)));
+    CHECK(near(p.quantity(), 0));
+}
+
+static void test_ignored_fills()
+{
+    position p;
+
+    p.apply(make_fill(buy, 0, 100, 5));
+    p.apply(make_fill(buy, -1, 100, 5));
+    CHECK(p.buys() == 0);
+    CHECK(near(p.fees(), 0));
+
+    // Coin sold before the ledger saw it bought has an unknown cost and is taken to sell at cost.
+    p.apply(make_fill(sell, 2, 200));
+    CHECK(near(p.realised(), 0));
+    CHECK(near(p.unmatched(), 2));
+    CHECK(near(p.quantity(), 0));
+}
+
+static void test_replay()
+{
+    const std::string path = (std::filesystem::temp_directory_path() / "mercury_ledger_test.txt").string();
+    std::filesystem::remove(path);
+
+    {
+        trade_ledger ledger(cost_basis::fifo);
+        CHECK(ledger.open(path));
+        CHECK(ledger.record("BTC-EUR", make_fill(buy, 1, 100, 1), "order-1"));
+        CHECK(ledger.record("BTC-EUR", make_fill(buy, 1, 200), "order-2"));
+        CHECK(ledger.record("ETH-EUR", make_fill(buy, 4, 40, 0.5L), "order-3"));
+        CHECK(ledger.record("BTC-EUR", make_fill(sell, 1.5L, 450, 2), "order-4"));
+    }
+
+    // A ledger opened on the same file picks up where the last one left off.
+    trade_ledger ledger(cost_basis::fifo);
+    CHECK(ledger.open(path));
+    CHECK(ledger.positions().size() == 2);
+
+    const position& btc = ledger.book("BTC-EUR");
+    CHECK(near(btc.realised(), 250));
+    CHECK(near(btc.quantity(), 0.5L));
+    CHECK(near(btc.cost(), 100));
+    CHECK(near(btc.fees(), 3));
+    CHECK(btc.buys() == 2 && btc.sells() == 1);
+
+    const position& eth = ledger.book("ETH-EUR");
+    CHECK(near(eth.quantity(), 4));
+    CHECK(near(eth.average_cost(), 10));
+
+    // The same fills read with the other cost basis give the average figures.
+    trade_ledger averaged(cost_basis::average);
+    CHECK(averaged.open(path));
+    CHECK(near(averaged.book("BTC-EUR").realised(), 225));
+
+    std::filesystem::remove(path);
+}
+
+static void test_parse_cost_basis()
+{
+    cost_basis method = cost_basis::fifo;
+
+    CHECK(parse_cost_basis("average", method) && method == cost_basis::average);
+    CHECK(parse_cost_basis("fifo", method) && method == cost_basis::fifo);
+    CHECK(!parse_cost_basis("lifo", method));
+    CHECK(!parse_cost_basis("", method));
+    CHECK(method == cost_basis::fifo);
+}
+
+int main()
+{
+    test_fifo();
+    test_fifo_across_lots();
+    test_average();
+    test_ignored_fills();
+    test_replay();
+    test_parse_cost_basis();
+
+    return test_result("ledger");
+}
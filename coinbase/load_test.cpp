@@ -0,0 +1,466 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   load_test.cpp
+ * Author: Chris Morrison
+ *
+ * Created on 20 October 2026, 00:35
+ */
+#include <sys/resource.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/thread_pool.hpp>
+#include <boost/thread/mutex.hpp>
+#include <tclap/CmdLine.h>
+#include "async_exchange.hpp"
+#include "exchange_context.hpp"
+#include "task.hpp"
+#include "trader.hpp"
+
+// ------------------------------------------------------------------------------------------------
+// mercury-load-test: finds out how many work orders one robot process can carry.
+//
+// Runs the real trading loop for N work orders against simulated exchanges that answer every call
+// after a delay drawn from a log-normal distribution, the shape round trips to a REST API usually
+// have. The work orders are spread over a number of markets; as in the robot, each market has its own
+// exchange context, calls to one market are made one at a time on a strand of a shared worker pool,
+// and every work order keeps its work order file open.
+//
+// N is ramped from 1 to the maximum in steps of ten. For every stage the tool reports the steps
+// (order posts, status checks) handled per second, the p50 and p99 time a work order takes to handle
+// one step, the resident memory and the CPU time used per work order, and the threads and file
+// descriptors in use. A stage that cannot start, typically because the process has run out of file
+// descriptors, ends the ramp and says why.
+// ------------------------------------------------------------------------------------------------
+
+struct load_settings
+{
+    unsigned int max_bots = 10000;
+    unsigned int markets = 10;
+    unsigned int threads = 4;
+    unsigned int stage_seconds = 10;
+    unsigned int interval_ms = 1000;
+    double latency_ms = 50.0;
+    double latency_p99_ms = 250.0;
+    unsigned int fill_checks = 3;
+};
+
+///
+/// An exchange that keeps its orders in memory and sleeps before every answer, as a real one would
+/// keep the calling thread waiting. Prices take a small random walk; every order rests for a random
+/// number of status checks and then fills. Only ever called on one strand, so it needs no locking.
+class latency_context : public mercury::exchange_context
+{
+public:
+    latency_context(const load_settings& settings, unsigned int seed)
+        : random_(seed), fill_checks_(0, settings.fill_checks)
+    {
+        // The p99 of a log-normal distribution lies 2.326 standard deviations above its median.
+        double sigma = std::log(std::max(settings.latency_p99_ms, settings.latency_ms) / settings.latency_ms) / 2.326;
+        latency_ = std::lognormal_distribution<double>(std::log(settings.latency_ms * 1000.0), sigma);
+        product_.set("BTC-EUR", "0.01", "0.00000001", "0.001", "70");
+    }
+
+    std::string fiat_balance() override { return fiat_; }
+    std::string coin_balance() override { return coin_; }
+
+    std::string current_price() override
+    {
+        std::string price;
+        read_current_price(price);
+        return price;
+    }
+
+    void read_current_price(std::string& out) override
+    {
+        char text[32];
+
+        delay();
+        price_ *= 1.0 + step_(random_);
+        std::snprintf(text, sizeof(text), "%.2f", price_);
+        out.assign(text);
+    }
+
+    void read_fiat_balance(std::string& out) override
+    {
+        delay();
+        out.assign(fiat_);
+    }
+
+    void read_coin_balance(std::string& out) override
+    {
+        delay();
+        out.assign(coin_);
+    }
+
+    cryptocoin::trading::order_status post_order(cryptocoin::trading::order_side, cryptocoin::trading::order_type,
+                                                 const std::string&, const std::string&, const std::string&,
+                                                 std::string& out_uuid) override
+    {
+        char uuid[32];
+
+        delay();
+        std::snprintf(uuid, sizeof(uuid), "load-%010lu", ++serial_);
+        out_uuid.assign(uuid);
+        orders_[out_uuid] = fill_checks_(random_);
+        return cryptocoin::trading::in_progress;
+    }
+
+    cryptocoin::trading::order_status get_order_status(const std::string& uuid) override
+    {
+        delay();
+        return check(uuid);
+    }
+
+    bool get_order_statuses(const std::vector<std::string>& uuids, std::vector<cryptocoin::trading::order_status>& out) override
+    {
+        // One listing of the open orders answers for all of them.
+        delay();
+        out.resize(uuids.size());
+        for (std::size_t i = 0; i < uuids.size(); ++i) out[i] = check(uuids[i]);
+        return true;
+    }
+
+    cryptocoin::trading::order_status cancel_order(const std::string& uuid) override
+    {
+        delay();
+        return (orders_.erase(uuid) != 0) ? cryptocoin::trading::cancelled : cryptocoin::trading::completed;
+    }
+
+    long double sell_price_adjustment() override { return 0.001; }
+    long double buy_price_ajustment() override { return 0.001; }
+
+    bool get_product_info(mercury::product_info& out) override
+    {
+        delay();
+        out = product_;
+        return true;
+    }
+
+private:
+    void delay()
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(static_cast<int64_t>(latency_(random_))));
+    }
+
+    /// Counts a status check against an order, which fills once it has rested long enough.
+    cryptocoin::trading::order_status check(const std::string& uuid)
+    {
+        auto order = orders_.find(uuid);
+        if (order == orders_.end()) return cryptocoin::trading::completed;
+        if (order->second == 0)
+        {
+            orders_.erase(order);
+            return cryptocoin::trading::completed;
+        }
+        --order->second;
+        return cryptocoin::trading::in_progress;
+    }
+
+    std::mt19937_64 random_;
+    std::lognormal_distribution<double> latency_;
+    std::uniform_int_distribution<unsigned int> fill_checks_;
+    std::normal_distribution<double> step_{0.0, 0.0005};
+    std::unordered_map<std::string, unsigned int> orders_;
+    unsigned long serial_ = 0;
+    double price_ = 8000.0;
+    const char* fiat_ = "1000.00";
+    const char* coin_ = "0.12345678";
+    mercury::product_info product_;
+};
+
+struct load_market
+{
+    load_market(const load_settings& settings, unsigned int seed, boost::asio::io_context& io, boost::asio::thread_pool& pool)
+        : context(settings, seed), exchange(context, io, &pool)
+    {
+    }
+
+    latency_context context;
+    mercury::async_exchange exchange;
+};
+
+/// What a stage measured.
+struct stage_result
+{
+    unsigned long steps = 0;
+    double seconds = 0.0;
+    double p50_ms = 0.0;
+    double p99_ms = 0.0;
+    double cpu_seconds = 0.0;
+    long rss_kb = 0;
+    long rss_growth_kb = 0;
+    long threads = 0;
+    long descriptors = 0;
+};
+
+/// Reads a "<name>: <number>" line from /proc/self/status, 0 if it is not there.
+static long proc_status(const char* name)
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    std::size_t len = std::strlen(name);
+
+    while (std::getline(status, line))
+    {
+        if (line.compare(0, len, name) == 0 && line.size() > len && line[len] == ':')
+            return std::strtol(line.c_str() + len + 1, nullptr, 10);
+    }
+
+    return 0;
+}
+
+static long open_descriptors()
+{
+    std::error_code error;
+    long count = 0;
+
+    for (std::filesystem::directory_iterator it("/proc/self/fd", error), end; !error && it != end; it.increment(error)) ++count;
+
+    return count;
+}
+
+static double cpu_seconds()
+{
+    rusage usage = {};
+    getrusage(RUSAGE_SELF, &usage);
+
+    return double(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) + double(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+///
+/// Steps one work order until the stage ends, at most once per interval, recording how long every
+/// step took. The first step is put off by a random part of the interval so that the work orders do
+/// not all start at once.
+static mercury::task<void> drive(mercury::trader& robot, mercury::async_exchange& exchange, std::chrono::microseconds offset,
+                                 std::chrono::microseconds interval, const bool& stopping, std::vector<int64_t>& latencies)
+{
+    co_await exchange.wait(offset);
+    while (!stopping)
+    {
+        auto started = std::chrono::steady_clock::now();
+        bool running = co_await robot.step(exchange);
+        auto took = std::chrono::steady_clock::now() - started;
+
+        if (!running) break;
+        latencies.push_back(std::chrono::duration_cast<std::chrono::microseconds>(took).count());
+        if (took < interval) co_await exchange.wait(interval - took);
+    }
+}
+
+static double percentile(std::vector<int64_t>& values, double fraction)
+{
+    if (values.empty()) return 0.0;
+
+    std::size_t n = static_cast<std::size_t>(fraction * double(values.size() - 1));
+    std::nth_element(values.begin(), values.begin() + n, values.end());
+
+    return double(values[n]) / 1000.0;
+}
+
+///
+/// Runs one stage of the ramp.
+///
+/// \param settings The load to apply.
+/// \param bots     Number of work orders.
+/// \param folder   Where to keep the work order files.
+/// \param result   Receives the measurements.
+/// \param error    Receives the reason if the stage could not be run.
+/// \return false if the stage could not be set up.
+static bool run_stage(const load_settings& settings, unsigned int bots, const std::filesystem::path& folder, stage_result& result,
+                      std::string& error)
+{
+    boost::mutex mtx;
+    std::ostream quiet(nullptr);
+    boost::asio::io_context io;
+    boost::asio::thread_pool pool(settings.threads);
+    std::vector<std::unique_ptr<load_market>> markets;
+    std::vector<std::unique_ptr<mercury::trader>> robots;
+    std::vector<int64_t> latencies;
+    std::mt19937 random(bots);
+    std::uniform_int_distribution<int64_t> offset(0, int64_t(settings.interval_ms) * 1000);
+    mercury::trader_settings trading;
+    bool stopping = false;
+    long rss_before = proc_status("VmRSS");
+
+    unsigned int market_count = std::min(settings.markets, bots);
+    for (unsigned int i = 0; i < market_count; ++i)
+        markets.push_back(std::make_unique<load_market>(settings, bots * 31 + i, io, pool));
+
+    latencies.reserve(std::size_t(bots) * settings.stage_seconds * 1000 / std::max(settings.interval_ms, 1u) + 1024);
+    for (unsigned int i = 0; i < bots; ++i)
+    {
+        std::filesystem::path path = folder / ("work-order-" + std::to_string(i) + ".txt");
+        {
+            std::ofstream file(path, std::ios::trunc);
+            file << "BTC:BUY:EUR:8000.00:NONE" << std::endl;
+            if (!file)
+            {
+                error = "the work order file " + path.string() + " could not be written: " + std::strerror(errno);
+                return false;
+            }
+        }
+
+        auto robot = std::make_unique<mercury::trader>(trading, mtx, quiet);
+        if (!robot->open(path.string()))
+        {
+            error = "work order " + std::to_string(i + 1) + " could not open its file: " + std::strerror(errno);
+            return false;
+        }
+
+        // The pacing is done by drive(), not by the trader's own waits.
+        robot->skip_waits();
+        robots.push_back(std::move(robot));
+    }
+
+    for (auto& market : markets) market->exchange.reconciler().set_max_age(std::chrono::seconds(0));
+
+    for (unsigned int i = 0; i < bots; ++i)
+    {
+        mercury::async_exchange& exchange = markets[i % market_count]->exchange;
+        std::chrono::microseconds start(offset(random));
+        mercury::spawn(io, drive(*robots[i], exchange, start, std::chrono::milliseconds(settings.interval_ms), stopping, latencies));
+    }
+
+    // The stage ends when the timer fires; the work orders then finish the step they are on.
+    boost::asio::steady_timer stage_timer(io, std::chrono::seconds(settings.stage_seconds));
+    stage_timer.async_wait([&](const boost::system::error_code&)
+    {
+        stopping = true;
+        result.rss_kb = proc_status("VmRSS");
+        result.threads = proc_status("Threads");
+        result.descriptors = open_descriptors();
+    });
+
+    double cpu_before = cpu_seconds();
+    auto started = std::chrono::steady_clock::now();
+    io.run();
+    pool.join();
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    result.cpu_seconds = cpu_seconds() - cpu_before;
+    result.rss_growth_kb = result.rss_kb - rss_before;
+    result.steps = latencies.size();
+    result.p50_ms = percentile(latencies, 0.50);
+    result.p99_ms = percentile(latencies, 0.99);
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    load_settings settings;
+
+    try
+    {
+        TCLAP::CmdLine cmd("Load test for the cryptocoin trading robot", ' ', "0.1");
+
+        TCLAP::ValueArg<unsigned int> bots_arg("n", "max-bots", "Largest number of work orders to ramp up to (default: 10000)", false, 10000, "number");
+        cmd.add(bots_arg);
+        TCLAP::ValueArg<unsigned int> markets_arg("m", "markets", "Number of markets the work orders are spread over (default: 10)", false, 10, "number");
+        cmd.add(markets_arg);
+        TCLAP::ValueArg<unsigned int> threads_arg("t", "exchange-threads", "Threads used to make calls to the exchange (default: 4)", false, 4, "number");
+        cmd.add(threads_arg);
+        TCLAP::ValueArg<unsigned int> seconds_arg("s", "stage-seconds", "How long to run each stage of the ramp (default: 10)", false, 10, "number");
+        cmd.add(seconds_arg);
+        TCLAP::ValueArg<unsigned int> interval_arg("i", "interval", "Milliseconds between the steps of one work order (default: 1000)", false, 1000, "number");
+        cmd.add(interval_arg);
+        TCLAP::ValueArg<double> latency_arg("l", "latency", "Median milliseconds the exchange takes to answer (default: 50)", false, 50.0, "number");
+        cmd.add(latency_arg);
+        TCLAP::ValueArg<double> p99_arg("", "latency-p99", "99th percentile of the exchange's answer time, milliseconds (default: 250)", false, 250.0, "number");
+        cmd.add(p99_arg);
+        TCLAP::ValueArg<unsigned int> fill_arg("f", "fill-checks", "Most status checks an order rests for before it fills (default: 3)", false, 3, "number");
+        cmd.add(fill_arg);
+
+        cmd.parse(argc, argv);
+
+        settings.max_bots = bots_arg.getValue();
+        settings.markets = markets_arg.getValue();
+        settings.threads = threads_arg.getValue();
+        settings.stage_seconds = seconds_arg.getValue();
+        settings.interval_ms = interval_arg.getValue();
+        settings.latency_ms = latency_arg.getValue();
+        settings.latency_p99_ms = p99_arg.getValue();
+        settings.fill_checks = fill_arg.getValue();
+    }
+    catch (TCLAP::ArgException& e)
+    {
+        std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
+        return 1;
+    }
+
+    if (settings.max_bots < 1 || settings.markets < 1 || settings.threads < 1 || settings.stage_seconds < 1)
+    {
+        std::cerr << "The number of work orders, markets, threads and the stage length must all be at least 1." << std::endl;
+        return 1;
+    }
+    if (!(settings.latency_ms > 0.0))
+    {
+        std::cerr << "Invalid value for '--latency,' the exchange must take some time to answer." << std::endl;
+        return 1;
+    }
+
+    rlimit files = {};
+    getrlimit(RLIMIT_NOFILE, &files);
+    std::printf("%u markets, %u exchange threads, one step per work order every %u ms, exchange latency p50 %.0f ms / p99 %.0f ms\n",
+                settings.markets, settings.threads, settings.interval_ms, settings.latency_ms, settings.latency_p99_ms);
+    std::printf("open file limit %llu, %u second stages\n\n", (unsigned long long)files.rlim_cur, settings.stage_seconds);
+    std::printf("%8s %10s %10s %10s %10s %12s %10s %8s %8s\n", "bots", "steps/s", "p50 ms", "p99 ms", "RSS MB", "RSS KB/bot",
+                "CPU%/bot", "threads", "fds");
+
+    std::filesystem::path folder = std::filesystem::temp_directory_path() / ("mercury-load-test-" + std::to_string(getpid()));
+    std::filesystem::create_directories(folder);
+
+    int status = 0;
+    for (unsigned int bots = 1;; bots = (bots >= settings.max_bots / 10) ? settings.max_bots : bots * 10)
+    {
+        stage_result result;
+        std::string error;
+
+        if (!run_stage(settings, bots, folder, result, error))
+        {
+            std::printf("%8u stopped: %s\n", bots, error.c_str());
+            status = 1;
+            break;
+        }
+
+        std::printf("%8u %10.1f %10.2f %10.2f %10.1f %12.1f %10.3f %8ld %8ld\n", bots, double(result.steps) / result.seconds, result.p50_ms,
+                    result.p99_ms, double(result.rss_kb) / 1024.0, double(result.rss_growth_kb) / bots,
+                    100.0 * result.cpu_seconds / result.seconds / bots, result.threads, result.descriptors);
+        std::fflush(stdout);
+
+        if (bots == settings.max_bots) break;
+    }
+
+    std::filesystem::remove_all(folder);
+
+    return status;
+}
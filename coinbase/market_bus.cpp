@@ -0,0 +1,330 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   market_bus.cpp
+ * Author: Chris Morrison
+ *
+ * Created on 19 October 2026, 20:05
+ */
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "fixed_point.hpp"
+#include "market_bus.hpp"
+
+namespace mercury
+{
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<int64_t>::is_always_lock_free &&
+              std::atomic<uint32_t>::is_always_lock_free, "the market bus needs lock-free atomics to work across processes");
+
+static const uint64_t bus_magic = 0x5355424d5243454dULL; // "MERCMBUS"
+static const uint32_t bus_version = 1;
+
+// How often a reader retries a snapshot that the writer keeps changing under it before giving up.
+static const int snapshot_attempts = 64;
+
+using detail::bus_header;
+using detail::bus_slot;
+
+void bus_slot::store(uint64_t odd_sequence, const bus_tick& tick)
+{
+    sequence.store(odd_sequence, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    product.store(tick.product, std::memory_order_relaxed);
+    time_us.store(tick.time_us, std::memory_order_relaxed);
+    price.store(tick.price, std::memory_order_relaxed);
+    bid.store(tick.bid, std::memory_order_relaxed);
+    ask.store(tick.ask, std::memory_order_relaxed);
+    volume.store(tick.volume, std::memory_order_relaxed);
+
+    sequence.store(odd_sequence + 1, std::memory_order_release);
+}
+
+uint64_t bus_slot::load(bus_tick& tick) const
+{
+    uint64_t before = sequence.load(std::memory_order_acquire);
+    if (before & 1) return 1;
+
+    tick.product = product.load(std::memory_order_relaxed);
+    tick.time_us = time_us.load(std::memory_order_relaxed);
+    tick.price = price.load(std::memory_order_relaxed);
+    tick.bid = bid.load(std::memory_order_relaxed);
+    tick.ask = ask.load(std::memory_order_relaxed);
+    tick.volume = volume.load(std::memory_order_relaxed);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t after = sequence.load(std::memory_order_relaxed);
+
+    // An odd answer means the copy is torn and must be thrown away.
+    return (before == after) ? before : 1;
+}
+
+std::size_t detail::bus_segment_size(uint64_t capacity)
+{
+    return sizeof(bus_header) + capacity * sizeof(bus_slot);
+}
+
+int64_t bus_now()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+static std::string segment_path(const std::string& name)
+{
+    return (!name.empty() && name[0] == '/') ? name : "/" + name;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Writer.
+// ------------------------------------------------------------------------------------------------
+
+market_bus_writer::~market_bus_writer()
+{
+    close();
+}
+
+bool market_bus_writer::create(const std::string& name, const std::vector<std::string>& products, uint64_t capacity)
+{
+    close();
+
+    if (products.empty() || products.size() > bus_max_products) return false;
+    for (const std::string& product : products)
+    {
+        if (product.empty() || product.size() >= bus_product_length) return false;
+    }
+
+    uint64_t slots = 2;
+    while (slots < capacity) slots <<= 1;
+
+    // Readers still attached to an older segment keep it until they let go; they see its heartbeat
+    // stop and can attach again.
+    std::string path = segment_path(name);
+    shm_unlink(path.c_str());
+
+    int fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) return false;
+
+    std::size_t size = detail::bus_segment_size(slots);
+    void* memory = (ftruncate(fd, static_cast<off_t>(size)) == 0) ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if (memory == MAP_FAILED)
+    {
+        shm_unlink(path.c_str());
+        return false;
+    }
+
+    bus_header* header = new (memory) bus_header();
+    bus_slot* ring = reinterpret_cast<bus_slot*>(static_cast<char*>(memory) + sizeof(bus_header));
+    for (uint64_t i = 0; i < slots; ++i) new (ring + i) bus_slot();
+
+    header->version = bus_version;
+    header->product_count = static_cast<uint32_t>(products.size());
+    header->capacity = slots;
+    for (std::size_t i = 0; i < products.size(); ++i)
+    {
+        std::memcpy(header->products[i].id, products[i].data(), products[i].size());
+        header->products[i].id[products[i].size()] = '\0';
+    }
+    header->heartbeat_us.store(bus_now(), std::memory_order_relaxed);
+    header->magic.store(bus_magic, std::memory_order_release);
+
+    name_ = path;
+    header_ = header;
+    ring_ = ring;
+    size_ = size;
+
+    return true;
+}
+
+void market_bus_writer::publish(const bus_tick& tick)
+{
+    if (!header_ || tick.product >= header_->product_count) return;
+
+    uint64_t position = header_->head.load(std::memory_order_relaxed);
+    ring_[position & (header_->capacity - 1)].store(2 * position + 1, tick);
+    header_->head.store(position + 1, std::memory_order_release);
+
+    bus_slot& snapshot = header_->products[tick.product].snapshot;
+    snapshot.store(snapshot.sequence.load(std::memory_order_relaxed) + 1, tick);
+
+    header_->heartbeat_us.store(tick.time_us, std::memory_order_release);
+}
+
+void market_bus_writer::refresh(const bus_tick& tick)
+{
+    if (!header_ || tick.product >= header_->product_count) return;
+
+    bus_slot& snapshot = header_->products[tick.product].snapshot;
+    snapshot.store(snapshot.sequence.load(std::memory_order_relaxed) + 1, tick);
+
+    header_->heartbeat_us.store(tick.time_us, std::memory_order_release);
+}
+
+void market_bus_writer::close()
+{
+    if (!header_) return;
+
+    munmap(header_, size_);
+    shm_unlink(name_.c_str());
+    header_ = nullptr;
+    ring_ = nullptr;
+    size_ = 0;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Reader.
+// ------------------------------------------------------------------------------------------------
+
+market_bus_reader::~market_bus_reader()
+{
+    close();
+}
+
+bool market_bus_reader::open(const std::string& name)
+{
+    close();
+
+    int fd = shm_open(segment_path(name).c_str(), O_RDONLY, 0);
+    if (fd < 0) return false;
+
+    struct stat info;
+    void* memory = MAP_FAILED;
+    std::size_t size = 0;
+    if (fstat(fd, &info) == 0 && static_cast<std::size_t>(info.st_size) >= sizeof(bus_header))
+    {
+        size = static_cast<std::size_t>(info.st_size);
+        memory = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (memory == MAP_FAILED) return false;
+
+    const bus_header* header = static_cast<const bus_header*>(memory);
+    if (header->magic.load(std::memory_order_acquire) != bus_magic || header->version != bus_version ||
+        header->product_count > bus_max_products || header->capacity == 0 || (header->capacity & (header->capacity - 1)) != 0 ||
+        detail::bus_segment_size(header->capacity) > size)
+    {
+        munmap(memory, size);
+        return false;
+    }
+
+    header_ = header;
+    ring_ = reinterpret_cast<const bus_slot*>(static_cast<const char*>(memory) + sizeof(bus_header));
+    size_ = size;
+    cursor_ = header->head.load(std::memory_order_acquire);
+
+    return true;
+}
+
+void market_bus_reader::close()
+{
+    if (!header_) return;
+
+    munmap(const_cast<bus_header*>(header_), size_);
+    header_ = nullptr;
+    ring_ = nullptr;
+    size_ = 0;
+}
+
+bool market_bus_reader::find(const std::string& product, uint32_t& index) const
+{
+    if (!header_) return false;
+
+    for (uint32_t i = 0; i < header_->product_count; ++i)
+    {
+        if (std::strncmp(header_->products[i].id, product.c_str(), bus_product_length) == 0)
+        {
+            index = i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool market_bus_reader::snapshot(uint32_t index, bus_tick& out) const
+{
+    if (!header_ || index >= header_->product_count) return false;
+
+    for (int attempt = 0; attempt < snapshot_attempts; ++attempt)
+    {
+        uint64_t sequence = header_->products[index].snapshot.load(out);
+        if ((sequence & 1) == 0) return sequence != 0;
+    }
+
+    return false;
+}
+
+bool market_bus_reader::read_price(uint32_t index, int64_t max_age_us, std::string& out) const
+{
+    bus_tick tick;
+    char buf[24 + bus_decimals];
+
+    if (!snapshot(index, tick) || tick.price <= 0 || bus_now() - tick.time_us > max_age_us) return false;
+
+    std::size_t len = format_fixed(tick.price, bus_decimals, buf, sizeof(buf));
+    if (len == 0) return false;
+
+    // Drop the padding zeros so the text reads the way the exchange would have sent it.
+    while (buf[len - 1] == '0') --len;
+    if (buf[len - 1] == '.') --len;
+
+    out.assign(buf, len);
+    return true;
+}
+
+bool market_bus_reader::next(bus_tick& out, uint64_t& missed)
+{
+    missed = 0;
+    if (!header_) return false;
+
+    uint64_t capacity = header_->capacity;
+    for (;;)
+    {
+        uint64_t head = header_->head.load(std::memory_order_acquire);
+        if (cursor_ >= head) return false;
+
+        // The slot after the newest tick may already be part way through being overwritten.
+        if (head - cursor_ >= capacity)
+        {
+            missed += head - capacity + 1 - cursor_;
+            cursor_ = head - capacity + 1;
+        }
+
+        uint64_t sequence = ring_[cursor_ & (capacity - 1)].load(out);
+        if (sequence == 2 * cursor_ + 2)
+        {
+            ++cursor_;
+            return true;
+        }
+
+        // Torn or already reused: the writer has lapped this reader, so look at the head again.
+        ++missed;
+        ++cursor_;
+    }
+}
+
+int64_t market_bus_reader::heartbeat() const
+{
+    return header_ ? header_->heartbeat_us.load(std::memory_order_acquire) : 0;
+}
+
+}
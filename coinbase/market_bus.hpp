@@ -0,0 +1,214 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   market_bus.hpp
+ * Author: Chris Morrison
+ *
+ * Created on 19 October 2026, 20:05
+ */
+#ifndef MARKET_BUS_HPP
+#define MARKET_BUS_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ------------------------------------------------------------------------------------------------
+// Shared-memory market data bus.
+//
+// One feed handler process publishes prices into a segment in /dev/shm and any number of robots map
+// the same segment read-only, so N robots cost one upstream connection between them. The segment
+// holds two things:
+//
+//  - a snapshot per product (last price, best bid and ask, 24 hour volume), each guarded by a seqlock
+//    so that a reader always sees a consistent set of values without ever blocking the writer;
+//  - a ring of every tick published, for readers that want the whole stream. Each reader keeps its
+//    own cursor; a reader that falls more than a ring's length behind skips ahead and is told how
+//    many ticks it missed.
+//
+// There is exactly one writer. Nothing in the segment is a pointer, and every shared word is a
+// lock-free std::atomic, so the layout means the same thing in every process that maps it.
+// ------------------------------------------------------------------------------------------------
+
+namespace mercury
+{
+
+/// Longest product identifier the bus can carry, e.g. "BTC-EUR".
+constexpr std::size_t bus_product_length = 24;
+
+/// Most products one bus can carry.
+constexpr std::size_t bus_max_products = 64;
+
+/// Fixed-point precision of every price and volume on the bus (see fixed_point.hpp).
+constexpr int bus_decimals = 8;
+
+///
+/// One market update, as published and as read back.
+struct bus_tick
+{
+    uint32_t product = 0;   ///< Index of the product on the bus.
+    int64_t time_us = 0;    ///< When the feed handler saw it, microseconds since the epoch.
+    int64_t price = 0;      ///< Last trade price, scaled by 10^bus_decimals.
+    int64_t bid = 0;        ///< Best bid, 0 if unknown.
+    int64_t ask = 0;        ///< Best ask, 0 if unknown.
+    int64_t volume = 0;     ///< 24 hour volume, 0 if unknown.
+};
+
+namespace detail
+{
+
+///
+/// A bus_tick behind a seqlock. The sequence is odd while the writer is part way through an update.
+struct bus_slot
+{
+    std::atomic<uint64_t> sequence;
+    std::atomic<uint32_t> product;
+    std::atomic<int64_t> time_us;
+    std::atomic<int64_t> price;
+    std::atomic<int64_t> bid;
+    std::atomic<int64_t> ask;
+    std::atomic<int64_t> volume;
+
+    void store(uint64_t odd_sequence, const bus_tick& tick);
+    uint64_t load(bus_tick& tick) const;
+};
+
+struct bus_product
+{
+    char id[bus_product_length];
+    bus_slot snapshot;
+};
+
+struct bus_header
+{
+    std::atomic<uint64_t> magic;        ///< Written last, once the segment is ready to read.
+    uint32_t version;
+    uint32_t product_count;
+    uint64_t capacity;                  ///< Slots in the tick ring, a power of two.
+    std::atomic<uint64_t> head;         ///< Ticks published so far.
+    std::atomic<int64_t> heartbeat_us;  ///< Last time the writer was alive.
+    bus_product products[bus_max_products];
+};
+
+/// Bytes needed for a segment with the given ring capacity.
+std::size_t bus_segment_size(uint64_t capacity);
+
+}
+
+///
+/// The feed handler's side of the bus.
+class market_bus_writer
+{
+public:
+    market_bus_writer() = default;
+    market_bus_writer(const market_bus_writer&) = delete;
+    market_bus_writer& operator=(const market_bus_writer&) = delete;
+    ~market_bus_writer();
+
+    ///
+    /// Creates (or re-creates) the segment.
+    ///
+    /// \param name     Segment name, without the leading slash; appears as /dev/shm/<name>.
+    /// \param products The products that will be published, in index order.
+    /// \param capacity Slots in the tick ring; rounded up to a power of two.
+    /// \return false if the segment cannot be created or the product list does not fit.
+    bool create(const std::string& name, const std::vector<std::string>& products, uint64_t capacity = 4096);
+
+    /// Publishes a tick: updates the product's snapshot and appends it to the ring.
+    void publish(const bus_tick& tick);
+
+    /// Re-stamps a product's snapshot with a tick that did not move the market; nothing goes on the ring.
+    void refresh(const bus_tick& tick);
+
+    /// Unmaps the segment and removes its name, so that no new reader can attach.
+    void close();
+
+    bool is_open() const { return header_ != nullptr; }
+
+private:
+    std::string name_;
+    detail::bus_header* header_ = nullptr;
+    detail::bus_slot* ring_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+///
+/// A robot's side of the bus. Readers never write to the segment, so any number can attach.
+class market_bus_reader
+{
+public:
+    market_bus_reader() = default;
+    market_bus_reader(const market_bus_reader&) = delete;
+    market_bus_reader& operator=(const market_bus_reader&) = delete;
+    ~market_bus_reader();
+
+    ///
+    /// Maps an existing segment and starts reading the ring from its current head.
+    ///
+    /// \return false if there is no such segment or it is not a market bus.
+    bool open(const std::string& name);
+
+    void close();
+
+    bool is_open() const { return header_ != nullptr; }
+
+    ///
+    /// Finds a product's index on the bus.
+    ///
+    /// \return false if the feed handler does not publish the product.
+    bool find(const std::string& product, uint32_t& index) const;
+
+    ///
+    /// Reads a consistent copy of a product's latest snapshot.
+    ///
+    /// \return false if nothing has been published for the product yet.
+    bool snapshot(uint32_t index, bus_tick& out) const;
+
+    ///
+    /// Reads the latest price of a product as decimal text, if it is no older than max_age_us.
+    ///
+    /// \param index      The product's index, see find().
+    /// \param max_age_us Oldest acceptable price, in microseconds.
+    /// \param out        Receives the price; its storage is reused.
+    /// \return false if the price is missing or stale, in which case out is left unchanged.
+    bool read_price(uint32_t index, int64_t max_age_us, std::string& out) const;
+
+    ///
+    /// Takes the next tick from the ring.
+    ///
+    /// \param out    Receives the tick.
+    /// \param missed Receives the number of ticks that were overwritten before this reader got to them.
+    /// \return false if the reader has caught up with the writer.
+    bool next(bus_tick& out, uint64_t& missed);
+
+    /// Microseconds since the epoch at which the writer last showed signs of life.
+    int64_t heartbeat() const;
+
+private:
+    const detail::bus_header* header_ = nullptr;
+    const detail::bus_slot* ring_ = nullptr;
+    std::size_t size_ = 0;
+    uint64_t cursor_ = 0;
+};
+
+/// Microseconds since the epoch, on the clock the bus uses for its timestamps.
+int64_t bus_now();
+
+}
+
+#endif /* MARKET_BUS_HPP */
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   mock_context.hpp
+ * Author: Chris Morrison
+ *
+ * Created on 19 October 2026, 19:30
+ */
+#ifndef MOCK_CONTEXT_HPP
+#define MOCK_CONTEXT_HPP
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "exchange_context.hpp"
+
+namespace mercury
+{
+
+///
+/// An in-memory exchange for benchmarks. Prices come from a fixed table that is walked one entry per
+/// price request, every order rests for a set number of status checks and then fills, and nothing is
+/// ever sent over the network. The read_*() overrides copy from fixed buffers, so a caller that reuses
+/// its strings sees no heap traffic from the context.
+class mock_context : public exchange_context
+{
+public:
+    ///
+    /// \param prices     Table of prices to cycle through.
+    /// \param count      Number of entries in the table.
+    /// \param fill_after Number of status checks an order stays in_progress before it fills.
+    mock_context(const char* const* prices, std::size_t count, unsigned int fill_after = 1)
+        : prices_(prices), count_(count), fill_after_(fill_after)
+    {
+        product_.set("BTC-EUR", "0.01", "0.00000001", "0.001", "70");
+    }
+
+    std::string fiat_balance() override { return fiat_; }
+    std::string coin_balance() override { return coin_; }
+    std::string current_price() override { return next(); }
+
+    void read_current_price(std::string& out) override { out.assign(next()); }
+    void read_fiat_balance(std::string& out) override { out.assign(fiat_); }
+    void read_coin_balance(std::string& out) override { out.assign(coin_); }
+
+    cryptocoin::trading::order_status post_order(cryptocoin::trading::order_side, cryptocoin::trading::order_type,
+                                                 const std::string& size, const std::string& price, const std::string&,
+                                                 std::string& out_uuid) override
+    {
+        std::snprintf(uuid_, sizeof(uuid_), "mock-%08u", ++serial_);
+        std::snprintf(size_, sizeof(size_), "%s", size.c_str());
+        std::snprintf(value_, sizeof(value_), "%.8Lf", std::strtold(size.c_str(), nullptr) * std::strtold(price.c_str(), nullptr));
+        out_uuid.assign(uuid_);
+        checks_ = 0;
+        ++posts_;
+        return cryptocoin::trading::in_progress;
+    }
+
+    cryptocoin::trading::order_status get_order_status(const std::string& uuid) override
+    {
+        if (std::strcmp(uuid.c_str(), uuid_) != 0) return cryptocoin::trading::completed;
+        return (++checks_ > fill_after_) ? cryptocoin::trading::completed : cryptocoin::trading::in_progress;
+    }
+
+    long double sell_price_adjustment() override { return 0.001; }
+    long double buy_price_ajustment() override { return 0.001; }
+
+    cryptocoin::trading::order_status cancel_order(const std::string&) override { return cryptocoin::trading::cancelled; }
+
+    bool get_order_statuses(const std::vector<std::string>& uuids, std::vector<cryptocoin::trading::order_status>& out) override
+    {
+        out.resize(uuids.size());
+        for (std::size_t i = 0; i < uuids.size(); ++i) out[i] = get_order_status(uuids[i]);
+        return true;
+    }
+
+    /// Every order fills in full at its limit price, without fees.
+    bool get_fill(const std::string&, order_fill& out) override
+    {
+        out.size.assign(size_);
+        out.value.assign(value_);
+        out.fee.assign("0");
+        return true;
+    }
+
+    bool get_product_info(product_info& out) override
+    {
+        out = product_;
+        return true;
+    }
+
+    /// Number of orders posted so far.
+    unsigned int posts() const { return posts_; }
+
+private:
+    const char* next()
+    {
+        const char* price = prices_[index_];
+        index_ = (index_ + 1 == count_) ? 0 : index_ + 1;
+        return price;
+    }
+
+    const char* const* prices_;
+    std::size_t count_;
+    std::size_t index_ = 0;
+    unsigned int fill_after_;
+    unsigned int checks_ = 0;
+    unsigned int serial_ = 0;
+    unsigned int posts_ = 0;
+    char uuid_[24] = {};
+    char size_[32] = {};
+    char value_[48] = {};
+    const char* fiat_ = "1000.00";
+    const char* coin_ = "0.12345678";
+    product_info product_;
+};
+
+}
+
+#endif /* MOCK_CONTEXT_HPP */
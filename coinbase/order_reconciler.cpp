@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   order_reconciler.cpp
+ * Author: Chris Morrison
+ *
+ * Created on 19 October 2026, 15:05
+ */
+#include "order_reconciler.hpp"
+
+namespace mercury
+{
+
+using namespace cryptocoin::trading;
+
+static bool is_final(order_status status)
+{
+    return status == completed || status == cancelled || status == fatal_error;
+}
+
+order_reconciler::tracked_order* order_reconciler::find(const std::string& uuid)
+{
+    for (tracked_order& order : orders_)
+    {
+        if (order.active && order.uuid == uuid) return &order;
+    }
+    return nullptr;
+}
+
+order_reconciler::tracked_order& order_reconciler::add(const std::string& uuid)
+{
+    tracked_order* slot = nullptr;
+
+    for (tracked_order& order : orders_)
+    {
+        if (!order.active)
+        {
+            slot = &order;
+            break;
+        }
+    }
+    if (!slot) slot = &orders_.emplace_back();
+
+    slot->uuid.assign(uuid);
+    slot->status = in_progress;
+    slot->known = false;
+    slot->active = true;
+    ++active_;
+
+    return *slot;
+}
+
+void order_reconciler::release(tracked_order& order)
+{
+    // The slot keeps its uuid string so the storage can be reused by the next order.
+    order.active = false;
+    order.on_change = nullptr;
+    --active_;
+}
+
+void order_reconciler::track(const std::string& uuid, listener on_change)
+{
+    tracked_order* order = find(uuid);
+    if (!order) order = &add(uuid);
+    order->on_change = std::move(on_change);
+}
+
+void order_reconciler::forget(const std::string& uuid)
+{
+    tracked_order* order = find(uuid);
+    if (order) release(*order);
+}
+
+order_status order_reconciler::status(exchange_context& context, const std::string& uuid)
+{
+    tracked_order* order = find(uuid);
+    if (!order) order = &add(uuid);
+
+    bool stale = !refreshed_ || (std::chrono::steady_clock::now() - last_refresh_) >= max_age_;
+    if ((stale || !order->known) && !refresh(context)) return network_error;
+
+    order = find(uuid);
+    if (!order || !order->known) return network_error;
+
+    order_status result = order->status;
+    if (is_final(result)) release(*order);
+
+    return result;
+}
+
+bool order_reconciler::refresh(exchange_context& context)
+{
+    // Reuse the uuid strings from the last refresh rather than copying into fresh ones.
+    uuids_.resize(active_);
+    slots_.clear();
+    for (std::size_t i = 0; i < orders_.size(); ++i)
+    {
+        if (!orders_[i].active) continue;
+        uuids_[slots_.size()].assign(orders_[i].uuid);
+        slots_.push_back(i);
+    }
+
+    last_refresh_ = std::chrono::steady_clock::now();
+    refreshed_ = true;
+    if (uuids_.empty()) return true;
+
+    if (!context.get_order_statuses(uuids_, statuses_) || statuses_.size() != uuids_.size()) return false;
+
+    // Record all the changes before calling anyone, so listeners are free to track or forget orders.
+    changed_.clear();
+    for (std::size_t i = 0; i < slots_.size(); ++i)
+    {
+        tracked_order& order = orders_[slots_[i]];
+        if (statuses_[i] == network_error) continue;
+        if (order.known && order.status == statuses_[i]) continue;
+
+        order.status = statuses_[i];
+        order.known = true;
+        if (order.on_change) changed_.push_back(slots_[i]);
+    }
+    for (std::size_t slot : changed_)
+    {
+        tracked_order& order = orders_[slot];
+        if (order.active && order.on_change) order.on_change(order.uuid, order.status);
+    }
+
+    return true;
+}
+
+}
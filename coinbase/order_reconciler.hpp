@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   order_reconciler.hpp
+ * Author: Chris Morrison
+ *
+ * Created on 19 October 2026, 15:05
+ */
+#ifndef ORDER_RECONCILER_HPP
+#define ORDER_RECONCILER_HPP
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+#include "exchange_context.hpp"
+
+namespace mercury
+{
+
+///
+/// Keeps track of every resting order and checks on all of them with one bulk lookup, so the cost of
+/// polling does not grow with the number of open orders. Status changes are passed to the callback
+/// registered for each order.
+///
+/// Orders are kept in a table whose slots (and their uuid strings) are reused, so tracking and
+/// forgetting orders in a steady state does not allocate. The table is a deque so that slots stay put
+/// while a listener adds orders.
+class order_reconciler
+{
+public:
+    /// Called when a tracked order changes status.
+    typedef std::function<void(const std::string& uuid, cryptocoin::trading::order_status status)> listener;
+
+    ///
+    /// \param max_age How long a bulk lookup is good for; status() only triggers a new lookup once the
+    ///                last one is older than this.
+    explicit order_reconciler(std::chrono::seconds max_age = std::chrono::seconds(30)) : max_age_(max_age) {}
+
+    ///
+    /// Starts tracking an order.
+    ///
+    /// \param uuid      The order identifier.
+    /// \param on_change Optional callback for status changes.
+    void track(const std::string& uuid, listener on_change = listener());
+
+    /// Stops tracking an order.
+    void forget(const std::string& uuid);
+
+    ///
+    /// Returns the status of an order, refreshing all tracked orders first if the last lookup is too old.
+    /// Untracked orders are tracked automatically; orders that have finished are forgotten once their
+    /// final status has been returned.
+    ///
+    /// \param context The exchange to ask.
+    /// \param uuid    The order identifier.
+    cryptocoin::trading::order_status status(exchange_context& context, const std::string& uuid);
+
+    ///
+    /// Looks up every tracked order with one bulk request and dispatches the changes.
+    ///
+    /// \param context The exchange to ask.
+    /// \return false if the lookup failed; cached statuses are then left as they were.
+    bool refresh(exchange_context& context);
+
+    /// Changes how long a bulk lookup is good for.
+    void set_max_age(std::chrono::seconds max_age) { max_age_ = max_age; }
+
+    /// Number of orders being tracked.
+    std::size_t size() const { return active_; }
+
+private:
+    struct tracked_order
+    {
+        std::string uuid;
+        cryptocoin::trading::order_status status = cryptocoin::trading::in_progress;
+        bool known = false;
+        bool active = false;
+        listener on_change;
+    };
+
+    tracked_order* find(const std::string& uuid);
+    tracked_order& add(const std::string& uuid);
+    void release(tracked_order& order);
+
+    std::chrono::seconds max_age_;
+    std::chrono::steady_clock::time_point last_refresh_;
+    bool refreshed_ = false;
+    std::size_t active_ = 0;
+    std::deque<tracked_order> orders_;
+    std::vector<std::string> uuids_;
+    std::vector<std::size_t> slots_;
+    std::vector<std::size_t> changed_;
+    std::vector<cryptocoin::trading::order_status> statuses_;
+};
+
+}
+
+#endif /* ORDER_RECONCILER_HPP */
@@ -0,0 +1,339 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   paper_context.cpp
+ * Author: Chris Morrison
+ *
+ * Created on 20 October 2026, 04:50
+ */
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include "fixed_point.hpp"
+#include "paper_context.hpp"
+
+namespace mercury
+{
+
+using cryptocoin::trading::order_status;
+
+// Rounding in the balance arithmetic must not turn a spend of the whole balance into a failure.
+static const double balance_tolerance = 1e-9;
+
+// Finished orders are remembered for this many posts, long enough for every work order to have read
+// its fill.
+static const unsigned long finished_orders_kept = 256;
+
+static int64_t wall_us()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+static double to_double(const std::string& text)
+{
+    return text.empty() ? 0.0 : std::strtod(text.c_str(), nullptr);
+}
+
+void paper_account::deposit(const std::string& currency, double amount)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    balances_[currency] += amount;
+}
+
+double paper_account::balance(const std::string& currency) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = balances_.find(currency);
+    return (found == balances_.end()) ? 0.0 : found->second;
+}
+
+bool paper_account::adjust(const std::string& currency, double change)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    double& balance = balances_[currency];
+    if (balance + change < -balance_tolerance) return false;
+    balance = std::max(0.0, balance + change);
+    return true;
+}
+
+paper_context::paper_context(exchange_context& market, paper_account& account, const std::string& coin, const std::string& fiat,
+                             const paper_settings& settings)
+    : market_(market), account_(account), coin_(coin), fiat_(fiat), settings_(settings)
+{
+}
+
+bool paper_context::replay(const std::string& tick_file)
+{
+    if (!std::filesystem::exists(tick_file) || !replay_.open(tick_file)) return false;
+
+    do
+    {
+        if (!replay_.next_block(replay_times_, replay_prices_)) return false;
+    } while (replay_times_.empty());
+
+    replay_next_ = 0;
+    replay_scale_ = double(power_of_ten(replay_.price_decimals()));
+    replay_offset_us_ = wall_us() - replay_times_[0];
+    replaying_ = true;
+    return true;
+}
+
+bool paper_context::next_replayed(double& price)
+{
+    int64_t now = wall_us() - replay_offset_us_;
+    bool moved = false;
+
+    // Every tick that is due by now; once the file runs out the price stays where it ended.
+    for (;;)
+    {
+        if (replay_next_ == replay_times_.size())
+        {
+            if (!replay_.next_block(replay_times_, replay_prices_)) break;
+            replay_next_ = 0;
+            continue;
+        }
+        if (replay_times_[replay_next_] > now) break;
+
+        price = double(replay_prices_[replay_next_]) / replay_scale_;
+        ticker_.price = format_fixed(replay_prices_[replay_next_], replay_.price_decimals());
+        ++replay_next_;
+        moved = true;
+    }
+
+    return moved;
+}
+
+bool paper_context::look()
+{
+    double traded = 0.0;
+
+    if (replaying_)
+    {
+        double price = 0.0;
+        if (next_replayed(price)) last_ = price;
+        bid_ = ask_ = 0.0;
+    }
+    else
+    {
+        if (!market_.get_ticker(ticker_)) return false;
+        last_ = to_double(ticker_.price);
+        bid_ = to_double(ticker_.bid);
+        ask_ = to_double(ticker_.ask);
+
+        // The 24 hour volume also drops as old trades leave its window, so a fall says nothing.
+        double volume = ticker_.volume.empty() ? -1.0 : to_double(ticker_.volume);
+        if (volume_ >= 0.0 && volume > volume_) traded = volume - volume_;
+        volume_ = volume;
+    }
+    if (last_ <= 0.0) return false;
+
+    for (auto& [uuid, order] : orders_)
+    {
+        if (order.status != cryptocoin::trading::in_progress) continue;
+
+        bool buying = (order.side == cryptocoin::trading::buy);
+        if (buying ? last_ < order.limit : last_ > order.limit)
+        {
+            fill(order, order.limit, settings_.maker_fee);
+        }
+        else if (last_ == order.limit)
+        {
+            order.queue_ahead -= traded;
+            if (order.queue_ahead <= 0.0) fill(order, order.limit, settings_.maker_fee);
+        }
+    }
+
+    return true;
+}
+
+void paper_context::fill(paper_order& order, double price, double fee_rate)
+{
+    double value = order.size * price;
+
+    order.fill_price = price;
+    order.fee = value * fee_rate;
+    order.status = cryptocoin::trading::completed;
+
+    if (order.side == cryptocoin::trading::buy)
+    {
+        // The hold covers the limit and the dearer fee, so whatever is left of it comes back.
+        account_.adjust(fiat_, order.held - value - order.fee);
+        account_.adjust(coin_, order.size);
+    }
+    else
+    {
+        account_.adjust(fiat_, value - order.fee);
+    }
+    order.held = 0.0;
+}
+
+std::string paper_context::format(double value)
+{
+    char text[48];
+
+    std::snprintf(text, sizeof(text), "%.8f", value);
+    return text;
+}
+
+std::string paper_context::fiat_balance()
+{
+    return format(account_.balance(fiat_));
+}
+
+std::string paper_context::coin_balance()
+{
+    return format(account_.balance(coin_));
+}
+
+std::string paper_context::current_price()
+{
+    std::string price;
+    read_current_price(price);
+    return price;
+}
+
+void paper_context::read_current_price(std::string& out)
+{
+    if (look())
+        out.assign(ticker_.price);
+    else
+        out.clear();
+}
+
+void paper_context::read_fiat_balance(std::string& out)
+{
+    out = fiat_balance();
+}
+
+void paper_context::read_coin_balance(std::string& out)
+{
+    out = coin_balance();
+}
+
+bool paper_context::get_ticker(ticker& out)
+{
+    if (!look()) return false;
+
+    out.price.assign(ticker_.price);
+    out.bid.assign(replaying_ ? "" : ticker_.bid);
+    out.ask.assign(replaying_ ? "" : ticker_.ask);
+    out.volume.assign(replaying_ ? "" : ticker_.volume);
+    return true;
+}
+
+order_status paper_context::post_order(cryptocoin::trading::order_side side, cryptocoin::trading::order_type type,
+                                       const std::string& size, const std::string& price, const std::string& /* funds */,
+                                       std::string& out_uuid)
+{
+    paper_order order;
+    char uuid[32];
+
+    order.side = side;
+    order.size = to_double(size);
+    order.limit = to_double(price);
+    if (order.size <= 0.0 || (type == cryptocoin::trading::limit && order.limit <= 0.0)) return cryptocoin::trading::invalid_order;
+    if (!look()) return cryptocoin::trading::network_error;
+
+    bool buying = (side == cryptocoin::trading::buy);
+    double touch = buying ? (ask_ > 0.0 ? ask_ : last_) : (bid_ > 0.0 ? bid_ : last_);
+    bool crosses = (type != cryptocoin::trading::limit) || (buying ? order.limit >= touch : order.limit <= touch);
+    if (type != cryptocoin::trading::limit) order.limit = touch;
+
+    // Funds are held while the order is open, as the exchange would.
+    order.held = buying ? order.size * order.limit * (1.0 + std::max(settings_.maker_fee, settings_.taker_fee)) : order.size;
+    if (!account_.adjust(buying ? fiat_ : coin_, -order.held)) return cryptocoin::trading::insufficient_funds;
+
+    forget_old_orders();
+    order.serial = ++serial_;
+    std::snprintf(uuid, sizeof(uuid), "paper-%08lu", order.serial);
+    out_uuid.assign(uuid);
+
+    if (crosses)
+        fill(order, touch, settings_.taker_fee);
+    else
+        order.queue_ahead = (settings_.queue_ahead + 1.0) * order.size;
+    orders_[out_uuid] = order;
+
+    // Like the exchange, a post only says the order was accepted; the fill shows up in its status.
+    return cryptocoin::trading::in_progress;
+}
+
+void paper_context::forget_old_orders()
+{
+    if (serial_ % finished_orders_kept != 0) return;
+
+    for (auto order = orders_.begin(); order != orders_.end();)
+    {
+        bool old = order->second.status != cryptocoin::trading::in_progress && order->second.serial + finished_orders_kept < serial_;
+        order = old ? orders_.erase(order) : std::next(order);
+    }
+}
+
+order_status paper_context::get_order_status(const std::string& uuid)
+{
+    auto found = orders_.find(uuid);
+
+    // An order from an earlier run: the simulated book did not survive the restart.
+    if (found == orders_.end()) return cryptocoin::trading::cancelled;
+    if (found->second.status == cryptocoin::trading::in_progress && !look()) return cryptocoin::trading::network_error;
+    return found->second.status;
+}
+
+bool paper_context::get_order_statuses(const std::vector<std::string>& uuids, std::vector<order_status>& out)
+{
+    if (!look()) return false;
+
+    out.resize(uuids.size());
+    for (std::size_t i = 0; i < uuids.size(); ++i)
+    {
+        auto found = orders_.find(uuids[i]);
+        out[i] = (found == orders_.end()) ? cryptocoin::trading::cancelled : found->second.status;
+    }
+    return true;
+}
+
+order_status paper_context::cancel_order(const std::string& uuid)
+{
+    auto found = orders_.find(uuid);
+
+    if (found == orders_.end()) return cryptocoin::trading::cancelled;
+
+    // A fill can beat the cancel here too: look at the market one last time first.
+    paper_order& order = found->second;
+    if (order.status == cryptocoin::trading::in_progress) look();
+    if (order.status != cryptocoin::trading::in_progress) return order.status;
+
+    account_.adjust(order.side == cryptocoin::trading::buy ? fiat_ : coin_, order.held);
+    order.held = 0.0;
+    order.status = cryptocoin::trading::cancelled;
+    return cryptocoin::trading::cancelled;
+}
+
+bool paper_context::get_fill(const std::string& uuid, order_fill& out)
+{
+    auto found = orders_.find(uuid);
+
+    if (found == orders_.end() || found->second.status != cryptocoin::trading::completed) return false;
+
+    const paper_order& order = found->second;
+    out.size = format(order.size);
+    out.value = format(order.size * order.fill_price);
+    out.fee = format(order.fee);
+    return true;
+}
+
+}
@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   paper_context.hpp
+ * Author: Chris Morrison
+ *
+ * Created on 20 October 2026, 04:50
+ */
+#ifndef PAPER_CONTEXT_HPP
+#define PAPER_CONTEXT_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "exchange_context.hpp"
+#include "tick_store.hpp"
+
+// ------------------------------------------------------------------------------------------------
+// Paper trading.
+//
+// A paper_context stands in for an exchange context. Prices, product rules and adjustment rates come
+// from the real market (or from a recorded tick file played back in real time), but orders never
+// leave the process: a fill simulator rests them on a pretend book, fills them against the prices it
+// sees and charges fees, and the balances are those of a simulated account. Everything above the
+// context - the trader, the work order file, the ledger - runs exactly as it does for real, so paper
+// results are directly comparable with production.
+//
+// Fill model: an order that crosses the market when it is posted fills at once at the touch and pays
+// the taker fee. Any other order joins the back of the queue at its price with queue_ahead times its
+// own size resting in front of it. It fills, at its limit and paying the maker fee, once the market
+// trades through its price, or once enough volume has traded at its price to clear the queue ahead.
+// Traded volume is estimated from the change in the 24 hour volume between looks at the market, so
+// played-back ticks, which carry no volume, only fill orders the market trades through.
+// ------------------------------------------------------------------------------------------------
+
+namespace mercury
+{
+
+///
+/// Costs and queueing of the simulated exchange.
+struct paper_settings
+{
+    double maker_fee = 0.0015;   ///< Fee on fills of resting orders, as a fraction of their value.
+    double taker_fee = 0.0025;   ///< Fee on orders that cross the market.
+    double queue_ahead = 1.0;    ///< Size resting ahead of a new order at its price, as a multiple of its size.
+};
+
+///
+/// Balances of the simulated account, shared by the paper contexts of every pair. Safe to use from
+/// any thread.
+class paper_account
+{
+public:
+    /// Adds funds to a currency.
+    void deposit(const std::string& currency, double amount);
+
+    /// The available balance of a currency; funds held by resting orders are not available.
+    double balance(const std::string& currency) const;
+
+    /// Applies a change to a balance, failing without a change if it would go negative.
+    bool adjust(const std::string& currency, double change);
+
+private:
+    mutable std::mutex mutex_;
+    std::map<std::string, double> balances_;
+};
+
+///
+/// Exchange context that simulates the orders and the account, taking only market data from the
+/// exchange. Like any context, it is called by one thread at a time.
+class paper_context : public exchange_context
+{
+public:
+    ///
+    /// \param market   The real exchange, used for prices, product rules and adjustment rates only.
+    /// \param account  The simulated account; it must outlive this object.
+    /// \param coin     The coin traded, e.g. "BTC".
+    /// \param fiat     The fiat currency, e.g. "EUR".
+    /// \param settings Fees and queueing.
+    paper_context(exchange_context& market, paper_account& account, const std::string& coin, const std::string& fiat,
+                  const paper_settings& settings);
+
+    ///
+    /// Takes prices from a recorded tick file instead of the exchange, played back in real time starting
+    /// from its first tick now.
+    ///
+    /// \return false if the file cannot be read.
+    bool replay(const std::string& tick_file);
+
+    std::string fiat_balance() override;
+    std::string coin_balance() override;
+    std::string current_price() override;
+    void read_current_price(std::string& out) override;
+    void read_fiat_balance(std::string& out) override;
+    void read_coin_balance(std::string& out) override;
+
+    cryptocoin::trading::order_status post_order(cryptocoin::trading::order_side side, cryptocoin::trading::order_type type,
+                                                 const std::string& size, const std::string& price, const std::string& funds,
+                                                 std::string& out_uuid) override;
+    cryptocoin::trading::order_status get_order_status(const std::string& uuid) override;
+    long double sell_price_adjustment() override { return market_.sell_price_adjustment(); }
+    long double buy_price_ajustment() override { return market_.buy_price_ajustment(); }
+
+    cryptocoin::trading::order_status cancel_order(const std::string& uuid) override;
+    bool get_order_statuses(const std::vector<std::string>& uuids, std::vector<cryptocoin::trading::order_status>& out) override;
+    bool get_product_info(product_info& out) override { return market_.get_product_info(out); }
+    bool get_fill(const std::string& uuid, order_fill& out) override;
+    bool get_ticker(ticker& out) override;
+
+private:
+    struct paper_order
+    {
+        cryptocoin::trading::order_side side = cryptocoin::trading::buy;
+        double size = 0.0;
+        double limit = 0.0;
+        double held = 0.0;          ///< Fiat (buys) or coin (sells) taken from the balance while the order is open.
+        double queue_ahead = 0.0;   ///< Size still in front of the order at its price.
+        double fill_price = 0.0;
+        double fee = 0.0;
+        cryptocoin::trading::order_status status = cryptocoin::trading::in_progress;
+        unsigned long serial = 0;
+    };
+
+    /// Reads the market, from the exchange or the tick file, and fills whatever it reaches.
+    bool look();
+
+    bool next_replayed(double& price);
+    void forget_old_orders();
+    void fill(paper_order& order, double price, double fee_rate);
+    static std::string format(double value);
+
+    exchange_context& market_;
+    paper_account& account_;
+    std::string coin_;
+    std::string fiat_;
+    paper_settings settings_;
+    std::unordered_map<std::string, paper_order> orders_;
+    unsigned long serial_ = 0;
+
+    ticker ticker_;
+    double last_ = 0.0;
+    double bid_ = 0.0;
+    double ask_ = 0.0;
+    double volume_ = -1.0;
+
+    tick_store_reader replay_;
+    bool replaying_ = false;
+    std::vector<int64_t> replay_times_;
+    std::vector<int64_t> replay_prices_;
+    std::size_t replay_next_ = 0;
+    double replay_scale_ = 1.0;
+    int64_t replay_offset_us_ = 0;
+};
+
+}
+
+#endif /* PAPER_CONTEXT_HPP */
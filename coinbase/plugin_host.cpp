@@ -0,0 +1,287 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   plugin_host.cpp
+ * Author: Chris Morrison
+ *
+ * Created on 20 October 2026, 02:05
+ */
+#include <dlfcn.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include "plugin_host.hpp"
+
+namespace mercury
+{
+
+plugin_host::~plugin_host()
+{
+    for (plugin_instance& instance : instances_) instance.api_->destroy(instance.state_);
+    for (module& m : modules_) dlclose(m.handle);
+}
+
+bool plugin_host::open(const std::string& path, module& out, std::string& error)
+{
+    // dlopen() hands back the library already loaded from a path, so every load goes through a copy
+    // of its own. The copy can go as soon as it is mapped.
+    char copy[] = "/tmp/mercury-plugin-XXXXXX";
+    int fd = mkstemp(copy);
+    if (fd < 0)
+    {
+        error = std::string("could not make a copy of the library: ") + std::strerror(errno);
+        return false;
+    }
+    close(fd);
+
+    std::error_code failed;
+    std::filesystem::copy_file(path, copy, std::filesystem::copy_options::overwrite_existing, failed);
+    void* handle = failed ? nullptr : dlopen(copy, RTLD_NOW | RTLD_LOCAL);
+    const char* reason = failed ? nullptr : dlerror();
+    unlink(copy);
+    if (failed)
+    {
+        error = "could not read " + path + ": " + failed.message();
+        return false;
+    }
+    if (!handle)
+    {
+        error = reason ? reason : "dlopen failed";
+        return false;
+    }
+
+    mercury_plugin_entry entry = reinterpret_cast<mercury_plugin_entry>(dlsym(handle, MERCURY_PLUGIN_ENTRY));
+    const mercury_strategy_plugin* api = entry ? entry() : nullptr;
+    if (!api || api->abi_version != MERCURY_PLUGIN_ABI || !api->name || !api->create || !api->destroy || !api->on_tick ||
+        !api->on_fill || !api->on_timer || !api->save_state || !api->load_state)
+    {
+        error = path + " is not a strategy plugin for ABI version " + std::to_string(MERCURY_PLUGIN_ABI);
+        dlclose(handle);
+        return false;
+    }
+
+    out.path = path;
+    out.handle = handle;
+    out.api = api;
+    return true;
+}
+
+bool plugin_host::load(const std::string& path, std::string& error)
+{
+    module m;
+
+    if (!open(path, m, error)) return false;
+    if (find_strategy(m.api->name) || has(m.api->name))
+    {
+        error = std::string("there is already a strategy called '") + m.api->name + "'";
+        dlclose(m.handle);
+        return false;
+    }
+
+    modules_.push_back(m);
+    return true;
+}
+
+bool plugin_host::has(const char* name) const
+{
+    for (const module& m : modules_)
+    {
+        if (std::strcmp(m.api->name, name) == 0) return true;
+    }
+
+    return false;
+}
+
+plugin_instance* plugin_host::attach(const char* name)
+{
+    for (const module& m : modules_)
+    {
+        if (std::strcmp(m.api->name, name) != 0) continue;
+
+        void* state = m.api->create();
+        if (!state) return nullptr;
+        instances_.push_back(plugin_instance(m.api, state));
+        return &instances_.back();
+    }
+
+    return nullptr;
+}
+
+bool plugin_host::swap(module& old, module& fresh, std::ostream& log)
+{
+    // Every instance gets its new state before any old one is let go, so that a failure part of the
+    // way through leaves everything on the old library.
+    std::vector<void*> states;
+    for (plugin_instance& instance : instances_)
+    {
+        if (instance.api_ != old.api) continue;
+
+        void* state = fresh.api->create();
+        if (!state)
+        {
+            log << "The new " << old.path << " failed to create an instance - keeping the old one." << std::endl;
+            for (void* made : states) fresh.api->destroy(made);
+            return false;
+        }
+        states.push_back(state);
+    }
+
+    std::size_t next = 0;
+    unsigned int fresh_starts = 0;
+    for (plugin_instance& instance : instances_)
+    {
+        if (instance.api_ != old.api) continue;
+
+        std::size_t size = old.api->save_state(instance.state_, nullptr, 0);
+        buffer_.resize(size);
+        if (size) old.api->save_state(instance.state_, buffer_.data(), size);
+
+        void* state = states[next++];
+        if (!fresh.api->load_state(state, old.api->state_version, buffer_.data(), size)) ++fresh_starts;
+        old.api->destroy(instance.state_);
+        instance.api_ = fresh.api;
+        instance.state_ = state;
+    }
+
+    log << "Reloaded " << old.path << ": " << next << " work orders handed over";
+    if (fresh_starts) log << ", " << fresh_starts << " of them starting afresh";
+    log << "." << std::endl;
+
+    return true;
+}
+
+bool plugin_host::reload(std::ostream& log)
+{
+    bool all = true;
+
+    for (module& m : modules_)
+    {
+        module fresh;
+        std::string error;
+
+        if (!open(m.path, fresh, error))
+        {
+            log << "Failed to reload " << m.path << ": " << error << " - keeping the old one." << std::endl;
+            all = false;
+            continue;
+        }
+        if (std::strcmp(fresh.api->name, m.api->name) != 0)
+        {
+            log << "Failed to reload " << m.path << ": the strategy is now called '" << fresh.api->name
+                << "' - keeping the old one." << std::endl;
+            dlclose(fresh.handle);
+            all = false;
+            continue;
+        }
+        if (!swap(m, fresh, log))
+        {
+            dlclose(fresh.handle);
+            all = false;
+            continue;
+        }
+
+        dlclose(m.handle);
+        m = fresh;
+    }
+
+    return all;
+}
+
+// ------------------------------------------------------------------------------------------------
+// The plugin strategy. Each decision asks the instance, starting from the advice the default
+// strategy would give, made up of the same policies (see strategy.hpp).
+// ------------------------------------------------------------------------------------------------
+
+static mercury_advice advise(const strategy_inputs& in, int side, bool resting, long double order, long double market,
+                             long double balance)
+{
+    mercury_check check = { side, resting ? 1 : 0, double(order), double(market), double(balance) };
+    mercury_advice advice = {};
+    bool buying = (side == MERCURY_BUY);
+
+    advice.at_market = buying ? better_price_entry::buy_at_market(order, market, in)
+                              : better_price_entry::sell_at_market(order, market, in);
+    advice.defer = buying ? better_price_entry::defer_buy(in) : better_price_entry::defer_sell(in);
+    advice.funds = double(balance_fraction_sizing::buy_funds(balance, in));
+    advice.reprice = buying ? chase_retry::reprice_buy(order, market, in) : chase_retry::reprice_sell(order, market, in);
+
+    in.plugin->check(check, advice);
+    return advice;
+}
+
+static long double follow_up(const strategy_inputs& in, int side, long double fill, long double rate)
+{
+    mercury_fill filled = { side, double(fill), double(rate) };
+    double price = in.plugin->fill(filled);
+
+    if (price > 0) return price;
+
+    long double step = rate_step_exit::distance(fill, rate, in);
+    return (side == MERCURY_BUY) ? fill + step : fill - step;
+}
+
+bool plugin_strategy::buy_at_market(long double order, long double market, const strategy_inputs& in)
+{
+    return advise(in, MERCURY_BUY, false, order, market, 0).at_market != 0;
+}
+
+bool plugin_strategy::sell_at_market(long double order, long double market, const strategy_inputs& in)
+{
+    return advise(in, MERCURY_SELL, false, order, market, 0).at_market != 0;
+}
+
+bool plugin_strategy::defer_buy(const strategy_inputs& in)
+{
+    return advise(in, MERCURY_BUY, false, 0, in.indicators.last_price(), 0).defer != 0;
+}
+
+bool plugin_strategy::defer_sell(const strategy_inputs& in)
+{
+    return advise(in, MERCURY_SELL, false, 0, in.indicators.last_price(), 0).defer != 0;
+}
+
+long double plugin_strategy::sell_after_buy(long double fill, long double rate, const strategy_inputs& in)
+{
+    return follow_up(in, MERCURY_BUY, fill, rate);
+}
+
+long double plugin_strategy::buy_after_sell(long double fill, long double rate, const strategy_inputs& in)
+{
+    return follow_up(in, MERCURY_SELL, fill, rate);
+}
+
+long double plugin_strategy::buy_funds(long double balance, const strategy_inputs& in)
+{
+    return advise(in, MERCURY_BUY, false, 0, in.indicators.last_price(), balance).funds;
+}
+
+bool plugin_strategy::watches_market(const strategy_inputs&)
+{
+    return true;
+}
+
+bool plugin_strategy::reprice_buy(long double order, long double market, const strategy_inputs& in)
+{
+    return advise(in, MERCURY_BUY, true, order, market, 0).reprice != 0;
+}
+
+bool plugin_strategy::reprice_sell(long double order, long double market, const strategy_inputs& in)
+{
+    return advise(in, MERCURY_SELL, true, order, market, 0).reprice != 0;
+}
+
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   plugin_host.hpp
+ * Author: Chris Morrison
+ *
+ * Created on 20 October 2026, 02:05
+ */
+#ifndef PLUGIN_HOST_HPP
+#define PLUGIN_HOST_HPP
+
+#include <cstdint>
+#include <deque>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "strategy.hpp"
+#include "strategy_plugin.h"
+
+namespace mercury
+{
+
+///
+/// One work order's instance of a plugin strategy. It stays put for the life of the host, while the
+/// library behind it can be swapped by plugin_host::reload().
+class plugin_instance
+{
+public:
+    const char* name() const { return api_->name; }
+
+    void tick(int64_t time_us, double price) { api_->on_tick(state_, time_us, price); }
+
+    /// The price of the order that follows a fill, or 0 to leave it to the robot.
+    double fill(const mercury_fill& fill) { return api_->on_fill(state_, &fill); }
+
+    /// Lets the plugin change the advice, which holds the robot's defaults on entry.
+    void check(const mercury_check& check, mercury_advice& advice) { api_->on_timer(state_, &check, &advice); }
+
+private:
+    friend class plugin_host;
+
+    plugin_instance(const mercury_strategy_plugin* api, void* state) : api_(api), state_(state) {}
+
+    const mercury_strategy_plugin* api_;
+    void* state_;
+};
+
+///
+/// Loads strategy plugins (see strategy_plugin.h) and hands out instances of them to work orders.
+class plugin_host
+{
+public:
+    plugin_host() = default;
+    plugin_host(const plugin_host&) = delete;
+    plugin_host& operator=(const plugin_host&) = delete;
+    ~plugin_host();
+
+    ///
+    /// Loads a plugin.
+    ///
+    /// \param path  The shared library.
+    /// \param error Receives the reason on failure.
+    /// \return false if the library cannot be loaded, was built for another ABI or has the name of a
+    ///         strategy that already exists.
+    bool load(const std::string& path, std::string& error);
+
+    /// True if a loaded plugin provides the named strategy.
+    bool has(const char* name) const;
+
+    ///
+    /// Creates an instance of the named plugin strategy for a work order.
+    ///
+    /// \return the instance, owned by the host, or nullptr if there is no such plugin or it failed to
+    ///         create one.
+    plugin_instance* attach(const char* name);
+
+    ///
+    /// Loads every plugin again from its file and moves its instances over to the new library, handing
+    /// each its old state. A plugin that fails to load again is left as it was.
+    ///
+    /// \param log Where to report what happened.
+    /// \return false if any plugin could not be reloaded.
+    bool reload(std::ostream& log);
+
+private:
+    struct module
+    {
+        std::string path;
+        void* handle = nullptr;
+        const mercury_strategy_plugin* api = nullptr;
+    };
+
+    bool open(const std::string& path, module& out, std::string& error);
+    bool swap(module& old, module& fresh, std::ostream& log);
+
+    std::vector<module> modules_;
+    std::deque<plugin_instance> instances_;
+    std::vector<unsigned char> buffer_;
+};
+
+}
+
+#endif /* PLUGIN_HOST_HPP */
@@ -0,0 +1,234 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   portfolio.cpp
+ * Author: Chris Morrison
+ *
+ * Created on 20 October 2026, 06:15
+ */
+#include <cstdlib>
+#include <iomanip>
+#include "portfolio.hpp"
+
+namespace mercury
+{
+
+static const std::size_t not_found = static_cast<std::size_t>(-1);
+
+// Smaller than any amount an order can hold.
+static const long double reserve_rounding = 1e-12L;
+
+static std::size_t index(holding side)
+{
+    return (side == holding::fiat) ? 0 : 1;
+}
+
+std::size_t portfolio::find_currency(const std::string& name)
+{
+    for (std::size_t i = 0; i < currencies_.size(); ++i)
+    {
+        if (currencies_[i].name == name) return i;
+    }
+    currencies_.emplace_back();
+    currencies_.back().name = name;
+    return currencies_.size() - 1;
+}
+
+std::size_t portfolio::find_pair(const std::string& coin, const std::string& fiat) const
+{
+    for (std::size_t i = 0; i < pairs_.size(); ++i)
+    {
+        const pair& p = pairs_[i];
+        if (currencies_[p.currencies[1]].name == coin && currencies_[p.currencies[0]].name == fiat) return i;
+    }
+    return not_found;
+}
+
+bool portfolio::add_pair(const std::string& text)
+{
+    std::size_t equals = text.find('=');
+    std::size_t dash = text.find('-');
+    if (equals == std::string::npos || dash == std::string::npos || dash == 0 || dash + 1 >= equals) return false;
+
+    std::string coin = text.substr(0, dash);
+    std::string fiat = text.substr(dash + 1, equals - dash - 1);
+    const char* weight_text = text.c_str() + equals + 1;
+    char* end = nullptr;
+    double weight = std::strtod(weight_text, &end);
+    if (end == weight_text || *end != '\0' || !(weight > 0.0)) return false;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (find_pair(coin, fiat) != not_found) return false;
+
+    pair p;
+    p.name = text.substr(0, equals);
+    p.currencies[0] = find_currency(fiat);
+    p.currencies[1] = find_currency(coin);
+    p.weight = weight;
+    currencies_[p.currencies[0]].weights += weight;
+    currencies_[p.currencies[1]].weights += weight;
+    pairs_.push_back(p);
+
+    return true;
+}
+
+bool portfolio::has_pair(const std::string& coin, const std::string& fiat) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return find_pair(coin, fiat) != not_found;
+}
+
+bool portfolio::join(const std::string& coin, const std::string& fiat, std::size_t& member)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::size_t found = find_pair(coin, fiat);
+    if (found == not_found) return false;
+
+    members_.emplace_back();
+    members_.back().pair = found;
+    member = members_.size() - 1;
+    return true;
+}
+
+uint64_t portfolio::balance_stamp(std::size_t member, holding side) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    const pair& p = pairs_[members_[member].pair];
+    return currencies_[p.currencies[index(side)]].posts;
+}
+
+bool portfolio::update_balance(std::size_t member, holding side, long double available, uint64_t stamp)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    const pair& p = pairs_[members_[member].pair];
+    currency& c = currencies_[p.currencies[index(side)]];
+    if (stamp != c.posts) return false;
+
+    c.free = (available > 0) ? available : 0;
+    return true;
+}
+
+long double portfolio::share_locked(const pair& p, holding side) const
+{
+    // The exchange leaves out what resting orders hold, so those are added back to get the whole.
+    const currency& c = currencies_[p.currencies[index(side)]];
+    return (c.free + c.resting) * p.weight / c.weights;
+}
+
+long double portfolio::budget_locked(const member_state& m, holding side) const
+{
+    const pair& p = pairs_[m.pair];
+    const currency& c = currencies_[p.currencies[index(side)]];
+
+    // A reservation about to be replaced is not counted against the new one; if it has not been posted,
+    // its funds are still free as well.
+    long double own = (m.side == side) ? m.reserved : 0;
+    long double budget = share_locked(p, side) - (p.reserved[index(side)] - own);
+    long double available = c.free - (c.pending - (m.posted ? 0 : own));
+
+    if (budget > available) budget = available;
+    return (budget > 0) ? budget : 0;
+}
+
+long double portfolio::share(std::size_t member, holding side) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return share_locked(pairs_[members_[member].pair], side);
+}
+
+long double portfolio::budget(std::size_t member, holding side) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return budget_locked(members_[member], side);
+}
+
+void portfolio::release_locked(member_state& m)
+{
+    if (m.reserved == 0) return;
+
+    pair& p = pairs_[m.pair];
+    currency& c = currencies_[p.currencies[index(m.side)]];
+    long double& held = m.posted ? c.resting : c.pending;
+    p.reserved[index(m.side)] -= m.reserved;
+    held -= m.reserved;
+    m.reserved = 0;
+    m.posted = false;
+
+    // Reservations released in a different order to the one they were taken in leave rounding behind.
+    if (p.reserved[index(m.side)] < reserve_rounding) p.reserved[index(m.side)] = 0;
+    if (held < reserve_rounding) held = 0;
+
+    // Funds never posted are free again straight away. Those of a posted order are either spent or back
+    // on the account; the next balance read says which.
+}
+
+bool portfolio::reserve(std::size_t member, holding side, long double amount)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    member_state& m = members_[member];
+    if (amount > budget_locked(m, side)) return false;
+
+    release_locked(m);
+    pair& p = pairs_[m.pair];
+    currency& c = currencies_[p.currencies[index(side)]];
+    m.side = side;
+    m.reserved = amount;
+    p.reserved[index(side)] += amount;
+    c.pending += amount;
+
+    return true;
+}
+
+void portfolio::posted(std::size_t member)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    member_state& m = members_[member];
+    if (m.reserved == 0 || m.posted) return;
+
+    // The exchange now holds the funds, so they move out of the free balance it last reported.
+    currency& c = currencies_[pairs_[m.pair].currencies[index(m.side)]];
+    c.pending -= m.reserved;
+    if (c.pending < reserve_rounding) c.pending = 0;
+    c.free -= m.reserved;
+    if (c.free < 0) c.free = 0;
+    c.resting += m.reserved;
+    ++c.posts;
+    m.posted = true;
+}
+
+void portfolio::release(std::size_t member)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    release_locked(members_[member]);
+}
+
+void portfolio::report(std::ostream& out) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    out << "Portfolio:" << std::endl;
+    for (const pair& p : pairs_)
+    {
+        const currency& fiat = currencies_[p.currencies[0]];
+        const currency& coin = currencies_[p.currencies[1]];
+        out << "  " << std::left << std::setw(12) << p.name << std::right << " weight " << std::setw(6) << std::fixed
+            << std::setprecision(2) << p.weight << "  share " << share_locked(p, holding::fiat) << " " << fiat.name << " ("
+            << p.reserved[0] << " reserved), " << std::setprecision(8) << share_locked(p, holding::coin) << " " << coin.name << " ("
+            << p.reserved[1] << " reserved)" << std::endl;
+    }
+}
+
+}
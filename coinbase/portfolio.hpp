@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   portfolio.hpp
+ * Author: Chris Morrison
+ *
+ * Created on 20 October 2026, 06:15
+ */
+#ifndef PORTFOLIO_HPP
+#define PORTFOLIO_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// ------------------------------------------------------------------------------------------------
+// Portfolio allocation.
+//
+// Without a portfolio every work order sizes its orders from the whole balance of the account, so
+// work orders on different pairs race for the same funds and the losers sleep on insufficient_funds.
+// A portfolio gives each pair a target weight and keeps one picture of the account: the balance the
+// exchange last reported as free for each currency, plus whatever the portfolio's own resting orders
+// hold. A pair's budget in a currency is its weight's share of that total, less what its own orders
+// already hold; pairs that share a currency (BTC-EUR and ETH-EUR share EUR) split it by their weights,
+// and work orders on the same pair share the pair's budget.
+//
+// A work order reserves the funds for an order before posting it. The reservation is checked against
+// the budget and taken in one step, so two work orders can never both spend the same funds, and it is
+// released once the order fills, is cancelled or fails. Until the order is posted its funds are still
+// free on the exchange, so what is available to spend is always derived: the free balance less the
+// reservations not yet posted. Once posted, the funds leave the free balance and are counted as
+// resting instead. A balance read that started before an order on the currency was posted may or may
+// not include its funds, so it is ignored rather than counting them twice.
+// ------------------------------------------------------------------------------------------------
+
+namespace mercury
+{
+
+/// The two sides of a pair's budget.
+enum class holding
+{
+    fiat,   ///< Spent by buys.
+    coin    ///< Spent by sells.
+};
+
+///
+/// Target weights and reservations for the pairs run in one process. Safe to use from any thread.
+class portfolio
+{
+public:
+    ///
+    /// Parses a target weight given as PAIR=WEIGHT, e.g. "BTC-EUR=60", and adds the pair.
+    ///
+    /// \return false if the text is not of that form, the weight is not positive or the pair is already in.
+    bool add_pair(const std::string& text);
+
+    /// True if the portfolio has a weight for the pair.
+    bool has_pair(const std::string& coin, const std::string& fiat) const;
+
+    bool empty() const { return pairs_.empty(); }
+
+    ///
+    /// Adds a work order on one of the pairs.
+    ///
+    /// \param coin   The coin traded.
+    /// \param fiat   The fiat currency.
+    /// \param member Receives the number the work order is known by.
+    /// \return false if the pair has no weight.
+    bool join(const std::string& coin, const std::string& fiat, std::size_t& member);
+
+    /// Taken just before reading a balance from the exchange, for update_balance() to tell whether it is stale.
+    uint64_t balance_stamp(std::size_t member, holding side) const;
+
+    ///
+    /// Updates the account picture with a balance read from the exchange.
+    ///
+    /// \param member    The work order that read it.
+    /// \param side      Which of its currencies was read.
+    /// \param available The available balance, which does not include funds held by resting orders.
+    /// \param stamp     The balance_stamp() taken before the read.
+    /// \return false, ignoring the reading, if an order has been posted on the currency since the stamp.
+    bool update_balance(std::size_t member, holding side, long double available, uint64_t stamp);
+
+    /// The pair's share of the account in one of its currencies, before reservations.
+    long double share(std::size_t member, holding side) const;
+
+    /// What the work order may spend now: the pair's share less the reservations on the pair, capped at
+    /// what the exchange reported as free less the reservations not yet posted.
+    long double budget(std::size_t member, holding side) const;
+
+    ///
+    /// Reserves funds for an order about to be posted, replacing any reservation the work order held.
+    ///
+    /// \return false, reserving nothing, if the amount is over the budget.
+    bool reserve(std::size_t member, holding side, long double amount);
+
+    /// The order the work order reserved funds for is now resting on the exchange.
+    void posted(std::size_t member);
+
+    /// Releases the work order's reservation, if it has one.
+    void release(std::size_t member);
+
+    /// Prints every pair's weight, budgets and reservations.
+    void report(std::ostream& out) const;
+
+private:
+    struct currency
+    {
+        std::string name;
+        long double free = 0;       ///< The balance the exchange last reported as available.
+        long double pending = 0;    ///< Reserved for orders not yet posted; still part of free.
+        long double resting = 0;    ///< Reserved for posted orders; no longer part of free.
+        uint64_t posts = 0;         ///< Orders posted on the currency, to spot stale balance reads.
+        double weights = 0;         ///< Sum of the weights of the pairs that trade the currency.
+    };
+
+    struct pair
+    {
+        std::string name;
+        std::size_t currencies[2];  ///< Indexed by holding.
+        double weight;
+        long double reserved[2] = { 0, 0 };
+    };
+
+    struct member_state
+    {
+        std::size_t pair;
+        holding side = holding::fiat;
+        long double reserved = 0;
+        bool posted = false;
+    };
+
+    std::size_t find_currency(const std::string& name);
+    std::size_t find_pair(const std::string& coin, const std::string& fiat) const;
+    long double share_locked(const pair& p, holding side) const;
+    long double budget_locked(const member_state& m, holding side) const;
+    void release_locked(member_state& m);
+
+    mutable std::mutex mutex_;
+    std::vector<currency> currencies_;
+    std::vector<pair> pairs_;
+    std::vector<member_state> members_;
+};
+
+}
+
+#endif /* PORTFOLIO_HPP */
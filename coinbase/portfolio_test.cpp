@@ -0,0 +1,218 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   portfolio_test.cpp
+ * Author: Chris Morrison
+ *
+ * Created on 20 October 2026, 19:35
+ */
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <thread>
+#include <vector>
+#include "portfolio.hpp"
+#include "unit_test.hpp"
+
+using namespace mercury;
+
+static bool near(long double actual, long double expected)
+{
+    return std::fabs(actual - expected) < 1e-9L;
+}
+
+// Reads a balance the way the trader does: stamp first, then the reading.
+static bool read_balance(portfolio& folio, std::size_t member, holding side, long double available)
+{
+    return folio.update_balance(member, side, available, folio.balance_stamp(member, side));
+}
+
+static void test_add_pair()
+{
+    portfolio folio;
+    const char* const bad[] = { "BTC-EUR", "BTCEUR=1", "-EUR=1", "BTC-=1", "BTC-EUR=", "BTC-EUR=0", "BTC-EUR=-1",
+                                "BTC-EUR=x", "BTC-EUR=5x", "BTC-EUR=nan" };
+
+    for (const char* text : bad) CHECK(!folio.add_pair(text));
+    CHECK(folio.empty());
+
+    CHECK(folio.add_pair("BTC-EUR=60"));
+    CHECK(!folio.add_pair("BTC-EUR=10"));
+    CHECK(folio.has_pair("BTC", "EUR"));
+    CHECK(!folio.has_pair("EUR", "BTC"));
+
+    std::size_t member = 0;
+    CHECK(folio.join("BTC", "EUR", member) && member == 0);
+    CHECK(!folio.join("ETH", "EUR", member));
+}
+
+static void test_shares()
+{
+    portfolio folio;
+    std::size_t btc = 0;
+    std::size_t eth = 0;
+
+    CHECK(folio.add_pair("BTC-EUR=60"));
+    CHECK(folio.add_pair("ETH-EUR=40"));
+    CHECK(folio.join("BTC", "EUR", btc));
+    CHECK(folio.join("ETH", "EUR", eth));
+
+    // Pairs that share a currency split it by weight; a currency only one pair trades is all its own.
+    CHECK(read_balance(folio, btc, holding::fiat, 1000));
+    CHECK(read_balance(folio, btc, holding::coin, 2));
+    CHECK(near(folio.share(btc, holding::fiat), 600));
+    CHECK(near(folio.share(eth, holding::fiat), 400));
+    CHECK(near(folio.share(btc, holding::coin), 2));
+    CHECK(near(folio.budget(eth, holding::fiat), 400));
+
+    // A balance cannot be negative.
+    CHECK(read_balance(folio, eth, holding::coin, -5));
+    CHECK(near(folio.share(eth, holding::coin), 0));
+}
+
+static void test_reservations()
+{
+    portfolio folio;
+    std::size_t a = 0;
+    std::size_t b = 0;
+    std::size_t eth = 0;
+
+    CHECK(folio.add_pair("BTC-EUR=60"));
+    CHECK(folio.add_pair("ETH-EUR=40"));
+    CHECK(folio.join("BTC", "EUR", a));
+    CHECK(folio.join("BTC", "EUR", b));
+    CHECK(folio.join("ETH", "EUR", eth));
+    CHECK(read_balance(folio, a, holding::fiat, 1000));
+    CHECK(read_balance(folio, a, holding::coin, 1));
+
+    // Work orders on the same pair share its budget.
+    CHECK(folio.reserve(a, holding::fiat, 500));
+    CHECK(near(folio.budget(b, holding::fiat), 100));
+    CHECK(!folio.reserve(b, holding::fiat, 200));
+    CHECK(folio.reserve(b, holding::fiat, 100));
+    CHECK(near(folio.budget(b, holding::fiat), 100));
+    CHECK(near(folio.budget(eth, holding::fiat), 400));
+
+    // A new reservation replaces the old one, which does not count against it.
+    CHECK(near(folio.budget(a, holding::fiat), 500));
+    CHECK(!folio.reserve(a, holding::fiat, 550));
+    CHECK(folio.reserve(a, holding::fiat, 450));
+    CHECK(near(folio.budget(b, holding::fiat), 150));
+
+    // Reserving the other currency gives up the first reservation.
+    CHECK(folio.reserve(b, holding::coin, 0.5L));
+    CHECK(near(folio.budget(a, holding::fiat), 600));
+    CHECK(near(folio.budget(b, holding::coin), 1));
+    CHECK(!folio.reserve(a, holding::coin, 0.6L));
+
+    // Released funds that were never posted are free again at once.
+    folio.release(b);
+    folio.release(b);
+    CHECK(near(folio.budget(b, holding::coin), 1));
+    CHECK(near(folio.budget(b, holding::fiat), 150));
+}
+
+static void test_posted_orders()
+{
+    portfolio folio;
+    std::size_t btc = 0;
+    std::size_t eth = 0;
+
+    CHECK(folio.add_pair("BTC-EUR=60"));
+    CHECK(folio.add_pair("ETH-EUR=40"));
+    CHECK(folio.join("BTC", "EUR", btc));
+    CHECK(folio.join("ETH", "EUR", eth));
+    CHECK(read_balance(folio, btc, holding::fiat, 1000));
+
+    uint64_t before = folio.balance_stamp(eth, holding::fiat);
+    CHECK(folio.reserve(btc, holding::fiat, 450));
+    folio.posted(btc);
+    folio.posted(btc);
+
+    // Once posted the funds leave the free balance and rest on the book; the shares do not move, but a
+    // new order can only spend what is still free.
+    CHECK(near(folio.share(btc, holding::fiat), 600));
+    CHECK(near(folio.share(eth, holding::fiat), 400));
+    CHECK(near(folio.budget(btc, holding::fiat), 550));
+    CHECK(near(folio.budget(eth, holding::fiat), 400));
+
+    // A reading started before the post may or may not include its funds, so it is refused.
+    CHECK(!folio.update_balance(eth, holding::fiat, 1000, before));
+    CHECK(near(folio.share(eth, holding::fiat), 400));
+
+    // One started after it leaves them out, as the exchange does.
+    CHECK(read_balance(folio, eth, holding::fiat, 550));
+    CHECK(near(folio.share(eth, holding::fiat), 400));
+
+    // Other currencies are not affected by the post.
+    CHECK(read_balance(folio, eth, holding::coin, 3));
+
+    // When the order is released the funds stay out of the picture until a reading says where they went.
+    folio.release(btc);
+    CHECK(near(folio.share(btc, holding::fiat), 330));
+    CHECK(read_balance(folio, btc, holding::fiat, 1000));
+    CHECK(near(folio.share(btc, holding::fiat), 600));
+
+    // An order that filled spent them.
+    CHECK(folio.reserve(btc, holding::fiat, 600));
+    folio.posted(btc);
+    folio.release(btc);
+    CHECK(read_balance(folio, btc, holding::fiat, 400));
+    CHECK(near(folio.share(btc, holding::fiat), 240));
+    CHECK(near(folio.budget(eth, holding::fiat), 160));
+}
+
+static void test_threads()
+{
+    portfolio folio;
+    std::vector<std::size_t> members(4);
+    std::vector<std::thread> threads;
+    std::atomic<int> holding_now{ 0 };
+    std::atomic<bool> over{ false };
+
+    CHECK(folio.add_pair("BTC-EUR=1"));
+    for (std::size_t& m : members) CHECK(folio.join("BTC", "EUR", m));
+    CHECK(read_balance(folio, members[0], holding::fiat, 600));
+
+    // Four work orders race for funds that cover three reservations; a fourth must never get through.
+    for (std::size_t m : members)
+    {
+        threads.emplace_back([&folio, &holding_now, &over, m]() {
+            for (int i = 0; i < 20000; ++i)
+            {
+                if (!folio.reserve(m, holding::fiat, 200)) continue;
+                if (++holding_now > 3) over = true;
+                --holding_now;
+                folio.release(m);
+            }
+        });
+    }
+    for (std::thread& t : threads) t.join();
+
+    CHECK(!over);
+    CHECK(near(folio.budget(members[0], holding::fiat), 600));
+}
+
+int main()
+{
+    test_add_pair();
+    test_shares();
+    test_reservations();
+    test_posted_orders();
+    test_threads();
+
+    return test_result("portfolio");
+}
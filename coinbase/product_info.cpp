@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   product_info.cpp
+ * Author: Chris Morrison
+ *
+ * Created on 19 October 2026, 16:30
+ */
+#include <cmath>
+#include <cstring>
+#include "fixed_point.hpp"
+#include "product_info.hpp"
+
+namespace mercury
+{
+
+// Prices that arrive as binary floating point are a hair either side of the decimal they came from;
+// this much slack (in units of the last decimal place) stops 8123.45 being floored to 8123.44.
+static const long double rounding_slack = 1e-6;
+
+///
+/// Turns an increment such as "0.01000000" into the smallest number of decimal places that holds it
+/// (2) and the increment at that precision (1).
+static bool parse_increment(const std::string& text, int& decimals, int64_t& increment)
+{
+    std::size_t dot = text.find('.');
+    std::size_t last = text.find_last_not_of('0');
+
+    decimals = (dot == std::string::npos || last == std::string::npos || last <= dot) ? 0 : static_cast<int>(last - dot);
+    if (decimals > max_decimals || !parse_fixed(text, decimals, increment)) return false;
+
+    return increment > 0;
+}
+
+static void assign_fixed(std::string& out, int64_t value, int decimals)
+{
+    char buf[48];
+    out.assign(buf, format_fixed(value, decimals, buf, sizeof(buf)));
+}
+
+static int64_t round_down(int64_t value, int64_t step)
+{
+    return value - value % step;
+}
+
+static int64_t round_up(int64_t value, int64_t step)
+{
+    int64_t rem = value % step;
+    return rem ? value + (step - rem) : value;
+}
+
+bool product_info::set(const std::string& product_id, const std::string& quote_inc, const std::string& base_inc,
+                       const std::string& min_size, const std::string& max_size)
+{
+    product_info info;
+
+    info.id = product_id;
+    if (!parse_increment(quote_inc, info.price_decimals, info.quote_increment)) return false;
+    if (!parse_increment(base_inc, info.size_decimals, info.base_increment)) return false;
+    if (!min_size.empty() && !parse_fixed(min_size, info.size_decimals, info.base_min_size)) return false;
+    if (!max_size.empty() && !parse_fixed(max_size, info.size_decimals, info.base_max_size)) return false;
+
+    *this = info;
+    return true;
+}
+
+std::string product_info::price_down(long double price) const
+{
+    int64_t units = static_cast<int64_t>(std::floor(price * power_of_ten(price_decimals) + rounding_slack));
+    return format_fixed(round_down(units, quote_increment), price_decimals);
+}
+
+std::string product_info::price_up(long double price) const
+{
+    int64_t units = static_cast<int64_t>(std::ceil(price * power_of_ten(price_decimals) - rounding_slack));
+    return format_fixed(round_up(units, quote_increment), price_decimals);
+}
+
+///
+/// Scales a price to units of the last decimal place, refusing anything that is not a positive number
+/// or does not fit.
+static bool price_units(long double price, int decimals, bool up, int64_t& units)
+{
+    long double scaled = price * power_of_ten(decimals);
+
+    if (!std::isfinite(scaled) || scaled <= 0 || scaled >= 9e18L) return false;
+    units = static_cast<int64_t>(up ? std::ceil(scaled - rounding_slack) : std::floor(scaled + rounding_slack));
+    return units > 0;
+}
+
+bool product_info::price_down(long double price, char* buf, std::size_t len) const
+{
+    int64_t units;
+
+    if (!price_units(price, price_decimals, false, units)) return false;
+    units = round_down(units, quote_increment);
+    return units > 0 && format_fixed(units, price_decimals, buf, len) > 0;
+}
+
+bool product_info::price_up(long double price, char* buf, std::size_t len) const
+{
+    int64_t units;
+
+    if (!price_units(price, price_decimals, true, units)) return false;
+    return format_fixed(round_up(units, quote_increment), price_decimals, buf, len) > 0;
+}
+
+std::string product_info::quantise_price(const std::string& price, bool up) const
+{
+    std::string out;
+    quantise_price(price.c_str(), up, out);
+    return out;
+}
+
+void product_info::quantise_price(const char* price, bool up, std::string& out) const
+{
+    // Parse with one extra digit of precision so we can tell whether rounding up is needed.
+    int64_t units;
+    std::size_t len = std::strlen(price);
+
+    if (price_decimals >= max_decimals || !parse_fixed(price, price + len, price_decimals + 1, units))
+    {
+        out.assign(price, len);
+        return;
+    }
+
+    int64_t step = quote_increment * 10;
+    assign_fixed(out, (up ? round_up(units, step) : round_down(units, step)) / 10, price_decimals);
+}
+
+bool product_info::size_for_funds(long double funds, long double price, std::string& out) const
+{
+    if (funds <= 0 || price <= 0) return false;
+
+    const long double scale = power_of_ten(size_decimals);
+    int64_t units = round_down(static_cast<int64_t>(std::floor(funds / price * scale)), base_increment);
+
+    // Guard against the division rounding up by a hair and overspending.
+    while (units > 0 && (units / scale) * price > funds) units -= base_increment;
+    if (base_max_size > 0 && units > base_max_size) units = round_down(base_max_size, base_increment);
+    if (units <= 0 || units < base_min_size) return false;
+
+    assign_fixed(out, units, size_decimals);
+    return true;
+}
+
+bool product_info::quantise_size(const std::string& size, std::string& out) const
+{
+    int64_t units;
+
+    if (!parse_fixed(size, size_decimals, units)) return false;
+
+    units = round_down(units, base_increment);
+    if (base_max_size > 0 && units > base_max_size) units = round_down(base_max_size, base_increment);
+    if (units <= 0 || units < base_min_size) return false;
+
+    assign_fixed(out, units, size_decimals);
+    return true;
+}
+
+}
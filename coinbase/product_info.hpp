@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   product_info.hpp
+ * Author: Chris Morrison
+ *
+ * Created on 19 October 2026, 16:30
+ */
+#ifndef PRODUCT_INFO_HPP
+#define PRODUCT_INFO_HPP
+
+#include <cstdint>
+#include <string>
+
+namespace mercury
+{
+
+///
+/// Trading rules for one product (e.g. BTC-EUR). Prices and sizes are held as fixed-point integers,
+/// each at the precision of its increment, so that quantising an order never goes through text.
+struct product_info
+{
+    std::string id;
+
+    int price_decimals = 2;         ///< Decimal places in the quote increment.
+    int64_t quote_increment = 1;    ///< Smallest price step, scaled by 10^price_decimals.
+
+    int size_decimals = 8;          ///< Decimal places in the base increment.
+    int64_t base_increment = 1;     ///< Smallest size step, scaled by 10^size_decimals.
+    int64_t base_min_size = 0;      ///< Smallest order size, scaled by 10^size_decimals.
+    int64_t base_max_size = 0;      ///< Largest order size, scaled by 10^size_decimals; 0 for no limit.
+
+    ///
+    /// Fills in the rules from the increment and size strings the exchange reports.
+    ///
+    /// \return false if any of the values could not be understood.
+    bool set(const std::string& product_id, const std::string& quote_inc, const std::string& base_inc,
+             const std::string& min_size, const std::string& max_size);
+
+    /// Rounds a price down to the quote increment (for buys).
+    std::string price_down(long double price) const;
+
+    /// Rounds a price up to the quote increment (for sells).
+    std::string price_up(long double price) const;
+
+    ///
+    /// \overload Writes into a buffer without touching the heap.
+    ///
+    /// \return false if the price is not a positive number within range, or the buffer is too small.
+    bool price_down(long double price, char* buf, std::size_t len) const;
+
+    ///
+    /// \overload Writes into a buffer without touching the heap.
+    ///
+    /// \return false if the price is not a positive number within range, or the buffer is too small.
+    bool price_up(long double price, char* buf, std::size_t len) const;
+
+    /// Rounds price text down or up to the quote increment; returns the text unchanged if it is not a number.
+    std::string quantise_price(const std::string& price, bool round_up) const;
+
+    /// \overload Writes into out, reusing its storage.
+    void quantise_price(const char* price, bool round_up, std::string& out) const;
+
+    ///
+    /// Works out the largest valid order size that the given funds buy at the given price.
+    ///
+    /// \param funds The fiat available.
+    /// \param price The limit price.
+    /// \param out   Receives the size, reusing its storage.
+    /// \return false if the funds do not stretch to the minimum order size.
+    bool size_for_funds(long double funds, long double price, std::string& out) const;
+
+    ///
+    /// Rounds a coin amount down to the base increment and clamps it to the maximum order size.
+    ///
+    /// \param size The amount, as text.
+    /// \param out  Receives the size, reusing its storage.
+    /// \return false if the amount is not a number or is below the minimum order size.
+    bool quantise_size(const std::string& size, std::string& out) const;
+};
+
+}
+
+#endif /* PRODUCT_INFO_HPP */
@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   profiler.cpp
+ * Author: Chris Morrison
+ *
+ * Created on 19 October 2026, 22:40
+ */
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <iomanip>
+#include "profiler.hpp"
+
+namespace mercury
+{
+
+static const char* const span_names[] = {
+    "BUY", "WFB", "SELL", "WFS",
+    "order check", "network error retry", "insufficient funds backoff", "market deferral",
+    "query retry", "order rejected retry", "repost wait", "restart wait", "slice wait",
+    "fill announcement"
+};
+
+static_assert(sizeof(span_names) / sizeof(span_names[0]) == static_cast<unsigned int>(span_kind::count),
+              "every span kind needs a name");
+
+const char* span_name(span_kind kind)
+{
+    unsigned int index = static_cast<unsigned int>(kind);
+    return (index < static_cast<unsigned int>(span_kind::count)) ? span_names[index] : "unknown";
+}
+
+int64_t profile_now()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// The first four kinds are the trader's states; the rest happen inside them.
+static bool is_state(span_kind kind)
+{
+    return static_cast<unsigned int>(kind) <= static_cast<unsigned int>(span_kind::wait_for_sell);
+}
+
+// Copies text into a JSON string body, escaping what has to be.
+static void write_json_string(std::ostream& out, const std::string& text)
+{
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\') out.put('\\');
+        if (static_cast<unsigned char>(c) < 0x20) c = ' ';
+        out.put(c);
+    }
+}
+
+state_profiler::~state_profiler()
+{
+    close();
+}
+
+bool state_profiler::open(const std::string& trace_path)
+{
+    close();
+    trace_.open(trace_path, std::ios::out | std::ios::trunc);
+    if (!trace_.is_open()) return false;
+
+    trace_ << "[";
+    first_event_ = true;
+
+    // Name the tracks added before the file was opened.
+    for (unsigned int i = 0; i < tracks_.size(); ++i) name_track(i);
+    trace_.flush();
+
+    return static_cast<bool>(trace_);
+}
+
+unsigned int state_profiler::add_track(const std::string& name)
+{
+    unsigned int id = static_cast<unsigned int>(tracks_.size());
+
+    tracks_.emplace_back();
+    tracks_.back().name = name;
+
+    if (trace_.is_open())
+    {
+        name_track(id);
+        trace_.flush();
+    }
+
+    return id;
+}
+
+void state_profiler::name_track(unsigned int id)
+{
+    // Tracks are shown as threads of a single process; tid 0 is avoided as some viewers treat it specially.
+    trace_ << (first_event_ ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << id + 1
+           << ",\"args\":{\"name\":\"";
+    write_json_string(trace_, tracks_[id].name);
+    trace_ << "\"}}";
+    first_event_ = false;
+}
+
+void state_profiler::record(unsigned int track, span_kind kind, int64_t start_us, int64_t end_us)
+{
+    if (track >= tracks_.size() || kind >= span_kind::count) return;
+
+    int64_t duration = (end_us > start_us) ? end_us - start_us : 0;
+    totals& t = tracks_[track].kinds[static_cast<unsigned int>(kind)];
+
+    ++t.count;
+    t.total_us += duration;
+    if (duration > t.max_us) t.max_us = duration;
+
+    if (!trace_.is_open()) return;
+
+    // Formatted into a local buffer so that recording a span does not allocate.
+    char event[192];
+    int len = std::snprintf(event, sizeof(event),
+                            "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%" PRId64 ",\"dur\":%" PRId64 ",\"pid\":1,\"tid\":%u}",
+                            first_event_ ? "\n" : ",\n", span_name(kind), is_state(kind) ? "state" : "wait", start_us,
+                            duration, track + 1);
+    if (len <= 0 || static_cast<std::size_t>(len) >= sizeof(event)) return;
+
+    trace_.write(event, len);
+    trace_.flush();
+    first_event_ = false;
+}
+
+void state_profiler::report(std::ostream& out) const
+{
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+
+    out << std::fixed << std::setprecision(3);
+    for (const track& t : tracks_)
+    {
+        unsigned int order[static_cast<unsigned int>(span_kind::count)];
+        unsigned int n = 0;
+
+        // Insert each recorded kind in place, most total time first; there are only a handful.
+        for (unsigned int k = 0; k < static_cast<unsigned int>(span_kind::count); ++k)
+        {
+            if (!t.kinds[k].count) continue;
+
+            unsigned int i = n++;
+            for (; i > 0 && t.kinds[order[i - 1]].total_us < t.kinds[k].total_us; --i) order[i] = order[i - 1];
+            order[i] = k;
+        }
+
+        out << t.name << ":" << std::endl;
+        if (n == 0) out << "    nothing recorded yet" << std::endl;
+        for (unsigned int i = 0; i < n; ++i)
+        {
+            const totals& k = t.kinds[order[i]];
+            out << "    " << std::left << std::setw(28) << span_name(static_cast<span_kind>(order[i])) << std::right << std::setw(8)
+                << k.count << " x, " << std::setw(14) << k.total_us / 1e6 << " s total, " << std::setw(12)
+                << k.total_us / 1e6 / k.count << " s mean, " << std::setw(12) << k.max_us / 1e6 << " s max" << std::endl;
+        }
+    }
+    if (!tracks_.empty()) out << "(a state's time includes the waits taken inside it)" << std::endl;
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+void state_profiler::close()
+{
+    if (!trace_.is_open()) return;
+
+    trace_ << "\n]\n";
+    trace_.close();
+}
+
+}
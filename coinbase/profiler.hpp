@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   profiler.hpp
+ * Author: Chris Morrison
+ *
+ * Created on 19 October 2026, 22:40
+ */
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <cstdint>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// ------------------------------------------------------------------------------------------------
+// Time-in-state profiling.
+//
+// Every work order gets a track, and every step it takes, every wait and every fill announcement is
+// recorded on it as a span. Spans are streamed to a Chrome trace file (the JSON array format, which
+// chrome://tracing and ui.perfetto.dev both load, and which stays valid if the process dies before
+// the closing bracket is written), and are added up per track for a summary report. A state's span
+// encloses the waits taken inside it, which the trace viewers show nested.
+// ------------------------------------------------------------------------------------------------
+
+namespace mercury
+{
+
+/// What a span measures.
+enum class span_kind : unsigned int
+{
+    buy,                ///< A BUY step.
+    wait_for_buy,       ///< A WFB step.
+    sell,               ///< A SELL step.
+    wait_for_sell,      ///< A WFS step.
+    order_check,        ///< Waiting to check on a resting order.
+    network_error,      ///< Waiting to retry after a network error.
+    insufficient_funds, ///< Backing off because the balance is too small.
+    market_deferral,    ///< Holding off while the market moves sharply.
+    query_retry,        ///< Waiting to retry a balance or product lookup.
+    order_rejected,     ///< Waiting to retry an order the exchange turned down.
+    repost,             ///< Waiting to repost a cancelled order.
+    restart_wait,       ///< Serving out a wait restored from a snapshot.
+    slice_wait,         ///< Waiting for the next slice of a sliced order.
+    fill_announcement,  ///< Blocked announcing a fill (playing the till sound).
+    count
+};
+
+/// The name a span kind is shown under.
+const char* span_name(span_kind kind);
+
+/// Microseconds on the clock spans are measured with.
+int64_t profile_now();
+
+///
+/// Collects spans from any number of work orders. Used from the io_context thread only.
+class state_profiler
+{
+public:
+    state_profiler() = default;
+    state_profiler(const state_profiler&) = delete;
+    state_profiler& operator=(const state_profiler&) = delete;
+    ~state_profiler();
+
+    ///
+    /// Starts a trace file. Without one, spans are still added up for the report.
+    ///
+    /// \return false if the file cannot be created.
+    bool open(const std::string& trace_path);
+
+    ///
+    /// Adds a track for a work order.
+    ///
+    /// \param name Shown as the track's name in the trace and the report.
+    /// \return the track's number, to pass to record().
+    unsigned int add_track(const std::string& name);
+
+    /// Records a span that ran from start_us to end_us (see profile_now()).
+    void record(unsigned int track, span_kind kind, int64_t start_us, int64_t end_us);
+
+    /// Writes the time spent in every kind of span, per track, largest first.
+    void report(std::ostream& out) const;
+
+    /// Finishes the trace file.
+    void close();
+
+private:
+    struct totals
+    {
+        uint64_t count = 0;
+        int64_t total_us = 0;
+        int64_t max_us = 0;
+    };
+
+    struct track
+    {
+        std::string name;
+        totals kinds[static_cast<unsigned int>(span_kind::count)];
+    };
+
+    void name_track(unsigned int id);
+
+    std::ofstream trace_;
+    bool first_event_ = true;
+    std::vector<track> tracks_;
+};
+
+}
+
+#endif /* PROFILER_HPP */
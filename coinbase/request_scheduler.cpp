@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   request_scheduler.cpp
+ * Author: Chris Morrison
+ *
+ * Created on 20 October 2026, 02:50
+ */
+#include <algorithm>
+#include <cmath>
+#include "request_scheduler.hpp"
+
+namespace mercury
+{
+
+static int64_t scheduler_now()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+const char* request_priority_name(request_priority priority)
+{
+    switch (priority)
+    {
+        case request_priority::trading: return "trading";
+        case request_priority::account: return "account";
+        case request_priority::polling: return "polling";
+        default: return "unknown";
+    }
+}
+
+request_scheduler::request_scheduler(boost::asio::io_context& io, double rate, double burst)
+    : timer_(io), rate_(rate), burst_(std::max(burst, 1.0)), tokens_(burst_), refilled_us_(scheduler_now())
+{
+}
+
+void request_scheduler::refill(int64_t now)
+{
+    tokens_ = std::min(burst_, tokens_ + double(now - refilled_us_) * rate_ / 1e6);
+    refilled_us_ = now;
+}
+
+void request_scheduler::submit(request_priority priority, scheduled_request* request)
+{
+    int64_t now = scheduler_now();
+
+    refill(now);
+    if (waiting_ == 0 && tokens_ >= 1.0)
+    {
+        tokens_ -= 1.0;
+        ++stats_.sent;
+        request->start(request);
+        return;
+    }
+
+    queue& q = queues_[std::size_t(priority)];
+    request->next = nullptr;
+    request->queued_us = now;
+    if (q.tail)
+        q.tail->next = request;
+    else
+        q.head = request;
+    q.tail = request;
+
+    ++waiting_;
+    ++stats_.held;
+    ++stats_.queued[std::size_t(priority)];
+    stats_.most_queued = std::max(stats_.most_queued, waiting_);
+    arm();
+}
+
+void request_scheduler::charge(uint64_t requests)
+{
+    if (requests == 1) return;
+
+    refill(scheduler_now());
+    tokens_ = std::min(burst_, tokens_ + 1.0 - double(requests));
+    if (requests > 1) stats_.extra += requests - 1;
+}
+
+void request_scheduler::drain()
+{
+    int64_t now = scheduler_now();
+
+    refill(now);
+    for (std::size_t p = 0; p < std::size_t(request_priority::count) && tokens_ >= 1.0;)
+    {
+        queue& q = queues_[p];
+        if (!q.head)
+        {
+            ++p;
+            continue;
+        }
+
+        scheduled_request* request = q.head;
+        q.head = request->next;
+        if (!q.head) q.tail = nullptr;
+
+        tokens_ -= 1.0;
+        --waiting_;
+        --stats_.queued[p];
+        ++stats_.sent;
+        stats_.total_wait_us += now - request->queued_us;
+        stats_.longest_wait_us = std::max(stats_.longest_wait_us, now - request->queued_us);
+
+        // Starting a request can queue another (it runs on the strand, not here), but never on this
+        // call stack, so the queues cannot change under the loop except at the tail.
+        request->start(request);
+    }
+
+    arm();
+}
+
+void request_scheduler::arm()
+{
+    if (armed_ || waiting_ == 0) return;
+
+    // Sleep until the next whole token is due.
+    double missing = std::max(0.0, 1.0 - tokens_);
+    int64_t delay_us = (rate_ > 0.0) ? static_cast<int64_t>(std::ceil(missing * 1e6 / rate_)) : 1000000;
+
+    armed_ = true;
+    timer_.expires_after(std::chrono::microseconds(delay_us));
+    timer_.async_wait([this](const boost::system::error_code& error)
+    {
+        armed_ = false;
+        if (!error) drain();
+    });
+}
+
+void request_scheduler::report(std::ostream& out) const
+{
+    out << "Exchange requests: " << stats_.sent << " sent";
+    if (stats_.extra) out << " and " << stats_.extra << " more by calls that needed several";
+    out << ", " << stats_.held << " held back";
+    if (stats_.held) out << " for " << (stats_.total_wait_us / int64_t(stats_.held)) / 1000 << " ms on average, "
+                         << stats_.longest_wait_us / 1000 << " ms at most";
+    out << "; most queued " << stats_.most_queued << ", queued now";
+    for (std::size_t p = 0; p < std::size_t(request_priority::count); ++p)
+        out << ' ' << request_priority_name(request_priority(p)) << ' ' << stats_.queued[p];
+    out << "." << std::endl;
+}
+
+}
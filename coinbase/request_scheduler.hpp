@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   request_scheduler.hpp
+ * Author: Chris Morrison
+ *
+ * Created on 20 October 2026, 02:50
+ */
+#ifndef REQUEST_SCHEDULER_HPP
+#define REQUEST_SCHEDULER_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+namespace mercury
+{
+
+///
+/// How urgent an exchange request is. Lower values are sent first.
+enum class request_priority
+{
+    trading,    ///< Posting and cancelling orders.
+    account,    ///< Balances, fills, product rules and fees.
+    polling,    ///< Order status checks and price queries.
+    count
+};
+
+const char* request_priority_name(request_priority priority);
+
+///
+/// A request waiting for the scheduler. The scheduler does not own requests; they stay where they
+/// are (in the awaiting coroutine's frame) and are linked into the queues in place.
+struct scheduled_request
+{
+    void (*start)(scheduled_request* request) = nullptr;
+    scheduled_request* next = nullptr;
+    int64_t queued_us = 0;
+};
+
+/// What the scheduler has done so far.
+struct scheduler_stats
+{
+    uint64_t sent = 0;                                          ///< Requests let through.
+    uint64_t extra = 0;                                         ///< Further requests made by calls that needed several.
+    uint64_t held = 0;                                          ///< Requests that had to queue.
+    uint64_t queued[std::size_t(request_priority::count)] = {}; ///< Requests queued now, by priority.
+    uint64_t most_queued = 0;                                   ///< The longest the queues have been.
+    int64_t total_wait_us = 0;                                  ///< Time spent queued, over every request.
+    int64_t longest_wait_us = 0;                                ///< The longest any one request queued.
+};
+
+///
+/// Token bucket shared by every exchange call in the process, so that however many work orders are
+/// running, the exchange sees no more than a set rate of requests. A request that finds the bucket
+/// empty is queued rather than failed, and queued requests go out in priority order (FIFO within a
+/// priority) as tokens come back, so orders and cancels never wait behind a backlog of status polls.
+///
+/// Everything happens on the io_context thread; the queues are intrusive, so scheduling a request
+/// never allocates.
+class request_scheduler
+{
+public:
+    ///
+    /// \param io    The io_context the work orders run on.
+    /// \param rate  Requests per second let through on average.
+    /// \param burst The most requests let through at once after a quiet spell; at least 1.
+    request_scheduler(boost::asio::io_context& io, double rate, double burst);
+
+    ///
+    /// Starts a request now if the bucket has a token and nothing more urgent is waiting, and queues
+    /// it otherwise. Call on the io_context thread.
+    void submit(request_priority priority, scheduled_request* request);
+
+    ///
+    /// Settles up for a call that made some other number of requests than the one it was let through
+    /// for. Extra requests are taken from the bucket, which may go into debt and hold back the requests
+    /// behind until it is paid off; a call that made none gets its token back. Call on the io_context thread.
+    ///
+    /// \param requests The requests the call made.
+    void charge(uint64_t requests);
+
+    const scheduler_stats& stats() const { return stats_; }
+
+    /// Writes the throttle figures and queue depths.
+    void report(std::ostream& out) const;
+
+private:
+    void refill(int64_t now);
+    void drain();
+    void arm();
+
+    struct queue
+    {
+        scheduled_request* head = nullptr;
+        scheduled_request* tail = nullptr;
+    };
+
+    boost::asio::steady_timer timer_;
+    double rate_;
+    double burst_;
+    double tokens_;
+    int64_t refilled_us_;
+    bool armed_ = false;
+    uint64_t waiting_ = 0;
+    queue queues_[std::size_t(request_priority::count)];
+    scheduler_stats stats_;
+};
+
+}
+
+#endif /* REQUEST_SCHEDULER_HPP */
@@ -0,0 +1,400 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   risk_engine.cpp
+ * Author: Chris Morrison
+ *
+ * Created on 20 October 2026, 07:05
+ */
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include "risk_engine.hpp"
+
+namespace mercury
+{
+
+using cryptocoin::trading::order_status;
+
+static const int64_t us_per_day = 86400LL * 1000000LL;
+
+// A last price older than this is too old to check an order against.
+static const int64_t price_max_age_us = 60LL * 1000000LL;
+
+static const char* const reason_text[] = {
+    "the kill switch has tripped",
+    "the price is outside the band around the last price",
+    "the order is worth more than the maximum notional",
+    "too many orders are resting",
+    "too many orders have been posted in the last minute",
+    "there is no last price to check the order against",
+    "the limit price is not a positive number"
+};
+
+static int64_t wall_us()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// The order rate is counted on the monotonic clock, so that the wall clock being stepped cannot empty
+// or jam the window.
+static int64_t steady_us()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static double to_double(const std::string& text)
+{
+    return text.empty() ? 0.0 : std::strtod(text.c_str(), nullptr);
+}
+
+/// Reads a price that must be a whole, positive, finite number.
+static bool positive_number(const std::string& text, double& out)
+{
+    char* end = nullptr;
+    out = std::strtod(text.c_str(), &end);
+    return !text.empty() && *end == '\0' && std::isfinite(out) && out > 0.0;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Account-wide checks.
+// ------------------------------------------------------------------------------------------------
+
+risk_engine::reason risk_engine::admit(int64_t now_us)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (killed_) return killed_reason;
+    if (limits_.max_open_orders > 0 && open_ >= limits_.max_open_orders) return open_orders_reason;
+    if (limits_.max_orders_per_minute > 0)
+    {
+        // One count per second for the last 60 seconds; moving the window on clears at most 60 of them.
+        int64_t second = now_us / 1000000;
+        if (second - minute_second_ >= 60)
+        {
+            for (unsigned int& count : minute_counts_) count = 0;
+            minute_total_ = 0;
+        }
+        else
+        {
+            while (minute_second_ < second)
+            {
+                unsigned int& count = minute_counts_[++minute_second_ % 60];
+                minute_total_ -= count;
+                count = 0;
+            }
+        }
+        minute_second_ = second;
+
+        if (minute_total_ >= limits_.max_orders_per_minute) return rate_reason;
+        ++minute_counts_[second % 60];
+        ++minute_total_;
+    }
+
+    ++open_;
+    ++admitted_;
+    return reason_count;
+}
+
+void risk_engine::withdraw()
+{
+    closed();
+}
+
+void risk_engine::closed()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (open_ > 0) --open_;
+}
+
+void risk_engine::resting()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++open_;
+}
+
+void risk_engine::reject(const std::string& pair, reason why)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++rejected_[why];
+    }
+    if (on_reject_) on_reject_(pair, reason_text[why]);
+}
+
+void risk_engine::start_day(position& p, int64_t day)
+{
+    if (day != day_)
+    {
+        day_ = day;
+        day_pnl_ = 0.0;
+    }
+    if (p.day != day)
+    {
+        // Coin carried over from an earlier day is not part of today's result.
+        p.day = day;
+        p.fiat = 0.0;
+        p.coin = 0.0;
+    }
+}
+
+bool risk_engine::over_loss_locked(const std::string& pair)
+{
+    if (limits_.max_daily_loss <= 0.0 || -day_pnl_ <= limits_.max_daily_loss || killed_) return false;
+
+    killed_ = true;
+    kill_pair_ = pair;
+    kill_reason_ = "the daily loss limit has been passed";
+    return true;
+}
+
+void risk_engine::mark(const std::string& pair, position& p, double price, int64_t now_us)
+{
+    bool tripped = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        start_day(p, now_us / us_per_day);
+        if (p.last > 0.0) day_pnl_ += p.coin * (price - p.last);
+        p.last = price;
+        tripped = over_loss_locked(pair);
+    }
+    if (tripped && on_kill_) on_kill_(pair, kill_reason_.c_str());
+}
+
+void risk_engine::fill(const std::string& pair, position& p, double coin, double fiat, int64_t now_us)
+{
+    bool tripped = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        start_day(p, now_us / us_per_day);
+        if (p.last <= 0.0 && coin != 0.0) p.last = std::fabs(fiat / coin);
+        p.coin += coin;
+        p.fiat += fiat;
+        day_pnl_ += fiat + coin * p.last;
+        tripped = over_loss_locked(pair);
+    }
+    if (tripped && on_kill_) on_kill_(pair, kill_reason_.c_str());
+}
+
+void risk_engine::kill(const std::string& pair, const char* why)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (killed_) return;
+        killed_ = true;
+        kill_pair_ = pair;
+        kill_reason_ = why;
+    }
+    if (on_kill_) on_kill_(pair, kill_reason_.c_str());
+}
+
+void risk_engine::report(std::ostream& out) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t rejected = 0;
+    for (uint64_t count : rejected_) rejected += count;
+
+    out << "Risk: " << (admitted_ + rejected) << " orders checked, " << rejected << " rejected, " << open_ << " resting, "
+        << std::fixed << std::setprecision(2) << day_pnl_ << " profit today";
+    if (killed_) out << "; the kill switch tripped because " << kill_reason_ << (kill_pair_.empty() ? "" : " on ") << kill_pair_;
+    out << "." << std::endl;
+
+    for (int i = 0; i < reason_count; ++i)
+    {
+        if (rejected_[i] > 0) out << "  " << std::setw(8) << rejected_[i] << " because " << reason_text[i] << std::endl;
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+// Per-pair checks.
+// ------------------------------------------------------------------------------------------------
+
+risk_context::risk_context(exchange_context& inner, risk_engine& engine, const std::string& pair)
+    : inner_(inner), engine_(engine), pair_(pair)
+{
+}
+
+void risk_context::open_orders(std::vector<std::string>& out) const
+{
+    std::lock_guard<std::mutex> lock(orders_mutex_);
+    out.clear();
+    for (const auto& entry : orders_) out.push_back(entry.first);
+}
+
+void risk_context::adopt(const std::string& uuid, cryptocoin::trading::order_side side, double price)
+{
+    {
+        std::lock_guard<std::mutex> lock(orders_mutex_);
+        if (!orders_.emplace(uuid, open_order{ side, 0.0, price }).second) return;
+    }
+    engine_.resting();
+}
+
+void risk_context::observe(double price, int64_t time_us)
+{
+    if (price <= 0.0) return;
+
+    last_ = price;
+    priced_us_ = time_us;
+    engine_.mark(pair_, position_, price, time_us);
+}
+
+void risk_context::observe(const std::string& price)
+{
+    observe(to_double(price), wall_us());
+}
+
+bool risk_context::reference_price(int64_t now_us, double& last) const
+{
+    int64_t priced = priced_us_;
+    last = last_;
+    return priced != 0 && now_us - priced <= price_max_age_us && last > 0.0;
+}
+
+std::string risk_context::current_price()
+{
+    std::string out = inner_.current_price();
+    observe(out);
+    return out;
+}
+
+void risk_context::read_current_price(std::string& out)
+{
+    inner_.read_current_price(out);
+    observe(out);
+}
+
+bool risk_context::get_ticker(ticker& out)
+{
+    bool ok = inner_.get_ticker(out);
+    if (ok) observe(out.price);
+    return ok;
+}
+
+order_status risk_context::post_order(cryptocoin::trading::order_side side, cryptocoin::trading::order_type type,
+                                      const std::string& size, const std::string& price, const std::string& funds,
+                                      std::string& out_uuid)
+{
+    const risk_limits& limits = engine_.limits();
+    int64_t now = wall_us();
+    double amount = to_double(size);
+    double limit = 0.0;
+    bool priced_order = (type != cryptocoin::trading::market);
+    bool valid_price = !priced_order || positive_number(price, limit);
+    risk_engine::reason why = risk_engine::reason_count;
+
+    // Every check before the account-wide ones is against this pair's own state.
+    double last = 0.0;
+    bool priced = (limits.price_band > 0.0 || (limits.max_notional > 0.0 && limit <= 0.0)) ? reference_price(now, last) : true;
+    double reference = (limit > 0.0) ? limit : last;
+    double value = funds.empty() ? amount * reference : to_double(funds);
+
+    if (engine_.killed())
+        why = risk_engine::killed_reason;
+    else if (!valid_price)
+        why = risk_engine::bad_price_reason;
+    else if (!priced)
+        why = risk_engine::no_price_reason;
+    else if (limits.price_band > 0.0 && limit > 0.0 && std::fabs(limit - last) > limits.price_band * last)
+        why = risk_engine::band_reason;
+    else if (limits.max_notional > 0.0 && value > limits.max_notional)
+        why = risk_engine::notional_reason;
+    else
+        why = engine_.admit(steady_us());
+
+    if (why != risk_engine::reason_count)
+    {
+        out_uuid.clear();
+        engine_.reject(pair_, why);
+
+        // Nothing more will be posted until the robot restarts, so the work order should stop rather than retry.
+        return (why == risk_engine::killed_reason) ? cryptocoin::trading::fatal_error : cryptocoin::trading::invalid_order;
+    }
+
+    order_status result = inner_.post_order(side, type, size, price, funds, out_uuid);
+    if (result == cryptocoin::trading::in_progress)
+    {
+        std::lock_guard<std::mutex> lock(orders_mutex_);
+        orders_[out_uuid] = open_order{ side, amount, reference };
+        return result;
+    }
+
+    engine_.withdraw();
+    if (result == cryptocoin::trading::completed) settle(out_uuid, open_order{ side, amount, reference });
+    return result;
+}
+
+void risk_context::settle(const std::string& uuid, const open_order& order)
+{
+    if (engine_.limits().max_daily_loss <= 0.0) return;
+
+    // The fill as the exchange reports it, fees and all; failing that, the order as it was posted.
+    double coin = order.size;
+    double fiat = order.size * order.price;
+    if (inner_.get_fill(uuid, fill_))
+    {
+        coin = to_double(fill_.size);
+        fiat = to_double(fill_.value);
+        double fee = to_double(fill_.fee);
+        fiat = (order.side == cryptocoin::trading::buy) ? fiat + fee : fiat - fee;
+    }
+    if (order.side == cryptocoin::trading::buy)
+        engine_.fill(pair_, position_, coin, -fiat, wall_us());
+    else
+        engine_.fill(pair_, position_, -coin, fiat, wall_us());
+}
+
+void risk_context::closed(const std::string& uuid, order_status status)
+{
+    if (status != cryptocoin::trading::completed && status != cryptocoin::trading::cancelled) return;
+
+    open_order order;
+    {
+        std::lock_guard<std::mutex> lock(orders_mutex_);
+        auto found = orders_.find(uuid);
+        if (found == orders_.end()) return;
+        order = found->second;
+        orders_.erase(found);
+    }
+    engine_.closed();
+    if (status == cryptocoin::trading::completed) settle(uuid, order);
+}
+
+order_status risk_context::get_order_status(const std::string& uuid)
+{
+    order_status result = inner_.get_order_status(uuid);
+    closed(uuid, result);
+    return result;
+}
+
+order_status risk_context::cancel_order(const std::string& uuid)
+{
+    order_status result = inner_.cancel_order(uuid);
+    closed(uuid, result);
+    return result;
+}
+
+bool risk_context::get_order_statuses(const std::vector<std::string>& uuids, std::vector<order_status>& out)
+{
+    bool ok = inner_.get_order_statuses(uuids, out);
+    if (!ok) return false;
+
+    for (std::size_t i = 0; i < uuids.size() && i < out.size(); ++i) closed(uuids[i], out[i]);
+    return true;
+}
+
+}
@@ -0,0 +1,264 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   risk_engine.hpp
+ * Author: Chris Morrison
+ *
+ * Created on 20 October 2026, 07:05
+ */
+#ifndef RISK_ENGINE_HPP
+#define RISK_ENGINE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "exchange_context.hpp"
+
+// ------------------------------------------------------------------------------------------------
+// Pre-trade risk checks.
+//
+// A risk_context sits in front of a pair's exchange context and checks every order before it is
+// posted: the limit price must be a positive number within a band around the last price seen, the
+// order's value must be under a maximum, and the account must be under its limits on open orders and
+// on orders posted in the last minute. An order that fails a check is never sent; the trader is told it
+// was invalid, or, once the kill switch has tripped, that the post failed fatally, so that the work order
+// stops rather than retrying an order that cannot go.
+//
+// The limits that span the account - open orders, order rate and the daily loss - are kept by one
+// risk_engine shared by every pair. Every check is a handful of comparisons against state held in
+// memory, under one lock. The daily loss is the change since midnight (UTC) in the fiat paid and
+// received for fills plus the coin bought and sold at the last price; it is kept up to date as fills
+// and prices come in, so checking it costs no more than the rest. Once it passes the limit, the kill
+// switch trips: no further order is allowed until the robot is restarted, and the owner is told so
+// that it can cancel every resting order.
+// ------------------------------------------------------------------------------------------------
+
+namespace mercury
+{
+
+///
+/// The limits checked before every order. Each is off when zero.
+struct risk_limits
+{
+    double price_band = 0.0;                ///< Furthest a limit price may be from the last price, as a fraction of it.
+    double max_notional = 0.0;              ///< Largest order value, in fiat.
+    unsigned int max_open_orders = 0;       ///< Most orders resting at once, over every pair.
+    unsigned int max_orders_per_minute = 0; ///< Most orders posted in any minute, over every pair.
+    double max_daily_loss = 0.0;            ///< Largest loss since midnight (UTC) before the kill switch trips, in fiat.
+
+    bool enabled() const
+    {
+        return price_band > 0.0 || max_notional > 0.0 || max_open_orders > 0 || max_orders_per_minute > 0 || max_daily_loss > 0.0;
+    }
+};
+
+/// Called with the pair and a description when an order is rejected or the kill switch trips.
+typedef void (*risk_callback)(const std::string& pair, const char* what);
+
+///
+/// The account-wide side of the risk checks, shared by the risk contexts of every pair. Safe to use
+/// from any thread.
+class risk_engine
+{
+public:
+    explicit risk_engine(const risk_limits& limits) : limits_(limits) {}
+
+    ///
+    /// \param on_reject Told about every order rejected; may be nullptr.
+    /// \param on_kill   Told once when the kill switch trips; it should cancel every resting order.
+    void set_alerts(risk_callback on_reject, risk_callback on_kill)
+    {
+        on_reject_ = on_reject;
+        on_kill_ = on_kill;
+    }
+
+    const risk_limits& limits() const { return limits_; }
+
+    ///
+    /// Trips the kill switch: every order from now on is rejected. Only the first call has any effect.
+    ///
+    /// \param pair The pair that caused it, or empty.
+    /// \param why  The reason, for the alert and the report.
+    void kill(const std::string& pair, const char* why);
+
+    bool killed() const { return killed_; }
+
+    /// Prints the checks made, the orders rejected for each reason and the day's profit or loss.
+    void report(std::ostream& out) const;
+
+private:
+    friend class risk_context;
+
+    /// Position of a pair since midnight, in its fiat and coin.
+    struct position
+    {
+        double fiat = 0.0;
+        double coin = 0.0;
+        double last = 0.0;
+        int64_t day = 0;
+    };
+
+    enum reason
+    {
+        killed_reason,
+        band_reason,
+        notional_reason,
+        open_orders_reason,
+        rate_reason,
+        no_price_reason,
+        bad_price_reason,
+        reason_count
+    };
+
+    ///
+    /// Checks the account-wide limits for a new order and, if it passes, counts it as posted.
+    ///
+    /// \param now_us Monotonic time (std::chrono::steady_clock), in microseconds, for the order rate.
+    /// \return reason_count if the order may go, otherwise why not.
+    reason admit(int64_t now_us);
+
+    /// Takes back the count of an order that was not accepted by the exchange.
+    void withdraw();
+
+    /// An order posted earlier is no longer resting.
+    void closed();
+
+    /// Counts an order that was already resting when the robot started; it does not count towards the rate.
+    void resting();
+
+    /// Counts a rejection and raises the alert.
+    void reject(const std::string& pair, reason why);
+
+    /// Marks the coin a pair has traded today to a new price.
+    void mark(const std::string& pair, position& p, double price, int64_t now_us);
+
+    /// Adds a fill to a pair's position: coin is positive for a buy and fiat positive for a sell.
+    void fill(const std::string& pair, position& p, double coin, double fiat, int64_t now_us);
+
+    void start_day(position& p, int64_t day);
+
+    /// Trips the kill switch if the day's loss is over the limit; true if it has just tripped.
+    bool over_loss_locked(const std::string& pair);
+
+    risk_limits limits_;
+    risk_callback on_reject_ = nullptr;
+    risk_callback on_kill_ = nullptr;
+
+    mutable std::mutex mutex_;
+    std::atomic<bool> killed_{ false };
+    std::string kill_pair_;
+    std::string kill_reason_;
+    unsigned int open_ = 0;
+    unsigned int minute_counts_[60] = {};
+    unsigned int minute_total_ = 0;
+    int64_t minute_second_ = 0;
+    int64_t day_ = 0;
+    double day_pnl_ = 0.0;
+    uint64_t admitted_ = 0;
+    uint64_t rejected_[reason_count] = {};
+};
+
+///
+/// Exchange context that applies the risk checks to every order and passes every call on to another
+/// context. Like any context, it is called by one thread at a time.
+class risk_context : public exchange_context
+{
+public:
+    ///
+    /// \param inner  The context that makes the calls; it must outlive this object.
+    /// \param engine The account-wide checks; it must outlive this object.
+    /// \param pair   The trading pair, for alerts.
+    risk_context(exchange_context& inner, risk_engine& engine, const std::string& pair);
+
+    /// The orders resting as far as this context knows, for the kill switch to cancel.
+    void open_orders(std::vector<std::string>& out) const;
+
+    ///
+    /// Takes on an order that was already resting when the robot started, e.g. one a restored work order
+    /// waits on, so that it counts towards the open orders and the kill switch cancels it. Its size is
+    /// not known; if it fills, the fill is settled from what the exchange reports.
+    ///
+    /// \param uuid  The order.
+    /// \param side  Whether it buys or sells.
+    /// \param price Its limit price.
+    void adopt(const std::string& uuid, cryptocoin::trading::order_side side, double price);
+
+    ///
+    /// Learns a price that did not come through this context, such as one from the market bus. May be
+    /// called from any thread.
+    ///
+    /// \param price   The last trade price.
+    /// \param time_us When it was seen, microseconds since the epoch.
+    void observe(double price, int64_t time_us);
+
+    std::string fiat_balance() override { return inner_.fiat_balance(); }
+    std::string coin_balance() override { return inner_.coin_balance(); }
+    std::string current_price() override;
+    void read_current_price(std::string& out) override;
+    void read_fiat_balance(std::string& out) override { inner_.read_fiat_balance(out); }
+    void read_coin_balance(std::string& out) override { inner_.read_coin_balance(out); }
+
+    cryptocoin::trading::order_status post_order(cryptocoin::trading::order_side side, cryptocoin::trading::order_type type,
+                                                 const std::string& size, const std::string& price, const std::string& funds,
+                                                 std::string& out_uuid) override;
+    cryptocoin::trading::order_status get_order_status(const std::string& uuid) override;
+    long double sell_price_adjustment() override { return inner_.sell_price_adjustment(); }
+    long double buy_price_ajustment() override { return inner_.buy_price_ajustment(); }
+
+    cryptocoin::trading::order_status cancel_order(const std::string& uuid) override;
+    bool get_order_statuses(const std::vector<std::string>& uuids, std::vector<cryptocoin::trading::order_status>& out) override;
+    bool get_product_info(product_info& out) override { return inner_.get_product_info(out); }
+    bool get_fill(const std::string& uuid, order_fill& out) override { return inner_.get_fill(uuid, out); }
+    bool get_ticker(ticker& out) override;
+
+private:
+    struct open_order
+    {
+        cryptocoin::trading::order_side side = cryptocoin::trading::buy;
+        double size = 0.0;
+        double price = 0.0;     ///< The limit price, or the last price for an order without one.
+    };
+
+    /// Learns the last price from text read from the exchange.
+    void observe(const std::string& price);
+
+    /// Gives the last price, if it is recent enough to check an order against.
+    bool reference_price(int64_t now_us, double& last) const;
+
+    /// Forgets an order once a call shows it has left the book, settling it if it filled.
+    void closed(const std::string& uuid, cryptocoin::trading::order_status status);
+
+    /// Adds a filled order to the day's result.
+    void settle(const std::string& uuid, const open_order& order);
+
+    exchange_context& inner_;
+    risk_engine& engine_;
+    std::string pair_;
+    risk_engine::position position_;
+    std::atomic<double> last_{ 0.0 };
+    std::atomic<int64_t> priced_us_{ 0 };
+    std::unordered_map<std::string, open_order> orders_;
+    mutable std::mutex orders_mutex_;
+    order_fill fill_;
+};
+
+}
+
+#endif /* RISK_ENGINE_HPP */
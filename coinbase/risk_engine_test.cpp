@@ -0,0 +1,243 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   risk_engine_test.cpp
+ * Author: Chris Morrison
+ *
+ * Created on 20 October 2026, 20:05
+ */
+#include <chrono>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "mock_context.hpp"
+#include "risk_engine.hpp"
+#include "unit_test.hpp"
+
+using namespace mercury;
+using namespace cryptocoin::trading;
+
+static const char* const prices[] = { "100" };
+
+static unsigned int rejections = 0;
+static unsigned int kills = 0;
+
+static void on_reject(const std::string&, const char*)
+{
+    ++rejections;
+}
+
+static void on_kill(const std::string&, const char*)
+{
+    ++kills;
+}
+
+static int64_t wall_us()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+static order_status post(risk_context& risk, order_side side, const char* size, const char* price, std::string& uuid)
+{
+    return risk.post_order(side, limit, size, price, "", uuid);
+}
+
+static void test_no_limits()
+{
+    risk_limits limits;
+    risk_engine engine(limits);
+    mock_context mock(prices, 1);
+    risk_context risk(mock, engine, "BTC-EUR");
+    std::string uuid;
+
+    // With every limit off, orders go through even before a price has been seen.
+    CHECK(!limits.enabled());
+    for (int i = 0; i < 100; ++i) CHECK(post(risk, buy, "1000", "1", uuid) == in_progress);
+    CHECK(!uuid.empty());
+}
+
+static void test_price_checks()
+{
+    risk_limits limits;
+    limits.price_band = 0.05;
+    limits.max_notional = 500;
+    risk_engine engine(limits);
+    mock_context mock(prices, 1);
+    risk_context risk(mock, engine, "BTC-EUR");
+    std::string uuid = "stale";
+    std::string price;
+
+    engine.set_alerts(on_reject, on_kill);
+    rejections = 0;
+    CHECK(limits.enabled());
+
+    // Nothing can be checked against a price that has not been seen, or was seen too long ago.
+    CHECK(post(risk, buy, "1", "100", uuid) == invalid_order);
+    CHECK(uuid.empty());
+    risk.observe(100.0, wall_us() - 120LL * 1000000LL);
+    CHECK(post(risk, buy, "1", "100", uuid) == invalid_order);
+
+    risk.read_current_price(price);
+    CHECK(post(risk, buy, "1", "100", uuid) == in_progress);
+
+    for (const char* bad : { "", "0", "-1", "abc", "12x", "inf", "nan", "1e400" }) CHECK(post(risk, buy, "1", bad, uuid) == invalid_order);
+
+    // The band is 5 either side of 100.
+    CHECK(post(risk, buy, "1", "105", uuid) == in_progress);
+    CHECK(post(risk, sell, "1", "95", uuid) == in_progress);
+    CHECK(post(risk, buy, "1", "105.01", uuid) == invalid_order);
+    CHECK(post(risk, sell, "1", "94.99", uuid) == invalid_order);
+
+    // Value is size times the limit price, the funds given, or size times the last price for a market order.
+    CHECK(post(risk, buy, "5", "100", uuid) == in_progress);
+    CHECK(post(risk, buy, "5.1", "100", uuid) == invalid_order);
+    CHECK(risk.post_order(buy, market, "", "", "600", uuid) == invalid_order);
+    CHECK(risk.post_order(buy, market, "", "", "400", uuid) == in_progress);
+    CHECK(risk.post_order(sell, market, "6", "", "", uuid) == invalid_order);
+    CHECK(risk.post_order(sell, market, "4", "", "", uuid) == in_progress);
+
+    CHECK(rejections == 2 + 8 + 2 + 3);
+    CHECK(mock.posts() == 6);
+}
+
+static void test_open_orders()
+{
+    risk_limits limits;
+    limits.max_open_orders = 3;
+    risk_engine engine(limits);
+    mock_context mock(prices, 1, 1000);
+    risk_context risk(mock, engine, "BTC-EUR");
+    std::vector<std::string> open;
+    std::string uuid;
+
+    // An order already resting when the robot started counts, once.
+    risk.adopt("old", buy, 99.0);
+    risk.adopt("old", buy, 99.0);
+    CHECK(post(risk, buy, "1", "100", uuid) == in_progress);
+    std::string first = uuid;
+    CHECK(post(risk, buy, "1", "100", uuid) == in_progress);
+    CHECK(post(risk, buy, "1", "100", uuid) == invalid_order);
+
+    risk.open_orders(open);
+    CHECK(open.size() == 3);
+
+    // The rejected order took no place; a cancelled one gives its place back.
+    CHECK(risk.cancel_order(first) == cancelled);
+    CHECK(post(risk, buy, "1", "100", uuid) == in_progress);
+    CHECK(risk.cancel_order("old") == cancelled);
+    CHECK(risk.cancel_order("old") == cancelled);
+    CHECK(post(risk, buy, "1", "100", uuid) == in_progress);
+    CHECK(post(risk, buy, "1", "100", uuid) == invalid_order);
+
+    // Orders closed through a status check free their places as well.
+    risk.open_orders(open);
+    std::vector<order_status> statuses;
+    CHECK(risk.get_order_statuses(open, statuses));
+    risk.open_orders(open);
+    CHECK(open.size() == 1);
+    CHECK(post(risk, buy, "1", "100", uuid) == in_progress);
+}
+
+static void test_order_rate()
+{
+    risk_limits limits;
+    limits.max_orders_per_minute = 3;
+    risk_engine engine(limits);
+    mock_context mock(prices, 1, 1000);
+    risk_context risk(mock, engine, "BTC-EUR");
+    std::string uuid;
+
+    // Orders that have since closed still count towards the minute.
+    for (int i = 0; i < 3; ++i)
+    {
+        CHECK(post(risk, buy, "1", "100", uuid) == in_progress);
+        CHECK(risk.cancel_order(uuid) == cancelled);
+    }
+    CHECK(post(risk, buy, "1", "100", uuid) == invalid_order);
+    CHECK(mock.posts() == 3);
+}
+
+static void test_daily_loss()
+{
+    risk_limits limits;
+    limits.max_daily_loss = 10;
+    risk_engine engine(limits);
+    mock_context mock(prices, 1, 0);
+    risk_context risk(mock, engine, "BTC-EUR");
+    std::string uuid;
+    std::string price;
+
+    engine.set_alerts(on_reject, on_kill);
+    kills = 0;
+
+    // One coin bought at 100 loses with the price: 5 is within the limit, 11 is not.
+    risk.read_current_price(price);
+    CHECK(post(risk, buy, "1", "100", uuid) == in_progress);
+    CHECK(risk.get_order_status(uuid) == completed);
+    risk.observe(95.0, wall_us());
+    CHECK(!engine.killed());
+    CHECK(post(risk, buy, "1", "95", uuid) == in_progress);
+    CHECK(risk.get_order_status(uuid) == completed);
+
+    // Two coins now: 95 -> 92 is a loss of 6 more, 11 in all.
+    risk.observe(92.0, wall_us());
+    CHECK(engine.killed());
+    CHECK(kills == 1);
+
+    // Once tripped, every order fails fatally so the work order stops, and the alert is not repeated.
+    CHECK(post(risk, sell, "1", "92", uuid) == fatal_error);
+    CHECK(uuid.empty());
+    risk.observe(80.0, wall_us());
+    engine.kill("BTC-EUR", "again");
+    CHECK(kills == 1);
+
+    std::ostringstream report;
+    engine.report(report);
+    CHECK(report.str().find("the kill switch tripped because the daily loss limit has been passed on BTC-EUR") != std::string::npos);
+}
+
+static void test_kill()
+{
+    risk_limits limits;
+    risk_engine engine(limits);
+    mock_context mock(prices, 1);
+    risk_context risk(mock, engine, "ETH-EUR");
+    std::string uuid;
+
+    engine.set_alerts(on_reject, on_kill);
+    kills = 0;
+
+    CHECK(post(risk, buy, "1", "100", uuid) == in_progress);
+    engine.kill("", "the owner asked");
+    engine.kill("", "the owner asked again");
+    CHECK(kills == 1);
+    CHECK(post(risk, buy, "1", "100", uuid) == fatal_error);
+    CHECK(risk.post_order(sell, market, "1", "", "", uuid) == fatal_error);
+    CHECK(mock.posts() == 1);
+}
+
+int main()
+{
+    test_no_limits();
+    test_price_checks();
+    test_open_orders();
+    test_order_rate();
+    test_daily_loss();
+    test_kill();
+
+    return test_result("risk_engine");
+}
@@ -0,0 +1,776 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   session_recording.cpp
+ * Author: Chris Morrison
+ *
+ * Created on 20 October 2026, 05:30
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iterator>
+#include "session_recording.hpp"
+
+namespace mercury
+{
+
+using cryptocoin::trading::order_status;
+
+// "MSR1" in the byte order it is read in.
+static const uint8_t session_magic[4] = { 'M', 'S', 'R', '1' };
+
+// A record header is five varints of at most ten bytes each.
+static const std::size_t max_record_header = 5 * 10;
+
+// A channel number that matches no channel.
+static const uint32_t no_channel = UINT32_MAX;
+
+static int64_t wall_us()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+const char* session_call_name(session_call call)
+{
+    switch (call)
+    {
+        case session_call::channel: return "channel";
+        case session_call::work_order: return "work order";
+        case session_call::fiat_balance: return "fiat balance";
+        case session_call::coin_balance: return "coin balance";
+        case session_call::current_price: return "current price";
+        case session_call::post_order: return "post order";
+        case session_call::get_order_status: return "order status";
+        case session_call::sell_price_adjustment: return "sell price adjustment";
+        case session_call::buy_price_adjustment: return "buy price adjustment";
+        case session_call::cancel_order: return "cancel order";
+        case session_call::get_order_statuses: return "order statuses";
+        case session_call::get_product_info: return "product info";
+        case session_call::get_fill: return "fill";
+        case session_call::get_ticker: return "ticker";
+    }
+    return "unknown";
+}
+
+// ------------------------------------------------------------------------------------------------
+// Encoding.
+// ------------------------------------------------------------------------------------------------
+
+void session_encoder::put(uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out_.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out_.push_back(static_cast<uint8_t>(value));
+}
+
+void session_encoder::put(int64_t value)
+{
+    put((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+void session_encoder::put(const char* text, std::size_t len)
+{
+    put(static_cast<uint64_t>(len));
+    out_.insert(out_.end(), text, text + len);
+}
+
+void session_encoder::put(const std::string& text)
+{
+    put(text.data(), text.size());
+}
+
+void session_encoder::put(long double value)
+{
+    // 21 significant digits are enough to bring back every bit of an x87 extended double.
+    char buf[48];
+    int len = std::snprintf(buf, sizeof(buf), "%.21Lg", value);
+    put(buf, (len > 0) ? static_cast<std::size_t>(len) : 0);
+}
+
+void session_encoder::put(const product_info& info)
+{
+    put(info.id);
+    put(static_cast<int64_t>(info.price_decimals));
+    put(info.quote_increment);
+    put(static_cast<int64_t>(info.size_decimals));
+    put(info.base_increment);
+    put(info.base_min_size);
+    put(info.base_max_size);
+}
+
+bool session_decoder::get(uint64_t& value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        if (!ok_ || data_ == end_) return ok_ = false;
+        uint8_t byte = *data_++;
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) return true;
+    }
+    return ok_ = false;
+}
+
+bool session_decoder::get(int64_t& value)
+{
+    uint64_t zigzag = 0;
+    if (!get(zigzag)) return false;
+    value = static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1);
+    return true;
+}
+
+bool session_decoder::get(std::string& text)
+{
+    uint64_t len = 0;
+    if (!get(len)) return false;
+    if (static_cast<uint64_t>(end_ - data_) < len) return ok_ = false;
+
+    text.assign(reinterpret_cast<const char*>(data_), static_cast<std::size_t>(len));
+    data_ += len;
+    return true;
+}
+
+bool session_decoder::get(long double& value)
+{
+    char buf[48];
+    uint64_t len = 0;
+    if (!get(len)) return false;
+    if (len >= sizeof(buf) || static_cast<uint64_t>(end_ - data_) < len) return ok_ = false;
+
+    std::memcpy(buf, data_, static_cast<std::size_t>(len));
+    buf[len] = '\0';
+    data_ += len;
+    value = std::strtold(buf, nullptr);
+    return true;
+}
+
+bool session_decoder::skip(std::size_t len)
+{
+    if (!ok_ || static_cast<std::size_t>(end_ - data_) < len) return ok_ = false;
+    data_ += len;
+    return true;
+}
+
+bool session_decoder::get(product_info& info)
+{
+    int64_t price_decimals = 0;
+    int64_t size_decimals = 0;
+
+    if (!get(info.id) || !get(price_decimals) || !get(info.quote_increment) || !get(size_decimals) || !get(info.base_increment) ||
+        !get(info.base_min_size) || !get(info.base_max_size))
+    {
+        return false;
+    }
+    info.price_decimals = static_cast<int>(price_decimals);
+    info.size_decimals = static_cast<int>(size_decimals);
+    return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Recording.
+// ------------------------------------------------------------------------------------------------
+
+bool session_recorder::open(const std::string& path)
+{
+    file_.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file_.is_open()) return false;
+
+    start_ = std::chrono::steady_clock::now();
+    // The header buffer is sized once for the largest record header, so writing a record never grows it.
+    header_.clear();
+    header_.reserve(max_record_header);
+    session_encoder(header_).put(wall_us());
+    file_.write(reinterpret_cast<const char*>(session_magic), sizeof(session_magic));
+    file_.write(reinterpret_cast<const char*>(header_.data()), static_cast<std::streamsize>(header_.size()));
+    file_.flush();
+
+    return static_cast<bool>(file_);
+}
+
+uint32_t session_recorder::add_channel(const std::string& pair)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint32_t channel = channels_++;
+    write_locked(session_call::channel, channel, last_start_us_, 0, reinterpret_cast<const uint8_t*>(pair.data()), pair.size());
+    return channel;
+}
+
+void session_recorder::add_work_order(const char* line)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    const uint8_t* body = reinterpret_cast<const uint8_t*>(line);
+    write_locked(session_call::work_order, work_orders_++, last_start_us_, 0, body, std::strlen(line));
+}
+
+int64_t session_recorder::now_us() const
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_).count();
+}
+
+bool session_recorder::write(session_call call, uint32_t channel, int64_t started_us, const std::vector<uint8_t>& body)
+{
+    int64_t duration_us = now_us() - started_us;
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    write_locked(call, channel, started_us, duration_us, body.data(), body.size());
+    return static_cast<bool>(file_);
+}
+
+void session_recorder::write_locked(session_call call, uint32_t channel, int64_t started_us, int64_t duration_us,
+                                    const uint8_t* body, std::size_t len)
+{
+    if (!file_.is_open()) return;
+
+    // Calls made at the same time on different channels can return in either order, so the start is
+    // stored as a signed difference from the one before.
+    header_.clear();
+    session_encoder out(header_);
+    out.put(static_cast<uint64_t>(call));
+    out.put(static_cast<uint64_t>(channel));
+    out.put(started_us - last_start_us_);
+    out.put(static_cast<uint64_t>(duration_us > 0 ? duration_us : 0));
+    out.put(static_cast<uint64_t>(len));
+    last_start_us_ = started_us;
+
+    file_.write(reinterpret_cast<const char*>(header_.data()), static_cast<std::streamsize>(header_.size()));
+    file_.write(reinterpret_cast<const char*>(body), static_cast<std::streamsize>(len));
+    file_.flush();
+}
+
+void session_recorder::close()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_.is_open()) file_.close();
+}
+
+recording_context::recording_context(exchange_context& inner, session_recorder& recorder, const std::string& pair)
+    : inner_(inner), recorder_(recorder), channel_(recorder.add_channel(pair))
+{
+}
+
+void recording_context::write(session_call call, int64_t started)
+{
+    recorder_.write(call, channel_, started, body_);
+}
+
+void recording_context::text(session_call call, int64_t started, const std::string& out)
+{
+    body_.clear();
+    session_encoder(body_).put(out);
+    write(call, started);
+}
+
+void recording_context::status(session_call call, int64_t started, const std::string& uuid, order_status result)
+{
+    body_.clear();
+    session_encoder encoder(body_);
+    encoder.put(uuid);
+    encoder.put(static_cast<uint64_t>(result));
+    write(call, started);
+}
+
+void recording_context::rate(session_call call, int64_t started, long double result)
+{
+    body_.clear();
+    session_encoder(body_).put(result);
+    write(call, started);
+}
+
+std::string recording_context::fiat_balance()
+{
+    int64_t started = recorder_.now_us();
+    std::string out = inner_.fiat_balance();
+    text(session_call::fiat_balance, started, out);
+    return out;
+}
+
+std::string recording_context::coin_balance()
+{
+    int64_t started = recorder_.now_us();
+    std::string out = inner_.coin_balance();
+    text(session_call::coin_balance, started, out);
+    return out;
+}
+
+std::string recording_context::current_price()
+{
+    int64_t started = recorder_.now_us();
+    std::string out = inner_.current_price();
+    text(session_call::current_price, started, out);
+    return out;
+}
+
+void recording_context::read_current_price(std::string& out)
+{
+    int64_t started = recorder_.now_us();
+    inner_.read_current_price(out);
+    text(session_call::current_price, started, out);
+}
+
+void recording_context::read_fiat_balance(std::string& out)
+{
+    int64_t started = recorder_.now_us();
+    inner_.read_fiat_balance(out);
+    text(session_call::fiat_balance, started, out);
+}
+
+void recording_context::read_coin_balance(std::string& out)
+{
+    int64_t started = recorder_.now_us();
+    inner_.read_coin_balance(out);
+    text(session_call::coin_balance, started, out);
+}
+
+order_status recording_context::post_order(cryptocoin::trading::order_side side, cryptocoin::trading::order_type type,
+                                           const std::string& size, const std::string& price, const std::string& funds,
+                                           std::string& out_uuid)
+{
+    int64_t started = recorder_.now_us();
+    order_status result = inner_.post_order(side, type, size, price, funds, out_uuid);
+
+    body_.clear();
+    session_encoder out(body_);
+    out.put(static_cast<uint64_t>(side));
+    out.put(static_cast<uint64_t>(type));
+    out.put(size);
+    out.put(price);
+    out.put(funds);
+    out.put(out_uuid);
+    out.put(static_cast<uint64_t>(result));
+    write(session_call::post_order, started);
+
+    return result;
+}
+
+order_status recording_context::get_order_status(const std::string& uuid)
+{
+    int64_t started = recorder_.now_us();
+    order_status result = inner_.get_order_status(uuid);
+    status(session_call::get_order_status, started, uuid, result);
+    return result;
+}
+
+long double recording_context::sell_price_adjustment()
+{
+    int64_t started = recorder_.now_us();
+    long double result = inner_.sell_price_adjustment();
+    rate(session_call::sell_price_adjustment, started, result);
+    return result;
+}
+
+long double recording_context::buy_price_ajustment()
+{
+    int64_t started = recorder_.now_us();
+    long double result = inner_.buy_price_ajustment();
+    rate(session_call::buy_price_adjustment, started, result);
+    return result;
+}
+
+order_status recording_context::cancel_order(const std::string& uuid)
+{
+    int64_t started = recorder_.now_us();
+    order_status result = inner_.cancel_order(uuid);
+    status(session_call::cancel_order, started, uuid, result);
+    return result;
+}
+
+bool recording_context::get_order_statuses(const std::vector<std::string>& uuids, std::vector<order_status>& out)
+{
+    int64_t started = recorder_.now_us();
+    bool result = inner_.get_order_statuses(uuids, out);
+
+    body_.clear();
+    session_encoder encoder(body_);
+    encoder.put(static_cast<uint64_t>(uuids.size()));
+    for (const std::string& uuid : uuids) encoder.put(uuid);
+    encoder.put(static_cast<uint64_t>(result));
+    encoder.put(static_cast<uint64_t>(result ? out.size() : 0));
+    if (result)
+    {
+        for (order_status s : out) encoder.put(static_cast<uint64_t>(s));
+    }
+    write(session_call::get_order_statuses, started);
+
+    return result;
+}
+
+bool recording_context::get_product_info(product_info& out)
+{
+    int64_t started = recorder_.now_us();
+    bool result = inner_.get_product_info(out);
+
+    body_.clear();
+    session_encoder encoder(body_);
+    encoder.put(static_cast<uint64_t>(result));
+    if (result) encoder.put(out);
+    write(session_call::get_product_info, started);
+
+    return result;
+}
+
+bool recording_context::get_fill(const std::string& uuid, order_fill& out)
+{
+    int64_t started = recorder_.now_us();
+    bool result = inner_.get_fill(uuid, out);
+
+    body_.clear();
+    session_encoder encoder(body_);
+    encoder.put(uuid);
+    encoder.put(static_cast<uint64_t>(result));
+    if (result)
+    {
+        encoder.put(out.size);
+        encoder.put(out.value);
+        encoder.put(out.fee);
+    }
+    write(session_call::get_fill, started);
+
+    return result;
+}
+
+bool recording_context::get_ticker(ticker& out)
+{
+    int64_t started = recorder_.now_us();
+    bool result = inner_.get_ticker(out);
+
+    body_.clear();
+    session_encoder encoder(body_);
+    encoder.put(static_cast<uint64_t>(result));
+    encoder.put(out.price);
+    encoder.put(out.bid);
+    encoder.put(out.ask);
+    encoder.put(out.volume);
+    write(session_call::get_ticker, started);
+
+    return result;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Replay.
+// ------------------------------------------------------------------------------------------------
+
+bool session_player::open(const std::string& path)
+{
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file.is_open()) return false;
+
+    data_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    if (data_.size() < sizeof(session_magic) || std::memcmp(data_.data(), session_magic, sizeof(session_magic)) != 0) return false;
+
+    session_decoder in(data_.data() + sizeof(session_magic), data_.size() - sizeof(session_magic));
+    if (!in.get(recorded_at_us_)) return false;
+
+    channels_.clear();
+    work_orders_.clear();
+    while (!in.at_end())
+    {
+        uint64_t call = 0;
+        uint64_t number = 0;
+        int64_t start_delta = 0;
+        uint64_t duration = 0;
+        uint64_t len = 0;
+
+        // A record cut short by a crash ends the recording; everything before it is still good.
+        if (!in.get(call) || !in.get(number) || !in.get(start_delta) || !in.get(duration) || !in.get(len)) break;
+        std::size_t offset = static_cast<std::size_t>(in.position() - data_.data());
+        if (!in.skip(static_cast<std::size_t>(len))) break;
+
+        const char* text = reinterpret_cast<const char*>(data_.data() + offset);
+        if (call == static_cast<uint64_t>(session_call::channel))
+        {
+            if (number != channels_.size()) return false;
+            channels_.emplace_back();
+            channels_.back().pair.assign(text, static_cast<std::size_t>(len));
+        }
+        else if (call == static_cast<uint64_t>(session_call::work_order))
+        {
+            work_orders_.emplace_back(text, static_cast<std::size_t>(len));
+        }
+        else if (number < channels_.size() && call <= static_cast<uint64_t>(session_call::get_ticker))
+        {
+            channels_[number].records.push_back(record{ static_cast<session_call>(call), static_cast<int64_t>(duration), offset,
+                                                        static_cast<std::size_t>(len) });
+        }
+    }
+
+    loaded_ = true;
+    return true;
+}
+
+bool session_player::has_channel(const std::string& pair) const
+{
+    for (const channel& c : channels_)
+    {
+        if (c.pair == pair) return true;
+    }
+    return false;
+}
+
+bool session_player::attach(const std::string& pair, uint32_t& number)
+{
+    for (std::size_t i = 0; i < channels_.size(); ++i)
+    {
+        if (channels_[i].pair != pair || channels_[i].attached) continue;
+
+        channels_[i].attached = true;
+        number = static_cast<uint32_t>(i);
+        if (running_++ == 0) started_ = std::chrono::steady_clock::now();
+        return true;
+    }
+    return false;
+}
+
+void session_player::finish(uint32_t /* number */)
+{
+    if (--running_ > 0) return;
+
+    replay_us_ = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started_).count();
+    if (on_end_) on_end_();
+}
+
+void session_player::mismatch(uint32_t number, std::size_t index, const char* what)
+{
+    if (mismatches_++ > 0) return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    first_mismatch_.assign(channels_[number].pair).append(" call ").append(std::to_string(index + 1)).append(", ").append(what);
+}
+
+void session_player::report(std::ostream& out) const
+{
+    int64_t replay_us = replay_us_;
+    if (running_ > 0)
+        replay_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started_).count();
+
+    std::size_t total = 0;
+    for (const channel& c : channels_) total += c.records.size();
+
+    out << "Replayed " << replayed_ << " of " << total << " recorded calls in " << std::fixed << std::setprecision(3)
+        << (replay_us / 1e6) << "s; they took " << (recorded_us_ / 1e6) << "s when recorded." << std::endl;
+    if (mismatches_ == 0) return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    out << mismatches_ << " calls were made with arguments other than the recorded ones, the first at " << first_mismatch_ << "."
+        << std::endl;
+}
+
+replay_context::replay_context(session_player& player, const std::string& pair) : player_(player)
+{
+    ended_ = !player_.attach(pair, channel_);
+}
+
+bool replay_context::next(session_call call, session_decoder& in)
+{
+    if (ended_) return false;
+
+    session_player::channel& channel = player_.channels_[channel_];
+    if (channel.next == channel.records.size() || channel.records[channel.next].call != call)
+    {
+        // The robot has gone off the recording; nothing recorded from here on answers it.
+        if (channel.next < channel.records.size())
+        {
+            scratch_.assign("expected ").append(session_call_name(channel.records[channel.next].call)).append(" but got ")
+                .append(session_call_name(call));
+            player_.mismatch(channel_, channel.next, scratch_.c_str());
+        }
+        ended_ = true;
+        player_.finish(channel_);
+        return false;
+    }
+
+    const session_player::record& r = channel.records[channel.next++];
+    in = session_decoder(player_.data_.data() + r.offset, r.len);
+    player_.replayed_++;
+    player_.recorded_us_ += r.duration_us;
+    return true;
+}
+
+void replay_context::expect(session_decoder& in, const std::string& argument, const char* what)
+{
+    if (in.get(scratch_) && scratch_ != argument)
+        player_.mismatch(channel_, player_.channels_[channel_].next - 1, what);
+}
+
+void replay_context::expect(session_decoder& in, uint64_t argument, const char* what)
+{
+    uint64_t recorded = 0;
+    if (in.get(recorded) && recorded != argument) player_.mismatch(channel_, player_.channels_[channel_].next - 1, what);
+}
+
+void replay_context::read_text(session_call call, std::string& out)
+{
+    session_decoder in;
+    if (!next(call, in) || !in.get(out)) out.clear();
+}
+
+order_status replay_context::read_status(session_call call, const std::string& uuid)
+{
+    session_decoder in;
+    uint64_t result = 0;
+
+    if (!next(call, in)) return cryptocoin::trading::fatal_error;
+    expect(in, uuid, "a different order");
+    return in.get(result) ? static_cast<order_status>(result) : cryptocoin::trading::fatal_error;
+}
+
+long double replay_context::read_rate(session_call call)
+{
+    session_decoder in;
+    long double result = 0;
+
+    if (!next(call, in) || !in.get(result)) return 0;
+    return result;
+}
+
+std::string replay_context::fiat_balance()
+{
+    std::string out;
+    read_text(session_call::fiat_balance, out);
+    return out;
+}
+
+std::string replay_context::coin_balance()
+{
+    std::string out;
+    read_text(session_call::coin_balance, out);
+    return out;
+}
+
+std::string replay_context::current_price()
+{
+    std::string out;
+    read_text(session_call::current_price, out);
+    return out;
+}
+
+void replay_context::read_current_price(std::string& out)
+{
+    read_text(session_call::current_price, out);
+}
+
+void replay_context::read_fiat_balance(std::string& out)
+{
+    read_text(session_call::fiat_balance, out);
+}
+
+void replay_context::read_coin_balance(std::string& out)
+{
+    read_text(session_call::coin_balance, out);
+}
+
+order_status replay_context::post_order(cryptocoin::trading::order_side side, cryptocoin::trading::order_type type,
+                                        const std::string& size, const std::string& price, const std::string& funds,
+                                        std::string& out_uuid)
+{
+    session_decoder in;
+    uint64_t result = 0;
+
+    out_uuid.clear();
+    if (!next(session_call::post_order, in)) return cryptocoin::trading::fatal_error;
+
+    expect(in, static_cast<uint64_t>(side), "a different side");
+    expect(in, static_cast<uint64_t>(type), "a different order type");
+    expect(in, size, "a different size");
+    expect(in, price, "a different price");
+    expect(in, funds, "different funds");
+    if (!in.get(out_uuid) || !in.get(result)) return cryptocoin::trading::fatal_error;
+
+    return static_cast<order_status>(result);
+}
+
+order_status replay_context::get_order_status(const std::string& uuid)
+{
+    return read_status(session_call::get_order_status, uuid);
+}
+
+long double replay_context::sell_price_adjustment()
+{
+    return read_rate(session_call::sell_price_adjustment);
+}
+
+long double replay_context::buy_price_ajustment()
+{
+    return read_rate(session_call::buy_price_adjustment);
+}
+
+order_status replay_context::cancel_order(const std::string& uuid)
+{
+    return read_status(session_call::cancel_order, uuid);
+}
+
+bool replay_context::get_order_statuses(const std::vector<std::string>& uuids, std::vector<order_status>& out)
+{
+    session_decoder in;
+    uint64_t count = 0;
+    uint64_t result = 0;
+
+    if (!next(session_call::get_order_statuses, in) || !in.get(count)) return false;
+    if (count != uuids.size()) player_.mismatch(channel_, player_.channels_[channel_].next - 1, "a different number of orders");
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        if (i < uuids.size())
+            expect(in, uuids[i], "a different order");
+        else
+            in.get(scratch_);
+    }
+    if (!in.get(result) || !in.get(count) || result == 0) return false;
+
+    out.resize(uuids.size(), cryptocoin::trading::network_error);
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        uint64_t status = 0;
+        if (!in.get(status)) return false;
+        if (i < out.size()) out[i] = static_cast<order_status>(status);
+    }
+    return true;
+}
+
+bool replay_context::get_product_info(product_info& out)
+{
+    session_decoder in;
+    uint64_t result = 0;
+
+    if (!next(session_call::get_product_info, in) || !in.get(result) || result == 0) return false;
+    return in.get(out);
+}
+
+bool replay_context::get_fill(const std::string& uuid, order_fill& out)
+{
+    session_decoder in;
+    uint64_t result = 0;
+
+    if (!next(session_call::get_fill, in)) return false;
+    expect(in, uuid, "a different order");
+    if (!in.get(result) || result == 0) return false;
+    return in.get(out.size) && in.get(out.value) && in.get(out.fee);
+}
+
+bool replay_context::get_ticker(ticker& out)
+{
+    session_decoder in;
+    uint64_t result = 0;
+
+    if (!next(session_call::get_ticker, in)) return false;
+    if (!in.get(result) || !in.get(out.price) || !in.get(out.bid) || !in.get(out.ask) || !in.get(out.volume)) return false;
+    return result != 0;
+}
+
+}
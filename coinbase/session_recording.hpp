@@ -0,0 +1,358 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   session_recording.hpp
+ * Author: Chris Morrison
+ *
+ * Created on 20 October 2026, 05:30
+ */
+#ifndef SESSION_RECORDING_HPP
+#define SESSION_RECORDING_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "exchange_context.hpp"
+
+// ------------------------------------------------------------------------------------------------
+// Recording and replaying sessions with the exchange.
+//
+// A recording_context sits in front of any exchange context and writes every call made through it -
+// which call, its arguments, its results, when it started and how long it took - to a session file.
+// A replay_context reads the file back and answers each call with the recorded results, straight
+// away, so a production session can be run again offline, as often as needed and at full speed.
+//
+// A session file is a 4 byte magic number and the wall clock time the recording started, followed by
+// one record per call. Numbers are LEB128 varints (zig-zagged when signed) and text is a varint length
+// and the bytes, so the file is compact and does not depend on the machine that wrote it. Every record
+// carries the channel (the trading pair) it belongs to and the length of its body, so a reader can
+// skip records it does not understand. The first records name the channels and give the work orders
+// as they were when the recording started. Each record is written out as soon as its call returns, so
+// a session that ends in a crash is recorded up to the crash.
+//
+// Replay is deterministic for as long as the robot makes the calls that were recorded, in the same
+// order. Where it asks for something else, the call is answered from the recording anyway and counted
+// as a mismatch; where it makes a different call altogether, or runs past the end of the recording,
+// the channel has come to its end and every further call on it fails.
+// ------------------------------------------------------------------------------------------------
+
+namespace mercury
+{
+
+///
+/// The calls that go into a session file. The values are part of the file format.
+enum class session_call : uint8_t
+{
+    channel = 0,            ///< Names a channel: the body is the trading pair.
+    work_order = 1,         ///< A work order as it was when recording started: the body is its line.
+    fiat_balance = 2,
+    coin_balance = 3,
+    current_price = 4,
+    post_order = 5,
+    get_order_status = 6,
+    sell_price_adjustment = 7,
+    buy_price_adjustment = 8,
+    cancel_order = 9,
+    get_order_statuses = 10,
+    get_product_info = 11,
+    get_fill = 12,
+    get_ticker = 13
+};
+
+/// The name of a call, for reports.
+const char* session_call_name(session_call call);
+
+///
+/// Writes the values of a session record into a byte buffer, reusing its storage.
+class session_encoder
+{
+public:
+    explicit session_encoder(std::vector<uint8_t>& out) : out_(out) {}
+
+    void put(uint64_t value);
+    void put(int64_t value);
+    void put(const std::string& text);
+    void put(const char* text, std::size_t len);
+
+    /// Written as text with enough digits to read back exactly.
+    void put(long double value);
+
+    void put(const product_info& info);
+
+private:
+    std::vector<uint8_t>& out_;
+};
+
+///
+/// Reads the values of a session record back. Any read past the end fails and leaves the decoder
+/// failed, so a caller can read a whole record and check ok() once.
+class session_decoder
+{
+public:
+    session_decoder() = default;
+    session_decoder(const uint8_t* data, std::size_t len) : data_(data), end_(data + len) {}
+
+    bool get(uint64_t& value);
+    bool get(int64_t& value);
+
+    /// Reads text, reusing the string's storage.
+    bool get(std::string& text);
+    bool get(long double& value);
+    bool get(product_info& info);
+
+    /// Moves past bytes without reading them.
+    bool skip(std::size_t len);
+
+    /// Where the next read starts.
+    const uint8_t* position() const { return data_; }
+
+    bool ok() const { return ok_; }
+    bool at_end() const { return data_ == end_; }
+
+private:
+    const uint8_t* data_ = nullptr;
+    const uint8_t* end_ = nullptr;
+    bool ok_ = true;
+};
+
+///
+/// Writes a session file. Safe to use from any thread; records are written in the order their calls
+/// return.
+class session_recorder
+{
+public:
+    session_recorder() = default;
+    session_recorder(const session_recorder&) = delete;
+    session_recorder& operator=(const session_recorder&) = delete;
+
+    ///
+    /// Creates the session file, replacing any file already there.
+    ///
+    /// \return false if the file cannot be written.
+    bool open(const std::string& path);
+
+    bool is_open() const { return file_.is_open(); }
+
+    /// Names a new channel and returns its number.
+    uint32_t add_channel(const std::string& pair);
+
+    /// Records a work order line as it is before any call is made.
+    void add_work_order(const char* line);
+
+    /// Microseconds since the recording started, to pass to write() as a call's start.
+    int64_t now_us() const;
+
+    ///
+    /// Writes one call.
+    ///
+    /// \param call       Which call.
+    /// \param channel    The channel it was made on.
+    /// \param started_us When it started, from now_us().
+    /// \param body       Its arguments and results.
+    /// \return false if the file could not be written.
+    bool write(session_call call, uint32_t channel, int64_t started_us, const std::vector<uint8_t>& body);
+
+    void close();
+
+private:
+    void write_locked(session_call call, uint32_t channel, int64_t started_us, int64_t duration_us, const uint8_t* body,
+                      std::size_t len);
+
+    std::mutex mutex_;
+    std::ofstream file_;
+    std::chrono::steady_clock::time_point start_;
+    std::vector<uint8_t> header_;
+    int64_t last_start_us_ = 0;
+    uint32_t channels_ = 0;
+    uint32_t work_orders_ = 0;
+};
+
+///
+/// A session file loaded for replay, shared by the replay contexts of every channel.
+class session_player
+{
+public:
+    ///
+    /// Loads a session file.
+    ///
+    /// \return false if the file cannot be read or is not a session file.
+    bool open(const std::string& path);
+
+    bool is_open() const { return loaded_; }
+
+    /// Number of work orders recorded, and the line of each.
+    std::size_t work_orders() const { return work_orders_.size(); }
+    const std::string& work_order(std::size_t index) const { return work_orders_[index]; }
+
+    /// Wall clock time the recording started, microseconds since the epoch.
+    int64_t recorded_at_us() const { return recorded_at_us_; }
+
+    /// True if the recording has a channel for the pair.
+    bool has_channel(const std::string& pair) const;
+
+    ///
+    /// Called once every channel being replayed has come to its end, on the thread of the last call.
+    ///
+    /// \param on_end The function to call; it must not block.
+    void set_end(void (*on_end)()) { on_end_ = on_end; }
+
+    /// Prints how much of the recording has been replayed and how long it took.
+    void report(std::ostream& out) const;
+
+private:
+    friend class replay_context;
+
+    struct record
+    {
+        session_call call;
+        int64_t duration_us;
+        std::size_t offset;
+        std::size_t len;
+    };
+
+    struct channel
+    {
+        std::string pair;
+        std::vector<record> records;
+        std::size_t next = 0;       ///< Only touched by the one replay context on the channel.
+        bool attached = false;
+    };
+
+    /// Takes a channel for a replay context; returns false if there is none for the pair.
+    bool attach(const std::string& pair, uint32_t& number);
+
+    void finish(uint32_t number);
+    void mismatch(uint32_t number, std::size_t index, const char* what);
+
+    std::vector<uint8_t> data_;
+    std::vector<channel> channels_;
+    std::vector<std::string> work_orders_;
+    int64_t recorded_at_us_ = 0;
+    bool loaded_ = false;
+    void (*on_end_)() = nullptr;
+
+    std::chrono::steady_clock::time_point started_;
+    std::atomic<unsigned int> running_{ 0 };
+    std::atomic<uint64_t> replayed_{ 0 };
+    std::atomic<int64_t> recorded_us_{ 0 };
+    std::atomic<int64_t> replay_us_{ 0 };
+    std::atomic<uint64_t> mismatches_{ 0 };
+    mutable std::mutex mutex_;
+    std::string first_mismatch_;
+};
+
+///
+/// Exchange context that passes every call on to another context and records it in a session file.
+/// Like any context, it is called by one thread at a time.
+class recording_context : public exchange_context
+{
+public:
+    ///
+    /// \param inner    The context that makes the calls; it must outlive this object.
+    /// \param recorder The session file; it must outlive this object.
+    /// \param pair     The trading pair, which names the channel the calls are recorded on.
+    recording_context(exchange_context& inner, session_recorder& recorder, const std::string& pair);
+
+    std::string fiat_balance() override;
+    std::string coin_balance() override;
+    std::string current_price() override;
+    void read_current_price(std::string& out) override;
+    void read_fiat_balance(std::string& out) override;
+    void read_coin_balance(std::string& out) override;
+
+    cryptocoin::trading::order_status post_order(cryptocoin::trading::order_side side, cryptocoin::trading::order_type type,
+                                                 const std::string& size, const std::string& price, const std::string& funds,
+                                                 std::string& out_uuid) override;
+    cryptocoin::trading::order_status get_order_status(const std::string& uuid) override;
+    long double sell_price_adjustment() override;
+    long double buy_price_ajustment() override;
+
+    cryptocoin::trading::order_status cancel_order(const std::string& uuid) override;
+    bool get_order_statuses(const std::vector<std::string>& uuids, std::vector<cryptocoin::trading::order_status>& out) override;
+    bool get_product_info(product_info& out) override;
+    bool get_fill(const std::string& uuid, order_fill& out) override;
+    bool get_ticker(ticker& out) override;
+
+private:
+    void text(session_call call, int64_t started, const std::string& out);
+    void status(session_call call, int64_t started, const std::string& uuid, cryptocoin::trading::order_status result);
+    void rate(session_call call, int64_t started, long double result);
+    void write(session_call call, int64_t started);
+
+    exchange_context& inner_;
+    session_recorder& recorder_;
+    uint32_t channel_;
+    std::vector<uint8_t> body_;
+};
+
+///
+/// Exchange context that answers every call from a recorded session, without waiting. Calls on a
+/// channel that has come to its end fail: text comes back empty, orders fatal_error and queries false.
+class replay_context : public exchange_context
+{
+public:
+    ///
+    /// \param player The recording; it must outlive this object.
+    /// \param pair   The trading pair, whose channel is replayed. See session_player::has_channel().
+    replay_context(session_player& player, const std::string& pair);
+
+    std::string fiat_balance() override;
+    std::string coin_balance() override;
+    std::string current_price() override;
+    void read_current_price(std::string& out) override;
+    void read_fiat_balance(std::string& out) override;
+    void read_coin_balance(std::string& out) override;
+
+    cryptocoin::trading::order_status post_order(cryptocoin::trading::order_side side, cryptocoin::trading::order_type type,
+                                                 const std::string& size, const std::string& price, const std::string& funds,
+                                                 std::string& out_uuid) override;
+    cryptocoin::trading::order_status get_order_status(const std::string& uuid) override;
+    long double sell_price_adjustment() override;
+    long double buy_price_ajustment() override;
+
+    cryptocoin::trading::order_status cancel_order(const std::string& uuid) override;
+    bool get_order_statuses(const std::vector<std::string>& uuids, std::vector<cryptocoin::trading::order_status>& out) override;
+    bool get_product_info(product_info& out) override;
+    bool get_fill(const std::string& uuid, order_fill& out) override;
+    bool get_ticker(ticker& out) override;
+
+private:
+    /// Moves on to the next record, which must be for the given call; false once the channel has ended.
+    bool next(session_call call, session_decoder& in);
+
+    /// Reads a recorded argument and counts a mismatch if the robot passed something else.
+    void expect(session_decoder& in, const std::string& argument, const char* what);
+    void expect(session_decoder& in, uint64_t argument, const char* what);
+
+    void read_text(session_call call, std::string& out);
+    cryptocoin::trading::order_status read_status(session_call call, const std::string& uuid);
+    long double read_rate(session_call call);
+
+    session_player& player_;
+    uint32_t channel_ = 0;
+    bool ended_ = false;
+    std::string scratch_;
+};
+
+}
+
+#endif /* SESSION_RECORDING_HPP */
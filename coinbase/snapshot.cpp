@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   snapshot.cpp
+ * Author: Chris Morrison
+ *
+ * Created on 19 October 2026, 22:00
+ */
+#include <cstring>
+#include "snapshot.hpp"
+
+namespace mercury
+{
+
+// ------------------------------------------------------------------------------------------------
+// Serialisation.
+// ------------------------------------------------------------------------------------------------
+
+void snapshot_writer::raw(const void* data, std::size_t len)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    out_.insert(out_.end(), bytes, bytes + len);
+}
+
+void snapshot_writer::put(const char* text)
+{
+    uint32_t len = static_cast<uint32_t>(std::strlen(text));
+
+    put(len);
+    raw(text, len);
+}
+
+void snapshot_writer::put(const double* values, std::size_t count)
+{
+    put(static_cast<uint64_t>(count));
+    raw(values, count * sizeof(double));
+}
+
+std::size_t snapshot_writer::begin_record(const char* key)
+{
+    put(key);
+    std::size_t start = out_.size();
+    put(uint32_t(0));
+
+    return start;
+}
+
+void snapshot_writer::end_record(std::size_t start)
+{
+    uint32_t len = static_cast<uint32_t>(out_.size() - start - sizeof(uint32_t));
+    std::memcpy(out_.data() + start, &len, sizeof(len));
+}
+
+bool snapshot_reader::raw(void* value, std::size_t len)
+{
+    if (!ok_ || static_cast<std::size_t>(end_ - data_) < len) return ok_ = false;
+
+    std::memcpy(value, data_, len);
+    data_ += len;
+
+    return true;
+}
+
+bool snapshot_reader::get(char* text, std::size_t size)
+{
+    uint32_t len = 0;
+
+    if (!get(len) || len >= size || static_cast<std::size_t>(end_ - data_) < len) return ok_ = false;
+
+    std::memcpy(text, data_, len);
+    text[len] = '\0';
+    data_ += len;
+
+    return true;
+}
+
+bool snapshot_reader::get(double* values, std::size_t count)
+{
+    uint64_t stored = 0;
+
+    if (!get(stored) || stored != count) return ok_ = false;
+
+    return raw(values, count * sizeof(double));
+}
+
+bool snapshot_reader::next_record(std::string& key, snapshot_reader& body)
+{
+    uint32_t len = 0;
+
+    if (at_end() || !get(len) || static_cast<std::size_t>(end_ - data_) < len) return ok_ = false;
+    key.assign(reinterpret_cast<const char*>(data_), len);
+    data_ += len;
+
+    if (!get(len) || static_cast<std::size_t>(end_ - data_) < len) return ok_ = false;
+    body = snapshot_reader(data_, len);
+    data_ += len;
+
+    return true;
+}
+
+}
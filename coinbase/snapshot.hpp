@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   snapshot.hpp
+ * Author: Chris Morrison
+ *
+ * Created on 19 October 2026, 22:00
+ */
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ------------------------------------------------------------------------------------------------
+// Warm-restart snapshots.
+//
+// The runtime state that is not in the work order files (price history, timers part way through) is
+// written every so often to one compact binary file, and read back on start-up. A snapshot is a
+// header followed by one record per source; each record carries its key and length, so a record
+// that no longer matches anything is skipped, and one that fails to load leaves the others alone.
+// Integers are stored in the machine's own byte order: a snapshot is for restarting on the same
+// machine, not for moving between them. See state_snapshots.hpp for taking them.
+// ------------------------------------------------------------------------------------------------
+
+namespace mercury
+{
+
+///
+/// Serialises values into a byte buffer, reusing its storage.
+class snapshot_writer
+{
+public:
+    explicit snapshot_writer(std::vector<uint8_t>& out) : out_(out) {}
+
+    void put(uint32_t value) { raw(&value, sizeof(value)); }
+    void put(uint64_t value) { raw(&value, sizeof(value)); }
+    void put(int64_t value) { raw(&value, sizeof(value)); }
+    void put(double value) { raw(&value, sizeof(value)); }
+    void put(const char* text);
+    void put(const double* values, std::size_t count);
+
+    /// Starts a length-prefixed record; returns the position to hand to end_record().
+    std::size_t begin_record(const char* key);
+    void end_record(std::size_t start);
+
+private:
+    void raw(const void* data, std::size_t len);
+
+    std::vector<uint8_t>& out_;
+};
+
+///
+/// Reads values back. Any read past the end, or of a value that does not fit, fails and leaves the
+/// reader failed, so a caller can read a whole record and check ok() once.
+class snapshot_reader
+{
+public:
+    snapshot_reader(const uint8_t* data, std::size_t len) : data_(data), end_(data + len) {}
+
+    bool get(uint32_t& value) { return raw(&value, sizeof(value)); }
+    bool get(uint64_t& value) { return raw(&value, sizeof(value)); }
+    bool get(int64_t& value) { return raw(&value, sizeof(value)); }
+    bool get(double& value) { return raw(&value, sizeof(value)); }
+
+    /// Reads text into a fixed buffer; fails if it does not fit.
+    bool get(char* text, std::size_t size);
+
+    /// Reads an array that must have exactly count values.
+    bool get(double* values, std::size_t count);
+
+    ///
+    /// Reads the next record's key and gives a reader for its body, moving past it.
+    ///
+    /// \return false at the end of the data or if the record is truncated.
+    bool next_record(std::string& key, snapshot_reader& body);
+
+    bool ok() const { return ok_; }
+    bool at_end() const { return data_ == end_; }
+
+private:
+    bool raw(void* value, std::size_t len);
+
+    const uint8_t* data_;
+    const uint8_t* end_;
+    bool ok_ = true;
+};
+
+///
+/// Something whose state goes into the snapshot.
+class snapshot_source
+{
+public:
+    virtual ~snapshot_source() = default;
+
+    /// Writes the state. Called on the thread that owns the state, so no locking is needed.
+    virtual void save_state(snapshot_writer& out) const = 0;
+
+    ///
+    /// Restores state written by save_state().
+    ///
+    /// \param in          The record.
+    /// \param snapshot_us When the snapshot was taken, microseconds since the epoch.
+    /// \return false if the record does not fit this source; the source is then left as it was.
+    virtual bool restore_state(snapshot_reader& in, int64_t snapshot_us) = 0;
+};
+
+}
+
+#endif /* SNAPSHOT_HPP */
@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   state_snapshots.cpp
+ * Author: Chris Morrison
+ *
+ * Created on 19 October 2026, 22:00
+ */
+#include <cstdio>
+#include <thread>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <boost/asio/post.hpp>
+#include "state_snapshots.hpp"
+
+namespace mercury
+{
+
+static const uint32_t snapshot_magic = 0x504e534d; // "MSNP"
+static const uint32_t snapshot_version = 1;
+
+// Snapshots bigger than this are not ours.
+static const std::size_t max_snapshot_size = 64 * 1024 * 1024;
+
+state_snapshots::state_snapshots(const std::string& path, boost::asio::io_context& io, boost::asio::thread_pool& pool,
+                                 std::chrono::seconds interval)
+    : path_(path), io_(io), pool_(pool), interval_(interval), timer_(io)
+{
+}
+
+void state_snapshots::add(const std::string& key, snapshot_source& source)
+{
+    sources_.emplace_back(key, &source);
+}
+
+void state_snapshots::capture(std::vector<uint8_t>& out) const
+{
+    snapshot_writer writer(out);
+    int64_t now = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+    out.clear();
+    writer.put(snapshot_magic);
+    writer.put(snapshot_version);
+    writer.put(now);
+    for (const auto& [key, source] : sources_)
+    {
+        std::size_t start = writer.begin_record(key.c_str());
+        source->save_state(writer);
+        writer.end_record(start);
+    }
+}
+
+bool state_snapshots::write(const std::vector<uint8_t>& data) const
+{
+    // Written to the side and renamed into place, so a crash part way through leaves the last good
+    // snapshot behind rather than half of a new one.
+    std::string temp = path_ + ".tmp";
+    int fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+
+    const uint8_t* p = data.data();
+    std::size_t left = data.size();
+    while (left > 0)
+    {
+        ssize_t n = ::write(fd, p, left);
+        if (n <= 0)
+        {
+            ::close(fd);
+            return false;
+        }
+        p += n;
+        left -= static_cast<std::size_t>(n);
+    }
+
+    bool ok = (::fsync(fd) == 0);
+    ok = (::close(fd) == 0) && ok;
+
+    return ok && std::rename(temp.c_str(), path_.c_str()) == 0;
+}
+
+std::size_t state_snapshots::restore()
+{
+    int fd = ::open(path_.c_str(), O_RDONLY);
+    if (fd < 0) return 0;
+
+    struct stat info;
+    std::vector<uint8_t> data;
+    if (::fstat(fd, &info) == 0 && info.st_size > 0 && static_cast<std::size_t>(info.st_size) <= max_snapshot_size)
+    {
+        data.resize(static_cast<std::size_t>(info.st_size));
+        if (::read(fd, data.data(), data.size()) != static_cast<ssize_t>(data.size())) data.clear();
+    }
+    ::close(fd);
+
+    snapshot_reader reader(data.data(), data.size());
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    int64_t taken = 0;
+    if (!reader.get(magic) || !reader.get(version) || !reader.get(taken) || magic != snapshot_magic || version != snapshot_version)
+    {
+        return 0;
+    }
+
+    std::size_t restored = 0;
+    std::string key;
+    snapshot_reader body(nullptr, 0);
+    while (reader.next_record(key, body))
+    {
+        for (const auto& [name, source] : sources_)
+        {
+            if (name == key && source->restore_state(body, taken)) ++restored;
+        }
+    }
+
+    return restored;
+}
+
+void state_snapshots::start()
+{
+    schedule();
+}
+
+void state_snapshots::stop()
+{
+    timer_.cancel();
+}
+
+void state_snapshots::schedule()
+{
+    timer_.expires_after(interval_);
+    timer_.async_wait([this](const boost::system::error_code& error)
+    {
+        if (error) return;
+
+        // The last write is still going; this snapshot is skipped rather than queued.
+        if (!writing_.load(std::memory_order_acquire))
+        {
+            std::vector<uint8_t>& buffer = buffers_[back_];
+            capture(buffer);
+            back_ ^= 1;
+            writing_.store(true, std::memory_order_release);
+            boost::asio::post(pool_, [this, &buffer]()
+            {
+                write(buffer);
+                writing_.store(false, std::memory_order_release);
+            });
+        }
+        schedule();
+    });
+}
+
+bool state_snapshots::save_now()
+{
+    std::vector<uint8_t> data;
+
+    // Both writes would go through the same temporary file.
+    while (writing_.load(std::memory_order_acquire)) std::this_thread::yield();
+
+    capture(data);
+    return write(data);
+}
+
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   state_snapshots.hpp
+ * Author: Chris Morrison
+ *
+ * Created on 19 October 2026, 22:00
+ */
+#ifndef STATE_SNAPSHOTS_HPP
+#define STATE_SNAPSHOTS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/thread_pool.hpp>
+#include "snapshot.hpp"
+
+namespace mercury
+{
+
+///
+/// Takes snapshots of a set of sources, on a timer and on request.
+///
+/// The sources are serialised on the io_context thread, which is quick since it only copies memory;
+/// writing the file (to a temporary, then renamed over the old one) is done on the worker pool. Two
+/// buffers take turns, so the next snapshot can be taken while the last is still being written; if
+/// the write is still going when the next one is due, that one is skipped.
+class state_snapshots
+{
+public:
+    ///
+    /// \param path     The snapshot file.
+    /// \param io       The io_context the sources live on.
+    /// \param pool     Where the file is written.
+    /// \param interval Time between snapshots.
+    state_snapshots(const std::string& path, boost::asio::io_context& io, boost::asio::thread_pool& pool, std::chrono::seconds interval);
+
+    /// Adds a source under a key that stays the same from one run to the next (its work order file, say).
+    void add(const std::string& key, snapshot_source& source);
+
+    ///
+    /// Reads the snapshot file, if there is one, and hands each record to the source with its key.
+    ///
+    /// \return the number of sources restored.
+    std::size_t restore();
+
+    /// Starts taking snapshots on the timer.
+    void start();
+
+    /// Stops the timer, so that it no longer keeps the io_context busy.
+    void stop();
+
+    /// Takes a snapshot and writes it before returning; used at shutdown.
+    bool save_now();
+
+private:
+    void schedule();
+    void capture(std::vector<uint8_t>& out) const;
+    bool write(const std::vector<uint8_t>& data) const;
+
+    std::string path_;
+    boost::asio::io_context& io_;
+    boost::asio::thread_pool& pool_;
+    std::chrono::seconds interval_;
+    boost::asio::steady_timer timer_;
+    std::vector<std::pair<std::string, snapshot_source*>> sources_;
+    std::vector<uint8_t> buffers_[2];
+    int back_ = 0;
+    std::atomic<bool> writing_{false};
+};
+
+}
+
+#endif /* STATE_SNAPSHOTS_HPP */
@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   strategy.cpp
+ * Author: Chris Morrison
+ *
+ * Created on 20 October 2026, 01:20
+ */
+#include <cstring>
+#include "strategy.hpp"
+
+namespace mercury
+{
+
+static constexpr strategy strategies[] = {
+    { "classic", "waits out sharp moves, steps by the wider of the exchange rate and the bands, chases the market",
+      strategy_kind::classic },
+    { "patient", "as classic, but leaves resting orders to fill where they are", strategy_kind::patient },
+    { "plain", "ignores the indicators: trades at once and steps by the exchange rate", strategy_kind::plain },
+};
+
+const strategy* find_strategy(const char* name)
+{
+    for (const strategy& s : strategies)
+    {
+        if (std::strcmp(s.name, name) == 0) return &s;
+    }
+
+    return nullptr;
+}
+
+void list_strategies(std::ostream& out)
+{
+    for (const strategy& s : strategies) out << "  " << s.name << " - " << s.description << std::endl;
+}
+
+}
@@ -0,0 +1,281 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   strategy.hpp
+ * Author: Chris Morrison
+ *
+ * Created on 20 October 2026, 01:20
+ */
+#ifndef STRATEGY_HPP
+#define STRATEGY_HPP
+
+#include <ostream>
+#include "candles.hpp"
+#include "indicators.hpp"
+
+// ------------------------------------------------------------------------------------------------
+// Trading strategies built from policies.
+//
+// A strategy makes the trader's pricing and sizing decisions. It is put together at compile time from
+// four policy classes, each a set of static member functions:
+//
+//   Entry   - the price of a new order and when to hold off posting it
+//   Exit    - how far from a fill the follow-up order goes
+//   Sizing  - how much of the fiat balance a buy may use
+//   Retry   - when a resting order is cancelled and re-priced
+//
+// policy_strategy<Entry, Exit, Sizing, Retry> inlines the four into one function per decision. A
+// trader picks its strategy by name once, when its work order is opened, and keeps only its kind;
+// decide() then switches on the kind straight into the inlined policies of that strategy, so no
+// decision is made through a function pointer. Only a plugin strategy calls out of line, to the plugin.
+// ------------------------------------------------------------------------------------------------
+
+namespace mercury
+{
+
+class plugin_instance;
+
+///
+/// What a decision may depend on besides prices.
+struct strategy_inputs
+{
+    const market_indicators& indicators;
+    const candle_aggregator& candles;   ///< OHLCV bars of the prices the work order has seen.
+    long double fiat_percent;           ///< Fraction of the fiat balance to use for buys.
+    long double chase_fraction;         ///< How far the market may run from a resting order; 0 for never.
+    plugin_instance* plugin = nullptr;  ///< The work order's plugin, for strategies loaded from one.
+};
+
+// ------------------------------------------------------------------------------------------------
+// Entry policies.
+// ------------------------------------------------------------------------------------------------
+
+///
+/// Trades at the work order price, or at the market when the market is better.
+struct better_price_entry
+{
+    static bool buy_at_market(long double order, long double market, const strategy_inputs&) { return market < order; }
+    static bool sell_at_market(long double order, long double market, const strategy_inputs&) { return market > order; }
+    static bool defer_buy(const strategy_inputs&) { return false; }
+    static bool defer_sell(const strategy_inputs&) { return false; }
+};
+
+///
+/// As better_price_entry, but does not buy into a market that is falling sharply or sell into one
+/// that is rising sharply until it settles.
+struct settled_market_entry : better_price_entry
+{
+    static bool defer_buy(const strategy_inputs& in) { return in.indicators.falling_sharply(); }
+    static bool defer_sell(const strategy_inputs& in) { return in.indicators.rising_sharply(); }
+};
+
+// ------------------------------------------------------------------------------------------------
+// Exit policies. Both keep the follow-up at least one whole unit of fiat from the fill.
+// ------------------------------------------------------------------------------------------------
+
+///
+/// Steps by the exchange's adjustment rate, widened to the half-width of the Bollinger bands when the
+/// market swings further than that.
+struct band_step_exit
+{
+    static long double distance(long double fill, long double rate, const strategy_inputs& in)
+    {
+        long double step = fill * in.indicators.adjustment_rate(fill, rate);
+        return (step < 1.00) ? 1.00 : step;
+    }
+};
+
+///
+/// Steps by the exchange's adjustment rate alone.
+struct rate_step_exit
+{
+    static long double distance(long double fill, long double rate, const strategy_inputs&)
+    {
+        long double step = fill * rate;
+        return (step < 1.00) ? 1.00 : step;
+    }
+};
+
+// ------------------------------------------------------------------------------------------------
+// Sizing policies.
+// ------------------------------------------------------------------------------------------------
+
+///
+/// Uses the configured fraction of the fiat balance.
+struct balance_fraction_sizing
+{
+    static long double buy_funds(long double balance, const strategy_inputs& in) { return balance * in.fiat_percent; }
+};
+
+// ------------------------------------------------------------------------------------------------
+// Retry policies.
+// ------------------------------------------------------------------------------------------------
+
+///
+/// Re-prices a resting order once the market has run the chase fraction away from it.
+struct chase_retry
+{
+    static bool watches(const strategy_inputs& in) { return in.chase_fraction > 0; }
+
+    static bool reprice_buy(long double order, long double market, const strategy_inputs& in)
+    {
+        return in.chase_fraction > 0 && market > order * (1 + in.chase_fraction);
+    }
+
+    static bool reprice_sell(long double order, long double market, const strategy_inputs& in)
+    {
+        return in.chase_fraction > 0 && market < order * (1 - in.chase_fraction);
+    }
+};
+
+///
+/// Leaves a resting order where it is until it fills.
+struct hold_retry
+{
+    static bool watches(const strategy_inputs&) { return false; }
+    static bool reprice_buy(long double, long double, const strategy_inputs&) { return false; }
+    static bool reprice_sell(long double, long double, const strategy_inputs&) { return false; }
+};
+
+// ------------------------------------------------------------------------------------------------
+// Composition and registry.
+// ------------------------------------------------------------------------------------------------
+
+///
+/// Puts four policies together into the decisions of a strategy:
+///
+///   buy_at_market, sell_at_market - true to post a new order at the market rather than the work order price
+///   defer_buy, defer_sell         - true to hold off posting a new order for now
+///   sell_after_buy, buy_after_sell - price of the order that follows a fill
+///   buy_funds                     - the fiat a buy may spend out of the balance
+///   watches_market                - true if resting orders are checked against the market at all
+///   reprice_buy, reprice_sell     - true to cancel a resting order and post it again at the market
+template <typename Entry, typename Exit, typename Sizing, typename Retry>
+class policy_strategy
+{
+public:
+    static bool buy_at_market(long double order, long double market, const strategy_inputs& in)
+    {
+        return Entry::buy_at_market(order, market, in);
+    }
+
+    static bool sell_at_market(long double order, long double market, const strategy_inputs& in)
+    {
+        return Entry::sell_at_market(order, market, in);
+    }
+    static bool defer_buy(const strategy_inputs& in) { return Entry::defer_buy(in); }
+    static bool defer_sell(const strategy_inputs& in) { return Entry::defer_sell(in); }
+
+    static long double sell_after_buy(long double fill, long double rate, const strategy_inputs& in)
+    {
+        return fill + Exit::distance(fill, rate, in);
+    }
+
+    static long double buy_after_sell(long double fill, long double rate, const strategy_inputs& in)
+    {
+        return fill - Exit::distance(fill, rate, in);
+    }
+
+    static long double buy_funds(long double balance, const strategy_inputs& in) { return Sizing::buy_funds(balance, in); }
+
+    static bool watches_market(const strategy_inputs& in) { return Retry::watches(in); }
+
+    static bool reprice_buy(long double order, long double market, const strategy_inputs& in)
+    {
+        return Retry::reprice_buy(order, market, in);
+    }
+
+    static bool reprice_sell(long double order, long double market, const strategy_inputs& in)
+    {
+        return Retry::reprice_sell(order, market, in);
+    }
+};
+
+/// Waits out sharp moves, steps by the wider of the exchange rate and the bands, chases the market.
+using classic_strategy = policy_strategy<settled_market_entry, band_step_exit, balance_fraction_sizing, chase_retry>;
+
+/// As classic_strategy, but leaves resting orders to fill where they are.
+using patient_strategy = policy_strategy<settled_market_entry, band_step_exit, balance_fraction_sizing, hold_retry>;
+
+/// Ignores the indicators: trades at once and steps by the exchange rate.
+using plain_strategy = policy_strategy<better_price_entry, rate_step_exit, balance_fraction_sizing, chase_retry>;
+
+///
+/// The decisions of a strategy loaded from a plugin. Each asks the work order's plugin instance,
+/// starting from the advice the default strategy would give (see plugin_host.cpp).
+struct plugin_strategy
+{
+    static bool buy_at_market(long double order, long double market, const strategy_inputs& in);
+    static bool sell_at_market(long double order, long double market, const strategy_inputs& in);
+    static bool defer_buy(const strategy_inputs& in);
+    static bool defer_sell(const strategy_inputs& in);
+    static long double sell_after_buy(long double fill, long double rate, const strategy_inputs& in);
+    static long double buy_after_sell(long double fill, long double rate, const strategy_inputs& in);
+    static long double buy_funds(long double balance, const strategy_inputs& in);
+    static bool watches_market(const strategy_inputs& in);
+    static bool reprice_buy(long double order, long double market, const strategy_inputs& in);
+    static bool reprice_sell(long double order, long double market, const strategy_inputs& in);
+};
+
+/// Which strategy a work order runs.
+enum class strategy_kind : unsigned char
+{
+    classic,
+    patient,
+    plain,
+    plugin
+};
+
+///
+/// A pre-built strategy in the registry.
+struct strategy
+{
+    const char* name;
+    const char* description;
+    strategy_kind kind;
+};
+
+///
+/// Makes one decision with the strategy of the given kind, e.g.
+/// decide(kind, [&](auto s) { return s.defer_buy(in); }).
+template <typename Decision>
+inline auto decide(strategy_kind kind, Decision&& decision)
+{
+    switch (kind)
+    {
+    case strategy_kind::patient: return decision(patient_strategy());
+    case strategy_kind::plain: return decision(plain_strategy());
+    case strategy_kind::plugin: return decision(plugin_strategy());
+    case strategy_kind::classic: break;
+    }
+    return decision(classic_strategy());
+}
+
+/// The strategy used when a work order does not name one.
+constexpr const char* default_strategy = "classic";
+
+///
+/// Looks up a pre-built strategy by name.
+///
+/// \return the strategy, or nullptr if there is none of that name.
+const strategy* find_strategy(const char* name);
+
+/// Lists the pre-built strategies, one per line.
+void list_strategies(std::ostream& out);
+
+}
+
+#endif /* STRATEGY_HPP */
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   strategy_plugin.h
+ * Author: Chris Morrison
+ *
+ * Created on 20 October 2026, 02:05
+ */
+#ifndef STRATEGY_PLUGIN_H
+#define STRATEGY_PLUGIN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* ------------------------------------------------------------------------------------------------
+ * The C ABI for strategy plugins.
+ *
+ * A plugin is a shared library that exports one function, mercury_plugin(), returning a table
+ * that describes it. The robot loads it with --plugin and any work order can then name it as
+ * its strategy (see strategy.hpp); every such work order gets an instance of its own from create().
+ *
+ * The robot calls an instance with:
+ *
+ *   on_tick  - every price the work order sees.
+ *   on_fill  - when an order fills; returns the price of the follow-up order.
+ *   on_timer - whenever the work order is about to act: before posting an order and at every check
+ *              on a resting one. The robot fills in its default advice first, so a plugin only has
+ *              to change what it has an opinion on.
+ *
+ * All calls come from the robot's one trading thread.
+ *
+ * Sending the robot SIGHUP reloads every plugin from its file. Work orders keep their open orders;
+ * each instance hands its state to its replacement by way of save_state() on the old library and
+ * load_state() on the new one, tagged with the old library's state_version. A new library that does
+ * not understand the state returns 0 from load_state() and its instance starts fresh.
+ *
+ * An empty plugin, for instance, looks like this:
+ *
+ *   static void* create(void) { static int dummy; return &dummy; }
+ *   static void destroy(void* state) {}
+ *   ...
+ *   static const mercury_strategy_plugin table = { MERCURY_PLUGIN_ABI, "empty", 1, create, destroy, ... };
+ *   const mercury_strategy_plugin* mercury_plugin(void) { return &table; }
+ * ------------------------------------------------------------------------------------------------ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Bumped whenever the layout of any structure below changes. */
+#define MERCURY_PLUGIN_ABI 1
+
+/* Name of the function every plugin exports. */
+#define MERCURY_PLUGIN_ENTRY "mercury_plugin"
+
+enum mercury_side
+{
+    MERCURY_BUY = 0,
+    MERCURY_SELL = 1
+};
+
+/* What the work order is about to do. Amounts not known at the time are 0. */
+typedef struct mercury_check
+{
+    int32_t side;           /* MERCURY_BUY or MERCURY_SELL. */
+    int32_t resting;        /* 1 if an order is on the book at order_price. */
+    double order_price;     /* The work order's price, or the resting order's. */
+    double market_price;    /* The latest price seen. */
+    double balance;         /* The fiat balance before a buy. */
+} mercury_check;
+
+/* The answer to a check. */
+typedef struct mercury_advice
+{
+    int32_t at_market;      /* 1 to post at the market price rather than the order price. */
+    int32_t defer;          /* 1 to hold off posting for a minute. */
+    double funds;           /* The fiat a buy may spend. */
+    int32_t reprice;        /* 1 to cancel the resting order and post it again at the market. */
+} mercury_advice;
+
+/* An order that has filled. */
+typedef struct mercury_fill
+{
+    int32_t side;           /* The side that filled. */
+    double price;           /* The price it filled at. */
+    double rate;            /* The exchange's suggested adjustment rate for the follow-up order. */
+} mercury_fill;
+
+typedef struct mercury_strategy_plugin
+{
+    uint32_t abi_version;   /* MERCURY_PLUGIN_ABI when the plugin was built. */
+    const char* name;       /* The strategy name work orders use; must not change between reloads. */
+    uint32_t state_version; /* Version of the state save_state() writes. */
+
+    void* (*create)(void);
+    void (*destroy)(void* state);
+
+    void (*on_tick)(void* state, int64_t time_us, double price);
+    double (*on_fill)(void* state, const mercury_fill* fill);
+    void (*on_timer)(void* state, const mercury_check* check, mercury_advice* advice);
+
+    /* Writes the state into buf if it fits; returns its size either way. */
+    size_t (*save_state)(void* state, void* buf, size_t len);
+    /* Takes over state saved by a library with the given state_version; returns 0 if it cannot. */
+    int (*load_state)(void* state, uint32_t version, const void* buf, size_t len);
+} mercury_strategy_plugin;
+
+typedef const mercury_strategy_plugin* (*mercury_plugin_entry)(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STRATEGY_PLUGIN_H */
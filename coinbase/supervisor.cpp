@@ -0,0 +1,547 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   supervisor.cpp
+ * Author: Chris Morrison
+ *
+ * Created on 20 October 2026, 03:30
+ */
+#include <fcntl.h>
+#include <poll.h>
+#include <sched.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#include <tclap/CmdLine.h>
+#include "work_order.hpp"
+#include "worker_health.hpp"
+
+// ------------------------------------------------------------------------------------------------
+// mercury-supervisor: runs the work orders of many pairs across a set of coinbase-robot worker
+// processes, one per core, so that a fault in one worker takes down only the pairs it trades.
+//
+// Work orders are sharded by pair (every work order on a pair shares its exchange connection and
+// exits, so they stay in one process) using rendezvous hashing: adding a worker moves only the pairs
+// that now hash highest to the new worker, about 1/N of them, and leaves the rest where they are.
+// Each worker is pinned to its own core, keeps a snapshot of its state in the state directory and
+// sends a health report every second. A worker that dies, or that stops reporting, is restarted from
+// its snapshot after a back-off that doubles with every failure in a row.
+//
+// The exchange limits the requests made with the API key as a whole, so --request-rate and
+// --request-burst are split evenly between the workers that have work orders; when a worker is
+// added, the others are restarted with their new share. Every other limit passed on to the workers, the risk limits
+// included, applies to each worker on its own.
+//
+// SIGUSR1 prints the health of every worker, SIGUSR2 adds a worker and rebalances the pairs onto it;
+// SIGINT and SIGTERM stop every worker (each writes its final snapshot) and then the supervisor.
+// ------------------------------------------------------------------------------------------------
+
+static volatile std::sig_atomic_t stopping = 0;
+static volatile std::sig_atomic_t reporting = 0;
+static volatile std::sig_atomic_t adding = 0;
+
+static void on_signal(int number)
+{
+    if (number == SIGUSR1)
+        reporting = 1;
+    else if (number == SIGUSR2)
+        adding = 1;
+    else
+        stopping = 1;
+}
+
+// How often the supervisor wakes up to look after the workers when no reports arrive.
+static const int poll_interval_ms = 200;
+
+// Back-off before restarting a worker that died; doubled after every failure in a row up to the most.
+static const int64_t first_backoff_us = 1000000;
+static const int64_t most_backoff_us = 60000000;
+
+// A worker that has been up this long without failing is healthy again and starts from the first back-off.
+static const int64_t settled_us = 300000000;
+
+// How long workers get to write their snapshots and stop before they are killed.
+static const int64_t shutdown_grace_us = 10000000;
+
+struct supervisor_settings
+{
+    std::string robot = "coinbase-robot";
+    std::vector<std::string> robot_args;
+    double request_rate = 5.0;
+    double request_burst = 10.0;
+    std::string state_dir = "mercury-workers";
+    std::string health_path;
+    unsigned int first_core = 0;
+    bool pinning = true;
+    int64_t health_timeout_us = 30000000;
+};
+
+///
+/// The work orders on one pair.
+struct shard
+{
+    std::string pair;
+    std::vector<std::string> paths;
+};
+
+///
+/// One worker process and what the supervisor knows about it.
+struct worker
+{
+    unsigned int slot = 0;
+    int core = -1;
+    pid_t pid = 0;
+    std::vector<std::string> paths;     ///< The work orders the running process was given.
+    std::vector<std::string> wanted;    ///< The work orders it should have after the last rebalance.
+    bool retiring = false;              ///< Asked to stop by the supervisor, so its exit is not a failure.
+    std::size_t sharing = 0;            ///< The number of workers the request rate was split between when it started.
+    int64_t started_us = 0;
+    int64_t restart_at_us = 0;
+    int64_t backoff_us = first_backoff_us;
+    unsigned int restarts = 0;
+    int64_t last_report_us = 0;
+    mercury::health_report report;
+    double cpu_percent = 0.0;
+};
+
+static int64_t now_us()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void log_line(const std::string& text)
+{
+    std::time_t t = std::time(nullptr);
+    char stamp[32];
+
+    std::strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", std::localtime(&t));
+    std::cout << stamp << ' ' << text << std::endl;
+}
+
+static std::string worker_file(const supervisor_settings& settings, const worker& w, const char* suffix)
+{
+    return settings.state_dir + "/worker-" + std::to_string(w.slot) + suffix;
+}
+
+///
+/// Weight of a pair on a worker slot; each pair goes to the slot that weighs most.
+static uint64_t shard_weight(const std::string& pair, unsigned int slot)
+{
+    // FNV-1a of the pair, then a splitmix64 finaliser over the pair and the slot together.
+    uint64_t h = 14695981039346656037ULL;
+    for (char c : pair) h = (h ^ uint8_t(c)) * 1099511628211ULL;
+
+    uint64_t z = h + (uint64_t(slot) + 1) * 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static void assign_shards(const std::vector<shard>& shards, std::vector<worker>& workers)
+{
+    for (worker& w : workers) w.wanted.clear();
+
+    for (const shard& s : shards)
+    {
+        std::size_t best = 0;
+        for (std::size_t i = 1; i < workers.size(); ++i)
+        {
+            if (shard_weight(s.pair, workers[i].slot) > shard_weight(s.pair, workers[best].slot)) best = i;
+        }
+        workers[best].wanted.insert(workers[best].wanted.end(), s.paths.begin(), s.paths.end());
+    }
+
+    for (worker& w : workers) std::sort(w.wanted.begin(), w.wanted.end());
+}
+
+///
+/// The number of workers with work orders, which split the request rate between them.
+static std::size_t busy_workers(const std::vector<worker>& workers)
+{
+    return std::size_t(std::count_if(workers.begin(), workers.end(), [](const worker& w) { return !w.wanted.empty(); }));
+}
+
+///
+/// Starts a worker on its wanted work orders, pinned to its core, with its output going to its log.
+///
+/// \param settings The supervisor's settings.
+/// \param w        The worker to start.
+/// \param sharing  The number of workers that split the request rate.
+static bool start_worker(const supervisor_settings& settings, worker& w, std::size_t sharing)
+{
+    std::vector<std::string> args = { settings.robot };
+    for (const std::string& path : w.wanted)
+    {
+        args.push_back("--work-order-file");
+        args.push_back(path);
+    }
+    args.push_back("--snapshot");
+    args.push_back(worker_file(settings, w, ".snapshot"));
+    args.push_back("--health-socket");
+    args.push_back(settings.health_path);
+    args.push_back("--request-rate");
+    args.push_back(std::to_string(settings.request_rate / double(sharing)));
+    args.push_back("--request-burst");
+    args.push_back(std::to_string(std::max(1.0, settings.request_burst / double(sharing))));
+    args.insert(args.end(), settings.robot_args.begin(), settings.robot_args.end());
+
+    std::vector<char*> argv;
+    for (std::string& arg : args) argv.push_back(arg.data());
+    argv.push_back(nullptr);
+
+    std::string log_path = worker_file(settings, w, ".log");
+    int log_fd = ::open(log_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (log_fd < 0)
+    {
+        log_line("Failed to open " + log_path + " for worker " + std::to_string(w.slot) + ".");
+        return false;
+    }
+
+    pid_t pid = ::fork();
+    if (pid == 0)
+    {
+        // Only async-signal-safe calls from here on.
+        if (w.core >= 0)
+        {
+            cpu_set_t cores;
+            CPU_ZERO(&cores);
+            CPU_SET(w.core, &cores);
+            ::sched_setaffinity(0, sizeof(cores), &cores);
+        }
+        ::dup2(log_fd, STDOUT_FILENO);
+        ::dup2(log_fd, STDERR_FILENO);
+        ::execvp(argv[0], argv.data());
+        ::_exit(127);
+    }
+    ::close(log_fd);
+
+    if (pid < 0)
+    {
+        log_line("Failed to start worker " + std::to_string(w.slot) + ".");
+        return false;
+    }
+
+    w.pid = pid;
+    w.paths = w.wanted;
+    w.sharing = sharing;
+    w.retiring = false;
+    w.started_us = now_us();
+    w.last_report_us = 0;
+    w.cpu_percent = 0.0;
+    log_line("Started worker " + std::to_string(w.slot) + " (pid " + std::to_string(pid) + ", core " +
+             (w.core >= 0 ? std::to_string(w.core) : std::string("any")) + ") with " + std::to_string(w.paths.size()) +
+             " work orders.");
+    return true;
+}
+
+///
+/// Asks every worker whose work orders or share of the request rate have changed to stop, so that it can be
+/// started again with its new ones.
+static void rebalance(std::vector<worker>& workers)
+{
+    for (worker& w : workers)
+    {
+        if (w.pid == 0 || (w.paths == w.wanted && w.sharing == busy_workers(workers))) continue;
+        w.retiring = true;
+        ::kill(w.pid, SIGTERM);
+        log_line("Stopping worker " + std::to_string(w.slot) + " to rebalance its pairs.");
+    }
+}
+
+static void reap_workers(std::vector<worker>& workers)
+{
+    int status = 0;
+    pid_t pid;
+
+    while ((pid = ::waitpid(-1, &status, WNOHANG)) > 0)
+    {
+        auto w = std::find_if(workers.begin(), workers.end(), [pid](const worker& candidate) { return candidate.pid == pid; });
+        if (w == workers.end()) continue;
+
+        int64_t now = now_us();
+        w->pid = 0;
+        w->paths.clear();
+        if (w->retiring)
+        {
+            w->restart_at_us = now;
+            continue;
+        }
+
+        // Any exit the supervisor did not ask for is a failure: the work orders are meant to run for ever.
+        if (now - w->started_us >= settled_us) w->backoff_us = first_backoff_us;
+        int64_t delay_us = w->backoff_us;
+        w->restart_at_us = now + delay_us;
+        w->backoff_us = std::min(w->backoff_us * 2, most_backoff_us);
+        ++w->restarts;
+
+        std::string how = WIFSIGNALED(status) ? "was killed by signal " + std::to_string(WTERMSIG(status))
+                                               : "exited with status " + std::to_string(WEXITSTATUS(status));
+        log_line("Worker " + std::to_string(w->slot) + " " + how + "; restarting it in " + std::to_string(delay_us / 1000000) +
+                 " seconds.");
+    }
+}
+
+static void read_reports(mercury::health_listener& listener, std::vector<worker>& workers)
+{
+    mercury::health_report report;
+
+    while (listener.receive(report))
+    {
+        auto w = std::find_if(workers.begin(), workers.end(),
+                              [&report](const worker& candidate) { return candidate.pid == report.pid; });
+        if (w == workers.end()) continue;
+
+        if (w->last_report_us && report.time_us > w->report.time_us)
+        {
+            w->cpu_percent = 100.0 * double(report.cpu_us - w->report.cpu_us) / double(report.time_us - w->report.time_us);
+        }
+        w->report = report;
+        w->last_report_us = now_us();
+    }
+}
+
+///
+/// Kills any worker that has not reported for too long; it is restarted like any other that died.
+static void check_health(const supervisor_settings& settings, std::vector<worker>& workers)
+{
+    int64_t now = now_us();
+
+    for (worker& w : workers)
+    {
+        if (w.pid == 0 || w.retiring) continue;
+        int64_t heard = std::max(w.last_report_us, w.started_us);
+        if (now - heard < settings.health_timeout_us) continue;
+
+        log_line("Worker " + std::to_string(w.slot) + " has not reported for " + std::to_string((now - heard) / 1000000) +
+                 " seconds; killing it.");
+        ::kill(w.pid, SIGKILL);
+        w.last_report_us = now;
+    }
+}
+
+static void report_workers(const std::vector<worker>& workers)
+{
+    int64_t now = now_us();
+
+    log_line("Workers:");
+    std::printf("%6s %8s %5s %11s %8s %7s %10s %10s %7s %9s\n", "worker", "pid", "core", "work orders", "restarts", "cpu %",
+                "max rss kb", "lag ms", "queued", "heard s");
+    for (const worker& w : workers)
+    {
+        std::printf("%6u %8d %5d %11zu %8u %7.1f %10lld %10.1f %7u %9lld\n", w.slot, int(w.pid), w.core, w.paths.size(), w.restarts,
+                    w.cpu_percent, (long long)w.report.max_rss_kb, w.report.loop_lag_us / 1000.0, w.report.queued_requests,
+                    w.last_report_us ? (long long)((now - w.last_report_us) / 1000000) : -1LL);
+    }
+    std::fflush(stdout);
+}
+
+static void stop_workers(std::vector<worker>& workers)
+{
+    for (worker& w : workers)
+    {
+        w.retiring = true;
+        if (w.pid) ::kill(w.pid, SIGTERM);
+    }
+
+    int64_t deadline = now_us() + shutdown_grace_us;
+    while (now_us() < deadline && std::any_of(workers.begin(), workers.end(), [](const worker& w) { return w.pid != 0; }))
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        reap_workers(workers);
+    }
+
+    for (worker& w : workers)
+    {
+        if (w.pid == 0) continue;
+        log_line("Worker " + std::to_string(w.slot) + " did not stop in time; killing it.");
+        ::kill(w.pid, SIGKILL);
+        ::waitpid(w.pid, nullptr, 0);
+        w.pid = 0;
+    }
+}
+
+static int pick_core(const supervisor_settings& settings, unsigned int slot)
+{
+    unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+    return settings.pinning ? int((settings.first_core + slot) % cores) : -1;
+}
+
+int main(int argc, char** argv)
+{
+    supervisor_settings settings;
+    std::vector<std::string> paths;
+    unsigned int worker_count = 0;
+
+    try
+    {
+        TCLAP::CmdLine cmd("Supervisor that shards work orders across pinned robot worker processes", ' ', "0.1");
+
+        TCLAP::MultiArg<std::string> name_arg("f", "work-order-file", "Full path of a work order file; give it once for every work order to run.", true, "file path");
+        cmd.add(name_arg);
+        TCLAP::ValueArg<unsigned int> workers_arg("n", "workers", "Number of worker processes (default: one per core)", false, 0, "number");
+        cmd.add(workers_arg);
+        TCLAP::ValueArg<std::string> robot_arg("r", "robot", "The robot executable to run as a worker (default: coinbase-robot on the PATH)", false, "coinbase-robot", "file path");
+        cmd.add(robot_arg);
+        TCLAP::MultiArg<std::string> pass_arg("a", "robot-arg", "An argument to pass on to every worker; give it once for every argument. Limits passed on, such as the risk limits, apply to each worker on its own.", false, "argument");
+        cmd.add(pass_arg);
+        TCLAP::ValueArg<double> rate_arg("", "request-rate", "Most requests per second sent to the exchange by every worker together, split evenly between those with work orders (default: 5, 0 for no limit)", false, 5, "number");
+        cmd.add(rate_arg);
+        TCLAP::ValueArg<double> burst_arg("", "request-burst", "Requests that may be sent at once after a quiet spell by every worker together, split evenly between those with work orders (default: 10)", false, 10, "number");
+        cmd.add(burst_arg);
+        TCLAP::ValueArg<std::string> state_arg("d", "state-dir", "Directory for the snapshots, logs and health socket of the workers (default: mercury-workers)", false, "mercury-workers", "directory");
+        cmd.add(state_arg);
+        TCLAP::ValueArg<unsigned int> core_arg("c", "first-core", "Core the first worker is pinned to; the others take the cores after it (default: 0)", false, 0, "number");
+        cmd.add(core_arg);
+        TCLAP::SwitchArg no_pin_arg("", "no-pinning", "Let the workers run on any core.");
+        cmd.add(no_pin_arg);
+        TCLAP::ValueArg<unsigned int> timeout_arg("", "health-timeout", "Seconds a worker may go without reporting before it is restarted (default: 30)", false, 30, "number");
+        cmd.add(timeout_arg);
+
+        cmd.parse(argc, argv);
+
+        paths = name_arg.getValue();
+        worker_count = workers_arg.getValue() ? workers_arg.getValue() : std::max(1u, std::thread::hardware_concurrency());
+        settings.robot = robot_arg.getValue();
+        settings.robot_args = pass_arg.getValue();
+        settings.state_dir = state_arg.getValue();
+        settings.first_core = core_arg.getValue();
+        settings.pinning = !no_pin_arg.getValue();
+        settings.health_timeout_us = int64_t(timeout_arg.getValue()) * 1000000;
+        settings.request_rate = rate_arg.getValue();
+        settings.request_burst = burst_arg.getValue();
+
+        if (settings.request_rate < 0 || settings.request_burst < 1)
+        {
+            std::cerr << "Invalid value for '--request-rate' or '--request-burst,' the rate must not be negative and the burst must be at least 1." << std::endl;
+            return 1;
+        }
+        for (const std::string& arg : settings.robot_args)
+        {
+            if (arg.rfind("--request-rate", 0) == 0 || arg.rfind("--request-burst", 0) == 0)
+            {
+                std::cerr << "Invalid value for '--robot-arg,' give " << arg.substr(0, arg.find('=')) << " to the supervisor, which splits it between the workers." << std::endl;
+                return 1;
+            }
+        }
+
+        if (timeout_arg.getValue() < 5)
+        {
+            std::cerr << "Invalid value for '--health-timeout,' workers report once a second, so allow them at least 5." << std::endl;
+            return 1;
+        }
+    }
+    catch (TCLAP::ArgException& e)
+    {
+        std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
+        return 1;
+    }
+
+    // Group the work orders by pair.
+    std::map<std::string, std::vector<std::string>> pairs;
+    for (const std::string& path : paths)
+    {
+        mercury::work_order_file file;
+        mercury::work_order order;
+        if (!file.open(path) || !file.read(order))
+        {
+            std::cerr << "Invalid value for '--work-order-file,' '" << path << "' is not a readable work order." << std::endl;
+            return 1;
+        }
+        pairs[std::string(order.coin) + "-" + order.fiat].push_back(std::filesystem::absolute(path).string());
+    }
+
+    std::vector<shard> shards;
+    for (auto& [pair, files] : pairs) shards.push_back(shard{ pair, files });
+
+    std::error_code error;
+    std::filesystem::create_directories(settings.state_dir, error);
+    settings.health_path = settings.state_dir + "/health.sock";
+
+    mercury::health_listener listener;
+    if (!listener.open(settings.health_path))
+    {
+        std::cerr << "Failed to listen for health reports on " << settings.health_path << "." << std::endl;
+        return 1;
+    }
+
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+    std::signal(SIGUSR1, on_signal);
+    std::signal(SIGUSR2, on_signal);
+
+    std::vector<worker> workers(worker_count);
+    for (unsigned int i = 0; i < worker_count; ++i)
+    {
+        workers[i].slot = i;
+        workers[i].core = pick_core(settings, i);
+    }
+    assign_shards(shards, workers);
+
+    log_line("Supervising " + std::to_string(paths.size()) + " work orders on " + std::to_string(shards.size()) + " pairs with " +
+             std::to_string(worker_count) + " workers.");
+
+    while (!stopping)
+    {
+        pollfd fd = { listener.fd(), POLLIN, 0 };
+        ::poll(&fd, 1, poll_interval_ms);
+
+        read_reports(listener, workers);
+        reap_workers(workers);
+        check_health(settings, workers);
+
+        if (adding)
+        {
+            adding = 0;
+            worker added;
+            added.slot = unsigned(workers.size());
+            added.core = pick_core(settings, added.slot);
+            workers.push_back(added);
+            assign_shards(shards, workers);
+            log_line("Added worker " + std::to_string(added.slot) + "; rebalancing.");
+            rebalance(workers);
+        }
+
+        // A pair that moves must have stopped in its old worker before it starts in its new one.
+        bool moving = std::any_of(workers.begin(), workers.end(), [](const worker& w) { return w.pid != 0 && w.retiring; });
+        int64_t now = now_us();
+        for (worker& w : workers)
+        {
+            if (moving || stopping || w.pid != 0 || w.wanted.empty() || now < w.restart_at_us) continue;
+            if (!start_worker(settings, w, busy_workers(workers))) w.restart_at_us = now + most_backoff_us;
+        }
+
+        if (reporting)
+        {
+            reporting = 0;
+            report_workers(workers);
+        }
+    }
+
+    log_line("Stopping the workers.");
+    stop_workers(workers);
+    return 0;
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   task.cpp
+ * Author: Chris Morrison
+ *
+ * Created on 19 October 2026, 22:30
+ */
+#include <new>
+#include "task.hpp"
+
+namespace mercury
+{
+
+namespace
+{
+
+// Frames are rounded up to a multiple of frame_granularity and kept on one free list per size; frames
+// too big for any list go straight to the heap.
+constexpr std::size_t frame_granularity = 64;
+constexpr std::size_t frame_lists = 64;
+
+struct free_frame
+{
+    free_frame* next;
+};
+
+thread_local free_frame* free_frames[frame_lists] = {};
+
+inline std::size_t frame_list(std::size_t size)
+{
+    return (size + frame_granularity - 1) / frame_granularity - 1;
+}
+
+struct detached
+{
+    struct promise_type : detail::frame_allocated
+    {
+        detached get_return_object() { return detached(); }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+detached run_detached(task<void> work)
+{
+    co_await std::move(work);
+}
+
+}
+
+void* allocate_frame(std::size_t size)
+{
+    std::size_t list = frame_list(size);
+
+    if (list >= frame_lists) return ::operator new(size);
+    if (free_frame* frame = free_frames[list])
+    {
+        free_frames[list] = frame->next;
+        return frame;
+    }
+    return ::operator new((list + 1) * frame_granularity);
+}
+
+void deallocate_frame(void* frame, std::size_t size)
+{
+    std::size_t list = frame_list(size);
+
+    if (list >= frame_lists)
+    {
+        ::operator delete(frame);
+        return;
+    }
+    free_frame* block = static_cast<free_frame*>(frame);
+    block->next = free_frames[list];
+    free_frames[list] = block;
+}
+
+void spawn(boost::asio::io_context& io, task<void> work)
+{
+    boost::asio::post(io, [work = std::move(work)]() mutable { run_detached(std::move(work)); });
+}
+
+}
@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   task.hpp
+ * Author: Chris Morrison
+ *
+ * Created on 19 October 2026, 22:30
+ */
+#ifndef TASK_HPP
+#define TASK_HPP
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <utility>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+
+// ------------------------------------------------------------------------------------------------
+// Coroutine tasks.
+//
+// A task is a lazily started coroutine that is run by co_awaiting it from another task, or by handing
+// it to spawn(). Awaiting a task that finishes without suspending costs no trip through the executor,
+// and coroutine frames come from per-thread free lists, so a steady state of tasks does not touch the
+// heap once every frame size in use has been seen.
+// ------------------------------------------------------------------------------------------------
+
+namespace mercury
+{
+
+/// Returns a block for a coroutine frame, reusing one freed earlier on this thread if possible.
+void* allocate_frame(std::size_t size);
+
+/// Gives a coroutine frame back to this thread's free list.
+void deallocate_frame(void* frame, std::size_t size);
+
+namespace detail
+{
+
+struct frame_allocated
+{
+    static void* operator new(std::size_t size) { return allocate_frame(size); }
+    static void operator delete(void* frame, std::size_t size) { deallocate_frame(frame, size); }
+};
+
+struct task_promise_base : frame_allocated
+{
+    std::coroutine_handle<> continuation;
+    std::exception_ptr error;
+
+    // Set by whichever of the awaiting coroutine and the task gets there second: the awaiter once it
+    // has started the task, the task once it has finished. That one resumes (or does not suspend) the
+    // awaiting coroutine, so a task that finishes at once never goes through the executor.
+    std::atomic<bool> ready{false};
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    struct final_awaiter
+    {
+        bool await_ready() noexcept { return false; }
+
+        template <typename Promise>
+        void await_suspend(std::coroutine_handle<Promise> task) noexcept
+        {
+            task_promise_base& promise = task.promise();
+            if (promise.ready.exchange(true, std::memory_order_acq_rel)) promise.continuation.resume();
+        }
+
+        void await_resume() noexcept {}
+    };
+
+    final_awaiter final_suspend() noexcept { return {}; }
+    void unhandled_exception() { error = std::current_exception(); }
+};
+
+}
+
+///
+/// A coroutine producing a T (or nothing, for task<void>).
+template <typename T = void>
+class task
+{
+public:
+    struct promise_type : detail::task_promise_base
+    {
+        std::optional<T> value;
+
+        task get_return_object() { return task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        void return_value(T result) { value.emplace(std::move(result)); }
+    };
+
+    task(task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+    task(const task&) = delete;
+    task& operator=(const task&) = delete;
+    ~task() { if (handle_) handle_.destroy(); }
+
+    bool await_ready() const noexcept { return false; }
+
+    bool await_suspend(std::coroutine_handle<> awaiting)
+    {
+        handle_.promise().continuation = awaiting;
+        handle_.resume();
+        return !handle_.promise().ready.exchange(true, std::memory_order_acq_rel);
+    }
+
+    T await_resume()
+    {
+        if (handle_.promise().error) std::rethrow_exception(handle_.promise().error);
+        return std::move(*handle_.promise().value);
+    }
+
+private:
+    explicit task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+template <>
+class task<void>
+{
+public:
+    struct promise_type : detail::task_promise_base
+    {
+        task get_return_object() { return task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        void return_void() {}
+    };
+
+    task(task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+    task(const task&) = delete;
+    task& operator=(const task&) = delete;
+    ~task() { if (handle_) handle_.destroy(); }
+
+    bool await_ready() const noexcept { return false; }
+
+    bool await_suspend(std::coroutine_handle<> awaiting)
+    {
+        handle_.promise().continuation = awaiting;
+        handle_.resume();
+        return !handle_.promise().ready.exchange(true, std::memory_order_acq_rel);
+    }
+
+    void await_resume()
+    {
+        if (handle_.promise().error) std::rethrow_exception(handle_.promise().error);
+    }
+
+private:
+    explicit task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+///
+/// Starts a task on an io_context. The task runs until it finishes, with nothing waiting on it; an
+/// exception escaping from it terminates the program.
+void spawn(boost::asio::io_context& io, task<void> work);
+
+}
+
+#endif /* TASK_HPP */
@@ -0,0 +1,454 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   tick_store.cpp
+ * Author: Chris Morrison
+ *
+ * Created on 19 October 2026, 09:40
+ */
+#include <cstring>
+#include <filesystem>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#include "fixed_point.hpp"
+#include "tick_store.hpp"
+
+namespace mercury
+{
+
+static const char file_magic[4] = { 'M', 'T', 'C', 'K' };
+static const uint32_t block_magic = 0x4b4c4254; // "TBLK"
+static const uint16_t file_version = 1;
+static const std::size_t file_header_size = 8;
+
+// ------------------------------------------------------------------------------------------------
+// Little-endian load/store helpers.
+// ------------------------------------------------------------------------------------------------
+
+static inline uint64_t load64(const uint8_t* p)
+{
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline void put32(std::vector<uint8_t>& out, uint32_t v)
+{
+    for (int i = 0; i < 4; ++i) out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+}
+
+static inline void put64(std::vector<uint8_t>& out, int64_t v)
+{
+    uint64_t u = static_cast<uint64_t>(v);
+    for (int i = 0; i < 8; ++i) out.push_back(static_cast<uint8_t>(u >> (8 * i)));
+}
+
+static inline uint32_t get32(const uint8_t* p)
+{
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+static inline int64_t get64(const uint8_t* p)
+{
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; --i) v = (v << 8) | p[i];
+    return static_cast<int64_t>(v);
+}
+
+static inline uint64_t zigzag(int64_t v)
+{
+    return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+static inline unsigned bit_width(uint64_t v)
+{
+    return v ? 64 - __builtin_clzll(v) : 0;
+}
+
+static inline std::size_t packed_bytes(std::size_t n, unsigned bits)
+{
+    return (n * bits + 7) / 8;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Bit packing.
+// ------------------------------------------------------------------------------------------------
+
+static void pack(const uint64_t* values, std::size_t n, unsigned bits, std::vector<uint8_t>& out)
+{
+    std::size_t start = out.size();
+
+    if (bits == 0) return;
+
+    out.resize(start + packed_bytes(n, bits), 0);
+    uint8_t* dst = out.data() + start;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        std::size_t bit = i * bits;
+        uint64_t v = values[i];
+        for (unsigned done = 0; done < bits;)
+        {
+            unsigned shift = (bit + done) & 7;
+            dst[(bit + done) >> 3] |= static_cast<uint8_t>(v << shift);
+            v >>= (8 - shift);
+            done += 8 - shift;
+        }
+    }
+}
+
+static void unpack(const uint8_t* src, std::size_t n, unsigned bits, uint64_t* out)
+{
+    if (bits == 0)
+    {
+        std::memset(out, 0, n * sizeof(uint64_t));
+        return;
+    }
+
+    const uint64_t mask = (bits == 64) ? ~0ULL : ((1ULL << bits) - 1);
+
+    // With at most 56 bits per value a single unaligned 64-bit load always covers the value, which
+    // keeps the loop branch free. Wider values may straddle two words.
+    if (bits <= 56)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            std::size_t bit = i * bits;
+            out[i] = (load64(src + (bit >> 3)) >> (bit & 7)) & mask;
+        }
+    }
+    else
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            std::size_t bit = i * bits;
+            unsigned shift = bit & 7;
+            uint64_t v = load64(src + (bit >> 3)) >> shift;
+            if (shift) v |= load64(src + (bit >> 3) + 8) << (64 - shift);
+            out[i] = v & mask;
+        }
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+// Zig-zag decoding and prefix sums; these dominate decode time so they get a vector path.
+// ------------------------------------------------------------------------------------------------
+
+static void unzigzag(uint64_t* v, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i) v[i] = (v[i] >> 1) ^ (0 - (v[i] & 1));
+}
+
+static void prefix_sum_scalar(uint64_t* v, std::size_t n, uint64_t base)
+{
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        base += v[i];
+        v[i] = base;
+    }
+}
+
+#if defined(__x86_64__)
+__attribute__((target("avx2")))
+static void prefix_sum_avx2(uint64_t* v, std::size_t n, uint64_t base)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i carry = _mm256_set1_epi64x(static_cast<long long>(base));
+    std::size_t i = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + i));
+        // [a b c d] + [0 a b c] + [0 0 a+b b+c]
+        __m256i s = _mm256_blend_epi32(_mm256_permute4x64_epi64(x, _MM_SHUFFLE(2, 1, 0, 0)), zero, 0x03);
+        x = _mm256_add_epi64(x, s);
+        s = _mm256_blend_epi32(_mm256_permute4x64_epi64(x, _MM_SHUFFLE(1, 0, 0, 0)), zero, 0x0F);
+        x = _mm256_add_epi64(x, s);
+        x = _mm256_add_epi64(x, carry);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(v + i), x);
+        carry = _mm256_permute4x64_epi64(x, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+
+    prefix_sum_scalar(v + i, n - i, i ? v[i - 1] : base);
+}
+#endif
+
+static void prefix_sum(uint64_t* v, std::size_t n, uint64_t base)
+{
+#if defined(__x86_64__)
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    if (has_avx2)
+    {
+        prefix_sum_avx2(v, n, base);
+        return;
+    }
+#endif
+    prefix_sum_scalar(v, n, base);
+}
+
+// ------------------------------------------------------------------------------------------------
+// Block encoding.
+// ------------------------------------------------------------------------------------------------
+
+void encode_tick_block(const int64_t* times, const int64_t* prices, std::size_t count, std::vector<uint8_t>& out)
+{
+    // Scratch space is kept per thread so that steady-state encoding does not allocate.
+    static thread_local std::vector<uint64_t> tz;
+    static thread_local std::vector<uint64_t> pz;
+    uint64_t tmax = 0;
+    uint64_t pmax = 0;
+    int64_t prev_delta = 0;
+
+    if (count == 0 || count > max_tick_block_size) return;
+
+    tz.resize(count - 1);
+    pz.resize(count - 1);
+    for (std::size_t i = 1; i < count; ++i)
+    {
+        int64_t delta = static_cast<int64_t>(static_cast<uint64_t>(times[i]) - static_cast<uint64_t>(times[i - 1]));
+        tz[i - 1] = zigzag(static_cast<int64_t>(static_cast<uint64_t>(delta) - static_cast<uint64_t>(prev_delta)));
+        pz[i - 1] = zigzag(static_cast<int64_t>(static_cast<uint64_t>(prices[i]) - static_cast<uint64_t>(prices[i - 1])));
+        prev_delta = delta;
+        tmax |= tz[i - 1];
+        pmax |= pz[i - 1];
+    }
+
+    unsigned tbits = bit_width(tmax);
+    unsigned pbits = bit_width(pmax);
+    std::size_t payload = packed_bytes(count - 1, tbits) + packed_bytes(count - 1, pbits);
+
+    put32(out, block_magic);
+    put32(out, static_cast<uint32_t>(count));
+    put32(out, static_cast<uint32_t>(payload));
+    out.push_back(static_cast<uint8_t>(tbits));
+    out.push_back(static_cast<uint8_t>(pbits));
+    out.push_back(0);
+    out.push_back(0);
+    put64(out, times[0]);
+    put64(out, times[count - 1]);
+    put64(out, prices[0]);
+    pack(tz.data(), count - 1, tbits, out);
+    pack(pz.data(), count - 1, pbits, out);
+}
+
+bool read_tick_block_info(const uint8_t* data, std::size_t len, tick_block_info& info)
+{
+    if (len < tick_block_header_size || get32(data) != block_magic) return false;
+
+    info.count = get32(data + 4);
+    info.payload_bytes = get32(data + 8);
+    info.first_time = get64(data + 16);
+    info.last_time = get64(data + 24);
+
+    // A corrupt header must not make the reader allocate more than a real block could need.
+    unsigned tbits = data[12];
+    unsigned pbits = data[13];
+    if (info.count == 0 || info.count > max_tick_block_size || tbits > 64 || pbits > 64) return false;
+
+    return packed_bytes(info.count - 1, tbits) + packed_bytes(info.count - 1, pbits) == info.payload_bytes;
+}
+
+bool decode_tick_block(const uint8_t* data, std::size_t len, std::vector<int64_t>& times, std::vector<int64_t>& prices)
+{
+    tick_block_info info;
+
+    if (!read_tick_block_info(data, len, info)) return false;
+
+    unsigned tbits = data[12];
+    unsigned pbits = data[13];
+    std::size_t n = info.count - 1;
+    std::size_t tbytes = packed_bytes(n, tbits);
+
+    if (len < tick_block_header_size + info.payload_bytes) return false;
+
+    const uint8_t* payload = data + tick_block_header_size;
+
+    times.resize(info.count);
+    prices.resize(info.count);
+    times[0] = get64(data + 16);
+    prices[0] = get64(data + 32);
+
+    uint64_t* t = reinterpret_cast<uint64_t*>(times.data() + 1);
+    uint64_t* p = reinterpret_cast<uint64_t*>(prices.data() + 1);
+
+    // Timestamps: delta-of-deltas -> deltas -> absolute times.
+    unpack(payload, n, tbits, t);
+    unzigzag(t, n);
+    prefix_sum(t, n, 0);
+    prefix_sum(t, n, static_cast<uint64_t>(times[0]));
+
+    // Prices: deltas -> absolute prices.
+    unpack(payload + tbytes, n, pbits, p);
+    unzigzag(p, n);
+    prefix_sum(p, n, static_cast<uint64_t>(prices[0]));
+
+    return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+// tick_store_writer
+// ------------------------------------------------------------------------------------------------
+
+tick_store_writer::~tick_store_writer()
+{
+    close();
+}
+
+bool tick_store_writer::open(const std::string& path, int price_decimals, std::size_t block_size)
+{
+    close();
+
+    if (price_decimals < 0 || price_decimals > max_decimals || block_size < 2 || block_size > max_tick_block_size) return false;
+
+    std::error_code ec;
+    bool exists = std::filesystem::exists(path, ec) && std::filesystem::file_size(path, ec) >= file_header_size;
+
+    if (exists)
+    {
+        char header[file_header_size];
+        std::ifstream in(path, std::ios::binary);
+        if (!in.read(header, file_header_size)) return false;
+        if (std::memcmp(header, file_magic, 4) != 0 || header[6] != price_decimals) return false;
+    }
+
+    file_.open(path, std::ios::binary | std::ios::out | std::ios::app);
+    if (!file_) return false;
+
+    if (!exists)
+    {
+        char header[file_header_size] = { file_magic[0], file_magic[1], file_magic[2], file_magic[3],
+                                          static_cast<char>(file_version & 0xFF), static_cast<char>(file_version >> 8),
+                                          static_cast<char>(price_decimals), 0 };
+        file_.write(header, file_header_size);
+    }
+
+    decimals_ = price_decimals;
+    block_size_ = block_size;
+    times_.clear();
+    prices_.clear();
+    times_.reserve(block_size_);
+    prices_.reserve(block_size_);
+    buffer_.reserve(tick_block_header_size + block_size_ * 16);
+
+    return static_cast<bool>(file_);
+}
+
+bool tick_store_writer::append(int64_t time_us, int64_t price)
+{
+    if (!file_.is_open()) return false;
+
+    times_.push_back(time_us);
+    prices_.push_back(price);
+
+    return (times_.size() >= block_size_) ? flush() : true;
+}
+
+bool tick_store_writer::append(int64_t time_us, const std::string& price)
+{
+    int64_t fixed;
+
+    if (!parse_fixed(price, decimals_, fixed)) return false;
+
+    return append(time_us, fixed);
+}
+
+bool tick_store_writer::flush()
+{
+    if (!file_.is_open()) return false;
+    if (times_.empty()) return true;
+
+    buffer_.clear();
+    encode_tick_block(times_.data(), prices_.data(), times_.size(), buffer_);
+    file_.write(reinterpret_cast<const char*>(buffer_.data()), static_cast<std::streamsize>(buffer_.size()));
+    file_.flush();
+    times_.clear();
+    prices_.clear();
+
+    return static_cast<bool>(file_);
+}
+
+void tick_store_writer::close()
+{
+    if (!file_.is_open()) return;
+
+    flush();
+    file_.close();
+}
+
+// ------------------------------------------------------------------------------------------------
+// tick_store_reader
+// ------------------------------------------------------------------------------------------------
+
+bool tick_store_reader::open(const std::string& path)
+{
+    char header[file_header_size];
+
+    file_.close();
+    file_.clear();
+    file_.open(path, std::ios::binary | std::ios::in);
+    if (!file_ || !file_.read(header, file_header_size)) return false;
+
+    // The decimals are read unsigned, so a corrupt byte cannot come out as a negative power of ten.
+    unsigned char decimals = static_cast<unsigned char>(header[6]);
+    if (std::memcmp(header, file_magic, 4) != 0 || header[4] != file_version || decimals > max_decimals)
+    {
+        file_.close();
+        return false;
+    }
+    decimals_ = decimals;
+
+    return true;
+}
+
+bool tick_store_reader::peek_block(tick_block_info& info)
+{
+    uint8_t header[tick_block_header_size];
+
+    if (!file_.is_open()) return false;
+
+    std::streampos pos = file_.tellg();
+    bool ok = static_cast<bool>(file_.read(reinterpret_cast<char*>(header), tick_block_header_size));
+    file_.clear();
+    file_.seekg(pos);
+
+    return ok && read_tick_block_info(header, tick_block_header_size, info);
+}
+
+bool tick_store_reader::skip_block()
+{
+    tick_block_info info;
+
+    if (!peek_block(info)) return false;
+    file_.seekg(static_cast<std::streamoff>(tick_block_header_size + info.payload_bytes), std::ios::cur);
+
+    return static_cast<bool>(file_);
+}
+
+bool tick_store_reader::next_block(std::vector<int64_t>& times, std::vector<int64_t>& prices)
+{
+    tick_block_info info;
+
+    if (!peek_block(info)) return false;
+
+    std::size_t len = tick_block_header_size + info.payload_bytes;
+    buffer_.resize(len + tick_block_padding);
+    std::memset(buffer_.data() + len, 0, tick_block_padding);
+    if (!file_.read(reinterpret_cast<char*>(buffer_.data()), static_cast<std::streamsize>(len))) return false;
+
+    return decode_tick_block(buffer_.data(), len, times, prices);
+}
+
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   tick_store.hpp
+ * Author: Chris Morrison
+ *
+ * Created on 19 October 2026, 09:40
+ */
+#ifndef TICK_STORE_HPP
+#define TICK_STORE_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <fstream>
+
+// ------------------------------------------------------------------------------------------------
+// Compressed tick files.
+//
+// A tick file is an 8 byte file header followed by a sequence of self-contained blocks. Each block
+// holds up to block_size ticks: timestamps (microseconds since the epoch) are stored as zig-zagged
+// delta-of-deltas and prices (fixed-point, see fixed_point.hpp) as zig-zagged deltas, both bit
+// packed at the narrowest width that fits the block. Every block carries its own base values, so
+// any block can be decoded without reading the ones before it.
+// ------------------------------------------------------------------------------------------------
+
+namespace mercury
+{
+
+/// Default number of ticks stored in a block.
+constexpr std::size_t default_tick_block_size = 1024;
+
+/// Most ticks a block may hold; a block header that claims more is treated as corrupt.
+constexpr std::size_t max_tick_block_size = 65536;
+
+/// Number of readable bytes decode_tick_block() needs beyond the end of the block payload.
+constexpr std::size_t tick_block_padding = 16;
+
+/// Size in bytes of the header in front of every block.
+constexpr std::size_t tick_block_header_size = 40;
+
+/// Summary of a block, available without decoding its payload.
+struct tick_block_info
+{
+    uint32_t count = 0;
+    uint32_t payload_bytes = 0;
+    int64_t first_time = 0;
+    int64_t last_time = 0;
+};
+
+///
+/// Encodes a block of ticks, appending the block header and payload to out.
+///
+/// \param times  Timestamps in microseconds.
+/// \param prices Fixed-point prices.
+/// \param count  Number of ticks, from 1 to max_tick_block_size.
+/// \param out    Receives the encoded block.
+void encode_tick_block(const int64_t* times, const int64_t* prices, std::size_t count, std::vector<uint8_t>& out);
+
+///
+/// Reads the header at the start of an encoded block.
+///
+/// \return false if the data does not start with a valid block header: one that claims no ticks, more
+///         than max_tick_block_size, or a payload size that does not match its bit widths.
+bool read_tick_block_info(const uint8_t* data, std::size_t len, tick_block_info& info);
+
+///
+/// Decodes one block. The buffer must have tick_block_padding readable bytes after the payload.
+///
+/// \param data   Start of the block header.
+/// \param len    Bytes available from data, not counting the padding.
+/// \param times  Receives the timestamps.
+/// \param prices Receives the prices.
+/// \return false if the block is truncated or corrupted.
+bool decode_tick_block(const uint8_t* data, std::size_t len, std::vector<int64_t>& times, std::vector<int64_t>& prices);
+
+///
+/// Appends ticks to a compressed tick file.
+class tick_store_writer
+{
+public:
+    tick_store_writer() = default;
+    tick_store_writer(const tick_store_writer&) = delete;
+    tick_store_writer& operator=(const tick_store_writer&) = delete;
+    ~tick_store_writer();
+
+    ///
+    /// Opens (or creates) a tick file for appending.
+    ///
+    /// \param path           File to write to.
+    /// \param price_decimals Fixed-point precision of the prices; must match an existing file.
+    /// \param block_size     Number of ticks to buffer before a block is written, from 2 to max_tick_block_size.
+    /// \return false if the file cannot be opened or was written with a different precision.
+    bool open(const std::string& path, int price_decimals = 8, std::size_t block_size = default_tick_block_size);
+
+    bool is_open() const { return file_.is_open(); }
+    int price_decimals() const { return decimals_; }
+
+    /// Adds a tick with a fixed-point price.
+    bool append(int64_t time_us, int64_t price);
+
+    /// Adds a tick with a price as returned by the trade context.
+    bool append(int64_t time_us, const std::string& price);
+
+    /// Writes out any buffered ticks as a (possibly short) block.
+    bool flush();
+
+    /// Flushes and closes the file.
+    void close();
+
+private:
+    std::ofstream file_;
+    int decimals_ = 8;
+    std::size_t block_size_ = default_tick_block_size;
+    std::vector<int64_t> times_;
+    std::vector<int64_t> prices_;
+    std::vector<uint8_t> buffer_;
+};
+
+///
+/// Reads blocks back from a compressed tick file.
+class tick_store_reader
+{
+public:
+    /// Opens a tick file and validates its header.
+    bool open(const std::string& path);
+
+    bool is_open() const { return file_.is_open(); }
+    int price_decimals() const { return decimals_; }
+
+    /// Returns the header of the next block without consuming it.
+    bool peek_block(tick_block_info& info);
+
+    /// Moves past the next block without decoding it.
+    bool skip_block();
+
+    /// Decodes the next block into the given vectors, reusing their storage.
+    bool next_block(std::vector<int64_t>& times, std::vector<int64_t>& prices);
+
+private:
+    std::ifstream file_;
+    int decimals_ = 8;
+    std::vector<uint8_t> buffer_;
+};
+
+}
+
+#endif /* TICK_STORE_HPP */
@@ -0,0 +1,240 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   tick_store_test.cpp
+ * Author: Chris Morrison
+ *
+ * Created on 20 October 2026, 18:40
+ */
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <string>
+#include <vector>
+#include "tick_store.hpp"
+#include "unit_test.hpp"
+
+using namespace mercury;
+
+// Where the fields of a block header are, as written by encode_tick_block().
+static const std::size_t count_offset = 4;
+static const std::size_t payload_offset = 8;
+static const std::size_t time_bits_offset = 12;
+static const std::size_t price_bits_offset = 13;
+
+///
+/// Makes a run of ticks that looks like a market: irregular gaps, with the odd long pause, and prices
+/// that mostly move a few ticks and sometimes jump either way. The generator is fixed, so every run of
+/// the test sees the same ticks.
+static void make_ticks(std::size_t count, std::vector<int64_t>& times, std::vector<int64_t>& prices)
+{
+    uint64_t state = 0x2545F4914F6CDD1DULL;
+    auto next = [&state]() {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return state >> 33;
+    };
+
+    times.resize(count);
+    prices.resize(count);
+    int64_t time = 1760000000000000LL;
+    int64_t price = 812345000000LL;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        uint64_t r = next();
+        time += static_cast<int64_t>(r % 250000) + ((r % 97 == 0) ? 60000000 : 0);
+        price += static_cast<int64_t>(r % 21) - 10 + ((r % 53 == 0) ? 50000000 : 0) - ((r % 59 == 0) ? 50000000 : 0);
+        times[i] = time;
+        prices[i] = price;
+    }
+}
+
+// Encodes a block and adds the padding decode_tick_block() needs; gives the length without the padding.
+static std::size_t encode(const std::vector<int64_t>& times, const std::vector<int64_t>& prices, std::vector<uint8_t>& block)
+{
+    block.clear();
+    encode_tick_block(times.data(), prices.data(), times.size(), block);
+    std::size_t len = block.size();
+    block.resize(len + tick_block_padding, 0);
+    return len;
+}
+
+static bool round_trips(const std::vector<int64_t>& times, const std::vector<int64_t>& prices)
+{
+    std::vector<uint8_t> block;
+    std::vector<int64_t> t;
+    std::vector<int64_t> p;
+    std::size_t len = encode(times, prices, block);
+
+    return decode_tick_block(block.data(), len, t, p) && t == times && p == prices;
+}
+
+static void test_round_trip()
+{
+    std::vector<int64_t> times;
+    std::vector<int64_t> prices;
+
+    for (std::size_t count : { std::size_t(1), std::size_t(2), std::size_t(3), std::size_t(17), default_tick_block_size, max_tick_block_size })
+    {
+        make_ticks(count, times, prices);
+        CHECK(round_trips(times, prices));
+    }
+
+    // Ticks that do not move pack into no bits at all.
+    CHECK(round_trips({ 5, 10, 15, 20, 25 }, { 7, 7, 7, 7, 7 }));
+
+    // Time running backwards and values at the ends of the range still come back exactly.
+    const int64_t low = std::numeric_limits<int64_t>::min();
+    const int64_t high = std::numeric_limits<int64_t>::max();
+    CHECK(round_trips({ 100, 50, 200, 0, high, low }, { high, low, 0, -1, 1, high }));
+}
+
+static void test_block_info()
+{
+    std::vector<int64_t> times;
+    std::vector<int64_t> prices;
+    std::vector<uint8_t> block;
+    tick_block_info info;
+
+    make_ticks(300, times, prices);
+    std::size_t len = encode(times, prices, block);
+
+    CHECK(read_tick_block_info(block.data(), len, info));
+    CHECK(info.count == 300);
+    CHECK(info.first_time == times.front());
+    CHECK(info.last_time == times.back());
+    CHECK(tick_block_header_size + info.payload_bytes == len);
+}
+
+static void test_encode_rejects()
+{
+    std::vector<int64_t> times;
+    std::vector<int64_t> prices;
+    std::vector<uint8_t> block;
+
+    make_ticks(max_tick_block_size + 1, times, prices);
+    encode_tick_block(times.data(), prices.data(), 0, block);
+    CHECK(block.empty());
+    encode_tick_block(times.data(), prices.data(), times.size(), block);
+    CHECK(block.empty());
+}
+
+static void put32(std::vector<uint8_t>& block, std::size_t offset, uint32_t value)
+{
+    for (int i = 0; i < 4; ++i) block[offset + i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+// Corrupts a copy of a good block and checks that neither reading its header nor decoding it succeeds.
+template <typename Damage>
+static bool rejected(const std::vector<uint8_t>& good, std::size_t len, Damage damage)
+{
+    std::vector<uint8_t> block = good;
+    std::vector<int64_t> t;
+    std::vector<int64_t> p;
+    tick_block_info info;
+
+    damage(block, len);
+
+    return !read_tick_block_info(block.data(), len, info) && !decode_tick_block(block.data(), len, t, p);
+}
+
+static void test_corrupt_input()
+{
+    std::vector<int64_t> times;
+    std::vector<int64_t> prices;
+    std::vector<uint8_t> good;
+    std::vector<int64_t> t;
+    std::vector<int64_t> p;
+    tick_block_info info;
+
+    make_ticks(100, times, prices);
+    std::size_t len = encode(times, prices, good);
+
+    CHECK(rejected(good, len, [](std::vector<uint8_t>& b, std::size_t&) { b[0] ^= 0xFF; }));
+    CHECK(rejected(good, len, [](std::vector<uint8_t>& b, std::size_t&) { put32(b, count_offset, 0); }));
+    CHECK(rejected(good, len, [](std::vector<uint8_t>& b, std::size_t&) { put32(b, count_offset, max_tick_block_size + 1); }));
+    CHECK(rejected(good, len, [](std::vector<uint8_t>& b, std::size_t&) { put32(b, count_offset, 0xFFFFFFFF); }));
+    CHECK(rejected(good, len, [](std::vector<uint8_t>& b, std::size_t&) { put32(b, count_offset, 101); }));
+    CHECK(rejected(good, len, [](std::vector<uint8_t>& b, std::size_t&) { put32(b, payload_offset, 0xFFFFFFFF); }));
+    CHECK(rejected(good, len, [](std::vector<uint8_t>& b, std::size_t&) { b[time_bits_offset] = 65; }));
+    CHECK(rejected(good, len, [](std::vector<uint8_t>& b, std::size_t&) { b[price_bits_offset] = 0xFF; }));
+
+    // A header the reader cannot see all of.
+    CHECK(!read_tick_block_info(good.data(), tick_block_header_size - 1, info));
+    CHECK(!decode_tick_block(good.data(), tick_block_header_size - 1, t, p));
+
+    // A complete header whose payload is cut short.
+    CHECK(read_tick_block_info(good.data(), tick_block_header_size, info));
+    CHECK(!decode_tick_block(good.data(), len - 1, t, p));
+    CHECK(!decode_tick_block(good.data(), tick_block_header_size, t, p));
+
+    CHECK(decode_tick_block(good.data(), len, t, p) && t == times && p == prices);
+}
+
+static void test_file_round_trip()
+{
+    const std::string path = (std::filesystem::temp_directory_path() / "mercury_tick_store_test.ticks").string();
+    std::vector<int64_t> times;
+    std::vector<int64_t> prices;
+    std::filesystem::remove(path);
+
+    make_ticks(10, times, prices);
+
+    tick_store_writer writer;
+    CHECK(!writer.open(path, 8, 1));
+    CHECK(!writer.open(path, 8, max_tick_block_size + 1));
+    CHECK(writer.open(path, 8, 4));
+    for (std::size_t i = 0; i < times.size(); ++i) CHECK(writer.append(times[i], prices[i]));
+    CHECK(!writer.append(times.back(), std::string("not a price")));
+    writer.close();
+
+    // A file written with one precision cannot be appended to with another.
+    CHECK(!writer.open(path, 2, 4));
+
+    tick_store_reader reader;
+    tick_block_info info;
+    std::vector<int64_t> t;
+    std::vector<int64_t> p;
+    std::vector<int64_t> all_times;
+    std::vector<int64_t> all_prices;
+
+    CHECK(reader.open(path));
+    CHECK(reader.price_decimals() == 8);
+    CHECK(reader.peek_block(info) && info.count == 4);
+    CHECK(reader.skip_block());
+    CHECK(reader.next_block(t, p) && t.size() == 4);
+    all_times.insert(all_times.end(), t.begin(), t.end());
+    all_prices.insert(all_prices.end(), p.begin(), p.end());
+    CHECK(reader.next_block(t, p) && t.size() == 2);
+    all_times.insert(all_times.end(), t.begin(), t.end());
+    all_prices.insert(all_prices.end(), p.begin(), p.end());
+    CHECK(!reader.next_block(t, p));
+
+    CHECK(all_times == std::vector<int64_t>(times.begin() + 4, times.end()));
+    CHECK(all_prices == std::vector<int64_t>(prices.begin() + 4, prices.end()));
+
+    std::filesystem::remove(path);
+}
+
+int main()
+{
+    test_round_trip();
+    test_block_info();
+    test_encode_rejects();
+    test_corrupt_input();
+    test_file_round_trip();
+
+    return test_result("tick_store");
+}
@@ -0,0 +1,1009 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   trader.cpp
+ * Author: Chris Morrison
+ *
+ * Created on 19 October 2026, 18:45
+ */
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <boost/thread/lock_guard.hpp>
+#include "fixed_point.hpp"
+#include "trader.hpp"
+
+namespace mercury
+{
+
+using namespace cryptocoin::trading;
+
+// The result of a co_await is always stored in a local before it is tested: GCC 12 mis-compiles some
+// co_await expressions used directly as conditions.
+
+///
+/// Writes the local time into a buffer, the heap-free stand-in for utilities::timestamp().
+static const char* stamp(char (&buf)[32])
+{
+    std::time_t now = std::time(nullptr);
+    std::tm local;
+
+    localtime_r(&now, &local);
+    if (std::strftime(buf, sizeof(buf), "%d/%m/%Y %H:%M:%S", &local) == 0) buf[0] = '\0';
+
+    return buf;
+}
+
+// Used by VWAP orders until a profile is set.
+static const volume_profile flat_profile;
+
+trader::trader(const trader_settings& settings, boost::mutex& log_mutex, std::ostream& log)
+    : settings_(settings), mtx_(log_mutex), log_(log), profile_(&flat_profile)
+{
+    // Sized once up front so the strings never need to grow in the trading loop.
+    price_.reserve(64);
+    balance_.reserve(64);
+    size_.reserve(64);
+    order_price_.reserve(64);
+    uuid_.reserve(64);
+    quantity_.reserve(64);
+}
+
+template <typename... Args>
+void trader::note(const Args&... args)
+{
+    char buf[32];
+    boost::lock_guard<boost::mutex> lock(mtx_);
+
+    log_ << stamp(buf) << ' ';
+    (log_ << ... << args) << std::endl;
+}
+
+static int64_t now_us()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+task<void> trader::pause(async_exchange& exchange, std::chrono::seconds duration, span_kind reason)
+{
+    if (skip_waits_) co_return;
+
+    // An exit that fired since the last wait is acted on straight away rather than at the next check.
+    if (exit_pending_ && !exit_posted_ && reason == span_kind::order_check) co_return;
+
+    // Kept so that a snapshot taken during the wait knows when it ends.
+    resume_at_us_ = now_us() + std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    int64_t started = profiler_ ? profile_now() : 0;
+    co_await exchange.wait(duration, &waiting_);
+    if (profiler_) profiler_->record(profile_track_, reason, started, profile_now());
+    resume_at_us_ = 0;
+}
+
+void trader::announce_fill(cryptocoin::trading::order_side side)
+{
+    if (!fill_) return;
+
+    // The announcement blocks the io_context thread (and so every other trader) while it plays.
+    int64_t started = profiler_ ? profile_now() : 0;
+    fill_(side);
+    if (profiler_) profiler_->record(profile_track_, span_kind::fill_announcement, started, profile_now());
+}
+
+void trader::open_position(long double entry)
+{
+    entry_price_ = static_cast<double>(entry);
+    entry_us_ = now_us();
+    exit_pending_ = false;
+    exit_posted_ = false;
+    if (exits_) exits_->arm(*this, entry_price_, entry_us_, settings_.exits);
+}
+
+void trader::close_position()
+{
+    if (exits_) exits_->disarm(*this);
+    entry_price_ = 0.0;
+    entry_us_ = 0;
+    exit_pending_ = false;
+    exit_posted_ = false;
+}
+
+void trader::exit_triggered(exit_reason reason, double price)
+{
+    // The engine has let go of the position, so a restart must not guard it again.
+    entry_price_ = 0.0;
+    entry_us_ = 0;
+    exit_pending_ = true;
+    exit_posted_ = false;
+
+    if (price > 0.0)
+        note("Exit: the ", exit_reason_name(reason), " fired at ", price, " ", order_.fiat, " - selling at the best bid.");
+    else
+        note("Exit: the ", exit_reason_name(reason), " fired - selling at the best bid.");
+
+    if (waiting_) waiting_->cancel();
+}
+
+bool trader::open(const std::string& work_order_path)
+{
+    if (!file_.open(work_order_path))
+    {
+        note("Fatal error: failed to open the work order file: ", std::strerror(errno));
+        return false;
+    }
+
+    if (!file_.read(order_))
+    {
+        note("Fatal error: the work order file did not contain the expected information and may be corrupted or damaged.");
+        return false;
+    }
+
+    if (!plan_.parse(order_.execution))
+    {
+        note("Fatal error: the execution plan '", order_.execution, "' in the work order file is not valid.");
+        return false;
+    }
+
+    const char* name = order_.strategy[0] ? order_.strategy : settings_.strategy_name.c_str();
+    const strategy* chosen = find_strategy(name);
+    bool found = (chosen != nullptr);
+    if (found) strategy_ = chosen->kind;
+    if (!found && plugins_ && plugins_->has(name))
+    {
+        plugin_ = plugins_->attach(name);
+        found = (plugin_ != nullptr);
+        strategy_ = strategy_kind::plugin;
+    }
+    if (!found)
+    {
+        note("Fatal error: there is no strategy called '", name, "'.");
+        return false;
+    }
+
+    return true;
+}
+
+task<bool> trader::fetch_price(async_exchange& exchange, long double& value)
+{
+    co_await exchange.read_current_price(price_);
+    if (price_.empty()) co_return false;
+
+    value = std::strtold(price_.c_str(), nullptr);
+    observe_price(value);
+
+    co_return true;
+}
+
+task<bool> trader::fetch_bid(async_exchange& exchange, long double& value)
+{
+    // Without a bid from the exchange, the last trade price is the best guess at where the market is.
+    bool known = co_await exchange.get_ticker(ticker_);
+    long double bid = known ? std::strtold(ticker_.bid.c_str(), nullptr) : 0;
+    if (bid <= 0) co_return co_await fetch_price(exchange, value);
+
+    price_.assign(ticker_.bid);
+    value = bid;
+    co_return true;
+}
+
+void trader::observe_price(long double value)
+{
+    indicators_.update(static_cast<double>(value));
+    candles_.update(now_us(), static_cast<double>(value));
+    if (position_) position_->mark(value);
+    if (exits_) exits_->update(static_cast<double>(value), now_us());
+    if (plugin_) plugin_->tick(now_us(), static_cast<double>(value));
+
+    if (!recorder_ || !recorder_->is_open()) return;
+
+    recorder_->append(now_us(), price_);
+}
+
+void trader::set_ledger(trade_ledger* ledger)
+{
+    ledger_ = ledger;
+    position_ = nullptr;
+    pair_.assign(order_.coin).append("-").append(order_.fiat);
+    if (ledger_) position_ = &ledger_->book(pair_);
+}
+
+task<void> trader::record_fill(async_exchange& exchange, order_side side, bool completed)
+{
+    if (!ledger_ && !parent_.active()) co_return;
+
+    // A child of a sliced order is settled with what it traded, which for one that was cancelled may
+    // be nothing at all.
+    const child_order* child = parent_.working();
+    bool found = co_await exchange.get_fill(uuid_, filled_);
+    if (!found)
+    {
+        if (completed && ledger_) note("Warning: the details of order ", uuid_, " could not be retrieved - the fill is missing from the ledger.");
+        if (child && completed) parent_.finish_child(child->size, child->size * child->price);
+        if (child && !completed) parent_.finish_child(0.0, 0.0);
+        co_return;
+    }
+
+    fill f;
+    f.time_us = now_us();
+    f.side = side;
+    f.size = std::strtold(filled_.size.c_str(), nullptr);
+    f.value = std::strtold(filled_.value.c_str(), nullptr);
+    f.fee = std::strtold(filled_.fee.c_str(), nullptr);
+
+    if (child) parent_.finish_child(static_cast<double>(f.size), static_cast<double>(f.value));
+    if (!ledger_ || f.size <= 0) co_return;
+
+    if (!ledger_->record(pair_, f, uuid_)) note("Warning: failed to write to the ledger: ", std::strerror(errno));
+}
+
+// How often a resting exit sell is checked against the best bid.
+static const std::chrono::seconds exit_check_interval(10);
+
+static std::chrono::seconds until(int64_t when_us)
+{
+    int64_t left = when_us - now_us();
+    return std::chrono::seconds((left > 0) ? (left + 999999) / 1000000 : 0);
+}
+
+std::chrono::seconds trader::check_interval() const
+{
+    std::chrono::seconds check = std::chrono::minutes(settings_.check_minutes);
+
+    // A working child is checked again when its slice ends, if that comes first.
+    const child_order* child = parent_.working();
+    if (child && until(child->until_us) < check) check = until(child->until_us);
+
+    return check;
+}
+
+bool trader::quantise_child(double size)
+{
+    char text[32];
+
+    if (std::snprintf(text, sizeof(text), "%.8f", size) >= int(sizeof(text))) return false;
+    quantity_.assign(text);
+
+    return product_.quantise_size(quantity_, size_);
+}
+
+task<trader::slice_step> trader::next_child(async_exchange& exchange, const char* side_name)
+{
+    int64_t now = now_us();
+    double available = std::strtod(size_.c_str(), nullptr);
+
+    if (!parent_.active())
+    {
+        parent_.start(available, now, plan_);
+        note("Working the ", side_name, " of ", size_, " ", order_.coin, " in ", plan_.slices, " slices ", plan_.interval_minutes,
+             " minutes apart.");
+    }
+
+    // What is left, or as much of it as can be traded now, must still make an order of its own.
+    double left = std::min(parent_.remaining(), available);
+    if (parent_.full() || !quantise_child(left)) co_return slice_step::done;
+
+    double volume = 0.0;
+    if (plan_.participation > 0.0)
+    {
+        bool known = co_await exchange.get_ticker(ticker_);
+        if (known) volume = std::strtod(ticker_.volume.c_str(), nullptr);
+    }
+
+    double size = std::min(parent_.next_size(now, *profile_, volume), available);
+    if (size <= 0.0) co_return slice_step::wait;
+
+    // Never leave a tail too small to trade. A child below the minimum order size waits for the
+    // schedule to catch up, unless the schedule has run out.
+    double minimum = double(product_.base_min_size) / double(power_of_ten(product_.size_decimals));
+    if (left - size < minimum) size = left;
+    if (size < minimum && !parent_.last_slice(now)) co_return slice_step::wait;
+    if (size < minimum) size = minimum;
+    if (!quantise_child(size)) co_return slice_step::wait;
+
+    co_return slice_step::post;
+}
+
+task<bool> trader::after_child(async_exchange& exchange, order_side side)
+{
+    if (parent_.remaining() <= 0.0 || parent_.full()) co_return co_await finish_parent(exchange, side);
+
+    if (!save((side == cryptocoin::trading::buy) ? "BUY" : "SELL", order_.price)) co_return false;
+    note("Child order ", parent_.children(), " has completed - ", parent_.remaining(), " ", order_.coin, " left to ",
+         (side == cryptocoin::trading::buy) ? "buy." : "sell.");
+    co_return true;
+}
+
+task<bool> trader::finish_parent(async_exchange& exchange, order_side side)
+{
+    long double average = parent_.average_price();
+    double traded = parent_.filled();
+
+    parent_.clear();
+    if (traded <= 0.0)
+    {
+        note("Warning: the sliced order traded nothing - starting it again in 30 seconds.");
+        if (!save((side == cryptocoin::trading::buy) ? "BUY" : "SELL", order_.price)) co_return false;
+        co_await pause(exchange, std::chrono::seconds(30), span_kind::order_rejected);
+        co_return true;
+    }
+
+    note("The sliced ", (side == cryptocoin::trading::buy) ? "buy" : "sell", " has completed: ", traded, " ", order_.coin, " at an average of ",
+         static_cast<double>(average), " ", order_.fiat, ".");
+    if (side == cryptocoin::trading::buy)
+    {
+        open_position(average);
+        long double rate = co_await exchange.sell_price_adjustment();
+        co_return save_target("SELL", decide([&](auto s) { return s.sell_after_buy(average, rate, inputs()); }));
+    }
+
+    close_position();
+    long double rate = co_await exchange.buy_price_ajustment();
+    co_return save_target("BUY", decide([&](auto s) { return s.buy_after_sell(average, rate, inputs()); }));
+}
+
+bool trader::save_target(const char* action, long double price)
+{
+    // The target is quantised like any order price: down for a buy, up for a sell.
+    bool selling = (std::strcmp(action, "SELL") == 0);
+    bool valid = selling ? product_.price_up(price, new_price_, sizeof(new_price_))
+                         : product_.price_down(price, new_price_, sizeof(new_price_));
+    if (!valid)
+    {
+        note("Fatal error: the strategy chose ", static_cast<double>(price), " as the next ", selling ? "sell" : "buy",
+             " price, which is not a valid price for ", product_.id, ".");
+        return false;
+    }
+    return save(action, new_price_);
+}
+
+bool trader::save(const char* action, const char* price, const char* uuid)
+{
+    if (!order_.set(action, price, uuid) || !file_.write(order_))
+    {
+        note("Fatal error: failed to update the work order file.");
+        return false;
+    }
+
+    // Leaving a wait means the order filled or was cancelled; either way its funds are no longer held.
+    if (portfolio_ && (order_.is("BUY") || order_.is("SELL"))) portfolio_->release(member_);
+    return true;
+}
+
+task<bool> trader::step(async_exchange& exchange)
+{
+    // The second parameter is always the action we are required to take and will be on of the following
+    // BUY
+    // SELL
+    // WFB
+    // WFS
+    int64_t started = profiler_ ? profile_now() : 0;
+    span_kind state;
+    bool running;
+
+    if (order_.is("BUY"))
+    {
+        state = span_kind::buy;
+        running = co_await buy(exchange);
+    }
+    else if (order_.is("WFB"))
+    {
+        state = span_kind::wait_for_buy;
+        running = co_await wait_for_buy(exchange);
+    }
+    else if (order_.is("SELL"))
+    {
+        state = span_kind::sell;
+        running = co_await sell(exchange);
+    }
+    else if (order_.is("WFS"))
+    {
+        state = span_kind::wait_for_sell;
+        running = co_await wait_for_sell(exchange);
+    }
+    else
+    {
+        file_.close();
+        co_return false;
+    }
+
+    if (profiler_) profiler_->record(profile_track_, state, started, profile_now());
+    co_return running;
+}
+
+task<void> trader::run(async_exchange& exchange)
+{
+    bool running = true;
+
+    // A position restored from a snapshot is guarded from where it was opened.
+    if (exits_ && entry_price_ > 0.0 && (order_.is("SELL") || order_.is("WFS")))
+        exits_->arm(*this, entry_price_, entry_us_, settings_.exits);
+
+    int64_t left_us = resume_at_us_ - now_us();
+    if (resume_at_us_ != 0 && left_us > 0 && !skip_waits_)
+    {
+        note("Resuming the wait left by the last run - next step in ", (left_us + 999999) / 1000000, " seconds.");
+        int64_t started = profiler_ ? profile_now() : 0;
+        co_await exchange.wait(std::chrono::ceil<std::chrono::seconds>(std::chrono::microseconds(left_us)));
+        if (profiler_) profiler_->record(profile_track_, span_kind::restart_wait, started, profile_now());
+    }
+    resume_at_us_ = 0;
+
+    while (running) running = co_await step(exchange);
+}
+
+void trader::save_state(snapshot_writer& out) const
+{
+    out.put(order_.coin);
+    out.put(order_.action);
+    out.put(order_.fiat);
+    out.put(order_.price);
+    out.put(order_.uuid);
+    out.put(resume_at_us_);
+    out.put(entry_price_);
+    out.put(entry_us_);
+    out.put(uint32_t(exit_pending_ ? (exit_posted_ ? 2 : 1) : 0));
+    parent_.save(out);
+    indicators_.save(out);
+    candles_.save(out);
+}
+
+bool trader::restore_state(snapshot_reader& in, int64_t /* snapshot_us */)
+{
+    work_order saved;
+    int64_t resume_at = 0;
+    double entry_price = 0.0;
+    int64_t entry_us = 0;
+    uint32_t exit_pending = 0;
+
+    if (!in.get(saved.coin, sizeof(saved.coin)) || !in.get(saved.action, sizeof(saved.action)) ||
+        !in.get(saved.fiat, sizeof(saved.fiat)) || !in.get(saved.price, sizeof(saved.price)) ||
+        !in.get(saved.uuid, sizeof(saved.uuid)) || !in.get(resume_at) || !in.get(entry_price) || !in.get(entry_us) ||
+        !in.get(exit_pending))
+    {
+        return false;
+    }
+
+    parent_order parent;
+    if (!parent.load(in)) return false;
+
+    // Price history is only any use for the same pair.
+    if (std::strcmp(saved.coin, order_.coin) != 0 || std::strcmp(saved.fiat, order_.fiat) != 0) return false;
+
+    // The indicators load into a copy and the candles load all or nothing, so a failure leaves both as they were.
+    market_indicators indicators = indicators_;
+    if (!indicators.load(in) || !candles_.load(in)) return false;
+    indicators_ = std::move(indicators);
+
+    if (std::strcmp(saved.action, order_.action) == 0 && std::strcmp(saved.price, order_.price) == 0 &&
+        std::strcmp(saved.uuid, order_.uuid) == 0)
+    {
+        resume_at_us_ = resume_at;
+        entry_price_ = entry_price;
+        entry_us_ = entry_us;
+        exit_pending_ = (exit_pending != 0);
+        exit_posted_ = (exit_pending == 2);
+        parent_ = parent;
+    }
+
+    return true;
+}
+
+// ============================================================================================
+// We need to buy some coin at the price in the work order file.
+// ============================================================================================
+task<bool> trader::buy(async_exchange& exchange)
+{
+    long double bp = std::strtold(order_.price, nullptr);
+    long double cp = 0;
+
+    order_price_.assign(order_.price);
+    bool priced = co_await fetch_price(exchange, cp);
+    if (!priced)
+    {
+        note("Warning: a temporary network error occurred - retrying in 1 minute.");
+        co_await pause(exchange, std::chrono::minutes(1), span_kind::network_error);
+        co_return true;
+    }
+
+    // If the current price has dropped below our buy price then update our buy price.
+    if (decide([&](auto s) { return s.buy_at_market(bp, cp, inputs()); }))
+    {
+        order_price_.assign(price_);
+        bp = cp;
+        note("Updated buy price to current, better price of ", price_, " ", order_.fiat);
+    }
+
+    // Do not try to catch a falling market, wait for it to settle first.
+    if (decide([&](auto s) { return s.defer_buy(inputs()); }))
+    {
+        note("Note: the market is falling sharply - deferring the buy for 1 minute.");
+        co_await pause(exchange, std::chrono::minutes(1), span_kind::market_deferral);
+        co_return true;
+    }
+
+    // Work out order size.
+    uint64_t read_stamp = portfolio_ ? portfolio_->balance_stamp(member_, holding::fiat) : 0;
+    co_await exchange.read_fiat_balance(balance_);
+    if (balance_.empty())
+    {
+        note("Warning: failed to retrieve balance from server - retrying in 30 seconds.");
+        co_await pause(exchange, std::chrono::seconds(30), span_kind::query_retry);
+        co_return true;
+    }
+    long double bal = std::strtold(balance_.c_str(), nullptr);
+    if (portfolio_)
+    {
+        if (!portfolio_->update_balance(member_, holding::fiat, bal, read_stamp))
+        {
+            note("Note: another order was posted while the ", order_.fiat, " balance was read - reading it again.");
+            co_await pause(exchange, std::chrono::seconds(1), span_kind::query_retry);
+            co_return true;
+        }
+        long double budget = portfolio_->budget(member_, holding::fiat);
+        if (budget < 5.00 && portfolio_->share(member_, holding::fiat) >= 5.00)
+        {
+            note("Note: the pair's share of the ", order_.fiat, " balance is held by other orders - checking again in 1 minute.");
+            co_await pause(exchange, std::chrono::minutes(1), span_kind::insufficient_funds);
+            co_return true;
+        }
+        bal = budget;
+    }
+    if (bal < 5.00)
+    {
+        if (parent_.filled() > 0.0) co_return co_await finish_parent(exchange, cryptocoin::trading::buy);
+        note("Fiat fiat_balance is less than 5.00 ", order_.fiat, " - trading impossible.");
+        co_return false;
+    }
+    // Get the part of the fiat fiat_balance that we are allowed to use.
+    bal = decide([&](auto s) { return s.buy_funds(bal, inputs()); });
+
+    // Size the order to the product's increments; the price rounds down so we never overspend.
+    bool have_rules = co_await exchange.get_product_info(product_);
+    if (!have_rules)
+    {
+        note("Warning: failed to retrieve product information from server - retrying in 30 seconds.");
+        co_await pause(exchange, std::chrono::seconds(30), span_kind::query_retry);
+        co_return true;
+    }
+    product_.quantise_price(order_price_.c_str(), false, price_);
+    order_price_.assign(price_);
+    bp = std::strtold(order_price_.c_str(), nullptr);
+    if (!product_.size_for_funds(bal, bp, size_))
+    {
+        if (parent_.filled() > 0.0) co_return co_await finish_parent(exchange, cryptocoin::trading::buy);
+        note("The usable fiat balance is below the minimum order size for ", product_.id, " - trading impossible.");
+        co_return false;
+    }
+
+    // A sliced buy posts the next child of the parent, once it is due.
+    int64_t child_until = 0;
+    if (plan_.sliced())
+    {
+        slice_step next = co_await next_child(exchange, "buy");
+        if (next == slice_step::done) co_return co_await finish_parent(exchange, cryptocoin::trading::buy);
+        if (next == slice_step::wait)
+        {
+            co_await pause(exchange, until(parent_.next_slice_us(now_us())), span_kind::slice_wait);
+            co_return true;
+        }
+        child_until = parent_.next_slice_us(now_us());
+    }
+
+    // Take the funds out of the pair's budget before posting, so that no other work order can spend them.
+    if (portfolio_ && !portfolio_->reserve(member_, holding::fiat, std::strtold(size_.c_str(), nullptr) * bp))
+    {
+        note("Note: the funds for the buy have been taken by another order - retrying in 1 minute.");
+        co_await pause(exchange, std::chrono::minutes(1), span_kind::insufficient_funds);
+        co_return true;
+    }
+
+    // Perform the trade.
+    note("Performing buy of ", size_, " ", order_.coin, " at ", order_price_, " ", order_.fiat, " per coin with ", balance_, " ", order_.fiat, ".");
+    uuid_.clear();
+    order_status result = co_await exchange.post_order(cryptocoin::trading::buy, size_, order_price_, uuid_);
+    if (portfolio_ && result == in_progress)
+        portfolio_->posted(member_);
+    else if (portfolio_)
+        portfolio_->release(member_);
+    if (parent_.active() && (result == in_progress || result == completed))
+        parent_.add_child(uuid_.c_str(), std::strtod(size_.c_str(), nullptr), static_cast<double>(bp), child_until);
+    switch (result)
+    {
+        case in_progress:
+            if (!save("WFB", order_price_.c_str(), uuid_.c_str())) co_return false;
+            note("Buy order posted - checking outcome in ", settings_.check_minutes, " minutes.");
+            co_await pause(exchange, check_interval(), span_kind::order_check);
+            co_return true;
+        case completed:
+        {
+            announce_fill(cryptocoin::trading::buy);
+            co_await record_fill(exchange, cryptocoin::trading::buy);
+            if (parent_.active()) co_return co_await after_child(exchange, cryptocoin::trading::buy);
+            open_position(bp);
+            long double rate = co_await exchange.sell_price_adjustment();
+            if (!save_target("SELL", decide([&](auto s) { return s.sell_after_buy(bp, rate, inputs()); }))) co_return false;
+            note("The current buy order has completed successfully.");
+            co_return true;
+        }
+        case network_error:
+            note("Warning: a temporary network error occurred - retrying in 1 minute.");
+            co_await pause(exchange, std::chrono::minutes(1), span_kind::network_error);
+            co_return true;
+        case fatal_error:
+            note("A fatal error occurred - see the log file for details.");
+            co_return false;
+        case insufficient_funds:
+            note("Warning: failed to post buy order due to insufficient fiat fiat_balance - retrying in 30 minutes.");
+            co_await pause(exchange, std::chrono::minutes(30), span_kind::insufficient_funds);
+            co_return true;
+        default:
+            note("Warning: failed to post buy order - retrying in 30 seconds.");
+            co_await pause(exchange, std::chrono::seconds(30), span_kind::order_rejected);
+            co_return true;
+    }
+}
+
+// ============================================================================================
+// A buy has been set up, we need to see if it has completed.
+// ============================================================================================
+task<bool> trader::wait_for_buy(async_exchange& exchange)
+{
+    long double bp = std::strtold(order_.price, nullptr);
+    long double cp = 0;
+
+    uuid_.assign(order_.uuid);
+    order_status result = co_await exchange.get_order_status(uuid_);
+
+    // A child whose slice is over is taken off the book; what it did not buy goes into the next one.
+    const child_order* child = parent_.working();
+    if (result == in_progress && child && now_us() >= child->until_us)
+    {
+        result = co_await exchange.cancel_order(uuid_);
+        if (result == cancelled)
+        {
+            co_await record_fill(exchange, cryptocoin::trading::buy, false);
+            co_return save("BUY", order_.price);
+        }
+    }
+
+    // If the market has run away from the order, take it off the book and buy at the new price.
+    bool moved = false;
+    if (result == in_progress && decide([&](auto s) { return s.watches_market(inputs()); }))
+    {
+        bool priced = co_await fetch_price(exchange, cp);
+        if (priced) moved = decide([&](auto s) { return s.reprice_buy(bp, cp, inputs()); });
+    }
+    if (moved)
+    {
+        note("Note: the market has moved to ", price_, " ", order_.fiat, " - cancelling the buy order to re-price it.");
+
+        // A fill can beat the cancel to the exchange, in which case the result is completed and is
+        // handled below like any other fill.
+        result = co_await exchange.cancel_order(uuid_);
+        if (result == cancelled)
+        {
+            if (parent_.active()) co_await record_fill(exchange, cryptocoin::trading::buy, false);
+            co_return save("BUY", price_.c_str());
+        }
+    }
+
+    switch (result)
+    {
+        case in_progress:
+            note("The current buy order has not yet completed - checking again in ", settings_.check_minutes, " minutes.");
+            co_await pause(exchange, check_interval(), span_kind::order_check);
+            co_return true;
+        case completed:
+        {
+            announce_fill(cryptocoin::trading::buy);
+            co_await record_fill(exchange, cryptocoin::trading::buy);
+            if (parent_.active()) co_return co_await after_child(exchange, cryptocoin::trading::buy);
+            open_position(bp);
+            long double rate = co_await exchange.sell_price_adjustment();
+            if (!save_target("SELL", decide([&](auto s) { return s.sell_after_buy(bp, rate, inputs()); }))) co_return false;
+            note("The current buy order has completed successfully.");
+            co_return true;
+        }
+        case network_error:
+            note("Warning: a temporary network error occurred - retrying in 1 minute.");
+            co_await pause(exchange, std::chrono::minutes(1), span_kind::network_error);
+            co_return true;
+        case cancelled:
+            if (parent_.active()) co_await record_fill(exchange, cryptocoin::trading::buy, false);
+            if (!save("BUY", order_.price)) co_return false;
+            note("The current buy order appears to have been cancelled - setting up for repost in 1 minute.");
+            co_await pause(exchange, std::chrono::minutes(1), span_kind::repost);
+            co_return true;
+        case fatal_error:
+            note("A fatal error occurred - see the log file for details.");
+            co_return false;
+        default:
+            break;
+    }
+
+    file_.close();
+    co_return false;
+}
+
+// ============================================================================================
+// We need to sell our coin at the price in the work order file.
+// ============================================================================================
+task<bool> trader::sell(async_exchange& exchange)
+{
+    long double bp = std::strtold(order_.price, nullptr);
+    long double cp = 0;
+
+    order_price_.assign(order_.price);
+    bool priced = co_await fetch_price(exchange, cp);
+    if (!priced)
+    {
+        note("Warning: a temporary network error occurred - retrying in 1 minute.");
+        co_await pause(exchange, std::chrono::minutes(1), span_kind::network_error);
+        co_return true;
+    }
+
+    // Closing a position on an exit sells at the best bid, whatever the work order's price, so that the
+    // order meets the market; wait_for_sell() follows the bid down until it fills.
+    if (exit_pending_)
+    {
+        if (!co_await fetch_bid(exchange, cp))
+        {
+            note("Warning: failed to retrieve the best bid for the exit sell - retrying in 30 seconds.");
+            co_await pause(exchange, std::chrono::seconds(30), span_kind::query_retry);
+            co_return true;
+        }
+        order_price_.assign(price_);
+        bp = cp;
+        parent_.clear();
+    }
+    // If the current price has risen above our sell price then update our sell price.
+    else if (decide([&](auto s) { return s.sell_at_market(bp, cp, inputs()); }))
+    {
+        order_price_.assign(price_);
+        bp = cp;
+        note("Updated buy price to current, better price of ", price_, " ", order_.fiat);
+    }
+
+    // Let a strongly rising market run before selling into it.
+    if (!exit_pending_ && decide([&](auto s) { return s.defer_sell(inputs()); }))
+    {
+        note("Note: the market is rising sharply - deferring the sell for 1 minute.");
+        co_await pause(exchange, std::chrono::minutes(1), span_kind::market_deferral);
+        co_return true;
+    }
+
+    uint64_t read_stamp = portfolio_ ? portfolio_->balance_stamp(member_, holding::coin) : 0;
+    co_await exchange.read_coin_balance(balance_);
+    if (balance_.empty())
+    {
+        note("Warning: failed to retrieve fiat balance from server - retrying in 30 seconds.");
+        co_await pause(exchange, std::chrono::seconds(30), span_kind::query_retry);
+        co_return true;
+    }
+
+    // Round the order onto the product's increments; the price rounds up so we never undersell, except
+    // on an exit, where it rounds down so the order meets the market.
+    bool have_rules = co_await exchange.get_product_info(product_);
+    if (!have_rules)
+    {
+        note("Warning: failed to retrieve product information from server - retrying in 30 seconds.");
+        co_await pause(exchange, std::chrono::seconds(30), span_kind::query_retry);
+        co_return true;
+    }
+    product_.quantise_price(order_price_.c_str(), !exit_pending_, price_);
+    order_price_.assign(price_);
+    bp = std::strtold(order_price_.c_str(), nullptr);
+    if (portfolio_)
+    {
+        // Sell no more than the pair's share of the coin, less what its other orders hold. Rounded down,
+        // so the size never comes out above the budget.
+        if (!portfolio_->update_balance(member_, holding::coin, std::strtold(balance_.c_str(), nullptr), read_stamp))
+        {
+            note("Note: another order was posted while the ", order_.coin, " balance was read - reading it again.");
+            co_await pause(exchange, std::chrono::seconds(1), span_kind::query_retry);
+            co_return true;
+        }
+        char budget[48];
+        std::snprintf(budget, sizeof(budget), "%.12Lf", std::floor(portfolio_->budget(member_, holding::coin) * 1e12L) / 1e12L);
+        balance_.assign(budget);
+    }
+    if (!product_.quantise_size(balance_, size_))
+    {
+        if (parent_.filled() > 0.0) co_return co_await finish_parent(exchange, cryptocoin::trading::sell);
+        note("Warning: the ", order_.coin, " balance of ", balance_, " is below the minimum order size - retrying in 30 minutes.");
+        co_await pause(exchange, std::chrono::minutes(30), span_kind::insufficient_funds);
+        co_return true;
+    }
+
+    // A sliced sell posts the next child of the parent, once it is due; an exit sells the lot at once.
+    int64_t child_until = 0;
+    if (plan_.sliced() && !exit_pending_)
+    {
+        slice_step next = co_await next_child(exchange, "sell");
+        if (next == slice_step::done) co_return co_await finish_parent(exchange, cryptocoin::trading::sell);
+        if (next == slice_step::wait)
+        {
+            co_await pause(exchange, until(parent_.next_slice_us(now_us())), span_kind::slice_wait);
+            co_return true;
+        }
+        child_until = parent_.next_slice_us(now_us());
+    }
+
+    if (portfolio_ && !portfolio_->reserve(member_, holding::coin, std::strtold(size_.c_str(), nullptr)))
+    {
+        note("Note: the ", order_.coin, " for the sell has been taken by another order - retrying in 1 minute.");
+        co_await pause(exchange, std::chrono::minutes(1), span_kind::insufficient_funds);
+        co_return true;
+    }
+
+    // Perform the trade.
+    note("Performing sell of ", size_, " ", order_.coin, " at ", order_price_, " ", order_.fiat, " per coin .");
+    uuid_.clear();
+    order_status result = co_await exchange.post_order(cryptocoin::trading::sell, size_, order_price_, uuid_);
+    if (portfolio_ && result == in_progress)
+        portfolio_->posted(member_);
+    else if (portfolio_)
+        portfolio_->release(member_);
+    if (parent_.active() && (result == in_progress || result == completed))
+        parent_.add_child(uuid_.c_str(), std::strtod(size_.c_str(), nullptr), static_cast<double>(bp), child_until);
+    switch (result)
+    {
+        case in_progress:
+            if (!save("WFS", order_price_.c_str(), uuid_.c_str())) co_return false;
+            exit_posted_ = exit_pending_;
+            if (exit_posted_)
+            {
+                note("Exit sell order posted - checking it against the best bid in ", exit_check_interval.count(), " seconds.");
+                co_await pause(exchange, exit_check_interval, span_kind::order_check);
+                co_return true;
+            }
+            note("Sell order posted - checking outcome in ", settings_.check_minutes, " minutes.");
+            co_await pause(exchange, check_interval(), span_kind::order_check);
+            co_return true;
+        case completed:
+        {
+            announce_fill(cryptocoin::trading::sell);
+            co_await record_fill(exchange, cryptocoin::trading::sell);
+            if (parent_.active()) co_return co_await after_child(exchange, cryptocoin::trading::sell);
+            close_position();
+            long double rate = co_await exchange.buy_price_ajustment();
+            if (!save_target("BUY", decide([&](auto s) { return s.buy_after_sell(bp, rate, inputs()); }))) co_return false;
+            note("The current sell order has completed successfully.");
+            co_return true;
+        }
+        case network_error:
+            note("Warning: a temporary network error occurred - retrying in 1 minute.");
+            co_await pause(exchange, std::chrono::minutes(1), span_kind::network_error);
+            co_return true;
+        case fatal_error:
+            note("A fatal error occurred - see the log file for details.");
+            co_return false;
+        case insufficient_funds:
+            note("Warning: failed to post sell order due to insufficient ", order_.coin, " fiat_balance - retrying in 30 minutes.");
+            co_await pause(exchange, std::chrono::minutes(30), span_kind::insufficient_funds);
+            co_return true;
+        default:
+            note("Warning: failed to post sell order - retrying in 30 seconds.");
+            co_await pause(exchange, std::chrono::seconds(30), span_kind::order_rejected);
+            co_return true;
+    }
+}
+
+// ============================================================================================
+// A sell order has been set up, we need to see if it has completed.
+// ============================================================================================
+task<bool> trader::wait_for_sell(async_exchange& exchange)
+{
+    long double sp = std::strtold(order_.price, nullptr);
+    long double cp = 0;
+
+    uuid_.assign(order_.uuid);
+    order_status result = co_await exchange.get_order_status(uuid_);
+
+    // A child whose slice is over is taken off the book; what it did not sell goes into the next one.
+    const child_order* child = parent_.working();
+    if (result == in_progress && child && !exit_pending_ && now_us() >= child->until_us)
+    {
+        result = co_await exchange.cancel_order(uuid_);
+        if (result == cancelled)
+        {
+            co_await record_fill(exchange, cryptocoin::trading::sell, false);
+            co_return save("SELL", order_.price);
+        }
+    }
+
+    // If the market has fallen away from the order, or an exit has fired, take it off the book and sell
+    // at the new price. An exit order is re-priced whenever the best bid drops below it.
+    bool moved = exit_pending_ && !exit_posted_;
+    if (result == in_progress && exit_posted_)
+    {
+        bool priced = co_await fetch_bid(exchange, cp);
+        moved = priced && cp < sp;
+    }
+    else if (result == in_progress && decide([&](auto s) { return s.watches_market(inputs()); }) && !moved)
+    {
+        bool priced = co_await fetch_price(exchange, cp);
+        if (priced) moved = decide([&](auto s) { return s.reprice_sell(sp, cp, inputs()); });
+    }
+    if (moved && result == in_progress)
+    {
+        if (exit_posted_)
+            note("Note: the best bid has fallen to ", price_, " ", order_.fiat, " - re-pricing the exit sell order.");
+        else if (exit_pending_)
+            note("Note: cancelling the sell order to close the position at the best bid.");
+        else
+            note("Note: the market has moved to ", price_, " ", order_.fiat, " - cancelling the sell order to re-price it.");
+
+        // A fill can beat the cancel to the exchange, in which case the result is completed and is
+        // handled below like any other fill.
+        result = co_await exchange.cancel_order(uuid_);
+        if (result == cancelled)
+        {
+            exit_posted_ = false;
+            if (parent_.active()) co_await record_fill(exchange, cryptocoin::trading::sell, false);
+            co_return save("SELL", exit_pending_ ? order_.price : price_.c_str());
+        }
+    }
+
+    switch (result)
+    {
+        case in_progress:
+            if (exit_posted_)
+            {
+                note("The exit sell order has not yet completed - checking again in ", exit_check_interval.count(), " seconds.");
+                co_await pause(exchange, exit_check_interval, span_kind::order_check);
+                co_return true;
+            }
+            note("The current sell order has not yet completed - checking again in ", settings_.check_minutes, " minutes.");
+            co_await pause(exchange, check_interval(), span_kind::order_check);
+            co_return true;
+        case completed:
+        {
+            announce_fill(cryptocoin::trading::sell);
+            co_await record_fill(exchange, cryptocoin::trading::sell);
+            if (parent_.active()) co_return co_await after_child(exchange, cryptocoin::trading::sell);
+            close_position();
+            long double rate = co_await exchange.buy_price_ajustment();
+            if (!save_target("BUY", decide([&](auto s) { return s.buy_after_sell(sp, rate, inputs()); }))) co_return false;
+            note("The current sell order has completed successfully.");
+            co_return true;
+        }
+        case network_error:
+            note("Warning: a temporary network error occurred - retrying in 1 minute.");
+            co_await pause(exchange, std::chrono::minutes(1), span_kind::network_error);
+            co_return true;
+        case cancelled:
+            exit_posted_ = false;
+            if (parent_.active()) co_await record_fill(exchange, cryptocoin::trading::sell, false);
+            if (!save("SELL", order_.price)) co_return false;
+            note("The current sell order appears to have been cancelled - setting up for repost in 1 minute.");
+            co_await pause(exchange, std::chrono::minutes(1), span_kind::repost);
+            co_return true;
+        case fatal_error:
+            note("A fatal error occurred - see the log file for details.");
+            co_return false;
+        default:
+            break;
+    }
+
+    file_.close();
+    co_return false;
+}
+
+}
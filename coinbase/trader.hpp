@@ -0,0 +1,261 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   trader.hpp
+ * Author: Chris Morrison
+ *
+ * Created on 19 October 2026, 18:45
+ */
+#ifndef TRADER_HPP
+#define TRADER_HPP
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <boost/thread/mutex.hpp>
+#include "async_exchange.hpp"
+#include "candles.hpp"
+#include "execution.hpp"
+#include "exit_engine.hpp"
+#include "indicators.hpp"
+#include "ledger.hpp"
+#include "plugin_host.hpp"
+#include "portfolio.hpp"
+#include "product_info.hpp"
+#include "profiler.hpp"
+#include "snapshot.hpp"
+#include "strategy.hpp"
+#include "task.hpp"
+#include "tick_store.hpp"
+#include "work_order.hpp"
+
+namespace mercury
+{
+
+///
+/// Settings for the trading loop, as given on the command line.
+struct trader_settings
+{
+    long double fiat_percent = 1.0;     ///< Fraction of the fiat balance to use for buys.
+    long double chase_fraction = 0.0;   ///< Re-price resting orders this far from the market; 0 for never.
+    unsigned int check_minutes = 10;    ///< Minutes between checks on a resting order.
+    exit_rules exits;                   ///< Exits guarding every position once its buy fills.
+    std::string strategy_name = default_strategy; ///< Strategy for work orders that do not name one.
+};
+
+/// Called when an order fills.
+typedef void (*fill_function)(cryptocoin::trading::order_side side);
+
+///
+/// The work order state machine (BUY -> WFB -> SELL -> WFS -> BUY ...), run as a coroutine.
+///
+/// The work order is read from its file once and then held in memory; the file is rewritten on every
+/// change so that a restart picks up where the last run left off. Exchange calls and the waits between
+/// steps suspend the coroutine rather than the thread, so any number of traders can share one
+/// io_context.
+///
+/// Every string the loop needs is a member that keeps its storage from one step to the next, and the
+/// work order itself lives in fixed buffers, so once the first cycle has sized everything a step
+/// makes no heap allocations of its own.
+///
+/// The price history and any wait in progress go into warm-restart snapshots (see state_snapshots.hpp),
+/// so a restarted trader serves out the rest of its wait instead of starting it again.
+///
+/// A work order with an execution plan has its buys and sells worked as parent orders split into
+/// child orders (see execution.hpp). Each child goes through the same states as a single order would:
+/// BUY posts it and WFB waits on it, and once it has filled or its slice is over, BUY posts the next.
+/// The state only moves on to SELL when the parent is done, and likewise for selling.
+///
+/// The prices and sizes of the orders are decided by the work order's strategy (see strategy.hpp),
+/// or by the one in the settings if the work order does not name one. The strategy can come from a
+/// plugin (see plugin_host.hpp), which sees every price the trader does.
+///
+/// With an exit engine, the coin held between a buy and its sell is guarded by the exits in the
+/// settings. When one fires, whatever wait the trader is in is cut short, the resting sell order is
+/// cancelled and the coin is sold at the market price.
+class trader : public snapshot_source, public exit_watcher
+{
+public:
+    ///
+    /// \param settings  The trading settings.
+    /// \param log_mutex Serialises output with the rest of the program.
+    /// \param log       Where progress messages go.
+    trader(const trader_settings& settings, boost::mutex& log_mutex, std::ostream& log = std::cout);
+
+    ///
+    /// Opens the work order file and reads the first instruction from it.
+    ///
+    /// \return false (after logging why) if the file cannot be opened or does not hold a valid work order,
+    ///         execution plan and strategy.
+    bool open(const std::string& work_order_path);
+
+    /// The work order as last read or written.
+    const work_order& current() const { return order_; }
+
+    /// With waits skipped every step follows straight on from the last; used by the benchmarks.
+    void skip_waits(bool skip = true) { skip_waits_ = skip; }
+    void set_fill(fill_function fill) { fill_ = fill; }
+    void set_tick_recorder(tick_store_writer* recorder) { recorder_ = recorder; }
+
+    ///
+    /// Enters every fill in a ledger, and marks the pair's position to each price seen. Call after
+    /// open(), since the pair comes from the work order.
+    void set_ledger(trade_ledger* ledger);
+
+    ///
+    /// Records every step, wait and fill announcement as a span on one of a profiler's tracks.
+    ///
+    /// \param profiler The profiler, or nullptr to stop profiling.
+    /// \param track    The track returned by state_profiler::add_track().
+    void set_profiler(state_profiler* profiler, unsigned int track)
+    {
+        profiler_ = profiler;
+        profile_track_ = track;
+    }
+
+    ///
+    /// Guards every position with the exits in the settings. The engine is shared by every trader on
+    /// the product and is fed every price any of them sees.
+    ///
+    /// \param exits The engine, or nullptr for no exits.
+    void set_exit_engine(exit_engine* exits) { exits_ = exits; }
+
+    /// Lets the work order name a strategy from one of the host's plugins. Call before open().
+    void set_plugins(plugin_host* plugins) { plugins_ = plugins; }
+
+    /// Sets the volume profile VWAP orders follow; it must outlive the trader. The default is flat.
+    void set_volume_profile(const volume_profile* profile) { profile_ = profile; }
+
+    ///
+    /// Sizes orders from the pair's budget in a portfolio instead of the whole balance, and reserves the
+    /// funds for every order before posting it.
+    ///
+    /// \param funds  The portfolio, or nullptr to use the whole balance.
+    /// \param member The number portfolio::join() gave the work order.
+    void set_portfolio(portfolio* funds, std::size_t member)
+    {
+        portfolio_ = funds;
+        member_ = member;
+    }
+
+    market_indicators& indicators() { return indicators_; }
+    candle_aggregator& candles() { return candles_; }
+
+    ///
+    /// Performs the next step of the work order.
+    ///
+    /// \return false when trading must stop.
+    task<bool> step(async_exchange& exchange);
+
+    /// Performs steps until trading must stop, after finishing any wait restored from a snapshot.
+    task<void> run(async_exchange& exchange);
+
+    void save_state(snapshot_writer& out) const override;
+
+    /// The wait in progress is only restored if the work order has not changed since the snapshot.
+    bool restore_state(snapshot_reader& in, int64_t snapshot_us) override;
+
+    void exit_triggered(exit_reason reason, double price) override;
+
+private:
+    task<bool> buy(async_exchange& exchange);
+    task<bool> wait_for_buy(async_exchange& exchange);
+    task<bool> sell(async_exchange& exchange);
+    task<bool> wait_for_sell(async_exchange& exchange);
+
+    task<bool> fetch_price(async_exchange& exchange, long double& value);
+    task<bool> fetch_bid(async_exchange& exchange, long double& value);
+    void observe_price(long double value);
+    task<void> record_fill(async_exchange& exchange, cryptocoin::trading::order_side side, bool completed = true);
+
+    enum class slice_step { post, wait, done };
+    task<slice_step> next_child(async_exchange& exchange, const char* side_name);
+    task<bool> after_child(async_exchange& exchange, cryptocoin::trading::order_side side);
+    task<bool> finish_parent(async_exchange& exchange, cryptocoin::trading::order_side side);
+    bool quantise_child(double size);
+    std::chrono::seconds check_interval() const;
+
+    strategy_inputs inputs() const
+    {
+        return strategy_inputs{ indicators_, candles_, settings_.fiat_percent, settings_.chase_fraction, plugin_ };
+    }
+
+    /// Makes one decision with the work order's strategy, chosen when the work order was opened.
+    template <typename Decision>
+    auto decide(Decision&& decision) const
+    {
+        return mercury::decide(strategy_, decision);
+    }
+
+    bool save_target(const char* action, long double price);
+    bool save(const char* action, const char* price, const char* uuid = nullptr);
+    task<void> pause(async_exchange& exchange, std::chrono::seconds duration, span_kind reason);
+    void announce_fill(cryptocoin::trading::order_side side);
+    void open_position(long double entry);
+    void close_position();
+
+    template <typename... Args>
+    void note(const Args&... args);
+
+    trader_settings settings_;
+    boost::mutex& mtx_;
+    std::ostream& log_;
+    bool skip_waits_ = false;
+    int64_t resume_at_us_ = 0;
+    async_exchange::timer* waiting_ = nullptr;
+    fill_function fill_ = nullptr;
+    tick_store_writer* recorder_ = nullptr;
+    trade_ledger* ledger_ = nullptr;
+    position* position_ = nullptr;
+    state_profiler* profiler_ = nullptr;
+    unsigned int profile_track_ = 0;
+    exit_engine* exits_ = nullptr;
+    portfolio* portfolio_ = nullptr;
+    std::size_t member_ = 0;
+    double entry_price_ = 0.0;
+    int64_t entry_us_ = 0;
+    bool exit_pending_ = false;
+    bool exit_posted_ = false;          // The resting sell is the one closing the position after an exit.
+
+    strategy_kind strategy_ = strategy_kind::classic;
+    plugin_host* plugins_ = nullptr;
+    plugin_instance* plugin_ = nullptr;
+    execution_plan plan_;
+    parent_order parent_;
+    const volume_profile* profile_;
+    ticker ticker_;
+    std::string pair_;
+    order_fill filled_;
+
+    work_order_file file_;
+    work_order order_;
+
+    market_indicators indicators_;
+    candle_aggregator candles_;
+    product_info product_;
+
+    std::string price_;
+    std::string balance_;
+    std::string size_;
+    std::string order_price_;
+    std::string uuid_;
+    std::string quantity_;
+    char new_price_[48] = {};
+};
+
+}
+
+#endif /* TRADER_HPP */
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   unit_test.hpp
+ * Author: Chris Morrison
+ *
+ * Created on 20 October 2026, 18:05
+ */
+#ifndef UNIT_TEST_HPP
+#define UNIT_TEST_HPP
+
+#include <cstdio>
+
+// ------------------------------------------------------------------------------------------------
+// Checks for the unit tests.
+//
+// Each test is a plain program: it runs its checks, prints every one that fails with its file and
+// line, and exits with status 1 if any did, which is all ctest and "make check" look at.
+// ------------------------------------------------------------------------------------------------
+
+namespace mercury
+{
+
+/// Number of checks that have failed so far.
+inline unsigned int& failed_checks()
+{
+    static unsigned int failed = 0;
+    return failed;
+}
+
+///
+/// Records the result of one check, printing it if it failed.
+///
+/// \param passed     The result.
+/// \param expression The text of the check.
+/// \param file       Where it is.
+/// \param line       The line it is on.
+inline void record_check(bool passed, const char* expression, const char* file, int line)
+{
+    if (passed) return;
+
+    std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+    ++failed_checks();
+}
+
+/// Prints the outcome of the test and gives the status for main() to return.
+inline int test_result(const char* name)
+{
+    if (failed_checks() == 0)
+    {
+        std::printf("%s: all checks passed\n", name);
+        return 0;
+    }
+
+    std::printf("%s: %u checks failed\n", name, failed_checks());
+    return 1;
+}
+
+}
+
+#define CHECK(expression) mercury::record_check(static_cast<bool>(expression), #expression, __FILE__, __LINE__)
+
+#endif /* UNIT_TEST_HPP */
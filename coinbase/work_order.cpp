@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   work_order.cpp
+ * Author: Chris Morrison
+ *
+ * Created on 19 October 2026, 18:10
+ */
+#include <cstring>
+#include "work_order.hpp"
+
+namespace mercury
+{
+
+// Written after the work order line to blank out whatever is left of a longer line written earlier.
+static const char padding[] = "                                        ";
+
+template <std::size_t N>
+static bool copy_field(char (&field)[N], const char* text, std::size_t len)
+{
+    if (len == 0 || len >= N) return false;
+    std::memcpy(field, text, len);
+    field[len] = '\0';
+    return true;
+}
+
+template <std::size_t N>
+static bool copy_optional_field(char (&field)[N], const char* text, std::size_t len)
+{
+    field[0] = '\0';
+    return len == 0 || copy_field(field, text, len);
+}
+
+template <std::size_t N>
+static bool copy_field(char (&field)[N], const char* text)
+{
+    return copy_field(field, text, std::strlen(text));
+}
+
+bool work_order::parse(const char* text, std::size_t len)
+{
+    const char* fields[7];
+    std::size_t lengths[7];
+    std::size_t count = 0;
+    const char* start = text;
+    const char* end = text + len;
+
+    for (const char* p = text; p <= end; ++p)
+    {
+        if (p == end || *p == ':')
+        {
+            if (count == 7) return false;
+            fields[count] = start;
+            lengths[count] = static_cast<std::size_t>(p - start);
+            ++count;
+            start = p + 1;
+        }
+    }
+    if (count < 5) return false;
+
+    work_order order;
+    if (!copy_field(order.coin, fields[0], lengths[0]) || !copy_field(order.action, fields[1], lengths[1]) ||
+        !copy_field(order.fiat, fields[2], lengths[2]) || !copy_field(order.price, fields[3], lengths[3]) ||
+        !copy_field(order.uuid, fields[4], lengths[4]) || (count == 6 && !copy_field(order.execution, fields[5], lengths[5])) ||
+        (count == 7 && (!copy_optional_field(order.execution, fields[5], lengths[5]) || !copy_field(order.strategy, fields[6], lengths[6]))))
+    {
+        return false;
+    }
+
+    *this = order;
+    return true;
+}
+
+std::size_t work_order::format(char* buf, std::size_t len) const
+{
+    const char* parts[7] = { coin, action, fiat, price, uuid, execution, strategy };
+    std::size_t n = 0;
+    int count = strategy[0] ? 7 : (execution[0] ? 6 : 5);
+
+    for (int i = 0; i < count; ++i)
+    {
+        std::size_t part = std::strlen(parts[i]);
+        if (n + part + 2 > len) return 0;
+        if (i > 0) buf[n++] = ':';
+        std::memcpy(buf + n, parts[i], part);
+        n += part;
+    }
+    buf[n] = '\0';
+
+    return n;
+}
+
+bool work_order::set(const char* new_action, const char* new_price, const char* new_uuid)
+{
+    work_order order = *this;
+
+    if (!copy_field(order.action, new_action) || !copy_field(order.price, new_price) ||
+        !copy_field(order.uuid, (new_uuid && *new_uuid) ? new_uuid : "NONE"))
+    {
+        return false;
+    }
+
+    *this = order;
+    return true;
+}
+
+bool work_order::is(const char* what) const
+{
+    return std::strcmp(action, what) == 0;
+}
+
+bool work_order_file::open(const std::string& path)
+{
+    file_.open(path, std::ios::in | std::ios::out);
+    return file_.is_open();
+}
+
+bool work_order_file::read(work_order& order)
+{
+    // Always start from the top: a write leaves the shared file position after the padding.
+    file_.clear(); // Make sure we are not EOF.
+    file_.seekg(0, std::ios::beg);
+
+    // The line is a single whitespace-free token, as it always has been.
+    file_ >> std::ws;
+    file_.getline(line_, sizeof(line_), '\n');
+    bool ok = !file_.fail() || file_.eof();
+    std::size_t len = std::strlen(line_);
+    file_.clear();
+
+    while (len > 0 && (line_[len - 1] == ' ' || line_[len - 1] == '\r' || line_[len - 1] == '\t')) --len;
+
+    return ok && len > 0 && order.parse(line_, len);
+}
+
+bool work_order_file::write(const work_order& order)
+{
+    std::size_t len = order.format(line_, sizeof(line_));
+
+    if (len == 0) return false;
+
+    file_.seekp(0, std::ios::beg);
+    file_.write(line_, static_cast<std::streamsize>(len));
+    file_.put('\n');
+    file_.write(padding, sizeof(padding) - 1);
+    file_.flush();
+
+    return static_cast<bool>(file_);
+}
+
+}
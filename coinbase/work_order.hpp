@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   work_order.hpp
+ * Author: Chris Morrison
+ *
+ * Created on 19 October 2026, 18:10
+ */
+#ifndef WORK_ORDER_HPP
+#define WORK_ORDER_HPP
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+
+namespace mercury
+{
+
+///
+/// One work order instruction, e.g. "BTC:WFB:EUR:8123.45:0b1f5c3e-...". Every field lives in a fixed
+/// buffer so that reading and rewriting the work order never touches the heap. An optional sixth
+/// field says how orders are executed (see execution.hpp), e.g. "BTC:BUY:EUR:8100:NONE:twap,6,10",
+/// and an optional seventh names the strategy (see strategy.hpp), e.g. "BTC:BUY:EUR:8100:NONE::patient".
+struct work_order
+{
+    char coin[16] = {};
+    char action[8] = {};
+    char fiat[16] = {};
+    char price[40] = {};
+    char uuid[64] = {};
+    char execution[24] = {};
+    char strategy[16] = {};
+
+    ///
+    /// Parses a work order line.
+    ///
+    /// \param text The line, which does not need to be null terminated.
+    /// \param len  Length of the line.
+    /// \return false unless the line has five to seven fields that all fit their buffers; only the
+    ///         execution field may be empty.
+    bool parse(const char* text, std::size_t len);
+
+    ///
+    /// Writes the work order line (without a line end) into a buffer.
+    ///
+    /// \return the number of characters written, or 0 if the buffer is too small.
+    std::size_t format(char* buf, std::size_t len) const;
+
+    /// Replaces the action, price and uuid in one go; a null uuid is written as NONE.
+    bool set(const char* new_action, const char* new_price, const char* new_uuid = nullptr);
+
+    /// Compares the action field.
+    bool is(const char* what) const;
+};
+
+///
+/// The work order file: a single work order line, rewritten in place on every state change.
+class work_order_file
+{
+public:
+    /// Opens an existing work order file for reading and writing.
+    bool open(const std::string& path);
+
+    bool is_open() const { return file_.is_open(); }
+
+    ///
+    /// Reads the work order from the start of the file.
+    ///
+    /// \return false if the file is empty or the line is not a valid work order.
+    bool read(work_order& order);
+
+    /// Rewrites the file with the given work order.
+    bool write(const work_order& order);
+
+    void close() { file_.close(); }
+
+private:
+    std::fstream file_;
+    char line_[256];
+};
+
+}
+
+#endif /* WORK_ORDER_HPP */
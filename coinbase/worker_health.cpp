@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   worker_health.cpp
+ * Author: Chris Morrison
+ *
+ * Created on 20 October 2026, 03:30
+ */
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstring>
+#include "worker_health.hpp"
+
+namespace mercury
+{
+
+static bool make_address(const std::string& path, sockaddr_un& address)
+{
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) return false;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size());
+    return true;
+}
+
+static int64_t microseconds(const timeval& t)
+{
+    return int64_t(t.tv_sec) * 1000000 + t.tv_usec;
+}
+
+health_reporter::~health_reporter()
+{
+    close();
+}
+
+bool health_reporter::open(const std::string& path)
+{
+    sockaddr_un address;
+
+    close();
+    if (!make_address(path, address)) return false;
+    fd_ = ::socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    path_ = path;
+    return fd_ >= 0;
+}
+
+bool health_reporter::send(health_report& report)
+{
+    sockaddr_un address;
+    rusage usage;
+
+    if (fd_ < 0 || !make_address(path_, address)) return false;
+
+    report.magic = health_report_magic;
+    report.pid = int32_t(::getpid());
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    report.time_us = std::chrono::duration_cast<std::chrono::microseconds>(now).count();
+    if (::getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+        report.cpu_us = microseconds(usage.ru_utime) + microseconds(usage.ru_stime);
+        report.max_rss_kb = usage.ru_maxrss;
+    }
+
+    return ::sendto(fd_, &report, sizeof(report), 0, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) ==
+           ssize_t(sizeof(report));
+}
+
+void health_reporter::close()
+{
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+}
+
+health_listener::~health_listener()
+{
+    close();
+}
+
+bool health_listener::open(const std::string& path)
+{
+    sockaddr_un address;
+
+    close();
+    if (!make_address(path, address)) return false;
+    fd_ = ::socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd_ < 0) return false;
+
+    ::unlink(path.c_str());
+    if (::bind(fd_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        close();
+        return false;
+    }
+    path_ = path;
+    return true;
+}
+
+bool health_listener::receive(health_report& report)
+{
+    if (fd_ < 0) return false;
+
+    // Anything that is not a whole report of the current layout is dropped.
+    for (;;)
+    {
+        ssize_t n = ::recv(fd_, &report, sizeof(report), MSG_TRUNC);
+        if (n < 0) return false;
+        if (n == ssize_t(sizeof(report)) && report.magic == health_report_magic) return true;
+    }
+}
+
+void health_listener::close()
+{
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+    if (!path_.empty()) ::unlink(path_.c_str());
+    path_.clear();
+}
+
+}
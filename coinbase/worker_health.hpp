@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2019 Chris Morrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * File:   worker_health.hpp
+ * Author: Chris Morrison
+ *
+ * Created on 20 October 2026, 03:30
+ */
+#ifndef WORKER_HEALTH_HPP
+#define WORKER_HEALTH_HPP
+
+#include <cstdint>
+#include <string>
+
+// ------------------------------------------------------------------------------------------------
+// Health reports from robot workers to mercury-supervisor.
+//
+// The supervisor binds a Unix datagram socket and every worker it starts sends it a fixed-size
+// report once a second. A datagram either arrives whole or not at all, and a worker never waits for
+// the supervisor: if the supervisor is gone or its queue is full the report is simply dropped. A
+// worker is known by its process id, which the supervisor got from fork().
+// ------------------------------------------------------------------------------------------------
+
+namespace mercury
+{
+
+/// Identifies a health report, and changes whenever its layout does.
+constexpr uint32_t health_report_magic = 0x4d484c31; // "MHL1"
+
+///
+/// What a worker says about itself.
+struct health_report
+{
+    uint32_t magic = health_report_magic;
+    int32_t pid = 0;                 ///< The worker's process id.
+    int64_t time_us = 0;             ///< When the report was made, microseconds since the epoch.
+    uint32_t work_orders = 0;        ///< Work orders still running.
+    uint32_t queued_requests = 0;    ///< Exchange requests held back by the scheduler right now.
+    int64_t cpu_us = 0;              ///< User and system CPU time used so far.
+    int64_t max_rss_kb = 0;          ///< Peak resident set size.
+    int64_t loop_lag_us = 0;         ///< How late the trading thread woke for this report.
+};
+
+///
+/// Sends health reports to the supervisor.
+class health_reporter
+{
+public:
+    health_reporter() = default;
+    health_reporter(const health_reporter&) = delete;
+    health_reporter& operator=(const health_reporter&) = delete;
+    ~health_reporter();
+
+    /// Creates the socket the reports are sent from. The supervisor need not be listening yet.
+    bool open(const std::string& path);
+
+    bool is_open() const { return fd_ >= 0; }
+
+    /// Sends one report, filling in the pid, time and CPU figures; false if it was dropped.
+    bool send(health_report& report);
+
+    void close();
+
+private:
+    int fd_ = -1;
+    std::string path_;
+};
+
+///
+/// Receives health reports, for the supervisor.
+class health_listener
+{
+public:
+    health_listener() = default;
+    health_listener(const health_listener&) = delete;
+    health_listener& operator=(const health_listener&) = delete;
+    ~health_listener();
+
+    /// Binds the socket, replacing any left behind by an earlier run.
+    bool open(const std::string& path);
+
+    /// The descriptor to poll for reports.
+    int fd() const { return fd_; }
+
+    /// Reads the next waiting report without blocking; false once there are none.
+    bool receive(health_report& report);
+
+    /// Closes and removes the socket.
+    void close();
+
+private:
+    int fd_ = -1;
+    std::string path_;
+};
+
+}
+
+#endif /* WORKER_HEALTH_HPP */